@@ -0,0 +1,20 @@
+# bench_changes
+add_executable(
+	bench_changes
+
+	bench/bench_changes.c
+)
+
+target_compile_definitions(
+	bench_changes
+
+	PRIVATE SRPC_BENCH_YANG_DIR="${PROJECT_SOURCE_DIR}/bench/yang"
+)
+
+target_link_libraries(
+	bench_changes
+
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
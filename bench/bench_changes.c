@@ -0,0 +1,501 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+/*
+ * Change iteration benchmark.
+ *
+ * Creates a private sysrepo repository and shared memory prefix, installs the srpc-bench module and measures how
+ * long srpc_iterate_changes() takes for synthetic commits:
+ *
+ *     bench_changes [-n entries per commit] [-c commits] [-s cycle|modify] [-r repository path]
+ *
+ * The cycle shape creates, modifies and deletes the list entries in turn, the modify shape only changes a leaf of
+ * already existing entries.
+ */
+
+#include <srpc.h>
+
+#include <dirent.h>
+#include <ftw.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+#ifndef SRPC_BENCH_YANG_DIR
+#define SRPC_BENCH_YANG_DIR "bench/yang"
+#endif
+
+// Name of the benchmark module.
+#define BENCH_MODULE "srpc-bench"
+
+// Path of the benchmark list.
+#define BENCH_LIST_PATH "/srpc-bench:interfaces/interface"
+
+/**
+ * Growable array of measured samples.
+ */
+typedef struct bench_samples_s
+{
+    uint64_t *values; ///< Samples in nanoseconds.
+    size_t count;     ///< Number of samples.
+    size_t size;      ///< Allocated number of samples.
+} bench_samples_t;
+
+/**
+ * Benchmark state shared with the module change callback.
+ */
+typedef struct bench_ctx_s
+{
+    bench_samples_t commits; ///< Duration of each sr_apply_changes() call.
+    bench_samples_t changes; ///< Time between consecutive change callbacks - iteration and callback cost.
+    uint64_t iterate_ns;     ///< Total time spent in srpc_iterate_changes().
+    uint64_t changes_count;  ///< Total number of iterated changes.
+    uint64_t last_change_ns; ///< Time of the previous change callback.
+    uint64_t callback_sink;  ///< Touched by the change callback so the work isn't optimized out.
+    int iterate_error;       ///< Last error returned by srpc_iterate_changes().
+} bench_ctx_t;
+
+static int bench_module_change_cb(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name,
+                                  const char *xpath, sr_event_t event, uint32_t request_id, void *private_data);
+static int bench_change_init_cb(void *priv);
+static int bench_change_cb(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+static int bench_commit(sr_session_ctx_t *session, bench_ctx_t *ctx, const char *shape, size_t round, size_t entries);
+static int bench_samples_add(bench_samples_t *samples, uint64_t value);
+static void bench_samples_report(const char *name, bench_samples_t *samples, double unit, const char *unit_name);
+static int bench_uint64_cmp(const void *a, const void *b);
+static uint64_t bench_now_ns(void);
+static void bench_cleanup_shm(const char *prefix);
+static int bench_remove_cb(const char *path, const struct stat *st, int flag, struct FTW *ftw);
+
+int main(int argc, char **argv)
+{
+    int error = 0;
+    int opt = 0;
+    size_t entries = 100;
+    size_t commits = 30;
+    const char *shape = "cycle";
+    const char *repo_path = NULL;
+    char repo_template[] = "/tmp/srpc-bench-XXXXXX";
+    char shm_prefix[64] = {0};
+    char yang_path[1024] = {0};
+    bool remove_repo = false;
+
+    sr_conn_ctx_t *connection = NULL;
+    sr_session_ctx_t *session = NULL;
+    sr_subscription_ctx_t *subscription = NULL;
+    bench_ctx_t ctx = {0};
+    uint64_t start = 0;
+    uint64_t total_ns = 0;
+
+    while ((opt = getopt(argc, argv, "n:c:s:r:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                entries = strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                commits = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                shape = optarg;
+                break;
+            case 'r':
+                repo_path = optarg;
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-n entries] [-c commits] [-s cycle|modify] [-r repository]\n", argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (strcmp(shape, "cycle") && strcmp(shape, "modify"))
+    {
+        fprintf(stderr, "Unknown commit shape \"%s\"\n", shape);
+        return 1;
+    }
+
+    // private repository and shared memory - never touch the system sysrepo instance
+    if (!repo_path)
+    {
+        if (!mkdtemp(repo_template))
+        {
+            perror("mkdtemp");
+            return 1;
+        }
+        repo_path = repo_template;
+        remove_repo = true;
+    }
+
+    snprintf(shm_prefix, sizeof(shm_prefix), "srpcbench%d", (int)getpid());
+    setenv("SYSREPO_REPOSITORY_PATH", repo_path, 1);
+    setenv("SYSREPO_SHM_PREFIX", shm_prefix, 1);
+
+    snprintf(yang_path, sizeof(yang_path), "%s/%s.yang", SRPC_BENCH_YANG_DIR, BENCH_MODULE);
+
+    SRPC_SAFE_CALL_ERR(error, sr_connect(SR_CONN_DEFAULT, &connection), error_out);
+    SRPC_SAFE_CALL_ERR(error, sr_install_module(connection, yang_path, SRPC_BENCH_YANG_DIR, NULL), error_out);
+    SRPC_SAFE_CALL_ERR(error, sr_session_start(connection, SR_DS_RUNNING, &session), error_out);
+    SRPC_SAFE_CALL_ERR(error,
+                       sr_module_change_subscribe(session, BENCH_MODULE, NULL, bench_module_change_cb, &ctx, 0,
+                                                  SR_SUBSCR_DEFAULT, &subscription),
+                       error_out);
+
+    // the modify shape works on already existing entries
+    if (!strcmp(shape, "modify"))
+    {
+        SRPC_SAFE_CALL_ERR(error, bench_commit(session, &ctx, "cycle", 0, entries), error_out);
+        ctx.commits.count = 0;
+        ctx.changes.count = 0;
+        ctx.iterate_ns = 0;
+        ctx.changes_count = 0;
+    }
+
+    start = bench_now_ns();
+    for (size_t i = 0; i < commits; i++)
+    {
+        SRPC_SAFE_CALL_ERR(error, bench_commit(session, &ctx, shape, i, entries), error_out);
+    }
+    total_ns = bench_now_ns() - start;
+
+    if (ctx.iterate_error)
+    {
+        fprintf(stderr, "srpc_iterate_changes() failed (%d)\n", ctx.iterate_error);
+        goto error_out;
+    }
+
+    printf("shape: %s, entries per commit: %zu, commits: %zu, changes: %llu\n", shape, entries, commits,
+           (unsigned long long)ctx.changes_count);
+    printf("end-to-end: %.1f commits/s\n", (double)commits * 1e9 / (double)(total_ns ? total_ns : 1));
+    printf("iteration: %.0f changes/s\n",
+           (double)ctx.changes_count * 1e9 / (double)(ctx.iterate_ns ? ctx.iterate_ns : 1));
+    bench_samples_report("commit latency", &ctx.commits, 1e6, "ms");
+    bench_samples_report("change latency", &ctx.changes, 1e3, "us");
+
+    goto out;
+
+error_out:
+    error = 1;
+
+out:
+    if (subscription)
+    {
+        sr_unsubscribe(subscription);
+    }
+
+    if (connection)
+    {
+        sr_disconnect(connection);
+    }
+
+    bench_cleanup_shm(shm_prefix);
+
+    if (remove_repo)
+    {
+        nftw(repo_path, bench_remove_cb, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    free(ctx.commits.values);
+    free(ctx.changes.values);
+
+    return error;
+}
+
+/**
+ * Module change callback - iterates the changes of the change event using srpc_iterate_changes().
+ *
+ * @param session Implicit session.
+ * @param sub_id Subscription ID.
+ * @param module_name Changed module name.
+ * @param xpath Subscription XPath.
+ * @param event Type of the callback event.
+ * @param request_id Request ID.
+ * @param private_data Benchmark context.
+ *
+ * @return Error code - SR_ERR_OK on success.
+ */
+static int bench_module_change_cb(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name,
+                                  const char *xpath, sr_event_t event, uint32_t request_id, void *private_data)
+{
+    bench_ctx_t *ctx = private_data;
+    uint64_t start = 0;
+    int error = 0;
+
+    if (event != SR_EV_CHANGE)
+    {
+        return SR_ERR_OK;
+    }
+
+    start = bench_now_ns();
+    error = srpc_iterate_changes(ctx, session, "/" BENCH_MODULE ":*//.", bench_change_cb, bench_change_init_cb, NULL);
+    ctx->iterate_ns += bench_now_ns() - start;
+
+    if (error)
+    {
+        ctx->iterate_error = error;
+    }
+
+    return SR_ERR_OK;
+}
+
+/**
+ * Changes init callback - starts measuring the first change.
+ *
+ * @param priv Benchmark context.
+ *
+ * @return Error code - 0 on success.
+ */
+static int bench_change_init_cb(void *priv)
+{
+    bench_ctx_t *ctx = priv;
+
+    ctx->last_change_ns = bench_now_ns();
+
+    return 0;
+}
+
+/**
+ * Change callback - records the time since the previous change and does the minimal work of a real callback.
+ *
+ * @param priv Benchmark context.
+ * @param session Sysrepo session.
+ * @param change_ctx Current change.
+ *
+ * @return Error code - 0 on success.
+ */
+static int bench_change_cb(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+{
+    bench_ctx_t *ctx = priv;
+    uint64_t now = 0;
+    const char *value = NULL;
+
+    if (change_ctx->node->schema->nodetype & LYD_NODE_TERM)
+    {
+        value = lyd_get_value(change_ctx->node);
+        ctx->callback_sink += value ? (uint64_t)value[0] : 0;
+    }
+
+    now = bench_now_ns();
+    bench_samples_add(&ctx->changes, now - ctx->last_change_ns);
+    ctx->last_change_ns = now;
+    ++ctx->changes_count;
+
+    return 0;
+}
+
+/**
+ * Build and apply a single synthetic commit.
+ *
+ * @param session Running datastore session.
+ * @param ctx Benchmark context.
+ * @param shape Commit shape.
+ * @param round Number of the commit.
+ * @param entries Number of list entries touched by the commit.
+ *
+ * @return Error code - 0 on success.
+ */
+static int bench_commit(sr_session_ctx_t *session, bench_ctx_t *ctx, const char *shape, size_t round, size_t entries)
+{
+    int error = 0;
+    char path[256] = {0};
+    char value[32] = {0};
+    size_t phase = !strcmp(shape, "cycle") ? round % 3 : 1;
+    uint64_t start = 0;
+
+    for (size_t i = 0; i < entries; i++)
+    {
+        snprintf(path, sizeof(path), BENCH_LIST_PATH "[name='eth%zu']", i);
+
+        switch (phase)
+        {
+            case 0:
+                // create the entry with its leafs
+                snprintf(path, sizeof(path), BENCH_LIST_PATH "[name='eth%zu']/description", i);
+                SRPC_SAFE_CALL_ERR(error, sr_set_item_str(session, path, "benchmark interface", NULL, 0), error_out);
+                snprintf(path, sizeof(path), BENCH_LIST_PATH "[name='eth%zu']/mtu", i);
+                SRPC_SAFE_CALL_ERR(error, sr_set_item_str(session, path, "1500", NULL, 0), error_out);
+                snprintf(path, sizeof(path), BENCH_LIST_PATH "[name='eth%zu']/enabled", i);
+                SRPC_SAFE_CALL_ERR(error, sr_set_item_str(session, path, "false", NULL, 0), error_out);
+                break;
+            case 1:
+                // modify a single leaf
+                snprintf(path, sizeof(path), BENCH_LIST_PATH "[name='eth%zu']/mtu", i);
+                snprintf(value, sizeof(value), "%zu", 1000 + (round + i) % 8000);
+                SRPC_SAFE_CALL_ERR(error, sr_set_item_str(session, path, value, NULL, 0), error_out);
+                break;
+            default:
+                // delete the entry
+                SRPC_SAFE_CALL_ERR(error, sr_delete_item(session, path, 0), error_out);
+                break;
+        }
+    }
+
+    start = bench_now_ns();
+    SRPC_SAFE_CALL_ERR(error, sr_apply_changes(session, 0), error_out);
+    SRPC_SAFE_CALL_ERR(error, bench_samples_add(&ctx->commits, bench_now_ns() - start), error_out);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Append a sample.
+ *
+ * @param samples Samples array.
+ * @param value Sample to append.
+ *
+ * @return Error code - 0 on success.
+ */
+static int bench_samples_add(bench_samples_t *samples, uint64_t value)
+{
+    uint64_t *values = NULL;
+
+    if (samples->count == samples->size)
+    {
+        size_t size = samples->size ? samples->size * 2 : 1024;
+
+        values = realloc(samples->values, size * sizeof(*values));
+        if (!values)
+        {
+            return -1;
+        }
+
+        samples->values = values;
+        samples->size = size;
+    }
+
+    samples->values[samples->count++] = value;
+
+    return 0;
+}
+
+/**
+ * Sort the samples and print their percentiles.
+ *
+ * @param name Name of the measured value.
+ * @param samples Samples in nanoseconds.
+ * @param unit Number of nanoseconds in the printed unit.
+ * @param unit_name Name of the printed unit.
+ *
+ */
+static void bench_samples_report(const char *name, bench_samples_t *samples, double unit, const char *unit_name)
+{
+    const double percentiles[] = {0.5, 0.9, 0.99};
+
+    if (!samples->count)
+    {
+        printf("%s: no samples\n", name);
+        return;
+    }
+
+    qsort(samples->values, samples->count, sizeof(*samples->values), bench_uint64_cmp);
+
+    printf("%s (%s):", name, unit_name);
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++)
+    {
+        size_t idx = (size_t)(percentiles[i] * (double)(samples->count - 1));
+        printf(" p%g %.3f", percentiles[i] * 100, (double)samples->values[idx] / unit);
+    }
+    printf(" max %.3f\n", (double)samples->values[samples->count - 1] / unit);
+}
+
+/**
+ * Compare two samples for qsort().
+ *
+ * @param a First sample.
+ * @param b Second sample.
+ *
+ * @return Comparison result.
+ */
+static int bench_uint64_cmp(const void *a, const void *b)
+{
+    uint64_t va = *(const uint64_t *)a;
+    uint64_t vb = *(const uint64_t *)b;
+
+    return (va > vb) - (va < vb);
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in nanoseconds.
+ */
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Remove shared memory files left by the private sysrepo instance.
+ *
+ * @param prefix Shared memory prefix.
+ *
+ */
+static void bench_cleanup_shm(const char *prefix)
+{
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    char path[512] = {0};
+    size_t prefix_len = strlen(prefix);
+
+    dir = opendir("/dev/shm");
+    if (!dir)
+    {
+        return;
+    }
+
+    while ((entry = readdir(dir)))
+    {
+        if (!strncmp(entry->d_name, prefix, prefix_len))
+        {
+            snprintf(path, sizeof(path), "/dev/shm/%s", entry->d_name);
+            unlink(path);
+        }
+    }
+
+    closedir(dir);
+}
+
+/**
+ * Remove a single file of the private repository - nftw() callback.
+ *
+ * @param path File path.
+ * @param st File status.
+ * @param flag Type of the file.
+ * @param ftw Position in the tree.
+ *
+ * @return Always 0 to continue the walk.
+ */
+static int bench_remove_cb(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    remove(path);
+
+    return 0;
+}
@@ -23,5 +23,24 @@
 #include <srpc/common.h>
 #include <srpc/feature_status.h>
 #include <srpc/ly_tree.h>
+#include <srpc/startup_store.h>
+#include <srpc/check.h>
+#include <srpc/oper_cache.h>
+#include <srpc/collector.h>
+#include <srpc/xpath_filter.h>
+#include <srpc/file_reader.h>
+#include <srpc/debounce.h>
+#include <srpc/txn_cache.h>
+#include <srpc/change_set.h>
+#include <srpc/snapshot.h>
+#include <srpc/intern.h>
+#include <srpc/edit_buffer.h>
+#include <srpc/mem_account.h>
+#include <srpc/file_writer.h>
+#include <srpc/shm_cache.h>
+#include <srpc/notif_sender.h>
+#include <srpc/session_pool.h>
+#include <srpc/backup_store.h>
+#include <srpc/change_journal.h>
 
 #endif // SRPC_H
\ No newline at end of file
@@ -0,0 +1,952 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "backup_store.h"
+#include "common.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/fs.h>
+
+#include <sysrepo.h>
+
+// Size of the buffers used for hashing and comparing file content.
+#define BACKUP_STORE_BUFFER_SIZE 65536
+
+// Maximal length of a blob or generation file name.
+#define BACKUP_STORE_NAME_SIZE 64
+
+// Number of alternative names tried for blobs whose content hash collides.
+#define BACKUP_STORE_MAX_PROBES 16
+
+// Age after which temporary files are considered left over by an interrupted backup.
+#define BACKUP_STORE_TMP_GRACE_S 3600
+
+// Prefix of temporary copies in the blobs directory.
+#define BACKUP_STORE_TMP_PREFIX "tmp."
+
+// FNV-1a 64-bit offset basis and prime.
+#define BACKUP_STORE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define BACKUP_STORE_FNV_PRIME 0x100000001b3ULL
+
+/**
+ * Backup store - directories of the blobs and of the generations of each path.
+ */
+struct srpc_backup_store_s
+{
+    char *root;         ///< Directory of the store.
+    int root_fd;        ///< Descriptor of the store directory.
+    int blobs_fd;       ///< Descriptor of the blobs directory.
+    int generations_fd; ///< Descriptor of the directory with a generations directory per path.
+    size_t retention;   ///< Generations kept per path, 0 for all.
+    uint64_t tmp_count; ///< Counter for unique temporary file names.
+};
+
+static int backup_store_lock(srpc_backup_store_t *store);
+static void backup_store_unlock(srpc_backup_store_t *store);
+static int backup_store_collect(srpc_backup_store_t *store);
+static int backup_store_open_dir(int parent_fd, const char *name, bool create);
+static int backup_store_path_dir(srpc_backup_store_t *store, const char *path, bool create);
+static int backup_store_list(int dir_fd, uint64_t **generations, size_t *generations_count);
+static int backup_store_blob(srpc_backup_store_t *store, int fd, const struct stat *st, char *name);
+static int backup_store_link_blob(srpc_backup_store_t *store, int fd, const char *tmp_name, mode_t mode,
+                                  char *name);
+static int backup_store_prune(int dir_fd, const uint64_t *generations, size_t generations_count, size_t retention);
+static int backup_store_hash(int fd, uint64_t *hash);
+static int backup_store_equal(int fd1, int fd2);
+static int backup_store_copy(int src_fd, int dst_fd, off_t size);
+static int backup_store_compare_generations(const void *g1, const void *g2);
+
+/**
+ * Open a backup store - replaces srpc_copy_file() backups taken before applying changes to system files. File content
+ * is stored once per unique content and mode in the blobs directory of the store, reflinked from the original where
+ * the filesystem supports it. Each backup of a path is a numbered generation hard linked to its blob - a backup of
+ * unchanged content doesn't create a new generation. The store handle is not thread safe - use one store per thread.
+ * Backups and garbage collections of all stores on the same directory, also in other processes, are serialized by a
+ * lock on the store directory.
+ *
+ * @param root Directory of the store - created if it doesn't exist, its parent has to exist.
+ * @param retention Number of generations kept per path - older generations are removed, 0 to keep all.
+ *
+ * @return New backup store, NULL on error.
+ */
+srpc_backup_store_t *srpc_backup_store_new(const char *root, size_t retention)
+{
+    srpc_backup_store_t *store = NULL;
+
+    SRPC_SAFE_CALL_PTR(store, calloc(1, sizeof(*store)), error_out);
+
+    store->root_fd = store->blobs_fd = store->generations_fd = -1;
+    store->retention = retention;
+
+    SRPC_SAFE_CALL_PTR(store->root, strdup(root), error_out);
+
+    if (mkdir(root, 0700) && errno != EEXIST)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to create backup store \"%s\" (%s)", root, strerror(errno));
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR_COND(store->root_fd, store->root_fd == -1, open(root, O_RDONLY | O_DIRECTORY | O_CLOEXEC),
+                            error_out);
+    SRPC_SAFE_CALL_ERR_COND(store->blobs_fd, store->blobs_fd == -1,
+                            backup_store_open_dir(store->root_fd, "blobs", true), error_out);
+    SRPC_SAFE_CALL_ERR_COND(store->generations_fd, store->generations_fd == -1,
+                            backup_store_open_dir(store->root_fd, "generations", true), error_out);
+
+    return store;
+
+error_out:
+    srpc_backup_store_free(&store);
+    return NULL;
+}
+
+/**
+ * Back up a file.
+ *
+ * @param store Backup store.
+ * @param path Path of the file.
+ * @param generation Generation holding the content output - an existing one if the content didn't change since the
+ * last backup, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_backup_store_backup(srpc_backup_store_t *store, const char *path, uint64_t *generation)
+{
+    int error = 0;
+    int fd = -1;
+    int dir_fd = -1;
+    struct stat st = {0};
+    struct stat blob_st = {0};
+    struct stat latest_st = {0};
+    char name[BACKUP_STORE_NAME_SIZE] = {0};
+    char generation_name[BACKUP_STORE_NAME_SIZE] = {0};
+    uint64_t *generations = NULL;
+    size_t generations_count = 0;
+    uint64_t next = 1;
+    bool locked = false;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to open \"%s\" for backup (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, fstat(fd, &st), error_out);
+
+    // a blob without generations is garbage until its generation is linked - keep the collection out meanwhile
+    SRPC_SAFE_CALL_ERR(error, backup_store_lock(store), error_out);
+    locked = true;
+
+    SRPC_SAFE_CALL_ERR(error, backup_store_blob(store, fd, &st, name), error_out);
+    SRPC_SAFE_CALL_ERR(error, fstatat(store->blobs_fd, name, &blob_st, 0), error_out);
+
+    SRPC_SAFE_CALL_ERR_COND(dir_fd, dir_fd == -1, backup_store_path_dir(store, path, true), error_out);
+    SRPC_SAFE_CALL_ERR(error, backup_store_list(dir_fd, &generations, &generations_count), error_out);
+
+    if (generations_count)
+    {
+        // unchanged content - the latest generation is a link to the same blob
+        snprintf(generation_name, sizeof(generation_name), "%020" PRIu64, generations[generations_count - 1]);
+        if (!fstatat(dir_fd, generation_name, &latest_st, 0) && latest_st.st_ino == blob_st.st_ino &&
+            latest_st.st_dev == blob_st.st_dev)
+        {
+            next = generations[generations_count - 1];
+            goto out;
+        }
+
+        next = generations[generations_count - 1] + 1;
+    }
+
+    snprintf(generation_name, sizeof(generation_name), "%020" PRIu64, next);
+    if (linkat(store->blobs_fd, name, dir_fd, generation_name, 0))
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to link backup of \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    if (store->retention && generations_count + 1 > store->retention)
+    {
+        // the new generation isn't part of the list, so keep one less of the listed ones
+        if (backup_store_prune(dir_fd, generations, generations_count, store->retention - 1) > 0)
+        {
+            backup_store_collect(store);
+        }
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    if (!error && generation)
+    {
+        *generation = next;
+    }
+
+    if (locked)
+    {
+        backup_store_unlock(store);
+    }
+
+    free(generations);
+
+    if (dir_fd != -1)
+    {
+        close(dir_fd);
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return error;
+}
+
+/**
+ * Restore a file from a backup. The content is reflinked or copied next to the file, which is then replaced
+ * atomically.
+ *
+ * @param store Backup store.
+ * @param path Path of the file.
+ * @param generation Generation to restore - 0 for the latest one.
+ *
+ * @return Error code - 0 on success, 1 if the generation doesn't exist.
+ */
+int srpc_backup_store_restore(srpc_backup_store_t *store, const char *path, uint64_t generation)
+{
+    int error = 0;
+    int dir_fd = -1;
+    int src_fd = -1;
+    int dst_fd = -1;
+    struct stat st = {0};
+    char generation_name[BACKUP_STORE_NAME_SIZE] = {0};
+    char *tmp_path = NULL;
+    uint64_t *generations = NULL;
+    size_t generations_count = 0;
+
+    dir_fd = backup_store_path_dir(store, path, false);
+    if (dir_fd == -1)
+    {
+        error = errno == ENOENT ? 1 : -1;
+        goto out;
+    }
+
+    if (!generation)
+    {
+        SRPC_SAFE_CALL_ERR(error, backup_store_list(dir_fd, &generations, &generations_count), error_out);
+        if (!generations_count)
+        {
+            error = 1;
+            goto out;
+        }
+        generation = generations[generations_count - 1];
+    }
+
+    snprintf(generation_name, sizeof(generation_name), "%020" PRIu64, generation);
+    src_fd = openat(dir_fd, generation_name, O_RDONLY | O_CLOEXEC);
+    if (src_fd == -1)
+    {
+        error = errno == ENOENT ? 1 : -1;
+        goto out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, fstat(src_fd, &st), error_out);
+
+    SRPC_SAFE_CALL_PTR(tmp_path, malloc(strlen(path) + sizeof(".srpc-restore")), error_out);
+    sprintf(tmp_path, "%s.srpc-restore", path);
+
+    SRPC_SAFE_CALL_ERR_COND(dst_fd, dst_fd == -1,
+                            open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 07777), error_out);
+    SRPC_SAFE_CALL_ERR(error, backup_store_copy(src_fd, dst_fd, st.st_size), error_out);
+    SRPC_SAFE_CALL_ERR(error, fchmod(dst_fd, st.st_mode & 07777), error_out);
+    SRPC_SAFE_CALL_ERR(error, fsync(dst_fd), error_out);
+
+    close(dst_fd);
+    dst_fd = -1;
+
+    SRPC_SAFE_CALL_ERR(error, rename(tmp_path, path), error_out);
+
+    goto out;
+
+error_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to restore \"%s\" from generation %" PRIu64, path, generation);
+    if (dst_fd != -1)
+    {
+        close(dst_fd);
+        dst_fd = -1;
+    }
+    if (tmp_path)
+    {
+        unlink(tmp_path);
+    }
+    error = -1;
+
+out:
+    free(tmp_path);
+    free(generations);
+
+    if (src_fd != -1)
+    {
+        close(src_fd);
+    }
+
+    if (dir_fd != -1)
+    {
+        close(dir_fd);
+    }
+
+    return error;
+}
+
+/**
+ * Get the available generations of a path.
+ *
+ * @param store Backup store.
+ * @param path Path of the file.
+ * @param generations Generations in ascending order output - free using free(), NULL if there are none.
+ * @param generations_count Number of generations output.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_backup_store_generations(srpc_backup_store_t *store, const char *path, uint64_t **generations,
+                                  size_t *generations_count)
+{
+    int error = 0;
+    int dir_fd = -1;
+
+    *generations = NULL;
+    *generations_count = 0;
+
+    dir_fd = backup_store_path_dir(store, path, false);
+    if (dir_fd == -1)
+    {
+        // never backed up
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    error = backup_store_list(dir_fd, generations, generations_count);
+
+    close(dir_fd);
+
+    return error;
+}
+
+/**
+ * Remove blobs which aren't referenced by any generation and temporary files left over by interrupted backups. Done
+ * automatically after generations were removed due to the retention.
+ *
+ * @param store Backup store.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_backup_store_gc(srpc_backup_store_t *store)
+{
+    int error = 0;
+
+    SRPC_SAFE_CALL_ERR(error, backup_store_lock(store), out);
+
+    error = backup_store_collect(store);
+
+    backup_store_unlock(store);
+
+out:
+    return error;
+}
+
+/**
+ * Free the backup store handle - the stored backups are kept.
+ *
+ * @param store Backup store.
+ *
+ */
+void srpc_backup_store_free(srpc_backup_store_t **store)
+{
+    srpc_backup_store_t *s = *store;
+
+    if (!s)
+    {
+        return;
+    }
+
+    if (s->generations_fd != -1)
+    {
+        close(s->generations_fd);
+    }
+
+    if (s->blobs_fd != -1)
+    {
+        close(s->blobs_fd);
+    }
+
+    if (s->root_fd != -1)
+    {
+        close(s->root_fd);
+    }
+
+    free(s->root);
+    free(s);
+
+    *store = NULL;
+}
+
+/**
+ * Lock the store directory - serializes the backups and garbage collections of all stores on the directory.
+ *
+ * @param store Backup store.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_lock(srpc_backup_store_t *store)
+{
+    while (flock(store->root_fd, LOCK_EX))
+    {
+        if (errno != EINTR)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to lock backup store \"%s\" (%s)", store->root, strerror(errno));
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Unlock the store directory.
+ *
+ * @param store Backup store.
+ *
+ */
+static void backup_store_unlock(srpc_backup_store_t *store)
+{
+    flock(store->root_fd, LOCK_UN);
+}
+
+/**
+ * Remove unreferenced blobs and old temporary files - the store has to be locked.
+ *
+ * @param store Backup store.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_collect(srpc_backup_store_t *store)
+{
+    int error = 0;
+    int fd = -1;
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    struct stat st = {0};
+    time_t now = time(NULL);
+    bool tmp = false;
+
+    SRPC_SAFE_CALL_ERR_COND(fd, fd == -1, openat(store->blobs_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC), error_out);
+    SRPC_SAFE_CALL_PTR(dir, fdopendir(fd), error_out);
+    fd = -1;
+
+    while ((entry = readdir(dir)))
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        if (fstatat(store->blobs_fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) || !S_ISREG(st.st_mode))
+        {
+            continue;
+        }
+
+        // the blob itself is the only link left - temporary files of interrupted backups only after a grace period,
+        // so a copy in progress isn't removed even where the lock isn't effective, for example on network filesystems
+        tmp = !strncmp(entry->d_name, BACKUP_STORE_TMP_PREFIX, strlen(BACKUP_STORE_TMP_PREFIX));
+        if (tmp ? now - st.st_mtime > BACKUP_STORE_TMP_GRACE_S : st.st_nlink == 1)
+        {
+            if (unlinkat(store->blobs_fd, entry->d_name, 0))
+            {
+                SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to remove blob %s (%s)", entry->d_name, strerror(errno));
+                error = -1;
+            }
+        }
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    if (dir)
+    {
+        closedir(dir);
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return error;
+}
+
+/**
+ * Open a directory, optionally creating it.
+ *
+ * @param parent_fd Descriptor of the parent directory.
+ * @param name Name of the directory.
+ * @param create Create the directory if it doesn't exist.
+ *
+ * @return Directory descriptor, -1 on error with errno set.
+ */
+static int backup_store_open_dir(int parent_fd, const char *name, bool create)
+{
+    if (create && mkdirat(parent_fd, name, 0700) && errno != EEXIST)
+    {
+        return -1;
+    }
+
+    return openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+/**
+ * Open the generations directory of a path. The directory name is the path with '%' and '/' escaped.
+ *
+ * @param store Backup store.
+ * @param path Path of the backed up file.
+ * @param create Create the directory if it doesn't exist.
+ *
+ * @return Directory descriptor, -1 on error with errno set.
+ */
+static int backup_store_path_dir(srpc_backup_store_t *store, const char *path, bool create)
+{
+    char *name = NULL;
+    char *iter = NULL;
+    int dir_fd = -1;
+
+    name = malloc(strlen(path) * 3 + 1);
+    if (!name)
+    {
+        return -1;
+    }
+
+    iter = name;
+    for (const char *c = path; *c; c++)
+    {
+        if (*c == '%' || *c == '/')
+        {
+            iter += sprintf(iter, "%%%02X", (unsigned char)*c);
+        }
+        else
+        {
+            *iter++ = *c;
+        }
+    }
+    *iter = 0;
+
+    dir_fd = backup_store_open_dir(store->generations_fd, name, create);
+
+    free(name);
+
+    return dir_fd;
+}
+
+/**
+ * List the generations in a generations directory.
+ *
+ * @param dir_fd Descriptor of the generations directory.
+ * @param generations Generations in ascending order output, NULL if there are none.
+ * @param generations_count Number of generations output.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_list(int dir_fd, uint64_t **generations, size_t *generations_count)
+{
+    int error = 0;
+    int fd = -1;
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    uint64_t *list = NULL;
+    uint64_t *tmp = NULL;
+    size_t count = 0, size = 0;
+    char *end = NULL;
+    uint64_t generation = 0;
+
+    // own descriptor - the directory stream takes it over and has its own position
+    SRPC_SAFE_CALL_ERR_COND(fd, fd == -1, openat(dir_fd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC), error_out);
+    SRPC_SAFE_CALL_PTR(dir, fdopendir(fd), error_out);
+    fd = -1;
+
+    while ((entry = readdir(dir)))
+    {
+        generation = strtoull(entry->d_name, &end, 10);
+        if (entry->d_name[0] == '.' || *end || !generation)
+        {
+            continue;
+        }
+
+        if (count == size)
+        {
+            size = size ? size * 2 : 8;
+            SRPC_SAFE_CALL_PTR(tmp, realloc(list, size * sizeof(*list)), error_out);
+            list = tmp;
+        }
+
+        list[count++] = generation;
+    }
+
+    if (count)
+    {
+        qsort(list, count, sizeof(*list), backup_store_compare_generations);
+    }
+
+    *generations = list;
+    *generations_count = count;
+    list = NULL;
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    free(list);
+
+    if (dir)
+    {
+        closedir(dir);
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return error;
+}
+
+/**
+ * Find or create the blob holding the content of a file. An existing blob with the same content hash and mode is
+ * compared with the file and reused without writing anything.
+ *
+ * @param store Backup store.
+ * @param fd Descriptor of the file.
+ * @param st Status of the file.
+ * @param name Name of the blob output - BACKUP_STORE_NAME_SIZE bytes.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_blob(srpc_backup_store_t *store, int fd, const struct stat *st, char *name)
+{
+    int error = 0;
+    int blob_fd = -1;
+    int tmp_fd = -1;
+    uint64_t hash = 0;
+    char tmp_name[BACKUP_STORE_NAME_SIZE] = {0};
+
+    SRPC_SAFE_CALL_ERR(error, backup_store_hash(fd, &hash), error_out);
+
+    snprintf(name, BACKUP_STORE_NAME_SIZE, "%016" PRIx64 "-%04o", hash, (unsigned int)(st->st_mode & 07777));
+
+    blob_fd = openat(store->blobs_fd, name, O_RDONLY | O_CLOEXEC);
+    if (blob_fd != -1)
+    {
+        error = backup_store_equal(fd, blob_fd);
+        close(blob_fd);
+        if (error == 1)
+        {
+            return 0;
+        }
+    }
+
+    // the copy is hashed again and named after its own content, the file could have changed meanwhile
+    snprintf(tmp_name, sizeof(tmp_name), BACKUP_STORE_TMP_PREFIX "%d.%" PRIu64, (int)getpid(), ++store->tmp_count);
+    SRPC_SAFE_CALL_ERR_COND(tmp_fd, tmp_fd == -1,
+                            openat(store->blobs_fd, tmp_name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600), error_out);
+    SRPC_SAFE_CALL_ERR(error, backup_store_copy(fd, tmp_fd, st->st_size), error_out);
+    SRPC_SAFE_CALL_ERR(error, fchmod(tmp_fd, st->st_mode & 07777), error_out);
+    SRPC_SAFE_CALL_ERR(error, fsync(tmp_fd), error_out);
+    SRPC_SAFE_CALL_ERR(error, backup_store_link_blob(store, tmp_fd, tmp_name, st->st_mode, name), error_out);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    if (tmp_fd != -1)
+    {
+        close(tmp_fd);
+        unlinkat(store->blobs_fd, tmp_name, 0);
+    }
+
+    return error;
+}
+
+/**
+ * Link a temporary copy as the blob of its content. If a blob of the same name exists with different content, the
+ * next free alternative name is used.
+ *
+ * @param store Backup store.
+ * @param fd Descriptor of the temporary copy.
+ * @param tmp_name Name of the temporary copy in the blobs directory.
+ * @param mode Mode of the copied file.
+ * @param name Name of the blob output - BACKUP_STORE_NAME_SIZE bytes.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_link_blob(srpc_backup_store_t *store, int fd, const char *tmp_name, mode_t mode,
+                                  char *name)
+{
+    int blob_fd = -1;
+    int equal = 0;
+    uint64_t hash = 0;
+
+    if (backup_store_hash(fd, &hash))
+    {
+        return -1;
+    }
+
+    for (int probe = 0; probe < BACKUP_STORE_MAX_PROBES; probe++)
+    {
+        if (probe)
+        {
+            snprintf(name, BACKUP_STORE_NAME_SIZE, "%016" PRIx64 "-%04o.%d", hash, (unsigned int)(mode & 07777),
+                     probe);
+        }
+        else
+        {
+            snprintf(name, BACKUP_STORE_NAME_SIZE, "%016" PRIx64 "-%04o", hash, (unsigned int)(mode & 07777));
+        }
+
+        if (!linkat(store->blobs_fd, tmp_name, store->blobs_fd, name, 0))
+        {
+            return 0;
+        }
+
+        if (errno != EEXIST)
+        {
+            return -1;
+        }
+
+        blob_fd = openat(store->blobs_fd, name, O_RDONLY | O_CLOEXEC);
+        if (blob_fd == -1)
+        {
+            return -1;
+        }
+
+        equal = backup_store_equal(fd, blob_fd);
+        close(blob_fd);
+
+        if (equal)
+        {
+            return equal == 1 ? 0 : -1;
+        }
+    }
+
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Too many backup blobs with content hash %016" PRIx64, hash);
+
+    return -1;
+}
+
+/**
+ * Remove the oldest generations beyond the retention.
+ *
+ * @param dir_fd Descriptor of the generations directory.
+ * @param generations Generations in ascending order.
+ * @param generations_count Number of generations.
+ * @param retention Number of generations to keep.
+ *
+ * @return Number of removed generations, -1 on error.
+ */
+static int backup_store_prune(int dir_fd, const uint64_t *generations, size_t generations_count, size_t retention)
+{
+    int removed = 0;
+    char generation_name[BACKUP_STORE_NAME_SIZE] = {0};
+
+    for (size_t i = 0; i + retention < generations_count; i++)
+    {
+        snprintf(generation_name, sizeof(generation_name), "%020" PRIu64, generations[i]);
+        if (unlinkat(dir_fd, generation_name, 0) && errno != ENOENT)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to remove backup generation %" PRIu64 " (%s)", generations[i],
+                          strerror(errno));
+            return -1;
+        }
+        removed++;
+    }
+
+    return removed;
+}
+
+/**
+ * Compute the FNV-1a hash of the whole file content.
+ *
+ * @param fd File descriptor - the file position isn't changed.
+ * @param hash Hash output.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_hash(int fd, uint64_t *hash)
+{
+    unsigned char buffer[BACKUP_STORE_BUFFER_SIZE];
+    ssize_t rc = 0;
+    off_t offset = 0;
+    uint64_t value = BACKUP_STORE_FNV_OFFSET;
+
+    while ((rc = pread(fd, buffer, sizeof(buffer), offset)) != 0)
+    {
+        if (rc == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        for (ssize_t i = 0; i < rc; i++)
+        {
+            value ^= buffer[i];
+            value *= BACKUP_STORE_FNV_PRIME;
+        }
+
+        offset += rc;
+    }
+
+    *hash = value;
+
+    return 0;
+}
+
+/**
+ * Compare the content of two files.
+ *
+ * @param fd1 First file descriptor - the file position isn't changed.
+ * @param fd2 Second file descriptor - the file position isn't changed.
+ *
+ * @return 1 if the content is equal, 0 if it differs, -1 on error.
+ */
+static int backup_store_equal(int fd1, int fd2)
+{
+    unsigned char buffer1[BACKUP_STORE_BUFFER_SIZE];
+    unsigned char buffer2[BACKUP_STORE_BUFFER_SIZE];
+    struct stat st1 = {0}, st2 = {0};
+    ssize_t rc1 = 0, rc2 = 0;
+    off_t offset = 0;
+
+    if (fstat(fd1, &st1) || fstat(fd2, &st2))
+    {
+        return -1;
+    }
+
+    if (st1.st_size != st2.st_size)
+    {
+        return 0;
+    }
+
+    while (offset < st1.st_size)
+    {
+        rc1 = pread(fd1, buffer1, sizeof(buffer1), offset);
+        rc2 = pread(fd2, buffer2, (size_t)(rc1 > 0 ? rc1 : 1), offset);
+        if (rc1 <= 0 || rc2 != rc1)
+        {
+            return rc1 == -1 || rc2 == -1 ? -1 : 0;
+        }
+
+        if (memcmp(buffer1, buffer2, (size_t)rc1))
+        {
+            return 0;
+        }
+
+        offset += rc1;
+    }
+
+    return 1;
+}
+
+/**
+ * Copy the file content - reflinked if the filesystem supports it, copied otherwise.
+ *
+ * @param src_fd Source file descriptor.
+ * @param dst_fd Destination file descriptor, empty.
+ * @param size Size of the source file.
+ *
+ * @return Error code - 0 on success.
+ */
+static int backup_store_copy(int src_fd, int dst_fd, off_t size)
+{
+    off_t offset = 0;
+    ssize_t rc = 0;
+
+#ifdef FICLONE
+    // shares the extents on copy on write filesystems like btrfs or XFS, nothing is copied
+    if (!ioctl(dst_fd, FICLONE, src_fd))
+    {
+        return 0;
+    }
+#endif
+
+    while (offset < size)
+    {
+        rc = sendfile(dst_fd, src_fd, &offset, (size_t)(size - offset));
+        if (rc == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        if (!rc)
+        {
+            // the file was truncated meanwhile
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Compare two generations for sorting.
+ *
+ * @param g1 First generation.
+ * @param g2 Second generation.
+ *
+ * @return Negative, zero or positive value as for qsort().
+ */
+static int backup_store_compare_generations(const void *g1, const void *g2)
+{
+    const uint64_t a = *(const uint64_t *)g1;
+    const uint64_t b = *(const uint64_t *)g2;
+
+    return (a > b) - (a < b);
+}
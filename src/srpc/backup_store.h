@@ -0,0 +1,98 @@
+/**
+ * @file backup_store.h
+ * @brief API for deduplicated backups of system files.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_BACKUP_STORE_H
+#define SRPC_BACKUP_STORE_H
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Open a backup store - replaces srpc_copy_file() backups taken before applying changes to system files. File content
+ * is stored once per unique content and mode in the blobs directory of the store, reflinked from the original where
+ * the filesystem supports it. Each backup of a path is a numbered generation hard linked to its blob - a backup of
+ * unchanged content doesn't create a new generation. The store handle is not thread safe - use one store per thread.
+ * Backups and garbage collections of all stores on the same directory, also in other processes, are serialized by a
+ * lock on the store directory.
+ *
+ * @param root Directory of the store - created if it doesn't exist, its parent has to exist.
+ * @param retention Number of generations kept per path - older generations are removed, 0 to keep all.
+ *
+ * @return New backup store, NULL on error.
+ */
+srpc_backup_store_t *srpc_backup_store_new(const char *root, size_t retention);
+
+/**
+ * Back up a file.
+ *
+ * @param store Backup store.
+ * @param path Path of the file.
+ * @param generation Generation holding the content output - an existing one if the content didn't change since the
+ * last backup, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_backup_store_backup(srpc_backup_store_t *store, const char *path, uint64_t *generation);
+
+/**
+ * Restore a file from a backup. The content is reflinked or copied next to the file, which is then replaced
+ * atomically.
+ *
+ * @param store Backup store.
+ * @param path Path of the file.
+ * @param generation Generation to restore - 0 for the latest one.
+ *
+ * @return Error code - 0 on success, 1 if the generation doesn't exist.
+ */
+int srpc_backup_store_restore(srpc_backup_store_t *store, const char *path, uint64_t generation);
+
+/**
+ * Get the available generations of a path.
+ *
+ * @param store Backup store.
+ * @param path Path of the file.
+ * @param generations Generations in ascending order output - free using free(), NULL if there are none.
+ * @param generations_count Number of generations output.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_backup_store_generations(srpc_backup_store_t *store, const char *path, uint64_t **generations,
+                                  size_t *generations_count);
+
+/**
+ * Remove blobs which aren't referenced by any generation and temporary files left over by interrupted backups. Done
+ * automatically after generations were removed due to the retention.
+ *
+ * @param store Backup store.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_backup_store_gc(srpc_backup_store_t *store);
+
+/**
+ * Free the backup store handle - the stored backups are kept.
+ *
+ * @param store Backup store.
+ *
+ */
+void srpc_backup_store_free(srpc_backup_store_t **store);
+
+#endif // SRPC_BACKUP_STORE_H
@@ -0,0 +1,935 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "change_journal.h"
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+// Journal file magic - identifies the file and the format.
+#define CHANGE_JOURNAL_MAGIC "SRPCJRN"
+
+// Journal format version - increment on changes of the record layout.
+#define CHANGE_JOURNAL_VERSION 1
+
+// Record type of a batch - the only record type so far.
+#define CHANGE_JOURNAL_RECORD_BATCH 1
+
+// Change flags.
+#define CHANGE_JOURNAL_PREVIOUS_DEFAULT 0x01 ///< Previous value was a default value.
+#define CHANGE_JOURNAL_DEFAULT 0x02          ///< Changed node is a default node.
+#define CHANGE_JOURNAL_KEY 0x04              ///< Changed node is a list key.
+#define CHANGE_JOURNAL_VALUE 0x08            ///< Value is recorded.
+#define CHANGE_JOURNAL_PREVIOUS_VALUE 0x10   ///< Previous value is recorded.
+#define CHANGE_JOURNAL_PREVIOUS_LIST 0x20    ///< Previous list keys predicate is recorded.
+
+// Maximal size of an encoded integer.
+#define CHANGE_JOURNAL_VARINT_SIZE 10
+
+typedef struct srpc_change_journal_header_s srpc_change_journal_header_t;
+typedef struct srpc_change_journal_buffer_s srpc_change_journal_buffer_t;
+typedef struct srpc_change_journal_cursor_s srpc_change_journal_cursor_t;
+
+/**
+ * Journal file header, followed by the batch records.
+ * Batch record - type byte, time since the journal start, number of changes, size of the changes and the xpath.
+ * Change - time since the batch start, time spent in the callback, operation, flags, node path and the recorded
+ * values. Numbers are LEB128 encoded, strings are length prefixed and null terminated.
+ */
+struct srpc_change_journal_header_s
+{
+    char magic[8];          ///< CHANGE_JOURNAL_MAGIC.
+    uint32_t version;       ///< CHANGE_JOURNAL_VERSION.
+    uint32_t reserved;      ///< Reserved, zero.
+    uint64_t start_time_us; ///< Wall clock time of the journal start.
+};
+
+/**
+ * Growing buffer for encoding records.
+ */
+struct srpc_change_journal_buffer_s
+{
+    uint8_t *data; ///< Encoded data.
+    size_t len;    ///< Length of the encoded data.
+    size_t size;   ///< Allocated size.
+    bool failed;   ///< An allocation failed - the content is incomplete.
+};
+
+/**
+ * Position in the mapped journal while decoding.
+ */
+struct srpc_change_journal_cursor_s
+{
+    const uint8_t *data; ///< Journal data.
+    size_t end;          ///< End of the decoded range.
+    size_t pos;          ///< Current position.
+};
+
+/**
+ * Batch being recorded - the changes of a single iteration.
+ */
+struct srpc_change_journal_batch_s
+{
+    char *xpath;                          ///< XPath of the iteration.
+    uint64_t epoch;                       ///< Journal the batch belongs to.
+    uint64_t begin_us;                    ///< Start of the batch on the monotonic clock.
+    uint64_t count;                       ///< Number of recorded changes.
+    srpc_change_journal_buffer_t changes; ///< Encoded changes.
+};
+
+// Lock for the journal state.
+static pthread_mutex_t change_journal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Descriptor of the journal being recorded, -1 if not recording.
+static int change_journal_fd = -1;
+
+// Start of the journal on the monotonic clock.
+static uint64_t change_journal_start_us = 0;
+
+// Incremented on each journal start - batches of a stopped journal are dropped.
+static uint64_t change_journal_epoch = 0;
+
+// Set while recording - checked without the lock, so iterations aren't serialized when not recording.
+static int change_journal_active = 0;
+
+static void change_journal_record(srpc_change_journal_batch_t *batch, const srpc_change_ctx_t *change_ctx,
+                                  uint64_t offset_us, uint64_t callback_us);
+static int change_journal_write(int fd, struct iovec *iov, int iov_count);
+static int change_journal_replay_batch(const struct ly_ctx *ly_ctx, srpc_change_journal_cursor_t *cursor,
+                                       uint64_t count, uint64_t batch_us, bool paced, void *priv,
+                                       sr_session_ctx_t *session, srpc_change_cb cb,
+                                       srpc_change_journal_stats_t *stats);
+static int change_journal_rebuild(const struct ly_ctx *ly_ctx, const char *path, const char *value, uint8_t flags,
+                                  struct lyd_node **tree, const struct lyd_node **node);
+static void change_journal_put(srpc_change_journal_buffer_t *buffer, const void *data, size_t size);
+static void change_journal_put_varint(srpc_change_journal_buffer_t *buffer, uint64_t value);
+static void change_journal_put_string(srpc_change_journal_buffer_t *buffer, const char *string);
+static int change_journal_get_byte(srpc_change_journal_cursor_t *cursor, uint8_t *value);
+static int change_journal_get_varint(srpc_change_journal_cursor_t *cursor, uint64_t *value);
+static int change_journal_get_string(srpc_change_journal_cursor_t *cursor, const char **string);
+static void change_journal_wait(uint64_t until_us);
+static uint64_t change_journal_now_us(void);
+
+/**
+ * Start recording the changes iterated by srpc_iterate_changes() in the whole process. Each iteration is appended to
+ * the journal as a batch with its xpath and time, each change with its operation, node path, value, previous value,
+ * previous list keys, previous default flag, time within the batch and the time spent in the callback.
+ *
+ * @param path Path of the journal - an existing file is overwritten.
+ *
+ * @return Error code - 0 on success, -1 on error or if a journal is already being recorded.
+ */
+int srpc_change_journal_start(const char *path)
+{
+    int error = 0;
+    int fd = -1;
+    srpc_change_journal_header_t header = {.version = CHANGE_JOURNAL_VERSION};
+    struct timespec ts = {0};
+    struct iovec iov = {.iov_base = &header, .iov_len = sizeof(header)};
+
+    memcpy(header.magic, CHANGE_JOURNAL_MAGIC, sizeof(header.magic));
+    clock_gettime(CLOCK_REALTIME, &ts);
+    header.start_time_us = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+
+    pthread_mutex_lock(&change_journal_lock);
+
+    if (change_journal_fd != -1)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Change journal is already being recorded");
+        goto error_out;
+    }
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0600);
+    if (fd == -1)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to open change journal \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, change_journal_write(fd, &iov, 1), error_out);
+
+    change_journal_fd = fd;
+    change_journal_start_us = change_journal_now_us();
+    change_journal_epoch++;
+    __atomic_store_n(&change_journal_active, 1, __ATOMIC_RELEASE);
+
+    goto out;
+
+error_out:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+    error = -1;
+
+out:
+    pthread_mutex_unlock(&change_journal_lock);
+
+    return error;
+}
+
+/**
+ * Stop recording - batches still being iterated are dropped.
+ *
+ */
+void srpc_change_journal_stop(void)
+{
+    pthread_mutex_lock(&change_journal_lock);
+
+    if (change_journal_fd != -1)
+    {
+        close(change_journal_fd);
+        change_journal_fd = -1;
+    }
+
+    __atomic_store_n(&change_journal_active, 0, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&change_journal_lock);
+}
+
+/**
+ * Begin recording a batch of changes - used by srpc_iterate_changes(), custom change iterators can use it the same
+ * way.
+ *
+ * @param xpath XPath the changes are iterated for.
+ *
+ * @return New batch, NULL if no journal is being recorded or on error.
+ */
+srpc_change_journal_batch_t *srpc_change_journal_batch_begin(const char *xpath)
+{
+    srpc_change_journal_batch_t *batch = NULL;
+
+    if (!__atomic_load_n(&change_journal_active, __ATOMIC_ACQUIRE))
+    {
+        return NULL;
+    }
+
+    SRPC_SAFE_CALL_PTR(batch, calloc(1, sizeof(*batch)), error_out);
+    SRPC_SAFE_CALL_PTR(batch->xpath, strdup(xpath ? xpath : ""), error_out);
+
+    pthread_mutex_lock(&change_journal_lock);
+    batch->epoch = change_journal_epoch;
+    pthread_mutex_unlock(&change_journal_lock);
+
+    batch->begin_us = change_journal_now_us();
+
+    return batch;
+
+error_out:
+    srpc_change_journal_batch_end(&batch);
+    return NULL;
+}
+
+/**
+ * Call the change callback and record the change with the time spent in the callback.
+ *
+ * @param batch Batch returned by srpc_change_journal_batch_begin().
+ * @param priv Private user data passed to the callback.
+ * @param session Session passed to the callback.
+ * @param cb Change callback.
+ * @param change_ctx Change to pass to the callback and to record.
+ *
+ * @return Return value of the callback.
+ */
+int srpc_change_journal_batch_call(srpc_change_journal_batch_t *batch, void *priv, sr_session_ctx_t *session,
+                                   srpc_change_cb cb, const srpc_change_ctx_t *change_ctx)
+{
+    int error = 0;
+    uint64_t start_us = change_journal_now_us();
+
+    error = cb(priv, session, change_ctx);
+
+    change_journal_record(batch, change_ctx, start_us - batch->begin_us, change_journal_now_us() - start_us);
+
+    return error;
+}
+
+/**
+ * Append the recorded batch to the journal and free it.
+ *
+ * @param batch Batch returned by srpc_change_journal_batch_begin(), can point to NULL.
+ *
+ */
+void srpc_change_journal_batch_end(srpc_change_journal_batch_t **batch)
+{
+    srpc_change_journal_batch_t *b = *batch;
+    srpc_change_journal_buffer_t header = {0};
+    struct iovec iov[2] = {0};
+    uint8_t type = CHANGE_JOURNAL_RECORD_BATCH;
+
+    if (!b)
+    {
+        return;
+    }
+
+    if (b->xpath && b->count && !b->changes.failed)
+    {
+        pthread_mutex_lock(&change_journal_lock);
+
+        // the journal could have been stopped or replaced since the batch began
+        if (change_journal_fd != -1 && change_journal_epoch == b->epoch)
+        {
+            change_journal_put(&header, &type, sizeof(type));
+            change_journal_put_varint(&header, b->begin_us - change_journal_start_us);
+            change_journal_put_varint(&header, b->count);
+            change_journal_put_varint(&header, b->changes.len);
+            change_journal_put_string(&header, b->xpath);
+
+            if (!header.failed)
+            {
+                iov[0] = (struct iovec){.iov_base = header.data, .iov_len = header.len};
+                iov[1] = (struct iovec){.iov_base = b->changes.data, .iov_len = b->changes.len};
+
+                if (change_journal_write(change_journal_fd, iov, 2))
+                {
+                    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to write change journal (%s)", strerror(errno));
+                }
+            }
+        }
+
+        pthread_mutex_unlock(&change_journal_lock);
+    }
+
+    free(header.data);
+    free(b->changes.data);
+    free(b->xpath);
+    free(b);
+
+    *batch = NULL;
+}
+
+/**
+ * Replay a journal into a change callback. Each batch is replayed like srpc_iterate_changes() iterated it - the init
+ * callback, the change callback for each change and the free callback. The changed nodes are rebuilt from their paths
+ * and values in the given context, each in its own tree which is freed after the callback. A failed callback aborts
+ * its batch and the replay continues with the next batch.
+ *
+ * @param ly_ctx Context with the modules of the recorded changes.
+ * @param path Path of the journal.
+ * @param xpath Replay only the batches recorded for this xpath - NULL for all batches.
+ * @param paced Replay at the recorded pace instead of at full speed.
+ * @param priv Private user data passed to the callbacks.
+ * @param session Session passed to the change callback, can be NULL if the callback doesn't use it.
+ * @param cb Change callback.
+ * @param init_cb Callback for changes data initialization - can be NULL.
+ * @param free_cb Callback for freeing changes data - can be NULL.
+ * @param stats Replay counters output, can be NULL.
+ *
+ * @return Error code - 0 on success, -1 if the journal can't be read or is corrupted.
+ */
+int srpc_change_journal_replay(const struct ly_ctx *ly_ctx, const char *path, const char *xpath, bool paced,
+                               void *priv, sr_session_ctx_t *session, srpc_change_cb cb, srpc_change_init_cb init_cb,
+                               srpc_change_free_cb free_cb, srpc_change_journal_stats_t *stats)
+{
+    int error = 0;
+    int fd = -1;
+    struct stat st = {0};
+    uint8_t *data = MAP_FAILED;
+    const srpc_change_journal_header_t *header = NULL;
+    srpc_change_journal_cursor_t cursor = {0};
+    srpc_change_journal_stats_t replay_stats = {0};
+    uint8_t type = 0;
+    uint64_t timestamp_us = 0, count = 0, size = 0;
+    uint64_t first_us = 0, begin_us = 0;
+    const char *batch_xpath = NULL;
+    size_t batch_end = 0;
+    bool first = true;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to open change journal \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, fstat(fd, &st), error_out);
+
+    if ((size_t)st.st_size < sizeof(*header))
+    {
+        goto corrupted_out;
+    }
+
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to map change journal \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    header = (const srpc_change_journal_header_t *)data;
+    if (memcmp(header->magic, CHANGE_JOURNAL_MAGIC, sizeof(header->magic)) ||
+        header->version != CHANGE_JOURNAL_VERSION)
+    {
+        goto corrupted_out;
+    }
+
+    cursor = (srpc_change_journal_cursor_t){.data = data, .end = (size_t)st.st_size, .pos = sizeof(*header)};
+    begin_us = change_journal_now_us();
+
+    while (cursor.pos < cursor.end)
+    {
+        if (change_journal_get_byte(&cursor, &type) || type != CHANGE_JOURNAL_RECORD_BATCH ||
+            change_journal_get_varint(&cursor, &timestamp_us) || change_journal_get_varint(&cursor, &count) ||
+            change_journal_get_varint(&cursor, &size) || change_journal_get_string(&cursor, &batch_xpath) ||
+            size > cursor.end - cursor.pos)
+        {
+            goto corrupted_out;
+        }
+
+        // decode the changes of the batch only
+        batch_end = cursor.pos + size;
+        cursor.end = batch_end;
+
+        if (!xpath || !strcmp(xpath, batch_xpath))
+        {
+            if (first)
+            {
+                first_us = timestamp_us;
+                first = false;
+            }
+
+            if (paced)
+            {
+                change_journal_wait(begin_us + (timestamp_us - first_us));
+            }
+
+            replay_stats.batches++;
+
+            if (init_cb && init_cb(priv))
+            {
+                replay_stats.failed++;
+            }
+            else
+            {
+                error = change_journal_replay_batch(ly_ctx, &cursor, count,
+                                                    paced ? begin_us + (timestamp_us - first_us) : 0, paced, priv,
+                                                    session, cb, &replay_stats);
+                if (error < 0)
+                {
+                    if (free_cb)
+                    {
+                        free_cb(priv);
+                    }
+                    goto corrupted_out;
+                }
+            }
+
+            if (free_cb)
+            {
+                free_cb(priv);
+            }
+        }
+
+        cursor.pos = batch_end;
+        cursor.end = (size_t)st.st_size;
+    }
+
+    error = 0;
+
+    goto out;
+
+corrupted_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Change journal \"%s\" is corrupted", path);
+
+error_out:
+    error = -1;
+
+out:
+    if (stats)
+    {
+        *stats = replay_stats;
+    }
+
+    if (data != MAP_FAILED)
+    {
+        munmap(data, (size_t)st.st_size);
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return error;
+}
+
+/**
+ * Encode a change into the batch.
+ *
+ * @param batch Batch being recorded.
+ * @param change_ctx Change to record.
+ * @param offset_us Time of the change since the batch start.
+ * @param callback_us Time spent in the callback.
+ *
+ */
+static void change_journal_record(srpc_change_journal_batch_t *batch, const srpc_change_ctx_t *change_ctx,
+                                  uint64_t offset_us, uint64_t callback_us)
+{
+    char *path = NULL;
+    const char *value = NULL;
+    uint8_t operation = (uint8_t)change_ctx->operation;
+    uint8_t flags = 0;
+
+    path = lyd_path(change_ctx->node, LYD_PATH_STD, NULL, 0);
+    if (!path)
+    {
+        batch->changes.failed = true;
+        return;
+    }
+
+    value = lyd_get_value(change_ctx->node);
+
+    if (change_ctx->previous_default)
+    {
+        flags |= CHANGE_JOURNAL_PREVIOUS_DEFAULT;
+    }
+    if (change_ctx->node->flags & LYD_DEFAULT)
+    {
+        flags |= CHANGE_JOURNAL_DEFAULT;
+    }
+    if (lysc_is_key(change_ctx->node->schema))
+    {
+        flags |= CHANGE_JOURNAL_KEY;
+    }
+    if (value)
+    {
+        flags |= CHANGE_JOURNAL_VALUE;
+    }
+    if (change_ctx->previous_value)
+    {
+        flags |= CHANGE_JOURNAL_PREVIOUS_VALUE;
+    }
+    if (change_ctx->previous_list)
+    {
+        flags |= CHANGE_JOURNAL_PREVIOUS_LIST;
+    }
+
+    change_journal_put_varint(&batch->changes, offset_us);
+    change_journal_put_varint(&batch->changes, callback_us);
+    change_journal_put(&batch->changes, &operation, sizeof(operation));
+    change_journal_put(&batch->changes, &flags, sizeof(flags));
+    change_journal_put_string(&batch->changes, path);
+
+    if (value)
+    {
+        change_journal_put_string(&batch->changes, value);
+    }
+    if (change_ctx->previous_value)
+    {
+        change_journal_put_string(&batch->changes, change_ctx->previous_value);
+    }
+    if (change_ctx->previous_list)
+    {
+        change_journal_put_string(&batch->changes, change_ctx->previous_list);
+    }
+
+    batch->count++;
+
+    free(path);
+}
+
+/**
+ * Write all data to the journal.
+ *
+ * @param fd Journal descriptor.
+ * @param iov Data to write - modified on partial writes.
+ * @param iov_count Number of data buffers.
+ *
+ * @return Error code - 0 on success.
+ */
+static int change_journal_write(int fd, struct iovec *iov, int iov_count)
+{
+    ssize_t rc = 0;
+
+    while (iov_count)
+    {
+        rc = writev(fd, iov, iov_count);
+        if (rc == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        // skip the written data
+        while (iov_count && (size_t)rc >= iov->iov_len)
+        {
+            rc -= (ssize_t)iov->iov_len;
+            iov++;
+            iov_count--;
+        }
+
+        if (iov_count)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + rc;
+            iov->iov_len -= (size_t)rc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Replay the changes of a single batch.
+ *
+ * @param ly_ctx Context to rebuild the nodes in.
+ * @param cursor Cursor at the changes of the batch.
+ * @param count Number of changes in the batch.
+ * @param batch_us Replay time of the batch start on the monotonic clock, used if paced.
+ * @param paced Replay at the recorded pace.
+ * @param priv Private user data passed to the callback.
+ * @param session Session passed to the callback.
+ * @param cb Change callback.
+ * @param stats Replay counters.
+ *
+ * @return Error code - 0 on success, 1 if a callback failed, -1 if the batch is corrupted.
+ */
+static int change_journal_replay_batch(const struct ly_ctx *ly_ctx, srpc_change_journal_cursor_t *cursor,
+                                       uint64_t count, uint64_t batch_us, bool paced, void *priv,
+                                       sr_session_ctx_t *session, srpc_change_cb cb,
+                                       srpc_change_journal_stats_t *stats)
+{
+    int error = 0;
+    uint64_t offset_us = 0, recorded_us = 0;
+    uint64_t start_us = 0, callback_us = 0;
+    uint8_t operation = 0, flags = 0;
+    const char *path = NULL;
+    const char *value = NULL;
+    struct lyd_node *tree = NULL;
+    srpc_change_ctx_t change_ctx = {0};
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        value = NULL;
+        change_ctx = (srpc_change_ctx_t){0};
+
+        if (change_journal_get_varint(cursor, &offset_us) || change_journal_get_varint(cursor, &recorded_us) ||
+            change_journal_get_byte(cursor, &operation) || change_journal_get_byte(cursor, &flags) ||
+            change_journal_get_string(cursor, &path) ||
+            ((flags & CHANGE_JOURNAL_VALUE) && change_journal_get_string(cursor, &value)) ||
+            ((flags & CHANGE_JOURNAL_PREVIOUS_VALUE) &&
+             change_journal_get_string(cursor, &change_ctx.previous_value)) ||
+            ((flags & CHANGE_JOURNAL_PREVIOUS_LIST) && change_journal_get_string(cursor, &change_ctx.previous_list)))
+        {
+            return -1;
+        }
+
+        if (change_journal_rebuild(ly_ctx, path, value, flags, &tree, &change_ctx.node))
+        {
+            SRPLG_LOG_WRN(SRPC_PLUGIN_NAME, "Unable to rebuild journal change of %s", path);
+            stats->skipped++;
+            continue;
+        }
+
+        change_ctx.operation = (sr_change_oper_t)operation;
+        change_ctx.previous_default = (flags & CHANGE_JOURNAL_PREVIOUS_DEFAULT) ? 1 : 0;
+
+        if (paced)
+        {
+            change_journal_wait(batch_us + offset_us);
+        }
+
+        start_us = change_journal_now_us();
+        error = cb(priv, session, &change_ctx);
+        callback_us = change_journal_now_us() - start_us;
+
+        lyd_free_all(tree);
+        tree = NULL;
+
+        stats->changes++;
+        stats->callback_us += callback_us;
+        stats->recorded_callback_us += recorded_us;
+        if (callback_us > stats->max_callback_us)
+        {
+            stats->max_callback_us = callback_us;
+        }
+
+        if (error)
+        {
+            // same as srpc_iterate_changes() - the rest of the batch isn't iterated
+            stats->failed++;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Rebuild a changed node in its own tree.
+ *
+ * @param ly_ctx Context to build the node in.
+ * @param path Path of the node.
+ * @param value Value of the node, NULL for inner nodes.
+ * @param flags Recorded change flags.
+ * @param tree Built tree output - free using lyd_free_all().
+ * @param node Rebuilt node output.
+ *
+ * @return Error code - 0 on success.
+ */
+static int change_journal_rebuild(const struct ly_ctx *ly_ctx, const char *path, const char *value, uint8_t flags,
+                                  struct lyd_node **tree, const struct lyd_node **node)
+{
+    int error = 0;
+    char *parent_path = NULL;
+    char *last = NULL;
+    struct lyd_node *found = NULL;
+
+    *tree = NULL;
+
+    if (flags & CHANGE_JOURNAL_KEY)
+    {
+        // keys can't be created on their own - build the list instance, which creates its keys from the predicates
+        SRPC_SAFE_CALL_PTR(parent_path, strdup(path), error_out);
+        last = strrchr(parent_path, '/');
+        if (!last || last == parent_path)
+        {
+            goto error_out;
+        }
+        *last = 0;
+
+        SRPC_SAFE_CALL_ERR(error, lyd_new_path(NULL, ly_ctx, parent_path, NULL, 0, tree), error_out);
+    }
+    else
+    {
+        SRPC_SAFE_CALL_ERR(error, lyd_new_path(NULL, ly_ctx, path, value, 0, tree), error_out);
+    }
+
+    SRPC_SAFE_CALL_ERR(error, lyd_find_path(*tree, path, 0, &found), error_out);
+
+    if (flags & CHANGE_JOURNAL_DEFAULT)
+    {
+        found->flags |= LYD_DEFAULT;
+    }
+
+    *node = found;
+
+    goto out;
+
+error_out:
+    lyd_free_all(*tree);
+    *tree = NULL;
+    error = -1;
+
+out:
+    free(parent_path);
+
+    return error;
+}
+
+/**
+ * Append data to the buffer.
+ *
+ * @param buffer Buffer.
+ * @param data Data to append.
+ * @param size Size of the data.
+ *
+ */
+static void change_journal_put(srpc_change_journal_buffer_t *buffer, const void *data, size_t size)
+{
+    size_t new_size = 0;
+    uint8_t *new_data = NULL;
+
+    if (buffer->failed)
+    {
+        return;
+    }
+
+    if (buffer->len + size > buffer->size)
+    {
+        new_size = buffer->size ? buffer->size : 256;
+        while (new_size < buffer->len + size)
+        {
+            new_size *= 2;
+        }
+
+        new_data = realloc(buffer->data, new_size);
+        if (!new_data)
+        {
+            buffer->failed = true;
+            return;
+        }
+
+        buffer->data = new_data;
+        buffer->size = new_size;
+    }
+
+    memcpy(buffer->data + buffer->len, data, size);
+    buffer->len += size;
+}
+
+/**
+ * Append a LEB128 encoded number to the buffer.
+ *
+ * @param buffer Buffer.
+ * @param value Number to append.
+ *
+ */
+static void change_journal_put_varint(srpc_change_journal_buffer_t *buffer, uint64_t value)
+{
+    uint8_t encoded[CHANGE_JOURNAL_VARINT_SIZE] = {0};
+    size_t len = 0;
+
+    do
+    {
+        encoded[len] = (uint8_t)(value & 0x7f);
+        value >>= 7;
+        if (value)
+        {
+            encoded[len] |= 0x80;
+        }
+        len++;
+    } while (value);
+
+    change_journal_put(buffer, encoded, len);
+}
+
+/**
+ * Append a length prefixed and null terminated string to the buffer.
+ *
+ * @param buffer Buffer.
+ * @param string String to append.
+ *
+ */
+static void change_journal_put_string(srpc_change_journal_buffer_t *buffer, const char *string)
+{
+    size_t len = strlen(string);
+
+    change_journal_put_varint(buffer, len);
+    change_journal_put(buffer, string, len + 1);
+}
+
+/**
+ * Decode a byte.
+ *
+ * @param cursor Cursor.
+ * @param value Byte output.
+ *
+ * @return Error code - 0 on success, -1 at the end of the range.
+ */
+static int change_journal_get_byte(srpc_change_journal_cursor_t *cursor, uint8_t *value)
+{
+    if (cursor->pos >= cursor->end)
+    {
+        return -1;
+    }
+
+    *value = cursor->data[cursor->pos++];
+
+    return 0;
+}
+
+/**
+ * Decode a LEB128 encoded number.
+ *
+ * @param cursor Cursor.
+ * @param value Number output.
+ *
+ * @return Error code - 0 on success, -1 if the number is truncated or too long.
+ */
+static int change_journal_get_varint(srpc_change_journal_cursor_t *cursor, uint64_t *value)
+{
+    uint64_t result = 0;
+    uint8_t byte = 0;
+
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if (change_journal_get_byte(cursor, &byte))
+        {
+            return -1;
+        }
+
+        result |= (uint64_t)(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Decode a string - it points into the journal.
+ *
+ * @param cursor Cursor.
+ * @param string String output.
+ *
+ * @return Error code - 0 on success, -1 if the string is truncated or not terminated.
+ */
+static int change_journal_get_string(srpc_change_journal_cursor_t *cursor, const char **string)
+{
+    uint64_t len = 0;
+
+    if (change_journal_get_varint(cursor, &len) || len >= cursor->end - cursor->pos || cursor->data[cursor->pos + len])
+    {
+        return -1;
+    }
+
+    *string = (const char *)cursor->data + cursor->pos;
+    cursor->pos += len + 1;
+
+    return 0;
+}
+
+/**
+ * Sleep until the given time of the monotonic clock.
+ *
+ * @param until_us Time to wake up at in microseconds.
+ *
+ */
+static void change_journal_wait(uint64_t until_us)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(until_us / 1000000),
+        .tv_nsec = (long)(until_us % 1000000) * 1000L,
+    };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in microseconds.
+ */
+static uint64_t change_journal_now_us(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
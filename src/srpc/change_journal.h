@@ -0,0 +1,101 @@
+/**
+ * @file change_journal.h
+ * @brief API for recording changes into a journal and replaying them into change callbacks.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_CHANGE_JOURNAL_H
+#define SRPC_CHANGE_JOURNAL_H
+
+#include "types.h"
+
+#include <stdbool.h>
+
+#include <sysrepo.h>
+
+/**
+ * Start recording the changes iterated by srpc_iterate_changes() in the whole process. Each iteration is appended to
+ * the journal as a batch with its xpath and time, each change with its operation, node path, value, previous value,
+ * previous list keys, previous default flag, time within the batch and the time spent in the callback.
+ *
+ * @param path Path of the journal - an existing file is overwritten.
+ *
+ * @return Error code - 0 on success, -1 on error or if a journal is already being recorded.
+ */
+int srpc_change_journal_start(const char *path);
+
+/**
+ * Stop recording - batches still being iterated are dropped.
+ *
+ */
+void srpc_change_journal_stop(void);
+
+/**
+ * Begin recording a batch of changes - used by srpc_iterate_changes(), custom change iterators can use it the same
+ * way.
+ *
+ * @param xpath XPath the changes are iterated for.
+ *
+ * @return New batch, NULL if no journal is being recorded or on error.
+ */
+srpc_change_journal_batch_t *srpc_change_journal_batch_begin(const char *xpath);
+
+/**
+ * Call the change callback and record the change with the time spent in the callback.
+ *
+ * @param batch Batch returned by srpc_change_journal_batch_begin().
+ * @param priv Private user data passed to the callback.
+ * @param session Session passed to the callback.
+ * @param cb Change callback.
+ * @param change_ctx Change to pass to the callback and to record.
+ *
+ * @return Return value of the callback.
+ */
+int srpc_change_journal_batch_call(srpc_change_journal_batch_t *batch, void *priv, sr_session_ctx_t *session,
+                                   srpc_change_cb cb, const srpc_change_ctx_t *change_ctx);
+
+/**
+ * Append the recorded batch to the journal and free it.
+ *
+ * @param batch Batch returned by srpc_change_journal_batch_begin(), can point to NULL.
+ *
+ */
+void srpc_change_journal_batch_end(srpc_change_journal_batch_t **batch);
+
+/**
+ * Replay a journal into a change callback. Each batch is replayed like srpc_iterate_changes() iterated it - the init
+ * callback, the change callback for each change and the free callback. The changed nodes are rebuilt from their paths
+ * and values in the given context, each in its own tree which is freed after the callback. A failed callback aborts
+ * its batch and the replay continues with the next batch.
+ *
+ * @param ly_ctx Context with the modules of the recorded changes.
+ * @param path Path of the journal.
+ * @param xpath Replay only the batches recorded for this xpath - NULL for all batches.
+ * @param paced Replay at the recorded pace instead of at full speed.
+ * @param priv Private user data passed to the callbacks.
+ * @param session Session passed to the change callback, can be NULL if the callback doesn't use it.
+ * @param cb Change callback.
+ * @param init_cb Callback for changes data initialization - can be NULL.
+ * @param free_cb Callback for freeing changes data - can be NULL.
+ * @param stats Replay counters output, can be NULL.
+ *
+ * @return Error code - 0 on success, -1 if the journal can't be read or is corrupted.
+ */
+int srpc_change_journal_replay(const struct ly_ctx *ly_ctx, const char *path, const char *xpath, bool paced,
+                               void *priv, sr_session_ctx_t *session, srpc_change_cb cb, srpc_change_init_cb init_cb,
+                               srpc_change_free_cb free_cb, srpc_change_journal_stats_t *stats);
+
+#endif // SRPC_CHANGE_JOURNAL_H
@@ -0,0 +1,415 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "change_set.h"
+#include "common.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <uthash.h>
+
+// Number of sysrepo change operations.
+#define SRPC_CHANGE_SET_OPERATIONS (SR_OP_MOVED + 1)
+
+// Initial number of changes allocated.
+#define SRPC_CHANGE_SET_INITIAL_SIZE 64
+
+typedef struct srpc_change_set_schema_s srpc_change_set_schema_t;
+
+/**
+ * Changes of a single schema node - a range of the schema index.
+ */
+struct srpc_change_set_schema_s
+{
+    const struct lysc_node *schema; ///< Key - schema node.
+    size_t offset;                  ///< Offset of the first change in the schema index.
+    size_t count;                   ///< Number of changes of the schema node.
+    UT_hash_handle hh;              ///< UTHash reserved data.
+};
+
+/**
+ * Change set - changes stored as a struct of arrays with indices by operation and by schema node.
+ */
+struct srpc_change_set_s
+{
+    sr_session_ctx_t *session;                                ///< Session of the module change callback.
+    sr_change_iter_t *iterator;                               ///< Kept alive - changes reference its data.
+    size_t count;                                             ///< Number of changes.
+    size_t size;                                              ///< Allocated number of changes.
+    const struct lyd_node **nodes;                            ///< Changed nodes.
+    const struct lysc_node **schemas;                         ///< Schema nodes of the changed nodes.
+    sr_change_oper_t *operations;                             ///< Operations.
+    const char **previous_values;                             ///< Previous values.
+    const char **previous_lists;                              ///< Previous list keys predicates.
+    int *previous_defaults;                                   ///< Previous default flags.
+    size_t *operation_index;                                  ///< Change indices ordered by operation.
+    size_t operation_offsets[SRPC_CHANGE_SET_OPERATIONS + 1]; ///< Offsets of the operations in the index.
+    size_t *schema_index;                                     ///< Change indices ordered by schema node.
+    srpc_change_set_schema_t *schema_ranges;                  ///< Schema index ranges hashed by schema node.
+};
+
+static int change_set_grow(srpc_change_set_t *set);
+static int change_set_index(srpc_change_set_t *set);
+
+/**
+ * Collect all changes for the provided xpath into a change set indexed by operation and by schema node.
+ * Use only inside the module change callback - the change set references nodes of the sysrepo changes.
+ *
+ * @param session Sysrepo session of the module change callback.
+ * @param xpath XPath for the changes iterator.
+ *
+ * @return New change set, NULL on error.
+ */
+srpc_change_set_t *srpc_change_set_new(sr_session_ctx_t *session, const char *xpath)
+{
+    int error = 0;
+    srpc_change_set_t *set = NULL;
+    srpc_change_ctx_t change_ctx = {0};
+
+    SRPC_SAFE_CALL_PTR(set, calloc(1, sizeof(*set)), error_out);
+    set->session = session;
+
+    SRPC_SAFE_CALL_ERR(error, sr_get_changes_iter(session, xpath, &set->iterator), error_out);
+
+    while (sr_get_change_tree_next(session, set->iterator, &change_ctx.operation, &change_ctx.node,
+                                   &change_ctx.previous_value, &change_ctx.previous_list,
+                                   &change_ctx.previous_default) == SR_ERR_OK)
+    {
+        if (set->count == set->size)
+        {
+            SRPC_SAFE_CALL_ERR(error, change_set_grow(set), error_out);
+        }
+
+        set->nodes[set->count] = change_ctx.node;
+        set->schemas[set->count] = change_ctx.node->schema;
+        set->operations[set->count] = change_ctx.operation;
+        set->previous_values[set->count] = change_ctx.previous_value;
+        set->previous_lists[set->count] = change_ctx.previous_list;
+        set->previous_defaults[set->count] = change_ctx.previous_default;
+        ++set->count;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, change_set_index(set), error_out);
+
+    return set;
+
+error_out:
+    srpc_change_set_free(&set);
+
+    return NULL;
+}
+
+/**
+ * Get the number of changes in the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Number of changes.
+ */
+size_t srpc_change_set_count(const srpc_change_set_t *set)
+{
+    return set->count;
+}
+
+/**
+ * Get a single change in the same form as used by srpc_iterate_changes().
+ *
+ * @param set Change set.
+ * @param index Index of the change.
+ * @param change_ctx Change context to fill.
+ *
+ */
+void srpc_change_set_get(const srpc_change_set_t *set, size_t index, srpc_change_ctx_t *change_ctx)
+{
+    change_ctx->node = set->nodes[index];
+    change_ctx->operation = set->operations[index];
+    change_ctx->previous_value = set->previous_values[index];
+    change_ctx->previous_list = set->previous_lists[index];
+    change_ctx->previous_default = set->previous_defaults[index];
+}
+
+/**
+ * Get the changed nodes of all changes, indexed the same way as the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Array of changed nodes.
+ */
+const struct lyd_node *const *srpc_change_set_nodes(const srpc_change_set_t *set)
+{
+    return set->nodes;
+}
+
+/**
+ * Get the schema nodes of all changes, indexed the same way as the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Array of schema nodes.
+ */
+const struct lysc_node *const *srpc_change_set_schemas(const srpc_change_set_t *set)
+{
+    return set->schemas;
+}
+
+/**
+ * Get the operations of all changes, indexed the same way as the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Array of operations.
+ */
+const sr_change_oper_t *srpc_change_set_operations(const srpc_change_set_t *set)
+{
+    return set->operations;
+}
+
+/**
+ * Get a view of all changes with the given operation.
+ *
+ * @param set Change set.
+ * @param operation Operation to select.
+ * @param view View to fill - valid as long as the change set.
+ *
+ */
+void srpc_change_set_view_operation(const srpc_change_set_t *set, sr_change_oper_t operation,
+                                    srpc_change_view_t *view)
+{
+    size_t op = (size_t)operation;
+
+    if (op >= SRPC_CHANGE_SET_OPERATIONS || !set->operation_index)
+    {
+        *view = (srpc_change_view_t){0};
+        return;
+    }
+
+    view->indices = set->operation_index + set->operation_offsets[op];
+    view->count = set->operation_offsets[op + 1] - set->operation_offsets[op];
+}
+
+/**
+ * Get a view of all changes of the given schema node.
+ *
+ * @param set Change set.
+ * @param schema Schema node to select - for example found by lys_find_path().
+ * @param view View to fill - valid as long as the change set.
+ *
+ */
+void srpc_change_set_view_schema(const srpc_change_set_t *set, const struct lysc_node *schema,
+                                 srpc_change_view_t *view)
+{
+    srpc_change_set_schema_t *range = NULL;
+
+    HASH_FIND_PTR(set->schema_ranges, &schema, range);
+    if (!range)
+    {
+        *view = (srpc_change_view_t){0};
+        return;
+    }
+
+    view->indices = set->schema_index + range->offset;
+    view->count = range->count;
+}
+
+/**
+ * Call the callback on each change of a view - for example first on deletes, then on creates and then on modifies.
+ *
+ * @param priv Private user data - pass plugin context.
+ * @param set Change set.
+ * @param view View of the changes - NULL for all changes.
+ * @param cb Callback to call on each change.
+ *
+ * @return Error code - 0 on success, negative number of the failed callback otherwise.
+ */
+int srpc_change_set_apply(void *priv, const srpc_change_set_t *set, const srpc_change_view_t *view,
+                          srpc_change_cb cb)
+{
+    size_t count = view ? view->count : set->count;
+    srpc_change_ctx_t change_ctx = {0};
+
+    for (size_t i = 0; i < count; i++)
+    {
+        srpc_change_set_get(set, view ? view->indices[i] : i, &change_ctx);
+
+        if (cb(priv, set->session, &change_ctx))
+        {
+            // return number of invalid callback
+            return -(int)(i + 1);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Free the change set and its changes iterator.
+ *
+ * @param set Change set.
+ *
+ */
+void srpc_change_set_free(srpc_change_set_t **set)
+{
+    srpc_change_set_t *s = *set;
+    srpc_change_set_schema_t *range = NULL, *tmp = NULL;
+
+    if (!s)
+    {
+        return;
+    }
+
+    HASH_ITER(hh, s->schema_ranges, range, tmp)
+    {
+        HASH_DEL(s->schema_ranges, range);
+        free(range);
+    }
+
+    free(s->schema_index);
+    free(s->operation_index);
+    free(s->previous_defaults);
+    free(s->previous_lists);
+    free(s->previous_values);
+    free(s->operations);
+    free(s->schemas);
+    free(s->nodes);
+
+    sr_free_change_iter(s->iterator);
+
+    free(s);
+
+    *set = NULL;
+}
+
+/**
+ * Double the capacity of all change arrays.
+ *
+ * @param set Change set.
+ *
+ * @return Error code - 0 on success.
+ */
+static int change_set_grow(srpc_change_set_t *set)
+{
+    size_t size = set->size ? set->size * 2 : SRPC_CHANGE_SET_INITIAL_SIZE;
+    void *ptr = NULL;
+
+// realloc a single array of the change set
+#define CHANGE_SET_REALLOC(array)                                                                                      \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        ptr = realloc((void *)set->array, size * sizeof(*set->array));                                                 \
+        if (!ptr)                                                                                                      \
+        {                                                                                                              \
+            return -1;                                                                                                 \
+        }                                                                                                              \
+        set->array = ptr;                                                                                              \
+    } while (0)
+
+    CHANGE_SET_REALLOC(nodes);
+    CHANGE_SET_REALLOC(schemas);
+    CHANGE_SET_REALLOC(operations);
+    CHANGE_SET_REALLOC(previous_values);
+    CHANGE_SET_REALLOC(previous_lists);
+    CHANGE_SET_REALLOC(previous_defaults);
+
+#undef CHANGE_SET_REALLOC
+
+    set->size = size;
+
+    return 0;
+}
+
+/**
+ * Build the operation and schema node indices. Both are built using counting sort so the changes keep their original
+ * order within each operation and schema node.
+ *
+ * @param set Change set.
+ *
+ * @return Error code - 0 on success.
+ */
+static int change_set_index(srpc_change_set_t *set)
+{
+    int error = 0;
+    size_t fill[SRPC_CHANGE_SET_OPERATIONS] = {0};
+    size_t offset = 0;
+    size_t op = 0;
+    srpc_change_set_schema_t *range = NULL, *tmp = NULL;
+
+    if (!set->count)
+    {
+        goto out;
+    }
+
+    SRPC_SAFE_CALL_PTR(set->operation_index, malloc(set->count * sizeof(*set->operation_index)), error_out);
+    SRPC_SAFE_CALL_PTR(set->schema_index, malloc(set->count * sizeof(*set->schema_index)), error_out);
+
+    // operation index
+    for (size_t i = 0; i < set->count; i++)
+    {
+        op = (size_t)set->operations[i];
+        if (op < SRPC_CHANGE_SET_OPERATIONS)
+        {
+            ++set->operation_offsets[op + 1];
+        }
+    }
+
+    for (op = 0; op < SRPC_CHANGE_SET_OPERATIONS; op++)
+    {
+        set->operation_offsets[op + 1] += set->operation_offsets[op];
+        fill[op] = set->operation_offsets[op];
+    }
+
+    for (size_t i = 0; i < set->count; i++)
+    {
+        op = (size_t)set->operations[i];
+        if (op < SRPC_CHANGE_SET_OPERATIONS)
+        {
+            set->operation_index[fill[op]++] = i;
+        }
+    }
+
+    // schema node index - count the changes of each schema node first
+    for (size_t i = 0; i < set->count; i++)
+    {
+        HASH_FIND_PTR(set->schema_ranges, &set->schemas[i], range);
+        if (!range)
+        {
+            SRPC_SAFE_CALL_PTR(range, calloc(1, sizeof(*range)), error_out);
+            range->schema = set->schemas[i];
+            HASH_ADD_PTR(set->schema_ranges, schema, range);
+        }
+        ++range->count;
+    }
+
+    HASH_ITER(hh, set->schema_ranges, range, tmp)
+    {
+        range->offset = offset;
+        offset += range->count;
+        range->count = 0;
+    }
+
+    for (size_t i = 0; i < set->count; i++)
+    {
+        HASH_FIND_PTR(set->schema_ranges, &set->schemas[i], range);
+        set->schema_index[range->offset + range->count++] = i;
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file change_set.h
+ * @brief API for materializing module changes once and accessing them in multiple passes.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_CHANGE_SET_H
+#define SRPC_CHANGE_SET_H
+
+#include "types.h"
+
+#include <sysrepo.h>
+
+/**
+ * Collect all changes for the provided xpath into a change set indexed by operation and by schema node.
+ * Use only inside the module change callback - the change set references nodes of the sysrepo changes.
+ *
+ * @param session Sysrepo session of the module change callback.
+ * @param xpath XPath for the changes iterator.
+ *
+ * @return New change set, NULL on error.
+ */
+srpc_change_set_t *srpc_change_set_new(sr_session_ctx_t *session, const char *xpath);
+
+/**
+ * Get the number of changes in the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Number of changes.
+ */
+size_t srpc_change_set_count(const srpc_change_set_t *set);
+
+/**
+ * Get a single change in the same form as used by srpc_iterate_changes().
+ *
+ * @param set Change set.
+ * @param index Index of the change.
+ * @param change_ctx Change context to fill.
+ *
+ */
+void srpc_change_set_get(const srpc_change_set_t *set, size_t index, srpc_change_ctx_t *change_ctx);
+
+/**
+ * Get the changed nodes of all changes, indexed the same way as the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Array of changed nodes.
+ */
+const struct lyd_node *const *srpc_change_set_nodes(const srpc_change_set_t *set);
+
+/**
+ * Get the schema nodes of all changes, indexed the same way as the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Array of schema nodes.
+ */
+const struct lysc_node *const *srpc_change_set_schemas(const srpc_change_set_t *set);
+
+/**
+ * Get the operations of all changes, indexed the same way as the change set.
+ *
+ * @param set Change set.
+ *
+ * @return Array of operations.
+ */
+const sr_change_oper_t *srpc_change_set_operations(const srpc_change_set_t *set);
+
+/**
+ * Get a view of all changes with the given operation.
+ *
+ * @param set Change set.
+ * @param operation Operation to select.
+ * @param view View to fill - valid as long as the change set.
+ *
+ */
+void srpc_change_set_view_operation(const srpc_change_set_t *set, sr_change_oper_t operation,
+                                    srpc_change_view_t *view);
+
+/**
+ * Get a view of all changes of the given schema node.
+ *
+ * @param set Change set.
+ * @param schema Schema node to select - for example found by lys_find_path().
+ * @param view View to fill - valid as long as the change set.
+ *
+ */
+void srpc_change_set_view_schema(const srpc_change_set_t *set, const struct lysc_node *schema,
+                                 srpc_change_view_t *view);
+
+/**
+ * Call the callback on each change of a view - for example first on deletes, then on creates and then on modifies.
+ *
+ * @param priv Private user data - pass plugin context.
+ * @param set Change set.
+ * @param view View of the changes - NULL for all changes.
+ * @param cb Callback to call on each change.
+ *
+ * @return Error code - 0 on success, negative number of the failed callback otherwise.
+ */
+int srpc_change_set_apply(void *priv, const srpc_change_set_t *set, const srpc_change_view_t *view,
+                          srpc_change_cb cb);
+
+/**
+ * Free the change set and its changes iterator.
+ *
+ * @param set Change set.
+ *
+ */
+void srpc_change_set_free(srpc_change_set_t **set);
+
+#endif // SRPC_CHANGE_SET_H
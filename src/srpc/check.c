@@ -0,0 +1,226 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "check.h"
+#include "common.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Marks an empty hash table slot.
+#define SRPC_CHECK_EMPTY_SLOT SIZE_MAX
+
+/**
+ * Open addressing hash table slot - index of the system pair and its cached key hash.
+ */
+typedef struct srpc_check_slot_s
+{
+    size_t index;  ///< Index into the system pairs array.
+    uint64_t hash; ///< Hash of the key.
+} srpc_check_slot_t;
+
+static uint64_t check_hash(const char *key);
+static bool check_value_equal(const char *v1, const char *v2);
+
+/**
+ * Compare keyed datastore values with the keyed values found on the system.
+ * System values are hashed once, so the comparison runs in linear time. Datastore entries with a NULL value are
+ * compared by key only, whatever the system value is - use them for leaf-lists and presence checks.
+ *
+ * Result status is srpc_check_status_none for an empty datastore set, srpc_check_status_non_existant if none of the
+ * keys exist on the system, srpc_check_status_equal if all keys exist with equal values and srpc_check_status_partial
+ * otherwise. Missing and differing entries point into the provided arrays.
+ *
+ * @param datastore Datastore key/value pairs.
+ * @param datastore_count Number of datastore pairs.
+ * @param system System key/value pairs - on duplicate keys the first pair is used.
+ * @param system_count Number of system pairs.
+ * @param result Comparison result - free with srpc_check_result_free().
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_check_values(const srpc_key_value_pair_t datastore[], size_t datastore_count,
+                      const srpc_key_value_pair_t system[], size_t system_count, srpc_check_result_t *result)
+{
+    int error = 0;
+    srpc_check_slot_t *table = NULL;
+    size_t capacity = 1;
+    size_t mask = 0;
+
+    memset(result, 0, sizeof(*result));
+
+    if (!datastore_count)
+    {
+        result->status = srpc_check_status_none;
+        goto out;
+    }
+
+    // at most half full - short probe sequences
+    while (capacity < system_count * 2)
+    {
+        capacity <<= 1;
+    }
+    mask = capacity - 1;
+
+    SRPC_SAFE_CALL_PTR(table, malloc(capacity * sizeof(*table)), error_out);
+    for (size_t i = 0; i < capacity; i++)
+    {
+        table[i].index = SRPC_CHECK_EMPTY_SLOT;
+    }
+
+    SRPC_SAFE_CALL_PTR(result->missing, malloc(datastore_count * sizeof(*result->missing)), error_out);
+    SRPC_SAFE_CALL_PTR(result->differing, malloc(datastore_count * sizeof(*result->differing)), error_out);
+    SRPC_SAFE_CALL_PTR(result->differing_system, malloc(datastore_count * sizeof(*result->differing_system)),
+                       error_out);
+
+    // hash system values
+    for (size_t i = 0; i < system_count; i++)
+    {
+        const uint64_t hash = check_hash(system[i].key);
+        size_t pos = (size_t)hash & mask;
+
+        while (table[pos].index != SRPC_CHECK_EMPTY_SLOT)
+        {
+            if (table[pos].hash == hash && !strcmp(system[table[pos].index].key, system[i].key))
+            {
+                break;
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        if (table[pos].index == SRPC_CHECK_EMPTY_SLOT)
+        {
+            table[pos].index = i;
+            table[pos].hash = hash;
+        }
+    }
+
+    // probe datastore values
+    for (size_t i = 0; i < datastore_count; i++)
+    {
+        const uint64_t hash = check_hash(datastore[i].key);
+        size_t pos = (size_t)hash & mask;
+        const srpc_key_value_pair_t *found = NULL;
+
+        while (table[pos].index != SRPC_CHECK_EMPTY_SLOT)
+        {
+            if (table[pos].hash == hash && !strcmp(system[table[pos].index].key, datastore[i].key))
+            {
+                found = &system[table[pos].index];
+                break;
+            }
+            pos = (pos + 1) & mask;
+        }
+
+        if (!found)
+        {
+            result->missing[result->missing_count++] = &datastore[i];
+        }
+        else if (datastore[i].value && !check_value_equal(datastore[i].value, found->value))
+        {
+            result->differing[result->differing_count] = &datastore[i];
+            result->differing_system[result->differing_count] = found;
+            ++result->differing_count;
+        }
+    }
+
+    if (result->missing_count == datastore_count)
+    {
+        result->status = srpc_check_status_non_existant;
+    }
+    else if (!result->missing_count && !result->differing_count)
+    {
+        result->status = srpc_check_status_equal;
+    }
+    else
+    {
+        result->status = srpc_check_status_partial;
+    }
+
+    goto out;
+
+error_out:
+    srpc_check_result_free(result);
+    result->status = srpc_check_status_error;
+    error = -1;
+
+out:
+    free(table);
+
+    return error;
+}
+
+/**
+ * Free data allocated for the comparison result.
+ *
+ * @param result Comparison result.
+ *
+ */
+void srpc_check_result_free(srpc_check_result_t *result)
+{
+    free(result->missing);
+    free(result->differing);
+    free(result->differing_system);
+
+    result->missing = NULL;
+    result->differing = NULL;
+    result->differing_system = NULL;
+    result->missing_count = 0;
+    result->differing_count = 0;
+}
+
+/**
+ * FNV-1a hash of the key.
+ *
+ * @param key Key to hash.
+ *
+ * @return Key hash.
+ */
+static uint64_t check_hash(const char *key)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (const unsigned char *iter = (const unsigned char *)key; *iter; iter++)
+    {
+        hash ^= *iter;
+        hash *= 0x100000001b3ULL;
+    }
+
+    // mix high bits into the low bits used for the table index
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/**
+ * Compare two possibly NULL values.
+ *
+ * @param v1 First value.
+ * @param v2 Second value.
+ *
+ * @return Wether the values are equal.
+ */
+static bool check_value_equal(const char *v1, const char *v2)
+{
+    if (!v1 || !v2)
+    {
+        return v1 == v2;
+    }
+
+    return !strcmp(v1, v2);
+}
@@ -0,0 +1,53 @@
+/**
+ * @file check.h
+ * @brief API for comparing datastore values with the values found on the system.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_CHECK_H
+#define SRPC_CHECK_H
+
+#include "types.h"
+
+/**
+ * Compare keyed datastore values with the keyed values found on the system.
+ * System values are hashed once, so the comparison runs in linear time. Datastore entries with a NULL value are
+ * compared by key only, whatever the system value is - use them for leaf-lists and presence checks.
+ *
+ * Result status is srpc_check_status_none for an empty datastore set, srpc_check_status_non_existant if none of the
+ * keys exist on the system, srpc_check_status_equal if all keys exist with equal values and srpc_check_status_partial
+ * otherwise. Missing and differing entries point into the provided arrays.
+ *
+ * @param datastore Datastore key/value pairs.
+ * @param datastore_count Number of datastore pairs.
+ * @param system System key/value pairs - on duplicate keys the first pair is used.
+ * @param system_count Number of system pairs.
+ * @param result Comparison result - free with srpc_check_result_free().
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_check_values(const srpc_key_value_pair_t datastore[], size_t datastore_count,
+                      const srpc_key_value_pair_t system[], size_t system_count, srpc_check_result_t *result);
+
+/**
+ * Free data allocated for the comparison result.
+ *
+ * @param result Comparison result.
+ *
+ */
+void srpc_check_result_free(srpc_check_result_t *result);
+
+#endif // SRPC_CHECK_H
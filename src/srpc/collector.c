@@ -0,0 +1,507 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "collector.h"
+#include "common.h"
+#include "mem_account.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+/**
+ * Collector - items, their front buffers and the collector thread state.
+ */
+struct srpc_collector_s
+{
+    sr_session_ctx_t *session;    ///< Session used for context acquisition and pushing.
+    srpc_collector_item_t *items; ///< Collected items.
+    struct lyd_node **front;      ///< Front buffer of each item - last collected data.
+    struct lyd_node **pushed;     ///< Last pushed data of each item whose front buffer failed to be pushed.
+    bool *push_pending;           ///< Front buffer of each item differs from the pushed data - pushed has the base.
+    size_t items_count;           ///< Number of items.
+    void *priv;                   ///< Private data passed to the build callbacks.
+    uint32_t interval_ms;         ///< Collection interval.
+    bool push;                    ///< Push changes to the operational datastore.
+    bool trigger;                 ///< Immediate collection requested.
+    bool stop;                    ///< Thread stop request.
+    pthread_t thread;             ///< Collector thread.
+    pthread_rwlock_t front_lock;  ///< Lock for the front buffers.
+    pthread_mutex_t lock;         ///< Lock for the thread control data.
+    pthread_cond_t cond;          ///< Signaled on trigger and stop requests.
+};
+
+static void *collector_thread(void *arg);
+static void collector_collect(srpc_collector_t *collector);
+static int collector_push(srpc_collector_t *collector, const struct ly_ctx *ly_ctx, const struct lyd_node *old,
+                          const struct lyd_node *new);
+
+/**
+ * Create a new collector and start its thread.
+ * Each interval, every item subtree is built into a back buffer and swapped with the front buffer served to the pull
+ * callbacks. If pushing is enabled, only the differences between the old and the new subtree are pushed as
+ * operational data - after a failed push, the next one contains the differences to the last pushed subtree.
+ *
+ * @param session Session used for acquiring the libyang context and pushing data - dedicated to the collector, it is
+ * switched to the operational datastore if pushing is enabled.
+ * @param items Array of collected subtrees - the array is copied.
+ * @param items_count Number of collected subtrees.
+ * @param priv Private user data passed to the build callbacks - pass plugin context.
+ * @param interval_ms Collection interval.
+ * @param push Push the changed data to the operational datastore.
+ *
+ * @return New collector, NULL on error.
+ */
+srpc_collector_t *srpc_collector_new(sr_session_ctx_t *session, const srpc_collector_item_t items[],
+                                     size_t items_count, void *priv, uint32_t interval_ms, bool push)
+{
+    int error = 0;
+    srpc_collector_t *collector = NULL;
+    pthread_condattr_t cond_attr;
+
+    SRPC_SAFE_CALL_PTR(collector, calloc(1, sizeof(*collector)), error_out);
+
+    if (items_count)
+    {
+        SRPC_SAFE_CALL_PTR(collector->items, malloc(items_count * sizeof(*collector->items)), error_out);
+        SRPC_SAFE_CALL_PTR(collector->front, calloc(items_count, sizeof(*collector->front)), error_out);
+        memcpy(collector->items, items, items_count * sizeof(*collector->items));
+
+        if (push)
+        {
+            SRPC_SAFE_CALL_PTR(collector->pushed, calloc(items_count, sizeof(*collector->pushed)), error_out);
+            SRPC_SAFE_CALL_PTR(collector->push_pending, calloc(items_count, sizeof(bool)), error_out);
+        }
+    }
+
+    if (push)
+    {
+        SRPC_SAFE_CALL_ERR(error, sr_session_switch_ds(session, SR_DS_OPERATIONAL), error_out);
+    }
+
+    collector->session = session;
+    collector->items_count = items_count;
+    collector->priv = priv;
+    collector->interval_ms = interval_ms;
+    collector->push = push;
+
+    // collect once before serving any requests
+    collector->trigger = true;
+
+    pthread_rwlock_init(&collector->front_lock, NULL);
+    pthread_mutex_init(&collector->lock, NULL);
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&collector->cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    if (pthread_create(&collector->thread, NULL, collector_thread, collector) != 0)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to start collector thread");
+        pthread_cond_destroy(&collector->cond);
+        pthread_mutex_destroy(&collector->lock);
+        pthread_rwlock_destroy(&collector->front_lock);
+        goto error_out;
+    }
+
+    return collector;
+
+error_out:
+    if (collector)
+    {
+        free(collector->items);
+        free(collector->front);
+        free(collector->pushed);
+        free(collector->push_pending);
+        free(collector);
+    }
+
+    return NULL;
+}
+
+/**
+ * Add the last collected data matching the path to the parent - use from sr_oper_get_items_cb.
+ *
+ * @param collector Collector.
+ * @param path Path of the requested data - usually the path received by the operational callback.
+ * @param parent Parent node for the data - same as for sr_oper_get_items_cb.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_collector_get_items(srpc_collector_t *collector, const char *path, struct lyd_node **parent)
+{
+    int error = 0;
+    struct ly_set *set = NULL;
+    struct lyd_node *root = NULL;
+    struct lyd_node *dup = NULL;
+
+    // merge into the top-level siblings of the request tree
+    if (*parent)
+    {
+        root = *parent;
+        while (lyd_parent(root))
+        {
+            root = lyd_parent(root);
+        }
+        root = lyd_first_sibling(root);
+    }
+
+    pthread_rwlock_rdlock(&collector->front_lock);
+
+    for (size_t i = 0; i < collector->items_count; i++)
+    {
+        if (!collector->front[i])
+        {
+            continue;
+        }
+
+        SRPC_SAFE_CALL_ERR(error, lyd_find_xpath(collector->front[i], path, &set), error_out);
+
+        for (uint32_t j = 0; j < set->count; j++)
+        {
+            SRPC_SAFE_CALL_ERR(error,
+                               lyd_dup_single(set->dnodes[j], NULL, LYD_DUP_RECURSIVE | LYD_DUP_WITH_PARENTS, &dup),
+                               error_out);
+            while (lyd_parent(dup))
+            {
+                dup = lyd_parent(dup);
+            }
+
+            SRPC_SAFE_CALL_ERR(error, lyd_merge_siblings(&root, dup, LYD_MERGE_DESTRUCT), error_out);
+            dup = NULL;
+        }
+
+        ly_set_free(set, NULL);
+        set = NULL;
+    }
+
+    goto out;
+
+error_out:
+    lyd_free_all(dup);
+    error = -1;
+
+out:
+    pthread_rwlock_unlock(&collector->front_lock);
+
+    ly_set_free(set, NULL);
+
+    // a new tree is handed over only on success
+    if (!*parent)
+    {
+        if (error)
+        {
+            lyd_free_all(root);
+        }
+        else
+        {
+            *parent = root;
+        }
+    }
+
+    return error;
+}
+
+/**
+ * Convert a libyang diff into a sysrepo edit - deleted nodes get the remove operation, all other nodes are merged.
+ * Used for pushing the collected data, the ietf-netconf module has to be present in the context.
+ *
+ * @param ly_ctx libyang context.
+ * @param diff Diff to convert in place.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_collector_diff_to_edit(const struct ly_ctx *ly_ctx, struct lyd_node *diff)
+{
+    int error = 0;
+    struct lyd_node *top = NULL;
+    struct lyd_node *elem = NULL;
+    struct lyd_node *child = NULL, *next_child = NULL;
+    struct lyd_meta *meta = NULL, *next_meta = NULL;
+    bool remove = false;
+
+    LY_LIST_FOR(diff, top)
+    {
+        LYD_TREE_DFS_BEGIN(top, elem)
+        {
+            meta = lyd_find_meta(elem->meta, NULL, "yang:operation");
+            remove = meta && !strcmp(lyd_get_meta_value(meta), "delete");
+
+            // drop all diff metadata
+            for (meta = elem->meta; meta; meta = next_meta)
+            {
+                next_meta = meta->next;
+                if (!strcmp(meta->annotation->module->name, "yang"))
+                {
+                    lyd_free_meta_single(meta);
+                }
+            }
+
+            if (remove)
+            {
+                // the removed node is identified by itself and its keys
+                LY_LIST_FOR_SAFE(lyd_child_no_keys(elem), next_child, child)
+                {
+                    lyd_free_tree(child);
+                }
+
+                SRPC_SAFE_CALL_ERR(error, lyd_new_meta(ly_ctx, elem, NULL, "ietf-netconf:operation", "remove", 0, NULL),
+                                   error_out);
+                LYD_TREE_DFS_continue = 1;
+            }
+
+            LYD_TREE_DFS_END(top, elem);
+        }
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Request an immediate collection without waiting for the interval to pass.
+ *
+ * @param collector Collector.
+ *
+ */
+void srpc_collector_trigger(srpc_collector_t *collector)
+{
+    pthread_mutex_lock(&collector->lock);
+    collector->trigger = true;
+    pthread_cond_signal(&collector->cond);
+    pthread_mutex_unlock(&collector->lock);
+}
+
+/**
+ * Stop the collector thread and free all collector data.
+ *
+ * @param collector Collector.
+ *
+ */
+void srpc_collector_free(srpc_collector_t **collector)
+{
+    srpc_collector_t *c = *collector;
+
+    if (!c)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&c->lock);
+    c->stop = true;
+    pthread_cond_signal(&c->cond);
+    pthread_mutex_unlock(&c->lock);
+
+    pthread_join(c->thread, NULL);
+
+    for (size_t i = 0; i < c->items_count; i++)
+    {
+        lyd_free_all(c->front[i]);
+        if (c->pushed)
+        {
+            lyd_free_all(c->pushed[i]);
+        }
+    }
+
+    pthread_cond_destroy(&c->cond);
+    pthread_mutex_destroy(&c->lock);
+    pthread_rwlock_destroy(&c->front_lock);
+    free(c->items);
+    free(c->front);
+    free(c->pushed);
+    free(c->push_pending);
+    free(c);
+
+    *collector = NULL;
+}
+
+/**
+ * Collector thread - collects all items each interval or when triggered.
+ *
+ * @param arg Collector.
+ *
+ * @return Always NULL.
+ */
+static void *collector_thread(void *arg)
+{
+    srpc_collector_t *collector = arg;
+    struct timespec deadline = {0};
+
+    pthread_mutex_lock(&collector->lock);
+
+    while (!collector->stop)
+    {
+        if (!collector->trigger)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += collector->interval_ms / 1000;
+            deadline.tv_nsec += (long)(collector->interval_ms % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec += 1;
+                deadline.tv_nsec -= 1000000000L;
+            }
+
+            while (!collector->trigger && !collector->stop)
+            {
+                if (pthread_cond_timedwait(&collector->cond, &collector->lock, &deadline) != 0)
+                {
+                    break;
+                }
+            }
+
+            if (collector->stop)
+            {
+                break;
+            }
+        }
+
+        collector->trigger = false;
+
+        pthread_mutex_unlock(&collector->lock);
+        collector_collect(collector);
+        pthread_mutex_lock(&collector->lock);
+    }
+
+    pthread_mutex_unlock(&collector->lock);
+
+    return NULL;
+}
+
+/**
+ * Build all items into back buffers, swap them with the front buffers and push the differences.
+ *
+ * @param collector Collector.
+ *
+ */
+static void collector_collect(srpc_collector_t *collector)
+{
+    int error = 0;
+    sr_conn_ctx_t *conn_ctx = NULL;
+    const struct ly_ctx *ly_ctx = NULL;
+    struct lyd_node *back = NULL;
+    struct lyd_node *old = NULL;
+
+    SRPC_SAFE_CALL_PTR(conn_ctx, sr_session_get_connection(collector->session), error_out);
+    SRPC_SAFE_CALL_PTR(ly_ctx, sr_acquire_context(conn_ctx), error_out);
+
+    for (size_t i = 0; i < collector->items_count; i++)
+    {
+        const srpc_collector_item_t *item = &collector->items[i];
+
+        back = NULL;
+        srpc_mem_account_begin(item->name);
+        error = item->cb(collector->priv, ly_ctx, &back);
+        srpc_mem_account_end(error ? NULL : back);
+        if (error)
+        {
+            // keep serving the previous data
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Collector build callback for %s failed (%d)", item->name, error);
+            lyd_free_all(back);
+            continue;
+        }
+
+        pthread_rwlock_wrlock(&collector->front_lock);
+        old = collector->front[i];
+        collector->front[i] = back;
+        pthread_rwlock_unlock(&collector->front_lock);
+
+        // the old front buffer is no longer visible to the readers
+        if (collector->push)
+        {
+            // diff against the data which was actually pushed, so failed changes are retried
+            error = collector_push(collector, ly_ctx, collector->push_pending[i] ? collector->pushed[i] : old, back);
+            if (error)
+            {
+                SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Pushing collected data for %s failed (%d)", item->name, error);
+                if (!collector->push_pending[i])
+                {
+                    collector->pushed[i] = old;
+                    collector->push_pending[i] = true;
+                    old = NULL;
+                }
+            }
+            else if (collector->push_pending[i])
+            {
+                lyd_free_all(collector->pushed[i]);
+                collector->pushed[i] = NULL;
+                collector->push_pending[i] = false;
+            }
+        }
+
+        lyd_free_all(old);
+    }
+
+    goto out;
+
+error_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to acquire libyang context for collection");
+
+out:
+    if (ly_ctx)
+    {
+        sr_release_context(conn_ctx);
+    }
+}
+
+/**
+ * Push the differences between the old and the new data to the operational datastore.
+ *
+ * @param collector Collector.
+ * @param ly_ctx libyang context.
+ * @param old Previously pushed data.
+ * @param new Newly collected data.
+ *
+ * @return Error code - 0 on success.
+ */
+static int collector_push(srpc_collector_t *collector, const struct ly_ctx *ly_ctx, const struct lyd_node *old,
+                          const struct lyd_node *new)
+{
+    int error = 0;
+    struct lyd_node *diff = NULL;
+
+    SRPC_SAFE_CALL_ERR(error, lyd_diff_siblings(old, new, 0, &diff), error_out);
+
+    if (!diff)
+    {
+        // unchanged - nothing to push
+        goto out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, srpc_collector_diff_to_edit(ly_ctx, diff), error_out);
+    SRPC_SAFE_CALL_ERR(error, sr_edit_batch(collector->session, diff, "merge"), error_out);
+    SRPC_SAFE_CALL_ERR(error, sr_apply_changes(collector->session, 0), error_out);
+
+    goto out;
+
+error_out:
+    sr_discard_changes(collector->session);
+    error = -1;
+
+out:
+    lyd_free_all(diff);
+
+    return error;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file collector.h
+ * @brief API for collecting operational state on a background thread.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_COLLECTOR_H
+#define SRPC_COLLECTOR_H
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Create a new collector and start its thread.
+ * Each interval, every item subtree is built into a back buffer and swapped with the front buffer served to the pull
+ * callbacks. If pushing is enabled, only the differences between the old and the new subtree are pushed as
+ * operational data - after a failed push, the next one contains the differences to the last pushed subtree.
+ *
+ * @param session Session used for acquiring the libyang context and pushing data - dedicated to the collector, it is
+ * switched to the operational datastore if pushing is enabled.
+ * @param items Array of collected subtrees - the array is copied.
+ * @param items_count Number of collected subtrees.
+ * @param priv Private user data passed to the build callbacks - pass plugin context.
+ * @param interval_ms Collection interval.
+ * @param push Push the changed data to the operational datastore.
+ *
+ * @return New collector, NULL on error.
+ */
+srpc_collector_t *srpc_collector_new(sr_session_ctx_t *session, const srpc_collector_item_t items[],
+                                     size_t items_count, void *priv, uint32_t interval_ms, bool push);
+
+/**
+ * Add the last collected data matching the path to the parent - use from sr_oper_get_items_cb.
+ *
+ * @param collector Collector.
+ * @param path Path of the requested data - usually the path received by the operational callback.
+ * @param parent Parent node for the data - same as for sr_oper_get_items_cb.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_collector_get_items(srpc_collector_t *collector, const char *path, struct lyd_node **parent);
+
+/**
+ * Convert a libyang diff into a sysrepo edit - deleted nodes get the remove operation, all other nodes are merged.
+ * Used for pushing the collected data, the ietf-netconf module has to be present in the context.
+ *
+ * @param ly_ctx libyang context.
+ * @param diff Diff to convert in place.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_collector_diff_to_edit(const struct ly_ctx *ly_ctx, struct lyd_node *diff);
+
+/**
+ * Request an immediate collection without waiting for the interval to pass.
+ *
+ * @param collector Collector.
+ *
+ */
+void srpc_collector_trigger(srpc_collector_t *collector);
+
+/**
+ * Stop the collector thread and free all collector data.
+ *
+ * @param collector Collector.
+ *
+ */
+void srpc_collector_free(srpc_collector_t **collector);
+
+#endif // SRPC_COLLECTOR_H
@@ -14,12 +14,44 @@
  *
  */
 
+#include <srpc/change_journal.h>
 #include <srpc/common.h>
 #include <sysrepo.h>
 #include <sysrepo/xpath.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <sys/sendfile.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Initial size of the command output buffer and the size of a single read.
+#define SRPC_EXEC_BUFFER_SIZE 4096
+
+/**
+ * Batch of command lines fed to a single command execution.
+ */
+struct srpc_exec_batch_s
+{
+    char **argv;       ///< Command and its arguments, NULL terminated.
+    char *input;       ///< Accumulated command lines.
+    size_t input_len;  ///< Length of the accumulated command lines.
+    size_t input_size; ///< Allocated size of the input buffer.
+    size_t count;      ///< Number of accumulated command lines.
+};
+
+static int exec_buffer_reserve(char **buffer, size_t *size, size_t needed);
+static int exec_remaining_ms(const struct timespec *deadline);
+static int exec_wait(pid_t pid, const struct timespec *deadline, int *status);
 
 /**
  * Check wether the datastore contains any data or not based on the provided path to check.
@@ -84,6 +116,9 @@ int srpc_iterate_changes(void *priv, sr_session_ctx_t *session, const char *xpat
 
     srpc_change_ctx_t change_ctx;
 
+    // NULL unless a change journal is being recorded
+    srpc_change_journal_batch_t *journal_batch = srpc_change_journal_batch_begin(xpath);
+
     // initialize changes data
     if (init_cb)
     {
@@ -108,7 +143,14 @@ int srpc_iterate_changes(void *priv, sr_session_ctx_t *session, const char *xpat
                                    &change_ctx.previous_value, &change_ctx.previous_list,
                                    &change_ctx.previous_default) == SR_ERR_OK)
     {
-        error = cb(priv, session, &change_ctx);
+        if (journal_batch)
+        {
+            error = srpc_change_journal_batch_call(journal_batch, priv, session, cb, &change_ctx);
+        }
+        else
+        {
+            error = cb(priv, session, &change_ctx);
+        }
         if (error)
         {
             // return number of invalid callback
@@ -128,6 +170,8 @@ out:
     // free iterator data
     sr_free_change_iter(changes_iterator);
 
+    srpc_change_journal_batch_end(&journal_batch);
+
     return error;
 }
 
@@ -230,4 +274,530 @@ out:
     }
 
     return error;
-}
\ No newline at end of file
+}
+
+/**
+ * Execute a command without a shell and capture its output. The command is started using posix_spawn() which avoids
+ * copying the address space of the calling process. The standard output and standard error are captured into the
+ * output buffer which is reused between calls - initialize it to zero before the first call.
+ *
+ * @param argv Command and its arguments, NULL terminated - the command is looked up in PATH.
+ * @param input Data to feed to the standard input of the command - can be NULL.
+ * @param input_len Length of the input data.
+ * @param timeout_ms Timeout after which the command is killed - 0 or less for no timeout.
+ * @param output Captured output and exit status of the command.
+ *
+ * @return Error code - 0 if the command was executed and exited with status 0.
+ */
+int srpc_exec(const char *const argv[], const char *input, size_t input_len, int timeout_ms,
+              srpc_exec_output_t *output)
+{
+    int error = 0;
+    int in_pipe[2] = {-1, -1};
+    int out_pipe[2] = {-1, -1};
+    pid_t pid = -1;
+    int status = 0;
+    size_t written = 0;
+    ssize_t rc = 0;
+    struct timespec deadline = {0};
+    struct timespec *deadline_ptr = NULL;
+    struct pollfd fds[2];
+    nfds_t fds_count = 0;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    bool actions_init = false;
+    bool attr_init = false;
+
+    sigset_t sigpipe_set;
+    sigset_t old_set;
+    sigset_t pending_set;
+    sigset_t empty_set;
+    bool sigpipe_pending = false;
+    bool mask_changed = false;
+    const struct timespec no_wait = {0};
+
+    output->len = 0;
+    output->exit_status = -1;
+    output->timed_out = false;
+
+    SRPC_SAFE_CALL_ERR(error, exec_buffer_reserve(&output->data, &output->size, SRPC_EXEC_BUFFER_SIZE), error_out);
+    output->data[0] = 0;
+
+    if (timeout_ms > 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        deadline_ptr = &deadline;
+    }
+
+    // pipes are close-on-exec - only the descriptors duplicated onto 0, 1 and 2 stay open in the child
+    SRPC_SAFE_CALL_ERR(error, pipe2(out_pipe, O_CLOEXEC), error_out);
+    if (input)
+    {
+        SRPC_SAFE_CALL_ERR(error, pipe2(in_pipe, O_CLOEXEC), error_out);
+    }
+
+    SRPC_SAFE_CALL_ERR(error, posix_spawn_file_actions_init(&actions), error_out);
+    actions_init = true;
+
+    if (input)
+    {
+        SRPC_SAFE_CALL_ERR(error, posix_spawn_file_actions_adddup2(&actions, in_pipe[0], STDIN_FILENO), error_out);
+    }
+    else
+    {
+        SRPC_SAFE_CALL_ERR(error, posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0),
+                           error_out);
+    }
+    SRPC_SAFE_CALL_ERR(error, posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDOUT_FILENO), error_out);
+    SRPC_SAFE_CALL_ERR(error, posix_spawn_file_actions_adddup2(&actions, out_pipe[1], STDERR_FILENO), error_out);
+
+    // the child starts with an empty signal mask and the default SIGPIPE action whatever the plugin daemon uses
+    sigemptyset(&empty_set);
+    sigemptyset(&sigpipe_set);
+    sigaddset(&sigpipe_set, SIGPIPE);
+
+    SRPC_SAFE_CALL_ERR(error, posix_spawnattr_init(&attr), error_out);
+    attr_init = true;
+    SRPC_SAFE_CALL_ERR(error, posix_spawnattr_setsigmask(&attr, &empty_set), error_out);
+    SRPC_SAFE_CALL_ERR(error, posix_spawnattr_setsigdefault(&attr, &sigpipe_set), error_out);
+    SRPC_SAFE_CALL_ERR(error, posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF),
+                       error_out);
+
+    // writing to the input of an already exited command must not kill the plugin - block SIGPIPE for this thread
+    sigpending(&pending_set);
+    sigpipe_pending = sigismember(&pending_set, SIGPIPE) == 1;
+    SRPC_SAFE_CALL_ERR(error, pthread_sigmask(SIG_BLOCK, &sigpipe_set, &old_set), error_out);
+    mask_changed = true;
+
+    SRPC_SAFE_CALL_ERR(error, posix_spawnp(&pid, argv[0], &actions, &attr, (char *const *)argv, environ), error_out);
+
+    close(out_pipe[1]);
+    out_pipe[1] = -1;
+    fcntl(out_pipe[0], F_SETFL, O_NONBLOCK);
+
+    if (input)
+    {
+        close(in_pipe[0]);
+        in_pipe[0] = -1;
+        fcntl(in_pipe[1], F_SETFL, O_NONBLOCK);
+
+        if (input_len == 0)
+        {
+            close(in_pipe[1]);
+            in_pipe[1] = -1;
+        }
+    }
+
+    // feed the input and collect the output until the command closes its output
+    while (out_pipe[0] != -1)
+    {
+        int wait_ms = -1;
+
+        if (deadline_ptr)
+        {
+            wait_ms = exec_remaining_ms(deadline_ptr);
+            if (wait_ms == 0)
+            {
+                goto timeout_out;
+            }
+        }
+
+        fds[0] = (struct pollfd){.fd = out_pipe[0], .events = POLLIN};
+        fds_count = 1;
+        if (in_pipe[1] != -1)
+        {
+            fds[1] = (struct pollfd){.fd = in_pipe[1], .events = POLLOUT};
+            fds_count = 2;
+        }
+
+        if (poll(fds, fds_count, wait_ms) == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "poll() error (%s)", strerror(errno));
+            goto error_out;
+        }
+
+        if (fds_count == 2 && fds[1].revents)
+        {
+            rc = write(in_pipe[1], input + written, input_len - written);
+            if (rc > 0)
+            {
+                written += (size_t)rc;
+            }
+
+            // the command stopped reading its input - keep collecting the output anyway
+            if (written == input_len || (rc == -1 && errno != EAGAIN && errno != EINTR))
+            {
+                close(in_pipe[1]);
+                in_pipe[1] = -1;
+            }
+        }
+
+        if (fds[0].revents)
+        {
+            SRPC_SAFE_CALL_ERR(error,
+                               exec_buffer_reserve(&output->data, &output->size,
+                                                   output->len + SRPC_EXEC_BUFFER_SIZE + 1),
+                               error_out);
+
+            rc = read(out_pipe[0], output->data + output->len, SRPC_EXEC_BUFFER_SIZE);
+            if (rc > 0)
+            {
+                output->len += (size_t)rc;
+                output->data[output->len] = 0;
+            }
+            else if (rc == 0)
+            {
+                close(out_pipe[0]);
+                out_pipe[0] = -1;
+            }
+            else if (errno != EAGAIN && errno != EINTR)
+            {
+                SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "read() error (%s)", strerror(errno));
+                goto error_out;
+            }
+        }
+    }
+
+    error = exec_wait(pid, deadline_ptr, &status);
+    if (error == 1)
+    {
+        goto timeout_out;
+    }
+    else if (error)
+    {
+        goto error_out;
+    }
+    pid = -1;
+
+    output->exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    error = output->exit_status == 0 ? 0 : -1;
+
+    goto out;
+
+timeout_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Command \"%s\" timed out after %d ms", argv[0], timeout_ms);
+    output->timed_out = true;
+
+error_out:
+    error = -1;
+
+out:
+    if (pid > 0)
+    {
+        kill(pid, SIGKILL);
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR)
+        {
+        }
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (in_pipe[i] != -1)
+        {
+            close(in_pipe[i]);
+        }
+        if (out_pipe[i] != -1)
+        {
+            close(out_pipe[i]);
+        }
+    }
+
+    if (mask_changed)
+    {
+        // drop a SIGPIPE raised by this call so it is not delivered once unblocked
+        if (!sigpipe_pending)
+        {
+            sigtimedwait(&sigpipe_set, NULL, &no_wait);
+        }
+        pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+    }
+
+    if (actions_init)
+    {
+        posix_spawn_file_actions_destroy(&actions);
+    }
+
+    if (attr_init)
+    {
+        posix_spawnattr_destroy(&attr);
+    }
+
+    return error;
+}
+
+/**
+ * Free the buffer of the command output.
+ *
+ * @param output Command output.
+ *
+ */
+void srpc_exec_output_free(srpc_exec_output_t *output)
+{
+    free(output->data);
+    *output = (srpc_exec_output_t){0};
+}
+
+/**
+ * Create a new batch of commands for a program which reads its commands from the standard input, for example
+ * "ip -batch -" or "bridge -batch -".
+ *
+ * @param argv Command and its arguments, NULL terminated.
+ *
+ * @return New command batch, NULL on error.
+ */
+srpc_exec_batch_t *srpc_exec_batch_new(const char *const argv[])
+{
+    srpc_exec_batch_t *batch = NULL;
+    size_t argc = 0;
+
+    while (argv[argc])
+    {
+        ++argc;
+    }
+
+    SRPC_SAFE_CALL_PTR(batch, calloc(1, sizeof(*batch)), error_out);
+    SRPC_SAFE_CALL_PTR(batch->argv, calloc(argc + 1, sizeof(*batch->argv)), error_out);
+
+    for (size_t i = 0; i < argc; i++)
+    {
+        SRPC_SAFE_CALL_PTR(batch->argv[i], strdup(argv[i]), error_out);
+    }
+
+    return batch;
+
+error_out:
+    srpc_exec_batch_free(&batch);
+
+    return NULL;
+}
+
+/**
+ * Append a single command line to the batch.
+ *
+ * @param batch Command batch.
+ * @param format Printf like format of the command line - new line is appended automatically.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_exec_batch_add(srpc_exec_batch_t *batch, const char *format, ...)
+{
+    int error = 0;
+    int line_len = 0;
+    va_list args;
+
+    va_start(args, format);
+    line_len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    if (line_len < 0)
+    {
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR(
+        error, exec_buffer_reserve(&batch->input, &batch->input_size, batch->input_len + (size_t)line_len + 2),
+        error_out);
+
+    va_start(args, format);
+    vsnprintf(batch->input + batch->input_len, (size_t)line_len + 1, format, args);
+    va_end(args);
+
+    batch->input_len += (size_t)line_len;
+    batch->input[batch->input_len++] = '\n';
+    batch->input[batch->input_len] = 0;
+    ++batch->count;
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Get the number of command lines added to the batch since the last run.
+ *
+ * @param batch Command batch.
+ *
+ * @return Number of command lines.
+ */
+size_t srpc_exec_batch_count(const srpc_exec_batch_t *batch)
+{
+    return batch->count;
+}
+
+/**
+ * Run the batch command once with all added command lines fed to its standard input and clear the batch.
+ * Nothing is executed if the batch is empty.
+ *
+ * @param batch Command batch.
+ * @param timeout_ms Timeout after which the command is killed - 0 or less for no timeout.
+ * @param output Captured output and exit status of the command.
+ *
+ * @return Error code - 0 if the command was executed and exited with status 0.
+ */
+int srpc_exec_batch_run(srpc_exec_batch_t *batch, int timeout_ms, srpc_exec_output_t *output)
+{
+    int error = 0;
+
+    if (batch->count == 0)
+    {
+        output->len = 0;
+        output->exit_status = 0;
+        output->timed_out = false;
+        return 0;
+    }
+
+    error = srpc_exec((const char *const *)batch->argv, batch->input, batch->input_len, timeout_ms, output);
+
+    batch->input_len = 0;
+    batch->count = 0;
+
+    return error;
+}
+
+/**
+ * Free the command batch.
+ *
+ * @param batch Command batch.
+ *
+ */
+void srpc_exec_batch_free(srpc_exec_batch_t **batch)
+{
+    srpc_exec_batch_t *b = *batch;
+
+    if (!b)
+    {
+        return;
+    }
+
+    if (b->argv)
+    {
+        for (size_t i = 0; b->argv[i]; i++)
+        {
+            free(b->argv[i]);
+        }
+        free(b->argv);
+    }
+
+    free(b->input);
+    free(b);
+
+    *batch = NULL;
+}
+
+/**
+ * Grow a buffer to hold at least the needed number of bytes.
+ *
+ * @param buffer Buffer to grow.
+ * @param size Allocated size of the buffer.
+ * @param needed Needed size.
+ *
+ * @return Error code - 0 on success.
+ */
+static int exec_buffer_reserve(char **buffer, size_t *size, size_t needed)
+{
+    size_t new_size = *size ? *size : SRPC_EXEC_BUFFER_SIZE;
+    char *new_buffer = NULL;
+
+    if (*buffer && *size >= needed)
+    {
+        return 0;
+    }
+
+    while (new_size < needed)
+    {
+        new_size *= 2;
+    }
+
+    new_buffer = realloc(*buffer, new_size);
+    if (!new_buffer)
+    {
+        return -1;
+    }
+
+    *buffer = new_buffer;
+    *size = new_size;
+
+    return 0;
+}
+
+/**
+ * Get the number of milliseconds remaining until the deadline.
+ *
+ * @param deadline Deadline on the monotonic clock.
+ *
+ * @return Remaining milliseconds, 0 if the deadline has passed.
+ */
+static int exec_remaining_ms(const struct timespec *deadline)
+{
+    struct timespec now = {0};
+    long long remaining = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    remaining = (long long)(deadline->tv_sec - now.tv_sec) * 1000LL + (deadline->tv_nsec - now.tv_nsec) / 1000000L;
+    if (remaining <= 0)
+    {
+        // round a sub-millisecond remainder up so poll() does not spin
+        return (deadline->tv_sec > now.tv_sec || (deadline->tv_sec == now.tv_sec && deadline->tv_nsec > now.tv_nsec))
+                   ? 1
+                   : 0;
+    }
+
+    return remaining > 60 * 60 * 1000LL ? 60 * 60 * 1000 : (int)remaining;
+}
+
+/**
+ * Wait for the command to exit.
+ *
+ * @param pid Process ID of the command.
+ * @param deadline Deadline on the monotonic clock - NULL to wait without a timeout.
+ * @param status Wait status of the command.
+ *
+ * @return Error code - 0 on success, 1 if the deadline has passed.
+ */
+static int exec_wait(pid_t pid, const struct timespec *deadline, int *status)
+{
+    const struct timespec interval = {.tv_sec = 0, .tv_nsec = 1000000L};
+    pid_t rc = 0;
+
+    while (true)
+    {
+        rc = waitpid(pid, status, deadline ? WNOHANG : 0);
+        if (rc == pid)
+        {
+            return 0;
+        }
+
+        if (rc == -1 && errno != EINTR)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "waitpid() error (%s)", strerror(errno));
+            return -1;
+        }
+
+        if (deadline && rc == 0)
+        {
+            // the command closed its output but is still running
+            if (exec_remaining_ms(deadline) == 0)
+            {
+                return 1;
+            }
+            nanosleep(&interval, NULL);
+        }
+    }
+}
@@ -135,4 +135,77 @@ int srpc_copy_file(const char *source, const char *destination);
 int srpc_extract_xpath_key_value(const char *xpath, const char *list, const char *key, char *buffer,
                                  size_t buffer_size);
 
+/**
+ * Execute a command without a shell and capture its output. The command is started using posix_spawn() which avoids
+ * copying the address space of the calling process. The standard output and standard error are captured into the
+ * output buffer which is reused between calls - initialize it to zero before the first call.
+ *
+ * @param argv Command and its arguments, NULL terminated - the command is looked up in PATH.
+ * @param input Data to feed to the standard input of the command - can be NULL.
+ * @param input_len Length of the input data.
+ * @param timeout_ms Timeout after which the command is killed - 0 or less for no timeout.
+ * @param output Captured output and exit status of the command.
+ *
+ * @return Error code - 0 if the command was executed and exited with status 0.
+ */
+int srpc_exec(const char *const argv[], const char *input, size_t input_len, int timeout_ms,
+              srpc_exec_output_t *output);
+
+/**
+ * Free the buffer of the command output.
+ *
+ * @param output Command output.
+ *
+ */
+void srpc_exec_output_free(srpc_exec_output_t *output);
+
+/**
+ * Create a new batch of commands for a program which reads its commands from the standard input, for example
+ * "ip -batch -" or "bridge -batch -".
+ *
+ * @param argv Command and its arguments, NULL terminated.
+ *
+ * @return New command batch, NULL on error.
+ */
+srpc_exec_batch_t *srpc_exec_batch_new(const char *const argv[]);
+
+/**
+ * Append a single command line to the batch.
+ *
+ * @param batch Command batch.
+ * @param format Printf like format of the command line - new line is appended automatically.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_exec_batch_add(srpc_exec_batch_t *batch, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Get the number of command lines added to the batch since the last run.
+ *
+ * @param batch Command batch.
+ *
+ * @return Number of command lines.
+ */
+size_t srpc_exec_batch_count(const srpc_exec_batch_t *batch);
+
+/**
+ * Run the batch command once with all added command lines fed to its standard input and clear the batch.
+ * Nothing is executed if the batch is empty.
+ *
+ * @param batch Command batch.
+ * @param timeout_ms Timeout after which the command is killed - 0 or less for no timeout.
+ * @param output Captured output and exit status of the command.
+ *
+ * @return Error code - 0 if the command was executed and exited with status 0.
+ */
+int srpc_exec_batch_run(srpc_exec_batch_t *batch, int timeout_ms, srpc_exec_output_t *output);
+
+/**
+ * Free the command batch.
+ *
+ * @param batch Command batch.
+ *
+ */
+void srpc_exec_batch_free(srpc_exec_batch_t **batch);
+
 #endif // SRPC_COMMON_H
\ No newline at end of file
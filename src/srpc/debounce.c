@@ -0,0 +1,563 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "debounce.h"
+#include "common.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uthash.h>
+
+// Number of retries of a failed apply before the intent is dropped.
+#define DEBOUNCE_RETRY_MAX 5
+
+typedef struct srpc_debounce_entry_s srpc_debounce_entry_t;
+
+/**
+ * Pending intent of a single resource.
+ */
+struct srpc_debounce_entry_s
+{
+    char *resource;              ///< Key - resource name.
+    void *intent;                ///< Merged intent.
+    uint64_t first_ms;           ///< Time of the first pending intent.
+    uint64_t last_ms;            ///< Time of the last enqueued intent.
+    uint64_t retry_ms;           ///< Time of the next retry after a failed apply, 0 if the apply didn't fail.
+    uint32_t retries;            ///< Number of failed applies.
+    srpc_debounce_entry_t *next; ///< Next entry taken for applying.
+    UT_hash_handle hh;           ///< UTHash reserved data.
+};
+
+/**
+ * Debouncer - pending intents and the timer thread state.
+ */
+struct srpc_debounce_s
+{
+    void *priv;                      ///< Private data passed to the callbacks.
+    uint32_t quiet_ms;               ///< Quiet period.
+    uint32_t max_delay_ms;           ///< Maximum delay of a pending resource.
+    srpc_debounce_merge_cb merge_cb; ///< Merge callback, can be NULL.
+    srpc_debounce_apply_cb apply_cb; ///< Apply callback.
+    srpc_debounce_free_cb free_cb;   ///< Free callback, can be NULL.
+    srpc_debounce_entry_t *entries;  ///< Pending entries hashed by resource.
+    int last_error;                  ///< Error of the timer thread applies since the last flush.
+    bool stop;                       ///< Thread stop request.
+    pthread_t thread;                ///< Timer thread.
+    pthread_mutex_t lock;            ///< Lock for the pending entries and the thread state.
+    pthread_mutex_t apply_lock;      ///< Serializes applies of the timer thread and flushes.
+    pthread_cond_t cond;             ///< Signaled on new entries and stop requests.
+};
+
+static void *debounce_thread(void *arg);
+static int debounce_apply(srpc_debounce_t *debounce, const char *resource, bool due_only);
+static void debounce_requeue(srpc_debounce_t *debounce, srpc_debounce_entry_t *entry);
+static uint64_t debounce_due_ms(const srpc_debounce_t *debounce, const srpc_debounce_entry_t *entry);
+static uint64_t debounce_now_ms(void);
+static void debounce_entry_free(srpc_debounce_t *debounce, srpc_debounce_entry_t *entry);
+
+/**
+ * Create a new debouncer and start its timer thread. Change callbacks enqueue their intents keyed by the system
+ * resource they touch (for example an interface or a configuration file) and the debouncer applies each resource once
+ * after no new intent has arrived for the quiet period, or at the latest after the maximum delay.
+ * An intent whose apply failed stays pending - merged with intents enqueued meanwhile - and is retried after the quiet
+ * period, doubled with each failure. After 5 failed retries the intent is dropped and the error is reported by the
+ * next flush.
+ *
+ * @param priv Private user data passed to the callbacks - pass plugin context.
+ * @param quiet_ms Time without new intents for a resource after which it gets applied.
+ * @param max_delay_ms Maximum time from the first pending intent of a resource to its apply.
+ * @param merge_cb Callback for merging intents of the same resource - if NULL the latest intent replaces the older.
+ * @param apply_cb Callback for applying the merged intent of a resource.
+ * @param free_cb Callback for freeing intents - can be NULL if intents are not allocated.
+ *
+ * @return New debouncer, NULL on error.
+ */
+srpc_debounce_t *srpc_debounce_new(void *priv, uint32_t quiet_ms, uint32_t max_delay_ms,
+                                   srpc_debounce_merge_cb merge_cb, srpc_debounce_apply_cb apply_cb,
+                                   srpc_debounce_free_cb free_cb)
+{
+    srpc_debounce_t *debounce = NULL;
+    pthread_condattr_t cond_attr;
+    bool lock_init = false, apply_lock_init = false, cond_init = false;
+
+    SRPC_SAFE_CALL_PTR(debounce, calloc(1, sizeof(*debounce)), error_out);
+
+    debounce->priv = priv;
+    debounce->quiet_ms = quiet_ms;
+    debounce->max_delay_ms = max_delay_ms < quiet_ms ? quiet_ms : max_delay_ms;
+    debounce->merge_cb = merge_cb;
+    debounce->apply_cb = apply_cb;
+    debounce->free_cb = free_cb;
+
+    lock_init = pthread_mutex_init(&debounce->lock, NULL) == 0;
+    apply_lock_init = pthread_mutex_init(&debounce->apply_lock, NULL) == 0;
+
+    // use monotonic clock for the timers
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    cond_init = pthread_cond_init(&debounce->cond, &cond_attr) == 0;
+    pthread_condattr_destroy(&cond_attr);
+
+    if (!lock_init || !apply_lock_init || !cond_init)
+    {
+        goto error_out;
+    }
+
+    if (pthread_create(&debounce->thread, NULL, debounce_thread, debounce) != 0)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to start debounce thread");
+        goto error_out;
+    }
+
+    return debounce;
+
+error_out:
+    if (debounce)
+    {
+        if (cond_init)
+        {
+            pthread_cond_destroy(&debounce->cond);
+        }
+        if (apply_lock_init)
+        {
+            pthread_mutex_destroy(&debounce->apply_lock);
+        }
+        if (lock_init)
+        {
+            pthread_mutex_destroy(&debounce->lock);
+        }
+        free(debounce);
+    }
+
+    return NULL;
+}
+
+/**
+ * Enqueue an intent for a resource. The debouncer takes ownership of the intent, also on error.
+ *
+ * @param debounce Debouncer.
+ * @param resource Resource key.
+ * @param intent Intent to merge into the pending intent of the resource.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_debounce_enqueue(srpc_debounce_t *debounce, const char *resource, void *intent)
+{
+    int error = 0;
+    srpc_debounce_entry_t *entry = NULL;
+    void *dropped = NULL;
+    uint64_t now = debounce_now_ms();
+
+    pthread_mutex_lock(&debounce->lock);
+
+    HASH_FIND_STR(debounce->entries, resource, entry);
+    if (entry)
+    {
+        if (debounce->merge_cb)
+        {
+            // the merged intent stays pending, the enqueued one is consumed
+            dropped = intent;
+            error = debounce->merge_cb(debounce->priv, resource, entry->intent, intent);
+            if (error)
+            {
+                SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to merge intent for resource \"%s\" (%d)", resource, error);
+                goto error_out;
+            }
+        }
+        else
+        {
+            // latest intent wins
+            dropped = entry->intent;
+            entry->intent = intent;
+        }
+
+        entry->last_ms = now;
+    }
+    else
+    {
+        SRPC_SAFE_CALL_PTR(entry, calloc(1, sizeof(*entry)), error_out);
+        entry->resource = strdup(resource);
+        if (!entry->resource)
+        {
+            free(entry);
+            goto error_out;
+        }
+
+        entry->intent = intent;
+        entry->first_ms = now;
+        entry->last_ms = now;
+        HASH_ADD_KEYPTR(hh, debounce->entries, entry->resource, strlen(entry->resource), entry);
+    }
+
+    pthread_cond_signal(&debounce->cond);
+
+    goto out;
+
+error_out:
+    dropped = intent;
+    error = -1;
+
+out:
+    pthread_mutex_unlock(&debounce->lock);
+
+    if (dropped && debounce->free_cb)
+    {
+        debounce->free_cb(dropped);
+    }
+
+    return error;
+}
+
+/**
+ * Synchronously apply pending intents on the calling thread - use when the system has to be consistent before the
+ * callback returns, for example in SR_EV_DONE. Waits for an apply already running on the timer thread.
+ *
+ * @param debounce Debouncer.
+ * @param resource Resource to apply - NULL to apply all pending resources.
+ *
+ * @return Error code - 0 on success, also reports errors of applies done on the timer thread since the last flush.
+ * Failed resources stay pending and are retried by the timer thread.
+ */
+int srpc_debounce_flush(srpc_debounce_t *debounce, const char *resource)
+{
+    int error = 0;
+
+    error = debounce_apply(debounce, resource, false);
+
+    pthread_mutex_lock(&debounce->lock);
+    if (!error)
+    {
+        error = debounce->last_error;
+    }
+    debounce->last_error = 0;
+    pthread_mutex_unlock(&debounce->lock);
+
+    return error;
+}
+
+/**
+ * Get the number of resources waiting to be applied.
+ *
+ * @param debounce Debouncer.
+ *
+ * @return Number of pending resources.
+ */
+size_t srpc_debounce_pending_count(srpc_debounce_t *debounce)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&debounce->lock);
+    count = HASH_COUNT(debounce->entries);
+    pthread_mutex_unlock(&debounce->lock);
+
+    return count;
+}
+
+/**
+ * Stop the timer thread, apply all pending intents and free the debouncer.
+ *
+ * @param debounce Debouncer.
+ *
+ */
+void srpc_debounce_free(srpc_debounce_t **debounce)
+{
+    srpc_debounce_t *d = *debounce;
+    srpc_debounce_entry_t *entry = NULL, *tmp = NULL;
+
+    if (!d)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&d->lock);
+    d->stop = true;
+    pthread_cond_signal(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+
+    pthread_join(d->thread, NULL);
+
+    // don't lose configuration which was already acknowledged to sysrepo
+    debounce_apply(d, NULL, false);
+
+    // failed applies were put back - there is no thread left to retry them
+    HASH_ITER(hh, d->entries, entry, tmp)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Dropping intent for resource \"%s\" which failed to apply", entry->resource);
+        HASH_DEL(d->entries, entry);
+        debounce_entry_free(d, entry);
+    }
+
+    pthread_cond_destroy(&d->cond);
+    pthread_mutex_destroy(&d->apply_lock);
+    pthread_mutex_destroy(&d->lock);
+    free(d);
+
+    *debounce = NULL;
+}
+
+/**
+ * Timer thread - applies resources once they are due.
+ *
+ * @param arg Debouncer.
+ *
+ * @return Always NULL.
+ */
+static void *debounce_thread(void *arg)
+{
+    srpc_debounce_t *debounce = arg;
+    srpc_debounce_entry_t *entry = NULL, *tmp = NULL;
+    uint64_t due_ms = 0;
+    uint64_t now = 0;
+    struct timespec ts = {0};
+    bool has_due = false;
+
+    pthread_mutex_lock(&debounce->lock);
+
+    while (!debounce->stop)
+    {
+        has_due = false;
+        HASH_ITER(hh, debounce->entries, entry, tmp)
+        {
+            uint64_t entry_due = debounce_due_ms(debounce, entry);
+            if (!has_due || entry_due < due_ms)
+            {
+                due_ms = entry_due;
+                has_due = true;
+            }
+        }
+
+        if (!has_due)
+        {
+            pthread_cond_wait(&debounce->cond, &debounce->lock);
+            continue;
+        }
+
+        now = debounce_now_ms();
+        if (now < due_ms)
+        {
+            ts.tv_sec = (time_t)(due_ms / 1000);
+            ts.tv_nsec = (long)(due_ms % 1000) * 1000000L;
+            pthread_cond_timedwait(&debounce->cond, &debounce->lock, &ts);
+            continue;
+        }
+
+        pthread_mutex_unlock(&debounce->lock);
+        debounce_apply(debounce, NULL, true);
+        pthread_mutex_lock(&debounce->lock);
+    }
+
+    pthread_mutex_unlock(&debounce->lock);
+
+    return NULL;
+}
+
+/**
+ * Take pending entries and apply them. Applies are serialized so a flush returns only after an apply of the same
+ * resource running on the timer thread has finished.
+ *
+ * @param debounce Debouncer.
+ * @param resource Resource to apply - NULL for all resources.
+ * @param due_only Apply only the entries whose quiet period or maximum delay has passed.
+ *
+ * @return Error code - 0 on success.
+ */
+static int debounce_apply(srpc_debounce_t *debounce, const char *resource, bool due_only)
+{
+    int error = 0;
+    int apply_error = 0;
+    srpc_debounce_entry_t *entry = NULL, *tmp = NULL;
+    srpc_debounce_entry_t *taken = NULL;
+    uint64_t now = debounce_now_ms();
+
+    pthread_mutex_lock(&debounce->apply_lock);
+
+    pthread_mutex_lock(&debounce->lock);
+    if (resource)
+    {
+        HASH_FIND_STR(debounce->entries, resource, entry);
+        if (entry)
+        {
+            HASH_DEL(debounce->entries, entry);
+            taken = entry;
+        }
+    }
+    else
+    {
+        HASH_ITER(hh, debounce->entries, entry, tmp)
+        {
+            if (!due_only || debounce_due_ms(debounce, entry) <= now)
+            {
+                HASH_DEL(debounce->entries, entry);
+                entry->next = taken;
+                taken = entry;
+            }
+        }
+    }
+    pthread_mutex_unlock(&debounce->lock);
+
+    // apply without holding the entries lock - callbacks keep enqueueing meanwhile
+    while (taken)
+    {
+        entry = taken;
+        taken = entry->next;
+
+        apply_error = debounce->apply_cb(debounce->priv, entry->resource, entry->intent);
+        if (apply_error)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to apply resource \"%s\" (%d)", entry->resource, apply_error);
+            error = apply_error;
+            debounce_requeue(debounce, entry);
+            continue;
+        }
+
+        debounce_entry_free(debounce, entry);
+    }
+
+    if (error && due_only)
+    {
+        pthread_mutex_lock(&debounce->lock);
+        debounce->last_error = error;
+        pthread_mutex_unlock(&debounce->lock);
+    }
+
+    pthread_mutex_unlock(&debounce->apply_lock);
+
+    return error;
+}
+
+/**
+ * Put an entry whose apply failed back to the pending entries. An intent enqueued for the resource meanwhile is merged
+ * into the failed one, or replaces it if there is no merge callback. Takes ownership of the entry.
+ *
+ * @param debounce Debouncer.
+ * @param entry Entry whose apply failed.
+ *
+ */
+static void debounce_requeue(srpc_debounce_t *debounce, srpc_debounce_entry_t *entry)
+{
+    srpc_debounce_entry_t *newer = NULL;
+    srpc_debounce_entry_t *dropped = NULL;
+    uint64_t now = debounce_now_ms();
+    int error = 0;
+
+    if (++entry->retries > DEBOUNCE_RETRY_MAX)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Dropping intent for resource \"%s\" after %u failed applies", entry->resource,
+                      entry->retries);
+        debounce_entry_free(debounce, entry);
+        return;
+    }
+
+    entry->retry_ms = now + ((uint64_t)debounce->quiet_ms << (entry->retries - 1));
+
+    pthread_mutex_lock(&debounce->lock);
+
+    HASH_FIND_STR(debounce->entries, entry->resource, newer);
+    if (!newer)
+    {
+        entry->first_ms = now;
+        entry->last_ms = now;
+        HASH_ADD_KEYPTR(hh, debounce->entries, entry->resource, strlen(entry->resource), entry);
+    }
+    else if (!debounce->merge_cb)
+    {
+        // latest intent wins
+        dropped = entry;
+    }
+    else if ((error = debounce->merge_cb(debounce->priv, entry->resource, entry->intent, newer->intent)))
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to merge intent for resource \"%s\" (%d) - dropping the failed one",
+                      entry->resource, error);
+        dropped = entry;
+    }
+    else
+    {
+        // the newer intent is applied on top of the failed one - keep the newer timing and the retry state
+        void *merged = entry->intent;
+
+        entry->intent = newer->intent;
+        newer->intent = merged;
+        newer->retries = entry->retries;
+        newer->retry_ms = entry->retry_ms;
+        dropped = entry;
+    }
+
+    pthread_cond_signal(&debounce->cond);
+
+    pthread_mutex_unlock(&debounce->lock);
+
+    if (dropped)
+    {
+        debounce_entry_free(debounce, dropped);
+    }
+}
+
+/**
+ * Get the time at which an entry should be applied.
+ *
+ * @param debounce Debouncer.
+ * @param entry Pending entry.
+ *
+ * @return Due time in milliseconds of the monotonic clock.
+ */
+static uint64_t debounce_due_ms(const srpc_debounce_t *debounce, const srpc_debounce_entry_t *entry)
+{
+    uint64_t quiet_due = entry->last_ms + debounce->quiet_ms;
+    uint64_t max_due = entry->first_ms + debounce->max_delay_ms;
+
+    if (entry->retry_ms)
+    {
+        // failed apply - retried after the backoff
+        return entry->retry_ms;
+    }
+
+    return quiet_due < max_due ? quiet_due : max_due;
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in milliseconds.
+ */
+static uint64_t debounce_now_ms(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Free a pending entry and its intent.
+ *
+ * @param debounce Debouncer.
+ * @param entry Entry to free.
+ *
+ */
+static void debounce_entry_free(srpc_debounce_t *debounce, srpc_debounce_entry_t *entry)
+{
+    if (debounce->free_cb && entry->intent)
+    {
+        debounce->free_cb(entry->intent);
+    }
+
+    free(entry->resource);
+    free(entry);
+}
@@ -0,0 +1,88 @@
+/**
+ * @file debounce.h
+ * @brief API for coalescing system apply work across multiple commits.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_DEBOUNCE_H
+#define SRPC_DEBOUNCE_H
+
+#include "types.h"
+
+#include <stdint.h>
+
+/**
+ * Create a new debouncer and start its timer thread. Change callbacks enqueue their intents keyed by the system
+ * resource they touch (for example an interface or a configuration file) and the debouncer applies each resource once
+ * after no new intent has arrived for the quiet period, or at the latest after the maximum delay.
+ * An intent whose apply failed stays pending - merged with intents enqueued meanwhile - and is retried after the quiet
+ * period, doubled with each failure. After 5 failed retries the intent is dropped and the error is reported by the
+ * next flush.
+ *
+ * @param priv Private user data passed to the callbacks - pass plugin context.
+ * @param quiet_ms Time without new intents for a resource after which it gets applied.
+ * @param max_delay_ms Maximum time from the first pending intent of a resource to its apply.
+ * @param merge_cb Callback for merging intents of the same resource - if NULL the latest intent replaces the older.
+ * @param apply_cb Callback for applying the merged intent of a resource.
+ * @param free_cb Callback for freeing intents - can be NULL if intents are not allocated.
+ *
+ * @return New debouncer, NULL on error.
+ */
+srpc_debounce_t *srpc_debounce_new(void *priv, uint32_t quiet_ms, uint32_t max_delay_ms,
+                                   srpc_debounce_merge_cb merge_cb, srpc_debounce_apply_cb apply_cb,
+                                   srpc_debounce_free_cb free_cb);
+
+/**
+ * Enqueue an intent for a resource. The debouncer takes ownership of the intent, also on error.
+ *
+ * @param debounce Debouncer.
+ * @param resource Resource key.
+ * @param intent Intent to merge into the pending intent of the resource.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_debounce_enqueue(srpc_debounce_t *debounce, const char *resource, void *intent);
+
+/**
+ * Synchronously apply pending intents on the calling thread - use when the system has to be consistent before the
+ * callback returns, for example in SR_EV_DONE. Waits for an apply already running on the timer thread.
+ *
+ * @param debounce Debouncer.
+ * @param resource Resource to apply - NULL to apply all pending resources.
+ *
+ * @return Error code - 0 on success, also reports errors of applies done on the timer thread since the last flush.
+ * Failed resources stay pending and are retried by the timer thread.
+ */
+int srpc_debounce_flush(srpc_debounce_t *debounce, const char *resource);
+
+/**
+ * Get the number of resources waiting to be applied.
+ *
+ * @param debounce Debouncer.
+ *
+ * @return Number of pending resources.
+ */
+size_t srpc_debounce_pending_count(srpc_debounce_t *debounce);
+
+/**
+ * Stop the timer thread, apply all pending intents and free the debouncer.
+ *
+ * @param debounce Debouncer.
+ *
+ */
+void srpc_debounce_free(srpc_debounce_t **debounce);
+
+#endif // SRPC_DEBOUNCE_H
@@ -0,0 +1,243 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "edit_buffer.h"
+#include "common.h"
+#include "ly_tree.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+/**
+ * Edit buffer - tree of the collected edits.
+ */
+struct srpc_edit_buffer_s
+{
+    sr_session_ctx_t *session;      ///< Session used for applying the edits.
+    sr_conn_ctx_t *conn_ctx;        ///< Connection of the session - holds the libyang context.
+    const struct ly_ctx *ly_ctx;    ///< libyang context of the connection.
+    char *default_operation;        ///< Default operation of the edit.
+    size_t chunk_size;              ///< Number of edits after which the tree is applied, 0 for no chunking.
+    struct lyd_node *tree;          ///< Collected edits.
+    size_t count;                   ///< Number of collected edits.
+    srpc_edit_buffer_stats_t stats; ///< Counters.
+};
+
+static int edit_buffer_apply_chunk(srpc_edit_buffer_t *buffer);
+static uint64_t edit_buffer_now_us(void);
+
+/**
+ * Create a new edit buffer. Edits are collected into a libyang tree and submitted with a single sr_edit_batch() and
+ * sr_apply_changes() instead of resolving every path with sr_set_item_str(). The libyang context of the session
+ * connection is held until the buffer is freed, so the buffer should be short-lived - create it for an import and
+ * free it afterwards.
+ *
+ * @param session Session used for applying the edits - switch it to the target datastore beforehand.
+ * @param default_operation Default operation of the edit - "merge", "replace" or "none", NULL for "merge".
+ * @param chunk_size Number of edits after which the collected tree is applied automatically - 0 to apply all edits
+ * at once in srpc_edit_buffer_apply(). Already applied chunks are not rolled back if a later chunk fails.
+ *
+ * @return New edit buffer, NULL on error.
+ */
+srpc_edit_buffer_t *srpc_edit_buffer_new(sr_session_ctx_t *session, const char *default_operation, size_t chunk_size)
+{
+    srpc_edit_buffer_t *buffer = NULL;
+
+    SRPC_SAFE_CALL_PTR(buffer, calloc(1, sizeof(*buffer)), error_out);
+    SRPC_SAFE_CALL_PTR(buffer->default_operation, strdup(default_operation ? default_operation : "merge"),
+                       error_out);
+    SRPC_SAFE_CALL_PTR(buffer->conn_ctx, sr_session_get_connection(session), error_out);
+    SRPC_SAFE_CALL_PTR(buffer->ly_ctx, sr_acquire_context(buffer->conn_ctx), error_out);
+
+    buffer->session = session;
+    buffer->chunk_size = chunk_size;
+
+    return buffer;
+
+error_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to create edit buffer");
+    if (buffer)
+    {
+        free(buffer->default_operation);
+        free(buffer);
+    }
+
+    return NULL;
+}
+
+/**
+ * Add a node to the collected edit. Parents along the path which are not in the edit yet are created.
+ *
+ * @param buffer Edit buffer.
+ * @param path Absolute path of the node.
+ * @param value Value of the node - NULL for containers and lists.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_edit_buffer_set(srpc_edit_buffer_t *buffer, const char *path, const char *value)
+{
+    int error = 0;
+    struct lyd_node *node = NULL;
+
+    // the new path is created as a separate tree and merged in - the merge finds the existing parents using the
+    // sibling hashes instead of resolving the whole path again
+    SRPC_SAFE_CALL_ERR(error, srpc_ly_tree_create_leaf(buffer->ly_ctx, NULL, &node, path, value), error_out);
+    SRPC_SAFE_CALL_ERR(error, lyd_merge_siblings(&buffer->tree, node, LYD_MERGE_DESTRUCT), error_out);
+    node = NULL;
+
+    buffer->count++;
+
+    if (buffer->chunk_size && buffer->count >= buffer->chunk_size)
+    {
+        SRPC_SAFE_CALL_ERR(error, edit_buffer_apply_chunk(buffer), error_out);
+    }
+
+    goto out;
+
+error_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to add \"%s\" to the edit buffer", path);
+    lyd_free_all(node);
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Get the number of collected edits which were not applied yet.
+ *
+ * @param buffer Edit buffer.
+ *
+ * @return Number of pending edits.
+ */
+size_t srpc_edit_buffer_count(srpc_edit_buffer_t *buffer)
+{
+    return buffer->count;
+}
+
+/**
+ * Apply all pending edits to the datastore. On error the pending edits are discarded.
+ *
+ * @param buffer Edit buffer.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_edit_buffer_apply(srpc_edit_buffer_t *buffer)
+{
+    if (!buffer->tree)
+    {
+        return 0;
+    }
+
+    return edit_buffer_apply_chunk(buffer);
+}
+
+/**
+ * Get the edit buffer counters.
+ *
+ * @param buffer Edit buffer.
+ * @param stats Counters output.
+ *
+ */
+void srpc_edit_buffer_get_stats(srpc_edit_buffer_t *buffer, srpc_edit_buffer_stats_t *stats)
+{
+    *stats = buffer->stats;
+}
+
+/**
+ * Free the edit buffer - pending edits are discarded, apply them beforehand.
+ *
+ * @param buffer Edit buffer.
+ *
+ */
+void srpc_edit_buffer_free(srpc_edit_buffer_t **buffer)
+{
+    srpc_edit_buffer_t *b = *buffer;
+
+    if (!b)
+    {
+        return;
+    }
+
+    // the tree has to be freed while the context is still held
+    lyd_free_all(b->tree);
+    sr_release_context(b->conn_ctx);
+
+    free(b->default_operation);
+    free(b);
+
+    *buffer = NULL;
+}
+
+/**
+ * Submit the collected tree as a single edit and apply it. The tree is freed in both cases.
+ *
+ * @param buffer Edit buffer.
+ *
+ * @return Error code - 0 on success.
+ */
+static int edit_buffer_apply_chunk(srpc_edit_buffer_t *buffer)
+{
+    int error = 0;
+    uint64_t start = edit_buffer_now_us();
+    uint64_t elapsed = 0;
+
+    SRPC_SAFE_CALL_ERR(error, sr_edit_batch(buffer->session, buffer->tree, buffer->default_operation), error_out);
+    SRPC_SAFE_CALL_ERR(error, sr_apply_changes(buffer->session, 0), error_out);
+
+    elapsed = edit_buffer_now_us() - start;
+
+    buffer->stats.edits += buffer->count;
+    buffer->stats.chunks++;
+    buffer->stats.total_us += elapsed;
+    buffer->stats.last_chunk_us = elapsed;
+    if (elapsed > buffer->stats.max_chunk_us)
+    {
+        buffer->stats.max_chunk_us = elapsed;
+    }
+
+    goto out;
+
+error_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to apply %zu buffered edits", buffer->count);
+    sr_discard_changes(buffer->session);
+    error = -1;
+
+out:
+    lyd_free_all(buffer->tree);
+    buffer->tree = NULL;
+    buffer->count = 0;
+
+    return error;
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in microseconds.
+ */
+static uint64_t edit_buffer_now_us(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file edit_buffer.h
+ * @brief API for collecting datastore edits into a single tree and applying them in bulk.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_EDIT_BUFFER_H
+#define SRPC_EDIT_BUFFER_H
+
+#include "types.h"
+
+#include <stddef.h>
+
+/**
+ * Create a new edit buffer. Edits are collected into a libyang tree and submitted with a single sr_edit_batch() and
+ * sr_apply_changes() instead of resolving every path with sr_set_item_str(). The libyang context of the session
+ * connection is held until the buffer is freed, so the buffer should be short-lived - create it for an import and
+ * free it afterwards.
+ *
+ * @param session Session used for applying the edits - switch it to the target datastore beforehand.
+ * @param default_operation Default operation of the edit - "merge", "replace" or "none", NULL for "merge".
+ * @param chunk_size Number of edits after which the collected tree is applied automatically - 0 to apply all edits
+ * at once in srpc_edit_buffer_apply(). Already applied chunks are not rolled back if a later chunk fails.
+ *
+ * @return New edit buffer, NULL on error.
+ */
+srpc_edit_buffer_t *srpc_edit_buffer_new(sr_session_ctx_t *session, const char *default_operation, size_t chunk_size);
+
+/**
+ * Add a node to the collected edit. Parents along the path which are not in the edit yet are created.
+ *
+ * @param buffer Edit buffer.
+ * @param path Absolute path of the node.
+ * @param value Value of the node - NULL for containers and lists.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_edit_buffer_set(srpc_edit_buffer_t *buffer, const char *path, const char *value);
+
+/**
+ * Get the number of collected edits which were not applied yet.
+ *
+ * @param buffer Edit buffer.
+ *
+ * @return Number of pending edits.
+ */
+size_t srpc_edit_buffer_count(srpc_edit_buffer_t *buffer);
+
+/**
+ * Apply all pending edits to the datastore. On error the pending edits are discarded.
+ *
+ * @param buffer Edit buffer.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_edit_buffer_apply(srpc_edit_buffer_t *buffer);
+
+/**
+ * Get the edit buffer counters.
+ *
+ * @param buffer Edit buffer.
+ * @param stats Counters output.
+ *
+ */
+void srpc_edit_buffer_get_stats(srpc_edit_buffer_t *buffer, srpc_edit_buffer_stats_t *stats);
+
+/**
+ * Free the edit buffer - pending edits are discarded, apply them beforehand.
+ *
+ * @param buffer Edit buffer.
+ *
+ */
+void srpc_edit_buffer_free(srpc_edit_buffer_t **buffer);
+
+#endif // SRPC_EDIT_BUFFER_H
@@ -16,6 +16,7 @@
 
 #include "feature_status.h"
 #include "common.h"
+#include "intern.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -95,7 +96,7 @@ int srpc_feature_status_hash_load(srpc_feature_status_hash_t **fs_hash, sr_sessi
             goto error_out;
         }
 
-        new_fs->id = strdup(feature);
+        new_fs->id = srpc_intern(feature);
         if (!new_fs->id)
         {
             goto error_out;
@@ -189,7 +190,7 @@ void srpc_feature_status_hash_free(srpc_feature_status_hash_t **fs_hash)
         HASH_DEL(*fs_hash, current);
 
         // free data
-        free((char *)current->id);
+        srpc_intern_release(current->id);
 
         // free allocated struct
         free(current);
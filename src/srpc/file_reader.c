@@ -0,0 +1,456 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "file_reader.h"
+#include "common.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <uthash.h>
+
+// Initial size of the read buffer - enough for all sysfs attributes.
+#define SRPC_FILE_READER_BUFFER_SIZE 4096
+
+typedef struct srpc_file_reader_file_s srpc_file_reader_file_t;
+
+/**
+ * Single kept open file.
+ */
+struct srpc_file_reader_file_s
+{
+    char *path;        ///< Key - file path.
+    int fd;            ///< File descriptor, -1 if closed.
+    size_t id;         ///< File ID - index into the files array.
+    UT_hash_handle hh; ///< UTHash reserved data.
+};
+
+/**
+ * File reader - kept open files and the reusable read buffer.
+ */
+struct srpc_file_reader_s
+{
+    srpc_file_reader_file_t *paths;  ///< Files hashed by path.
+    srpc_file_reader_file_t **files; ///< Files indexed by ID - removed files are NULL.
+    size_t files_count;              ///< Number of used IDs.
+    char *buffer;                    ///< Read buffer.
+    size_t buffer_size;              ///< Size of the read buffer.
+};
+
+static int file_reader_pread_all(srpc_file_reader_t *reader, int fd, size_t *len);
+static srpc_file_reader_file_t *file_reader_get(srpc_file_reader_t *reader, size_t id);
+static int file_reader_parse_uint(srpc_file_reader_t *reader, size_t id, int base, uint64_t *value);
+
+/**
+ * Create a new file reader. A reader is not thread safe - use one reader per thread.
+ *
+ * @return New file reader, NULL on error.
+ */
+srpc_file_reader_t *srpc_file_reader_new(void)
+{
+    srpc_file_reader_t *reader = NULL;
+
+    SRPC_SAFE_CALL_PTR(reader, calloc(1, sizeof(*reader)), error_out);
+    SRPC_SAFE_CALL_PTR(reader->buffer, malloc(SRPC_FILE_READER_BUFFER_SIZE), error_out);
+    reader->buffer_size = SRPC_FILE_READER_BUFFER_SIZE;
+
+    return reader;
+
+error_out:
+    free(reader);
+
+    return NULL;
+}
+
+/**
+ * Open a file and keep it open for reading. Adding an already added path returns its existing ID.
+ *
+ * @param reader File reader.
+ * @param path Path of the file.
+ * @param id ID of the file to use for reading.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_add(srpc_file_reader_t *reader, const char *path, size_t *id)
+{
+    int error = 0;
+    srpc_file_reader_file_t *file = NULL;
+    srpc_file_reader_file_t **files = NULL;
+    size_t free_id = 0;
+
+    HASH_FIND_STR(reader->paths, path, file);
+    if (file)
+    {
+        *id = file->id;
+        goto out;
+    }
+
+    // reuse IDs of removed files
+    for (free_id = 0; free_id < reader->files_count && reader->files[free_id]; free_id++)
+    {
+    }
+
+    if (free_id == reader->files_count)
+    {
+        SRPC_SAFE_CALL_PTR(files, realloc(reader->files, (reader->files_count + 1) * sizeof(*files)), error_out);
+        reader->files = files;
+        reader->files[reader->files_count++] = NULL;
+    }
+
+    SRPC_SAFE_CALL_PTR(file, calloc(1, sizeof(*file)), error_out);
+    file->fd = -1;
+    file->id = free_id;
+    SRPC_SAFE_CALL_PTR(file->path, strdup(path), error_out);
+    SRPC_SAFE_CALL_ERR_COND(file->fd, file->fd == -1, open(path, O_RDONLY | O_CLOEXEC), error_out);
+
+    reader->files[free_id] = file;
+    HASH_ADD_KEYPTR(hh, reader->paths, file->path, strlen(file->path), file);
+
+    *id = free_id;
+
+    goto out;
+
+error_out:
+    if (file)
+    {
+        free(file->path);
+        free(file);
+    }
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Close the file and forget its ID - use when the underlying object (for example an interface) is removed.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ *
+ */
+void srpc_file_reader_remove(srpc_file_reader_t *reader, size_t id)
+{
+    srpc_file_reader_file_t *file = file_reader_get(reader, id);
+
+    if (!file)
+    {
+        return;
+    }
+
+    HASH_DEL(reader->paths, file);
+    reader->files[id] = NULL;
+
+    if (file->fd != -1)
+    {
+        close(file->fd);
+    }
+    free(file->path);
+    free(file);
+}
+
+/**
+ * Read the whole file content into the reader buffer. The file is reopened once if reading the kept descriptor fails.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param data Null terminated file content - valid until the next read using the same reader.
+ * @param len Length of the content, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read(srpc_file_reader_t *reader, size_t id, const char **data, size_t *len)
+{
+    int error = 0;
+    size_t read_len = 0;
+    srpc_file_reader_file_t *file = NULL;
+
+    SRPC_SAFE_CALL_PTR(file, file_reader_get(reader, id), error_out);
+
+    if (file->fd == -1 || file_reader_pread_all(reader, file->fd, &read_len))
+    {
+        // the file could have been recreated (device re-added etc.) - try a fresh descriptor
+        if (file->fd != -1)
+        {
+            close(file->fd);
+        }
+
+        file->fd = open(file->path, O_RDONLY | O_CLOEXEC);
+        if (file->fd == -1 || file_reader_pread_all(reader, file->fd, &read_len))
+        {
+            goto error_out;
+        }
+    }
+
+    *data = reader->buffer;
+    if (len)
+    {
+        *len = read_len;
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Read the file and parse its content as a decimal unsigned integer - leading zeros don't select another base.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read_uint64(srpc_file_reader_t *reader, size_t id, uint64_t *value)
+{
+    return file_reader_parse_uint(reader, id, 10, value);
+}
+
+/**
+ * Read the file and parse its content as a hexadecimal unsigned integer, with or without the 0x prefix - for example
+ * interface flags.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read_hex64(srpc_file_reader_t *reader, size_t id, uint64_t *value)
+{
+    return file_reader_parse_uint(reader, id, 16, value);
+}
+
+/**
+ * Read the file and parse its content as a decimal signed integer.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read_int64(srpc_file_reader_t *reader, size_t id, int64_t *value)
+{
+    const char *data = NULL;
+    char *end = NULL;
+    long long parsed = 0;
+
+    if (srpc_file_reader_read(reader, id, &data, NULL))
+    {
+        return -1;
+    }
+
+    errno = 0;
+    parsed = strtoll(data, &end, 10);
+    if (errno || end == data || (*end && !isspace((unsigned char)*end)))
+    {
+        return -1;
+    }
+
+    *value = (int64_t)parsed;
+
+    return 0;
+}
+
+/**
+ * Read and parse multiple files as decimal unsigned integers - for example all statistics attributes of an interface.
+ *
+ * @param reader File reader.
+ * @param ids IDs of the files.
+ * @param values Parsed values - values of failed files are set to 0.
+ * @param errors Error code of each file - 0 on success, can be NULL.
+ * @param count Number of files.
+ *
+ * @return Number of files which failed to be read or parsed.
+ */
+size_t srpc_file_reader_read_batch(srpc_file_reader_t *reader, const size_t ids[], uint64_t values[], int errors[],
+                                   size_t count)
+{
+    size_t failed = 0;
+    int error = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        error = srpc_file_reader_read_uint64(reader, ids[i], &values[i]);
+        if (error)
+        {
+            values[i] = 0;
+            ++failed;
+        }
+
+        if (errors)
+        {
+            errors[i] = error;
+        }
+    }
+
+    return failed;
+}
+
+/**
+ * Close all files and free the reader.
+ *
+ * @param reader File reader.
+ *
+ */
+void srpc_file_reader_free(srpc_file_reader_t **reader)
+{
+    srpc_file_reader_t *r = *reader;
+
+    if (!r)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < r->files_count; i++)
+    {
+        srpc_file_reader_remove(r, i);
+    }
+
+    free(r->files);
+    free(r->buffer);
+    free(r);
+
+    *reader = NULL;
+}
+
+/**
+ * Read the whole file from its start into the reader buffer, growing the buffer if needed. A read which doesn't fill
+ * the buffer is taken as the end of the file, so attribute files are read with a single system call.
+ *
+ * @param reader File reader.
+ * @param fd File descriptor.
+ * @param len Number of read bytes.
+ *
+ * @return Error code - 0 on success.
+ */
+static int file_reader_pread_all(srpc_file_reader_t *reader, int fd, size_t *len)
+{
+    size_t total = 0;
+    size_t space = 0;
+    ssize_t rc = 0;
+    char *buffer = NULL;
+
+    while (true)
+    {
+        // keep space for the terminating null byte
+        if (total + 1 >= reader->buffer_size)
+        {
+            buffer = realloc(reader->buffer, reader->buffer_size * 2);
+            if (!buffer)
+            {
+                return -1;
+            }
+            reader->buffer = buffer;
+            reader->buffer_size *= 2;
+        }
+
+        space = reader->buffer_size - total - 1;
+        rc = pread(fd, reader->buffer + total, space, (off_t)total);
+        if (rc == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        total += (size_t)rc;
+
+        // only a full buffer can have more data behind it
+        if ((size_t)rc < space)
+        {
+            break;
+        }
+    }
+
+    reader->buffer[total] = 0;
+    *len = total;
+
+    return 0;
+}
+
+/**
+ * Read the file and parse its content as an unsigned integer.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param base Base of the number - 10 or 16.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+static int file_reader_parse_uint(srpc_file_reader_t *reader, size_t id, int base, uint64_t *value)
+{
+    const char *data = NULL;
+    char *end = NULL;
+    unsigned long long parsed = 0;
+
+    if (srpc_file_reader_read(reader, id, &data, NULL))
+    {
+        return -1;
+    }
+
+    while (isspace((unsigned char)*data))
+    {
+        ++data;
+    }
+
+    // rejects signs, which strtoull() accepts
+    if (!(base == 16 ? isxdigit((unsigned char)*data) : isdigit((unsigned char)*data)))
+    {
+        return -1;
+    }
+
+    errno = 0;
+    parsed = strtoull(data, &end, base);
+    if (errno || (*end && !isspace((unsigned char)*end)))
+    {
+        return -1;
+    }
+
+    *value = (uint64_t)parsed;
+
+    return 0;
+}
+
+/**
+ * Get a file by its ID.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ *
+ * @return File, NULL if the ID is invalid.
+ */
+static srpc_file_reader_file_t *file_reader_get(srpc_file_reader_t *reader, size_t id)
+{
+    if (id >= reader->files_count)
+    {
+        return NULL;
+    }
+
+    return reader->files[id];
+}
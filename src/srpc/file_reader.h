@@ -0,0 +1,123 @@
+/**
+ * @file file_reader.h
+ * @brief API for repeated reading of small sysfs and procfs files using persistent file descriptors.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_FILE_READER_H
+#define SRPC_FILE_READER_H
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Create a new file reader. A reader is not thread safe - use one reader per thread.
+ *
+ * @return New file reader, NULL on error.
+ */
+srpc_file_reader_t *srpc_file_reader_new(void);
+
+/**
+ * Open a file and keep it open for reading. Adding an already added path returns its existing ID.
+ *
+ * @param reader File reader.
+ * @param path Path of the file.
+ * @param id ID of the file to use for reading.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_add(srpc_file_reader_t *reader, const char *path, size_t *id);
+
+/**
+ * Close the file and forget its ID - use when the underlying object (for example an interface) is removed.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ *
+ */
+void srpc_file_reader_remove(srpc_file_reader_t *reader, size_t id);
+
+/**
+ * Read the whole file content into the reader buffer. The file is reopened once if reading the kept descriptor fails.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param data Null terminated file content - valid until the next read using the same reader.
+ * @param len Length of the content, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read(srpc_file_reader_t *reader, size_t id, const char **data, size_t *len);
+
+/**
+ * Read the file and parse its content as a decimal unsigned integer - leading zeros don't select another base.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read_uint64(srpc_file_reader_t *reader, size_t id, uint64_t *value);
+
+/**
+ * Read the file and parse its content as a hexadecimal unsigned integer, with or without the 0x prefix - for example
+ * interface flags.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read_hex64(srpc_file_reader_t *reader, size_t id, uint64_t *value);
+
+/**
+ * Read the file and parse its content as a decimal signed integer.
+ *
+ * @param reader File reader.
+ * @param id ID of the file.
+ * @param value Parsed value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_reader_read_int64(srpc_file_reader_t *reader, size_t id, int64_t *value);
+
+/**
+ * Read and parse multiple files as decimal unsigned integers - for example all statistics attributes of an interface.
+ *
+ * @param reader File reader.
+ * @param ids IDs of the files.
+ * @param values Parsed values - values of failed files are set to 0.
+ * @param errors Error code of each file - 0 on success, can be NULL.
+ * @param count Number of files.
+ *
+ * @return Number of files which failed to be read or parsed.
+ */
+size_t srpc_file_reader_read_batch(srpc_file_reader_t *reader, const size_t ids[], uint64_t values[], int errors[],
+                                   size_t count);
+
+/**
+ * Close all files and free the reader.
+ *
+ * @param reader File reader.
+ *
+ */
+void srpc_file_reader_free(srpc_file_reader_t **reader);
+
+#endif // SRPC_FILE_READER_H
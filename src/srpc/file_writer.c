@@ -0,0 +1,627 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "file_writer.h"
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef SRPC_HAVE_LIBURING
+#include <liburing.h>
+
+// Number of submission queue entries - each write uses two, one for writing and one for closing the file.
+#define SRPC_FILE_WRITER_RING_SIZE 64
+#endif
+
+typedef struct srpc_file_writer_entry_s srpc_file_writer_entry_t;
+
+/**
+ * Single queued attribute write.
+ */
+struct srpc_file_writer_entry_s
+{
+    char *path;         ///< Path of the attribute.
+    char *value;        ///< Value to write.
+    size_t value_len;   ///< Length of the value.
+    const void *change; ///< Change which caused the write.
+    int fd;             ///< Opened file, -1 if not open.
+    int error;          ///< errno value of the failed operation, 0 on success.
+    bool done;          ///< The write was processed.
+};
+
+/**
+ * File writer - queued writes and the io_uring instance.
+ */
+struct srpc_file_writer_s
+{
+    srpc_file_writer_entry_t *entries;    ///< Queued writes.
+    size_t entries_count;                 ///< Number of queued writes.
+    size_t entries_size;                  ///< Allocated number of entries.
+    srpc_file_writer_failure_t *failures; ///< Failures of the last flush.
+    size_t failures_size;                 ///< Allocated number of failures.
+    bool flushed;                         ///< The entries belong to the last flush and are cleared on next use.
+#ifdef SRPC_HAVE_LIBURING
+    struct io_uring ring; ///< Ring used for submitting the writes.
+    bool async;           ///< The ring is initialized and supports all used operations.
+#endif
+};
+
+static int file_writer_queue(srpc_file_writer_t *writer, const char *path, char *value, size_t value_len,
+                             const void *change);
+static void file_writer_clear(srpc_file_writer_t *writer);
+static void file_writer_write_sync(srpc_file_writer_entry_t *entry);
+#ifdef SRPC_HAVE_LIBURING
+static bool file_writer_ring_init(srpc_file_writer_t *writer);
+static int file_writer_write_async(srpc_file_writer_t *writer);
+static int file_writer_submit_round(srpc_file_writer_t *writer, srpc_file_writer_entry_t *entries, size_t count);
+static int file_writer_reap(srpc_file_writer_t *writer, unsigned submitted, bool open);
+#endif
+
+/**
+ * Create a new file writer. Attribute writes queued while iterating changes are submitted together on flush - as
+ * io_uring batches if the library is built with liburing and the kernel supports it, otherwise using a synchronous
+ * open, write and close loop. A writer is not thread safe - use one writer per thread.
+ *
+ * @return New file writer, NULL on error.
+ */
+srpc_file_writer_t *srpc_file_writer_new(void)
+{
+    srpc_file_writer_t *writer = NULL;
+
+    SRPC_SAFE_CALL_PTR(writer, calloc(1, sizeof(*writer)), error_out);
+
+#ifdef SRPC_HAVE_LIBURING
+    writer->async = file_writer_ring_init(writer);
+    if (!writer->async)
+    {
+        SRPLG_LOG_INF(SRPC_PLUGIN_NAME, "io_uring not available, using synchronous attribute writes");
+    }
+#endif
+
+    return writer;
+
+error_out:
+    return NULL;
+}
+
+/**
+ * Check whether the writer submits the writes using io_uring.
+ *
+ * @param writer File writer.
+ *
+ * @return True if io_uring is used, false for the synchronous fallback.
+ */
+bool srpc_file_writer_is_async(srpc_file_writer_t *writer)
+{
+#ifdef SRPC_HAVE_LIBURING
+    return writer->async;
+#else
+    (void)writer;
+    return false;
+#endif
+}
+
+/**
+ * Queue an attribute write. The path and value are copied.
+ *
+ * @param writer File writer.
+ * @param path Path of the attribute - for example /proc/sys/net/ipv6/conf/eth0/mtu.
+ * @param value Value to write.
+ * @param change Change which caused the write, returned with a failure - usually the changed node, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_writer_add(srpc_file_writer_t *writer, const char *path, const char *value, const void *change)
+{
+    char *copy = strdup(value);
+
+    if (!copy)
+    {
+        return -1;
+    }
+
+    return file_writer_queue(writer, path, copy, strlen(copy), change);
+}
+
+/**
+ * Queue an attribute write with a formatted value.
+ *
+ * @param writer File writer.
+ * @param path Path of the attribute.
+ * @param change Change which caused the write, can be NULL.
+ * @param format Printf like format of the value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_writer_addf(srpc_file_writer_t *writer, const char *path, const void *change, const char *format, ...)
+{
+    char *value = NULL;
+    int value_len = 0;
+    va_list args;
+
+    va_start(args, format);
+    value_len = vasprintf(&value, format, args);
+    va_end(args);
+
+    if (value_len < 0)
+    {
+        return -1;
+    }
+
+    return file_writer_queue(writer, path, value, (size_t)value_len, change);
+}
+
+/**
+ * Get the number of queued writes.
+ *
+ * @param writer File writer.
+ *
+ * @return Number of writes queued since the last flush.
+ */
+size_t srpc_file_writer_count(srpc_file_writer_t *writer)
+{
+    return writer->flushed ? 0 : writer->entries_count;
+}
+
+/**
+ * Submit all queued writes and wait for their completion. Writes are applied in the order they were queued, so a
+ * later write of the same attribute wins. Writes are independent otherwise - a failed write doesn't stop the others.
+ * The queue is empty afterwards.
+ *
+ * @param writer File writer.
+ * @param failures Failed writes - valid until the next use of the writer, can be NULL.
+ * @param failures_count Number of failed writes, can be NULL.
+ *
+ * @return Error code - 0 if all writes succeeded, -1 if any of them failed.
+ */
+int srpc_file_writer_flush(srpc_file_writer_t *writer, const srpc_file_writer_failure_t **failures,
+                           size_t *failures_count)
+{
+    size_t failed = 0;
+
+    if (failures)
+    {
+        *failures = NULL;
+    }
+
+    if (failures_count)
+    {
+        *failures_count = 0;
+    }
+
+    if (writer->flushed)
+    {
+        file_writer_clear(writer);
+    }
+
+#ifdef SRPC_HAVE_LIBURING
+    if (writer->async && file_writer_write_async(writer))
+    {
+        // the remaining writes are done synchronously and the ring is not used anymore
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "io_uring submission failed, switching to synchronous attribute writes");
+        io_uring_queue_exit(&writer->ring);
+        writer->async = false;
+    }
+#endif
+
+    for (size_t i = 0; i < writer->entries_count; i++)
+    {
+        if (!writer->entries[i].done)
+        {
+            file_writer_write_sync(&writer->entries[i]);
+        }
+
+        if (writer->entries[i].error)
+        {
+            ++failed;
+        }
+    }
+
+    if (failed > writer->failures_size)
+    {
+        srpc_file_writer_failure_t *tmp = realloc(writer->failures, failed * sizeof(*tmp));
+        if (!tmp)
+        {
+            // failures can't be reported - clear the queue anyway, the writes were done
+            file_writer_clear(writer);
+            return -1;
+        }
+        writer->failures = tmp;
+        writer->failures_size = failed;
+    }
+
+    failed = 0;
+    for (size_t i = 0; i < writer->entries_count; i++)
+    {
+        const srpc_file_writer_entry_t *entry = &writer->entries[i];
+
+        if (entry->error)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Writing \"%s\" to %s failed (%s)", entry->value, entry->path,
+                          strerror(entry->error));
+            writer->failures[failed++] = (srpc_file_writer_failure_t){
+                .path = entry->path,
+                .value = entry->value,
+                .change = entry->change,
+                .error = entry->error,
+            };
+        }
+    }
+
+    // keep the entries until the next use - the failures point to their strings
+    writer->flushed = true;
+
+    if (failures)
+    {
+        *failures = writer->failures;
+    }
+
+    if (failures_count)
+    {
+        *failures_count = failed;
+    }
+
+    return failed ? -1 : 0;
+}
+
+/**
+ * Free the file writer - queued writes are dropped.
+ *
+ * @param writer File writer.
+ *
+ */
+void srpc_file_writer_free(srpc_file_writer_t **writer)
+{
+    srpc_file_writer_t *w = *writer;
+
+    if (!w)
+    {
+        return;
+    }
+
+    file_writer_clear(w);
+
+#ifdef SRPC_HAVE_LIBURING
+    if (w->async)
+    {
+        io_uring_queue_exit(&w->ring);
+    }
+#endif
+
+    free(w->entries);
+    free(w->failures);
+    free(w);
+
+    *writer = NULL;
+}
+
+/**
+ * Add a write to the queue. The writer takes ownership of the value, also on error.
+ *
+ * @param writer File writer.
+ * @param path Path of the attribute.
+ * @param value Allocated value.
+ * @param value_len Length of the value.
+ * @param change Change which caused the write.
+ *
+ * @return Error code - 0 on success.
+ */
+static int file_writer_queue(srpc_file_writer_t *writer, const char *path, char *value, size_t value_len,
+                             const void *change)
+{
+    srpc_file_writer_entry_t *entry = NULL;
+
+    if (writer->flushed)
+    {
+        file_writer_clear(writer);
+    }
+
+    if (writer->entries_count == writer->entries_size)
+    {
+        size_t new_size = writer->entries_size ? writer->entries_size * 2 : 16;
+        srpc_file_writer_entry_t *tmp = realloc(writer->entries, new_size * sizeof(*tmp));
+        if (!tmp)
+        {
+            goto error_out;
+        }
+        writer->entries = tmp;
+        writer->entries_size = new_size;
+    }
+
+    entry = &writer->entries[writer->entries_count];
+    *entry = (srpc_file_writer_entry_t){
+        .path = strdup(path),
+        .value = value,
+        .value_len = value_len,
+        .change = change,
+        .fd = -1,
+    };
+
+    if (!entry->path)
+    {
+        goto error_out;
+    }
+
+    ++writer->entries_count;
+
+    return 0;
+
+error_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to queue write of %s", path);
+    free(value);
+
+    return -1;
+}
+
+/**
+ * Free all entries and the failures pointing to them.
+ *
+ * @param writer File writer.
+ *
+ */
+static void file_writer_clear(srpc_file_writer_t *writer)
+{
+    for (size_t i = 0; i < writer->entries_count; i++)
+    {
+        free(writer->entries[i].path);
+        free(writer->entries[i].value);
+    }
+
+    writer->entries_count = 0;
+    writer->flushed = false;
+}
+
+/**
+ * Write the entry value synchronously.
+ *
+ * @param entry Entry to write.
+ *
+ */
+static void file_writer_write_sync(srpc_file_writer_entry_t *entry)
+{
+    ssize_t written = 0;
+
+    // opened by an interrupted io_uring submission
+    if (entry->fd >= 0)
+    {
+        close(entry->fd);
+    }
+
+    entry->fd = open(entry->path, O_WRONLY | O_CLOEXEC);
+    if (entry->fd < 0)
+    {
+        entry->error = errno;
+        goto out;
+    }
+
+    do
+    {
+        written = write(entry->fd, entry->value, entry->value_len);
+    } while (written < 0 && errno == EINTR);
+
+    if (written < 0)
+    {
+        entry->error = errno;
+    }
+    else if ((size_t)written != entry->value_len)
+    {
+        entry->error = EIO;
+    }
+
+    close(entry->fd);
+
+out:
+    entry->fd = -1;
+    entry->done = true;
+}
+
+#ifdef SRPC_HAVE_LIBURING
+
+/**
+ * Initialize the ring and check that the kernel supports all used operations - open, write and close.
+ *
+ * @param writer File writer.
+ *
+ * @return True if the ring can be used.
+ */
+static bool file_writer_ring_init(srpc_file_writer_t *writer)
+{
+    struct io_uring_probe *probe = NULL;
+    bool supported = false;
+
+    if (io_uring_queue_init(SRPC_FILE_WRITER_RING_SIZE, &writer->ring, 0) < 0)
+    {
+        return false;
+    }
+
+    probe = io_uring_get_probe_ring(&writer->ring);
+    if (probe)
+    {
+        supported = io_uring_opcode_supported(probe, IORING_OP_OPENAT) &&
+                    io_uring_opcode_supported(probe, IORING_OP_WRITE) &&
+                    io_uring_opcode_supported(probe, IORING_OP_CLOSE);
+        io_uring_free_probe(probe);
+    }
+
+    if (!supported)
+    {
+        io_uring_queue_exit(&writer->ring);
+    }
+
+    return supported;
+}
+
+/**
+ * Write all entries using the ring, in rounds fitting into the submission queue.
+ *
+ * @param writer File writer.
+ *
+ * @return Error code - 0 on success, -1 if the ring failed and the remaining entries have to be written synchronously.
+ */
+static int file_writer_write_async(srpc_file_writer_t *writer)
+{
+    const size_t round_size = SRPC_FILE_WRITER_RING_SIZE / 2;
+
+    for (size_t i = 0; i < writer->entries_count; i += round_size)
+    {
+        size_t count = writer->entries_count - i < round_size ? writer->entries_count - i : round_size;
+
+        if (file_writer_submit_round(writer, &writer->entries[i], count))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Write a round of entries - all files are opened in one submission and then written and closed in another one.
+ * The writes and closes form a single hard linked chain in the queue order, so dependent attributes and repeated
+ * writes of the same attribute are applied in the same order as by the synchronous fallback, and each close is
+ * executed even if its write fails.
+ *
+ * @param writer File writer.
+ * @param entries Entries of the round.
+ * @param count Number of entries.
+ *
+ * @return Error code - 0 on success.
+ */
+static int file_writer_submit_round(srpc_file_writer_t *writer, srpc_file_writer_entry_t *entries, size_t count)
+{
+    struct io_uring_sqe *sqe = NULL;
+    unsigned queued = 0;
+    int submitted = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        sqe = io_uring_get_sqe(&writer->ring);
+        io_uring_prep_openat(sqe, AT_FDCWD, entries[i].path, O_WRONLY | O_CLOEXEC, 0);
+        io_uring_sqe_set_data(sqe, &entries[i]);
+        ++queued;
+    }
+
+    submitted = io_uring_submit_and_wait(&writer->ring, queued);
+    if (submitted < 0 || file_writer_reap(writer, (unsigned)submitted, true) || (unsigned)submitted != queued)
+    {
+        return -1;
+    }
+
+    queued = 0;
+    sqe = NULL;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (entries[i].fd < 0)
+        {
+            continue;
+        }
+
+        // link the previous close to this write - without links io-wq can run the operations in any order
+        if (sqe)
+        {
+            sqe->flags |= IOSQE_IO_HARDLINK;
+        }
+
+        sqe = io_uring_get_sqe(&writer->ring);
+        io_uring_prep_write(sqe, entries[i].fd, entries[i].value, (unsigned)entries[i].value_len, 0);
+        io_uring_sqe_set_data(sqe, &entries[i]);
+        sqe->flags |= IOSQE_IO_HARDLINK;
+
+        sqe = io_uring_get_sqe(&writer->ring);
+        io_uring_prep_close(sqe, entries[i].fd);
+        io_uring_sqe_set_data(sqe, NULL);
+
+        // the ring owns the descriptor now - never close it again in the synchronous fallback
+        entries[i].fd = -1;
+        queued += 2;
+    }
+
+    if (!queued)
+    {
+        return 0;
+    }
+
+    submitted = io_uring_submit_and_wait(&writer->ring, queued);
+    if (submitted < 0 || file_writer_reap(writer, (unsigned)submitted, false) || (unsigned)submitted != queued)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Wait for the completions of the submitted operations and store their results to the entries.
+ *
+ * @param writer File writer.
+ * @param submitted Number of submitted operations.
+ * @param open The completions belong to open operations.
+ *
+ * @return Error code - 0 on success.
+ */
+static int file_writer_reap(srpc_file_writer_t *writer, unsigned submitted, bool open)
+{
+    struct io_uring_cqe *cqe = NULL;
+    srpc_file_writer_entry_t *entry = NULL;
+
+    for (unsigned i = 0; i < submitted; i++)
+    {
+        if (io_uring_wait_cqe(&writer->ring, &cqe) < 0)
+        {
+            return -1;
+        }
+
+        entry = io_uring_cqe_get_data(cqe);
+
+        // close completions carry no entry - the file is closed even if closing reports an error
+        if (entry && open)
+        {
+            if (cqe->res < 0)
+            {
+                entry->error = -cqe->res;
+                entry->done = true;
+            }
+            else
+            {
+                entry->fd = cqe->res;
+            }
+        }
+        else if (entry)
+        {
+            if (cqe->res < 0)
+            {
+                entry->error = -cqe->res;
+            }
+            else if ((size_t)cqe->res != entry->value_len)
+            {
+                entry->error = EIO;
+            }
+            entry->done = true;
+        }
+
+        io_uring_cqe_seen(&writer->ring, cqe);
+    }
+
+    return 0;
+}
+
+#endif
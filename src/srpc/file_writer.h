@@ -0,0 +1,102 @@
+/**
+ * @file file_writer.h
+ * @brief API for batched writing of sysctl and sysfs attributes.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_FILE_WRITER_H
+#define SRPC_FILE_WRITER_H
+
+#include "types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Create a new file writer. Attribute writes queued while iterating changes are submitted together on flush - as
+ * io_uring batches if the library is built with liburing and the kernel supports it, otherwise using a synchronous
+ * open, write and close loop. A writer is not thread safe - use one writer per thread.
+ *
+ * @return New file writer, NULL on error.
+ */
+srpc_file_writer_t *srpc_file_writer_new(void);
+
+/**
+ * Check whether the writer submits the writes using io_uring.
+ *
+ * @param writer File writer.
+ *
+ * @return True if io_uring is used, false for the synchronous fallback.
+ */
+bool srpc_file_writer_is_async(srpc_file_writer_t *writer);
+
+/**
+ * Queue an attribute write. The path and value are copied.
+ *
+ * @param writer File writer.
+ * @param path Path of the attribute - for example /proc/sys/net/ipv6/conf/eth0/mtu.
+ * @param value Value to write.
+ * @param change Change which caused the write, returned with a failure - usually the changed node, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_writer_add(srpc_file_writer_t *writer, const char *path, const char *value, const void *change);
+
+/**
+ * Queue an attribute write with a formatted value.
+ *
+ * @param writer File writer.
+ * @param path Path of the attribute.
+ * @param change Change which caused the write, can be NULL.
+ * @param format Printf like format of the value.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_file_writer_addf(srpc_file_writer_t *writer, const char *path, const void *change, const char *format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+/**
+ * Get the number of queued writes.
+ *
+ * @param writer File writer.
+ *
+ * @return Number of writes queued since the last flush.
+ */
+size_t srpc_file_writer_count(srpc_file_writer_t *writer);
+
+/**
+ * Submit all queued writes and wait for their completion. Writes are applied in the order they were queued, so a
+ * later write of the same attribute wins. Writes are independent otherwise - a failed write doesn't stop the others.
+ * The queue is empty afterwards.
+ *
+ * @param writer File writer.
+ * @param failures Failed writes - valid until the next use of the writer, can be NULL.
+ * @param failures_count Number of failed writes, can be NULL.
+ *
+ * @return Error code - 0 if all writes succeeded, -1 if any of them failed.
+ */
+int srpc_file_writer_flush(srpc_file_writer_t *writer, const srpc_file_writer_failure_t **failures,
+                           size_t *failures_count);
+
+/**
+ * Free the file writer - queued writes are dropped.
+ *
+ * @param writer File writer.
+ *
+ */
+void srpc_file_writer_free(srpc_file_writer_t **writer);
+
+#endif // SRPC_FILE_WRITER_H
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "intern.h"
+#include "common.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uthash.h>
+
+#include <libyang/libyang.h>
+
+typedef struct srpc_intern_entry_s srpc_intern_entry_t;
+
+/**
+ * Single interned string - the string itself is stored right after the entry.
+ */
+struct srpc_intern_entry_s
+{
+    size_t refcount;   ///< Number of references.
+    UT_hash_handle hh; ///< UTHash reserved data.
+    char str[];        ///< Key - interned string.
+};
+
+// Process-wide table of interned strings.
+static srpc_intern_entry_t *intern_table = NULL;
+
+// Lock for the interned strings table.
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static srpc_intern_entry_t *intern_entry(const char *interned);
+
+/**
+ * Intern a string. Equal strings are stored only once and get the same pointer, so interned strings can be compared
+ * by pointer. Each call takes a reference which has to be released using srpc_intern_release().
+ *
+ * @param str String to intern.
+ *
+ * @return Interned string, NULL on error.
+ */
+const char *srpc_intern(const char *str)
+{
+    return srpc_intern_len(str, strlen(str));
+}
+
+/**
+ * Intern the first len characters of a string.
+ *
+ * @param str String to intern - doesn't have to be null terminated.
+ * @param len Number of characters to intern.
+ *
+ * @return Interned string, NULL on error.
+ */
+const char *srpc_intern_len(const char *str, size_t len)
+{
+    srpc_intern_entry_t *entry = NULL;
+
+    pthread_mutex_lock(&intern_lock);
+
+    HASH_FIND(hh, intern_table, str, len, entry);
+    if (entry)
+    {
+        ++entry->refcount;
+        goto out;
+    }
+
+    entry = malloc(sizeof(*entry) + len + 1);
+    if (!entry)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to allocate interned string");
+        goto out;
+    }
+
+    memcpy(entry->str, str, len);
+    entry->str[len] = 0;
+    entry->refcount = 1;
+    HASH_ADD_KEYPTR(hh, intern_table, entry->str, len, entry);
+
+out:
+    pthread_mutex_unlock(&intern_lock);
+
+    return entry ? entry->str : NULL;
+}
+
+/**
+ * Take another reference to an already interned string without looking it up.
+ *
+ * @param interned Interned string.
+ *
+ * @return The same interned string.
+ */
+const char *srpc_intern_ref(const char *interned)
+{
+    pthread_mutex_lock(&intern_lock);
+    ++intern_entry(interned)->refcount;
+    pthread_mutex_unlock(&intern_lock);
+
+    return interned;
+}
+
+/**
+ * Intern the canonical value of a data node. Use for values which outlive the data tree - while the tree exists,
+ * the value returned by lyd_get_value() can be borrowed directly since libyang already stores it only once.
+ *
+ * @param node Data node with a value.
+ *
+ * @return Interned value, NULL on error or if the node has no value.
+ */
+const char *srpc_intern_lyd_value(const struct lyd_node *node)
+{
+    const char *value = lyd_get_value(node);
+
+    return value ? srpc_intern(value) : NULL;
+}
+
+/**
+ * Release a reference to an interned string. The string is freed when its last reference is released.
+ *
+ * @param interned Interned string, can be NULL.
+ *
+ */
+void srpc_intern_release(const char *interned)
+{
+    srpc_intern_entry_t *entry = NULL;
+
+    if (!interned)
+    {
+        return;
+    }
+
+    entry = intern_entry(interned);
+
+    pthread_mutex_lock(&intern_lock);
+    if (--entry->refcount == 0)
+    {
+        HASH_DEL(intern_table, entry);
+        free(entry);
+    }
+    pthread_mutex_unlock(&intern_lock);
+}
+
+/**
+ * Get the number of distinct interned strings.
+ *
+ * @return Number of interned strings.
+ */
+size_t srpc_intern_count(void)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&intern_lock);
+    count = HASH_COUNT(intern_table);
+    pthread_mutex_unlock(&intern_lock);
+
+    return count;
+}
+
+/**
+ * Get the table entry of an interned string.
+ *
+ * @param interned Interned string.
+ *
+ * @return Table entry.
+ */
+static srpc_intern_entry_t *intern_entry(const char *interned)
+{
+    return (srpc_intern_entry_t *)(void *)(interned - offsetof(srpc_intern_entry_t, str));
+}
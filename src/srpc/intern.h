@@ -0,0 +1,81 @@
+/**
+ * @file intern.h
+ * @brief API for interning strings shared between plugin data structures.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_INTERN_H
+#define SRPC_INTERN_H
+
+#include "types.h"
+
+#include <stddef.h>
+
+/**
+ * Intern a string. Equal strings are stored only once and get the same pointer, so interned strings can be compared
+ * by pointer. Each call takes a reference which has to be released using srpc_intern_release().
+ *
+ * @param str String to intern.
+ *
+ * @return Interned string, NULL on error.
+ */
+const char *srpc_intern(const char *str);
+
+/**
+ * Intern the first len characters of a string.
+ *
+ * @param str String to intern - doesn't have to be null terminated.
+ * @param len Number of characters to intern.
+ *
+ * @return Interned string, NULL on error.
+ */
+const char *srpc_intern_len(const char *str, size_t len);
+
+/**
+ * Take another reference to an already interned string without looking it up.
+ *
+ * @param interned Interned string.
+ *
+ * @return The same interned string.
+ */
+const char *srpc_intern_ref(const char *interned);
+
+/**
+ * Intern the canonical value of a data node. Use for values which outlive the data tree - while the tree exists,
+ * the value returned by lyd_get_value() can be borrowed directly since libyang already stores it only once.
+ *
+ * @param node Data node with a value.
+ *
+ * @return Interned value, NULL on error or if the node has no value.
+ */
+const char *srpc_intern_lyd_value(const struct lyd_node *node);
+
+/**
+ * Release a reference to an interned string. The string is freed when its last reference is released.
+ *
+ * @param interned Interned string, can be NULL.
+ *
+ */
+void srpc_intern_release(const char *interned);
+
+/**
+ * Get the number of distinct interned strings.
+ *
+ * @return Number of interned strings.
+ */
+size_t srpc_intern_count(void);
+
+#endif // SRPC_INTERN_H
@@ -15,6 +15,21 @@
  */
 
 #include <srpc/ly_tree.h>
+#include <srpc/common.h>
+#include <srpc/mem_account.h>
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysrepo.h>
+
+static LY_ERR ly_tree_new_path(struct lyd_node *parent, const struct ly_ctx *ly_ctx, const char *path,
+                               const char *value, struct lyd_node **store);
+static const struct lyd_value *ly_tree_leaf_value(const struct lyd_node *node);
+static int ly_tree_leaf_type_error(const struct lyd_node *node, const char *expected);
+static int ly_tree_leaf_string(const struct lyd_node *node, char separator, char *buffer, size_t buffer_size);
+static int ly_tree_parse_prefix(int family, char *buffer, void *addr, uint8_t max_length, uint8_t *prefix_length);
 
 /**
  * Generic child search.
@@ -156,6 +171,359 @@ struct lyd_node *srpc_ly_tree_get_child_choice(const struct lyd_node *node, cons
     return srpc_ly_tree_get_child(node, LYS_CHOICE, name);
 }
 
+/**
+ * Gather multiple child nodes of a node at once. For each descriptor the first child with a matching name and node
+ * type is stored to nodes[slot] - entries for which no child was found are set to NULL. The descriptors are resolved
+ * to schema nodes and the children are found using the libyang children hash table, so unlike a series of
+ * srpc_ly_tree_get_child_* calls, each scanning the children from the start, the cost doesn't grow with the number of
+ * children. Descriptors are usually a static array with slots taken from an enum, each slot used once.
+ *
+ * @param node Node to search.
+ * @param items Descriptors of the child nodes to search for.
+ * @param items_count Number of descriptors - the nodes array must have at least this many entries.
+ * @param nodes Array to which the found nodes are stored.
+ * @param missing_count Number of descriptors for which no child was found - can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_ly_tree_gather(const struct lyd_node *node, const srpc_ly_tree_gather_t items[], const size_t items_count,
+                        struct lyd_node *nodes[], size_t *missing_count)
+{
+    int error = 0;
+    const struct lysc_node *schema = NULL;
+    struct lyd_node *match = NULL;
+    size_t remaining = items_count;
+
+    for (size_t i = 0; i < items_count; i++)
+    {
+        if (items[i].slot >= items_count)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Invalid gather slot %zu for node \"%s\"", items[i].slot, items[i].name);
+            goto error_out;
+        }
+
+        // descriptors are only a few, unlike the children
+        for (size_t j = 0; j < i; j++)
+        {
+            if (items[j].slot == items[i].slot)
+            {
+                SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Duplicate gather slot %zu for node \"%s\"", items[i].slot,
+                              items[i].name);
+                goto error_out;
+            }
+        }
+
+        nodes[items[i].slot] = NULL;
+    }
+
+    if (!node || !node->schema || !lyd_child(node))
+    {
+        goto out;
+    }
+
+    // match the descriptors against the schema children, the data children are then found using the libyang children
+    // hash table - the cost doesn't grow with the number of children, for example list entries
+    while (remaining && (schema = lys_getnext(schema, node->schema, NULL, 0)))
+    {
+        for (size_t i = 0; i < items_count; i++)
+        {
+            // keep the first match - same as srpc_ly_tree_get_child()
+            if (nodes[items[i].slot] || items[i].node_type != schema->nodetype || strcmp(items[i].name, schema->name))
+            {
+                continue;
+            }
+
+            if (lyd_find_sibling_val(lyd_child(node), schema, NULL, 0, &match) == LY_SUCCESS)
+            {
+                nodes[items[i].slot] = match;
+                remaining--;
+            }
+        }
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    if (missing_count)
+    {
+        *missing_count = remaining;
+    }
+
+    return error;
+}
+
+/**
+ * Get the value of an unsigned integer leaf (uint8 - uint64) from the value stored by libyang, without parsing the
+ * canonical string. Derived types are resolved by libyang and union values are read from the matching member type.
+ *
+ * @param node Leaf or leaf-list node - NULL results in an error without logging, so a lookup result can be passed
+ * directly.
+ * @param value Variable to which the value is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an unsigned integer.
+ */
+int srpc_ly_tree_leaf_get_uint(const struct lyd_node *node, uint64_t *value)
+{
+    const struct lyd_value *val = ly_tree_leaf_value(node);
+
+    if (!val)
+    {
+        return ly_tree_leaf_type_error(node, "unsigned integer");
+    }
+
+    switch (val->realtype->basetype)
+    {
+        case LY_TYPE_UINT8:
+            *value = val->uint8;
+            break;
+        case LY_TYPE_UINT16:
+            *value = val->uint16;
+            break;
+        case LY_TYPE_UINT32:
+            *value = val->uint32;
+            break;
+        case LY_TYPE_UINT64:
+            *value = val->uint64;
+            break;
+        default:
+            return ly_tree_leaf_type_error(node, "unsigned integer");
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of a signed integer leaf (int8 - int64) from the value stored by libyang.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param value Variable to which the value is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a signed integer.
+ */
+int srpc_ly_tree_leaf_get_int(const struct lyd_node *node, int64_t *value)
+{
+    const struct lyd_value *val = ly_tree_leaf_value(node);
+
+    if (!val)
+    {
+        return ly_tree_leaf_type_error(node, "signed integer");
+    }
+
+    switch (val->realtype->basetype)
+    {
+        case LY_TYPE_INT8:
+            *value = val->int8;
+            break;
+        case LY_TYPE_INT16:
+            *value = val->int16;
+            break;
+        case LY_TYPE_INT32:
+            *value = val->int32;
+            break;
+        case LY_TYPE_INT64:
+            *value = val->int64;
+            break;
+        default:
+            return ly_tree_leaf_type_error(node, "signed integer");
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of a boolean leaf from the value stored by libyang.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param value Variable to which the value is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a boolean.
+ */
+int srpc_ly_tree_leaf_get_bool(const struct lyd_node *node, bool *value)
+{
+    const struct lyd_value *val = ly_tree_leaf_value(node);
+
+    if (!val || val->realtype->basetype != LY_TYPE_BOOL)
+    {
+        return ly_tree_leaf_type_error(node, "boolean");
+    }
+
+    *value = val->boolean ? true : false;
+
+    return 0;
+}
+
+/**
+ * Get the value of an enumeration leaf from the value stored by libyang.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param name Variable to which the enum name is stored - points into the schema, can be NULL.
+ * @param value Variable to which the assigned enum value is stored, can be NULL.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an enumeration.
+ */
+int srpc_ly_tree_leaf_get_enum(const struct lyd_node *node, const char **name, int32_t *value)
+{
+    const struct lyd_value *val = ly_tree_leaf_value(node);
+
+    if (!val || val->realtype->basetype != LY_TYPE_ENUM)
+    {
+        return ly_tree_leaf_type_error(node, "enumeration");
+    }
+
+    if (name)
+    {
+        *name = val->enum_item->name;
+    }
+
+    if (value)
+    {
+        *value = val->enum_item->value;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of a decimal64 leaf from the value stored by libyang. The real value is value / 10^fraction_digits.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param value Variable to which the unscaled value is stored.
+ * @param fraction_digits Variable to which the fraction digits of the type are stored, can be NULL.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a decimal64.
+ */
+int srpc_ly_tree_leaf_get_dec64(const struct lyd_node *node, int64_t *value, uint8_t *fraction_digits)
+{
+    const struct lyd_value *val = ly_tree_leaf_value(node);
+
+    if (!val || val->realtype->basetype != LY_TYPE_DEC64)
+    {
+        return ly_tree_leaf_type_error(node, "decimal64");
+    }
+
+    *value = val->dec64;
+
+    if (fraction_digits)
+    {
+        *fraction_digits = ((const struct lysc_type_dec *)val->realtype)->fraction_digits;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of an IPv4 address leaf (ietf-inet-types ipv4-address or ipv4-address-no-zone). A zone suffix is
+ * ignored. The binary layout of the inet types depends on the libyang type plugin version, so the canonical string
+ * is converted.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the address is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv4 address.
+ */
+int srpc_ly_tree_leaf_get_ipv4_address(const struct lyd_node *node, struct in_addr *addr)
+{
+    char buffer[INET_ADDRSTRLEN] = {0};
+
+    if (ly_tree_leaf_string(node, '%', buffer, sizeof(buffer)) || inet_pton(AF_INET, buffer, addr) != 1)
+    {
+        return ly_tree_leaf_type_error(node, "IPv4 address");
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of an IPv6 address leaf (ietf-inet-types ipv6-address or ipv6-address-no-zone). A zone suffix is
+ * ignored.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the address is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv6 address.
+ */
+int srpc_ly_tree_leaf_get_ipv6_address(const struct lyd_node *node, struct in6_addr *addr)
+{
+    char buffer[INET6_ADDRSTRLEN] = {0};
+
+    if (ly_tree_leaf_string(node, '%', buffer, sizeof(buffer)) || inet_pton(AF_INET6, buffer, addr) != 1)
+    {
+        return ly_tree_leaf_type_error(node, "IPv6 address");
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of an IPv4 prefix leaf (ietf-inet-types ipv4-prefix).
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the prefix address is stored.
+ * @param prefix_length Variable to which the prefix length is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv4 prefix.
+ */
+int srpc_ly_tree_leaf_get_ipv4_prefix(const struct lyd_node *node, struct in_addr *addr, uint8_t *prefix_length)
+{
+    char buffer[INET_ADDRSTRLEN + 4] = {0};
+
+    if (ly_tree_leaf_string(node, 0, buffer, sizeof(buffer)) ||
+        ly_tree_parse_prefix(AF_INET, buffer, addr, 32, prefix_length))
+    {
+        return ly_tree_leaf_type_error(node, "IPv4 prefix");
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of an IPv6 prefix leaf (ietf-inet-types ipv6-prefix).
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the prefix address is stored.
+ * @param prefix_length Variable to which the prefix length is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv6 prefix.
+ */
+int srpc_ly_tree_leaf_get_ipv6_prefix(const struct lyd_node *node, struct in6_addr *addr, uint8_t *prefix_length)
+{
+    char buffer[INET6_ADDRSTRLEN + 4] = {0};
+
+    if (ly_tree_leaf_string(node, 0, buffer, sizeof(buffer)) ||
+        ly_tree_parse_prefix(AF_INET6, buffer, addr, 128, prefix_length))
+    {
+        return ly_tree_leaf_type_error(node, "IPv6 prefix");
+    }
+
+    return 0;
+}
+
+/**
+ * Get the value of a MAC address leaf (ietf-yang-types mac-address).
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param mac Array to which the 6 address bytes are stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a MAC address.
+ */
+int srpc_ly_tree_leaf_get_mac_address(const struct lyd_node *node, uint8_t mac[6])
+{
+    char buffer[18] = {0};
+    char end = 0;
+
+    if (ly_tree_leaf_string(node, 0, buffer, sizeof(buffer)) ||
+        sscanf(buffer, "%2hhx:%2hhx:%2hhx:%2hhx:%2hhx:%2hhx%c", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5],
+               &end) != 6)
+    {
+        return ly_tree_leaf_type_error(node, "MAC address");
+    }
+
+    return 0;
+}
+
 /**
  * Create a container node inside of the parent node using the provided path.
  *
@@ -171,7 +539,7 @@ int srpc_ly_tree_create_container(const struct ly_ctx *ly_ctx, struct lyd_node *
 {
     LY_ERR ly_error = LY_SUCCESS;
 
-    ly_error = lyd_new_path(parent, ly_ctx, path, NULL, 0, store);
+    ly_error = ly_tree_new_path(parent, ly_ctx, path, NULL, store);
     if (ly_error != LY_SUCCESS)
     {
         return (int)ly_error;
@@ -203,7 +571,7 @@ int srpc_ly_tree_create_list(const struct ly_ctx *ly_ctx, struct lyd_node *paren
         return -1;
     }
 
-    ly_error = lyd_new_path(parent, ly_ctx, path_buffer, key_value, 0, store);
+    ly_error = ly_tree_new_path(parent, ly_ctx, path_buffer, key_value, store);
     if (ly_error != LY_SUCCESS)
     {
         return (int)ly_error;
@@ -227,7 +595,7 @@ int srpc_ly_tree_create_list_without_key(const struct ly_ctx *ly_ctx, struct lyd
 {
     LY_ERR ly_error = LY_SUCCESS;
 
-    ly_error = lyd_new_path(parent, ly_ctx, path, NULL, 0, store);
+    ly_error = ly_tree_new_path(parent, ly_ctx, path, NULL, store);
 
     return (int)ly_error;
 }
@@ -269,7 +637,7 @@ int srpc_ly_tree_create_list_full(const struct ly_ctx *ly_ctx, struct lyd_node *
         }
     }
 
-    ly_error = lyd_new_path(parent, ly_ctx, path_buffer, NULL, 0, store);
+    ly_error = ly_tree_new_path(parent, ly_ctx, path_buffer, NULL, store);
     if (ly_error != LY_SUCCESS)
     {
         return -2;
@@ -294,7 +662,7 @@ int srpc_ly_tree_create_leaf(const struct ly_ctx *ly_ctx, struct lyd_node *paren
 {
     LY_ERR ly_error = LY_SUCCESS;
 
-    ly_error = lyd_new_path(parent, ly_ctx, path, value, 0, store);
+    ly_error = ly_tree_new_path(parent, ly_ctx, path, value, store);
     if (ly_error != LY_SUCCESS)
     {
         return (int)ly_error;
@@ -320,11 +688,167 @@ int srpc_ly_tree_append_leaf_list(const struct ly_ctx *ly_ctx, struct lyd_node *
 {
     LY_ERR ly_error = LY_SUCCESS;
 
-    ly_error = lyd_new_path(parent, ly_ctx, path, value, 0, store);
+    ly_error = ly_tree_new_path(parent, ly_ctx, path, value, store);
     if (ly_error != LY_SUCCESS)
     {
         return (int)ly_error;
     }
 
+    return 0;
+}
+
+/**
+ * Create the nodes of a path and account them for the current memory accounting scope.
+ *
+ * @param parent Parent node, can be NULL.
+ * @param ly_ctx libyang context to use.
+ * @param path Path of the node to create.
+ * @param value Value of the node, can be NULL.
+ * @param store Variable to which the first created node will be stored, can be NULL.
+ *
+ * @return LY_ERR on error - 0 on success.
+ */
+static LY_ERR ly_tree_new_path(struct lyd_node *parent, const struct ly_ctx *ly_ctx, const char *path,
+                               const char *value, struct lyd_node **store)
+{
+    struct lyd_node *created = NULL;
+    LY_ERR ly_error = LY_SUCCESS;
+
+    ly_error = lyd_new_path(parent, ly_ctx, path, value, 0, &created);
+    if (ly_error != LY_SUCCESS)
+    {
+        return ly_error;
+    }
+
+    srpc_mem_account_node(created);
+
+    if (store)
+    {
+        *store = created;
+    }
+
+    return LY_SUCCESS;
+}
+
+/**
+ * Get the value stored by libyang for a leaf or leaf-list node. For unions the value of the matching member type is
+ * returned, so the caller can check the resolved base type.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ *
+ * @return Stored value, NULL if the node is missing or not a leaf.
+ */
+static const struct lyd_value *ly_tree_leaf_value(const struct lyd_node *node)
+{
+    const struct lyd_value *val = NULL;
+
+    if (!node || !node->schema || !(node->schema->nodetype & LYD_NODE_TERM))
+    {
+        return NULL;
+    }
+
+    val = &((const struct lyd_node_term *)node)->value;
+
+    while (val->realtype->basetype == LY_TYPE_UNION && val->subvalue)
+    {
+        val = &val->subvalue->value;
+    }
+
+    return val;
+}
+
+/**
+ * Log a leaf value type mismatch. A missing node is not logged - it is the usual result of an optional leaf lookup.
+ *
+ * @param node Node with the unexpected value, can be NULL.
+ * @param expected Description of the expected type.
+ *
+ * @return Always -1 - used as the return value of the getters.
+ */
+static int ly_tree_leaf_type_error(const struct lyd_node *node, const char *expected)
+{
+    if (node)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Node \"%s\" is not a valid %s leaf", node->schema ? LYD_NAME(node) : "",
+                      expected);
+    }
+
+    return -1;
+}
+
+/**
+ * Copy the canonical value of a string based leaf to a buffer.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param separator Character at which the value is cut off - 0 to copy the whole value.
+ * @param buffer Buffer to copy the value to.
+ * @param buffer_size Size of the buffer.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing, not a string or the value does not fit.
+ */
+static int ly_tree_leaf_string(const struct lyd_node *node, char separator, char *buffer, size_t buffer_size)
+{
+    const struct lyd_value *val = ly_tree_leaf_value(node);
+    const char *str = NULL;
+    const char *end = NULL;
+    size_t len = 0;
+
+    if (!val || val->realtype->basetype != LY_TYPE_STRING)
+    {
+        return -1;
+    }
+
+    str = lyd_get_value(node);
+    if (!str)
+    {
+        return -1;
+    }
+
+    end = separator ? strchr(str, separator) : NULL;
+    len = end ? (size_t)(end - str) : strlen(str);
+
+    if (len >= buffer_size)
+    {
+        return -1;
+    }
+
+    memcpy(buffer, str, len);
+    buffer[len] = 0;
+
+    return 0;
+}
+
+/**
+ * Parse an address prefix in the address/length notation.
+ *
+ * @param family Address family - AF_INET or AF_INET6.
+ * @param buffer Prefix string - modified while parsing.
+ * @param addr Address structure matching the family.
+ * @param max_length Maximal prefix length of the family.
+ * @param prefix_length Variable to which the prefix length is stored.
+ *
+ * @return Error code - 0 on success.
+ */
+static int ly_tree_parse_prefix(int family, char *buffer, void *addr, uint8_t max_length, uint8_t *prefix_length)
+{
+    char *slash = strchr(buffer, '/');
+    char *end = NULL;
+    unsigned long length = 0;
+
+    if (!slash || !slash[1])
+    {
+        return -1;
+    }
+
+    *slash = 0;
+    length = strtoul(slash + 1, &end, 10);
+
+    if (*end || length > max_length || inet_pton(family, buffer, addr) != 1)
+    {
+        return -1;
+    }
+
+    *prefix_length = (uint8_t)length;
+
     return 0;
 }
\ No newline at end of file
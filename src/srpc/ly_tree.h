@@ -22,6 +22,7 @@
 
 #include "types.h"
 #include <libyang/libyang.h>
+#include <netinet/in.h>
 
 /**
  * Generic child search.
@@ -102,6 +103,133 @@ struct lyd_node *srpc_ly_tree_get_leaf_list_next(const struct lyd_node *node);
  */
 struct lyd_node *srpc_ly_tree_get_child_choice(const struct lyd_node *node, const char *name);
 
+/**
+ * Gather multiple child nodes of a node at once. For each descriptor the first child with a matching name and node
+ * type is stored to nodes[slot] - entries for which no child was found are set to NULL. The descriptors are resolved
+ * to schema nodes and the children are found using the libyang children hash table, so unlike a series of
+ * srpc_ly_tree_get_child_* calls, each scanning the children from the start, the cost doesn't grow with the number of
+ * children. Descriptors are usually a static array with slots taken from an enum, each slot used once.
+ *
+ * @param node Node to search.
+ * @param items Descriptors of the child nodes to search for.
+ * @param items_count Number of descriptors - the nodes array must have at least this many entries.
+ * @param nodes Array to which the found nodes are stored.
+ * @param missing_count Number of descriptors for which no child was found - can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_ly_tree_gather(const struct lyd_node *node, const srpc_ly_tree_gather_t items[], const size_t items_count,
+                        struct lyd_node *nodes[], size_t *missing_count);
+
+/**
+ * Get the value of an unsigned integer leaf (uint8 - uint64) from the value stored by libyang, without parsing the
+ * canonical string. Derived types are resolved by libyang and union values are read from the matching member type.
+ *
+ * @param node Leaf or leaf-list node - NULL results in an error without logging, so a lookup result can be passed
+ * directly.
+ * @param value Variable to which the value is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an unsigned integer.
+ */
+int srpc_ly_tree_leaf_get_uint(const struct lyd_node *node, uint64_t *value);
+
+/**
+ * Get the value of a signed integer leaf (int8 - int64) from the value stored by libyang.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param value Variable to which the value is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a signed integer.
+ */
+int srpc_ly_tree_leaf_get_int(const struct lyd_node *node, int64_t *value);
+
+/**
+ * Get the value of a boolean leaf from the value stored by libyang.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param value Variable to which the value is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a boolean.
+ */
+int srpc_ly_tree_leaf_get_bool(const struct lyd_node *node, bool *value);
+
+/**
+ * Get the value of an enumeration leaf from the value stored by libyang.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param name Variable to which the enum name is stored - points into the schema, can be NULL.
+ * @param value Variable to which the assigned enum value is stored, can be NULL.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an enumeration.
+ */
+int srpc_ly_tree_leaf_get_enum(const struct lyd_node *node, const char **name, int32_t *value);
+
+/**
+ * Get the value of a decimal64 leaf from the value stored by libyang. The real value is value / 10^fraction_digits.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param value Variable to which the unscaled value is stored.
+ * @param fraction_digits Variable to which the fraction digits of the type are stored, can be NULL.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a decimal64.
+ */
+int srpc_ly_tree_leaf_get_dec64(const struct lyd_node *node, int64_t *value, uint8_t *fraction_digits);
+
+/**
+ * Get the value of an IPv4 address leaf (ietf-inet-types ipv4-address or ipv4-address-no-zone). A zone suffix is
+ * ignored. The binary layout of the inet types depends on the libyang type plugin version, so the canonical string
+ * is converted.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the address is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv4 address.
+ */
+int srpc_ly_tree_leaf_get_ipv4_address(const struct lyd_node *node, struct in_addr *addr);
+
+/**
+ * Get the value of an IPv6 address leaf (ietf-inet-types ipv6-address or ipv6-address-no-zone). A zone suffix is
+ * ignored.
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the address is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv6 address.
+ */
+int srpc_ly_tree_leaf_get_ipv6_address(const struct lyd_node *node, struct in6_addr *addr);
+
+/**
+ * Get the value of an IPv4 prefix leaf (ietf-inet-types ipv4-prefix).
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the prefix address is stored.
+ * @param prefix_length Variable to which the prefix length is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv4 prefix.
+ */
+int srpc_ly_tree_leaf_get_ipv4_prefix(const struct lyd_node *node, struct in_addr *addr, uint8_t *prefix_length);
+
+/**
+ * Get the value of an IPv6 prefix leaf (ietf-inet-types ipv6-prefix).
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param addr Variable to which the prefix address is stored.
+ * @param prefix_length Variable to which the prefix length is stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not an IPv6 prefix.
+ */
+int srpc_ly_tree_leaf_get_ipv6_prefix(const struct lyd_node *node, struct in6_addr *addr, uint8_t *prefix_length);
+
+/**
+ * Get the value of a MAC address leaf (ietf-yang-types mac-address).
+ *
+ * @param node Leaf or leaf-list node, can be NULL.
+ * @param mac Array to which the 6 address bytes are stored.
+ *
+ * @return Error code - 0 on success, -1 if the node is missing or its value is not a MAC address.
+ */
+int srpc_ly_tree_leaf_get_mac_address(const struct lyd_node *node, uint8_t mac[6]);
+
 /**
  * Create a container node inside of the parent node using the provided path.
  *
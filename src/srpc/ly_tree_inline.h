@@ -0,0 +1,187 @@
+/**
+ * @file ly_tree_inline.h
+ * @brief Inline definitions of the libyang tree lookup API
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_LY_TREE_INLINE_H
+#define SRPC_LY_TREE_INLINE_H
+
+#include "ly_tree.h"
+
+#include <string.h>
+
+/*
+ * Optional header - not included by srpc.h. The functions behave the same as their srpc_ly_tree_get_* counterparts,
+ * but are visible to the compiler at the call site, so the node type argument is folded into the lookup loop.
+ * Define SRPC_LY_TREE_USE_INLINE before including this header to redirect the srpc_ly_tree_get_* calls of the
+ * including file to the inline definitions.
+ */
+
+/**
+ * Generic child search.
+ *
+ * @param node Node to search.
+ * @param node_type Schema node type - LYS_CONTAINER, LYS_LIST etc.
+ * @param name Name of the node to search for.
+ *
+ * @return Child node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_child(const struct lyd_node *node, uint16_t node_type,
+                                                             const char *name)
+{
+    struct lyd_node *ch = lyd_child(node);
+
+    while (ch)
+    {
+        // node type check first - it is a single compare against a constant, opaque nodes have no schema
+        if (ch->schema && ch->schema->nodetype == node_type && strcmp(LYD_NAME(ch), name) == 0)
+        {
+            return ch;
+        }
+        ch = ch->next;
+    }
+
+    return NULL;
+}
+
+/**
+ * Container node search.
+ *
+ * @param node Node to search.
+ * @param name Name of the node to search for.
+ *
+ * @return Child node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_child_container(const struct lyd_node *node, const char *name)
+{
+    return srpc_ly_tree_inline_get_child(node, LYS_CONTAINER, name);
+}
+
+/**
+ * List node search.
+ *
+ * @param node Node to search.
+ * @param name Name of the node to search for.
+ *
+ * @return Child node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_child_list(const struct lyd_node *node, const char *name)
+{
+    return srpc_ly_tree_inline_get_child(node, LYS_LIST, name);
+}
+
+/**
+ * Leaf list node search.
+ *
+ * @param node Node to search.
+ * @param name Name of the node to search for.
+ *
+ * @return Child node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_child_leaf_list(const struct lyd_node *node, const char *name)
+{
+    return srpc_ly_tree_inline_get_child(node, LYS_LEAFLIST, name);
+}
+
+/**
+ * Leaf node search.
+ *
+ * @param node Node to search.
+ * @param name Name of the node to search for.
+ *
+ * @return Child node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_child_leaf(const struct lyd_node *node, const char *name)
+{
+    return srpc_ly_tree_inline_get_child(node, LYS_LEAF, name);
+}
+
+/**
+ * Choice node search.
+ *
+ * @param node Node to search.
+ * @param name Name of the node to search for.
+ *
+ * @return Child node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_child_choice(const struct lyd_node *node, const char *name)
+{
+    return srpc_ly_tree_inline_get_child(node, LYS_CHOICE, name);
+}
+
+/**
+ * Get next sibling with the same name and node type.
+ *
+ * @param node Current element.
+ * @param node_type Schema node type - LYS_LIST or LYS_LEAFLIST.
+ *
+ * @return Next node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_next(const struct lyd_node *node, uint16_t node_type)
+{
+    const char *name = LYD_NAME(node);
+    struct lyd_node *iter = node->next;
+
+    while (iter)
+    {
+        if (iter->schema && iter->schema->nodetype == node_type && !strcmp(LYD_NAME(iter), name))
+        {
+            return iter;
+        }
+
+        iter = iter->next;
+    }
+
+    return NULL;
+}
+
+/**
+ * Get next list element.
+ *
+ * @param node Current list element.
+ *
+ * @return Next list node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_list_next(const struct lyd_node *node)
+{
+    return srpc_ly_tree_inline_get_next(node, LYS_LIST);
+}
+
+/**
+ * Get next leaf list element.
+ *
+ * @param node Current leaf list element.
+ *
+ * @return Next list node, NULL if not found.
+ */
+static inline struct lyd_node *srpc_ly_tree_inline_get_leaf_list_next(const struct lyd_node *node)
+{
+    return srpc_ly_tree_inline_get_next(node, LYS_LEAFLIST);
+}
+
+#ifdef SRPC_LY_TREE_USE_INLINE
+#define srpc_ly_tree_get_child srpc_ly_tree_inline_get_child
+#define srpc_ly_tree_get_child_container srpc_ly_tree_inline_get_child_container
+#define srpc_ly_tree_get_child_list srpc_ly_tree_inline_get_child_list
+#define srpc_ly_tree_get_child_leaf_list srpc_ly_tree_inline_get_child_leaf_list
+#define srpc_ly_tree_get_child_leaf srpc_ly_tree_inline_get_child_leaf
+#define srpc_ly_tree_get_child_choice srpc_ly_tree_inline_get_child_choice
+#define srpc_ly_tree_get_list_next srpc_ly_tree_inline_get_list_next
+#define srpc_ly_tree_get_leaf_list_next srpc_ly_tree_inline_get_leaf_list_next
+#endif // SRPC_LY_TREE_USE_INLINE
+
+#endif // SRPC_LY_TREE_INLINE_H
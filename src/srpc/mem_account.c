@@ -0,0 +1,380 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "mem_account.h"
+#include "common.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uthash.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+// Maximal depth of nested scopes - deeper scopes are counted for the deepest tracked one.
+#define MEM_ACCOUNT_MAX_DEPTH 8
+
+typedef struct srpc_mem_account_entry_s srpc_mem_account_entry_t;
+typedef struct srpc_mem_account_frame_s srpc_mem_account_frame_t;
+
+/**
+ * Statistics of a named scope.
+ */
+struct srpc_mem_account_entry_s
+{
+    char *name;                     ///< Key - scope name.
+    srpc_mem_account_stats_t stats; ///< Statistics.
+    UT_hash_handle hh;              ///< UTHash reserved data.
+};
+
+/**
+ * Active scope of a thread.
+ */
+struct srpc_mem_account_frame_s
+{
+    const char *name; ///< Scope name.
+    uint64_t nodes;   ///< Nodes counted so far.
+    uint64_t bytes;   ///< Bytes counted so far.
+};
+
+// Process-wide table of scope statistics.
+static srpc_mem_account_entry_t *mem_account_table = NULL;
+
+// Lock for the statistics table and the threshold.
+static pthread_mutex_t mem_account_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Scope size above which a warning is logged, 0 for no warning.
+static uint64_t mem_account_threshold = 0;
+
+// Active scopes of the thread.
+static _Thread_local srpc_mem_account_frame_t mem_account_frames[MEM_ACCOUNT_MAX_DEPTH];
+
+// Number of active scopes of the thread - can exceed the maximal depth.
+static _Thread_local size_t mem_account_depth = 0;
+
+static srpc_mem_account_frame_t *mem_account_frame(void);
+static void mem_account_measure(const struct lyd_node *node, uint64_t *nodes, uint64_t *bytes);
+static uint64_t mem_account_node_size(const struct lyd_node *node);
+static void mem_account_record(const char *name, uint64_t nodes, uint64_t bytes);
+
+/**
+ * Begin a named accounting scope on the calling thread. Until the matching srpc_mem_account_end(), nodes created by
+ * the srpc_ly_tree_create_* helpers and trees passed to srpc_mem_account_node() or srpc_mem_account_tree() are
+ * counted for the scope. Scopes can be nested - a finished scope is also counted for its parent.
+ * The collector and the operational cache open a scope around their build callbacks automatically.
+ *
+ * @param name Name of the scope, usually the callback path - has to stay valid until the scope ends.
+ *
+ */
+void srpc_mem_account_begin(const char *name)
+{
+    if (mem_account_depth < MEM_ACCOUNT_MAX_DEPTH)
+    {
+        mem_account_frames[mem_account_depth] = (srpc_mem_account_frame_t){.name = name};
+    }
+
+    ++mem_account_depth;
+}
+
+/**
+ * End the current accounting scope of the calling thread and record its statistics. If the scope size exceeds the
+ * threshold, a warning is logged.
+ *
+ * @param tree Tree built within the scope, can be NULL - if its size exceeds the nodes counted through the ly_tree
+ * helpers, the tree size is recorded instead, so trees built without the helpers are accounted as well.
+ *
+ */
+void srpc_mem_account_end(const struct lyd_node *tree)
+{
+    srpc_mem_account_frame_t frame = {0};
+    srpc_mem_account_frame_t *parent = NULL;
+    uint64_t tree_nodes = 0, tree_bytes = 0;
+
+    if (!mem_account_depth)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Memory accounting scope ended without being started");
+        return;
+    }
+
+    --mem_account_depth;
+
+    if (mem_account_depth >= MEM_ACCOUNT_MAX_DEPTH)
+    {
+        // untracked scope - its nodes were counted for the deepest tracked scope
+        return;
+    }
+
+    frame = mem_account_frames[mem_account_depth];
+
+    for (const struct lyd_node *iter = tree; iter; iter = iter->next)
+    {
+        mem_account_measure(iter, &tree_nodes, &tree_bytes);
+    }
+
+    if (tree_bytes > frame.bytes)
+    {
+        frame.nodes = tree_nodes;
+        frame.bytes = tree_bytes;
+    }
+
+    parent = mem_account_frame();
+    if (parent)
+    {
+        parent->nodes += frame.nodes;
+        parent->bytes += frame.bytes;
+    }
+
+    mem_account_record(frame.name, frame.nodes, frame.bytes);
+}
+
+/**
+ * Account a node and its subtree for the current scope - no-op without an active scope.
+ *
+ * @param node Node to account, can be NULL.
+ *
+ */
+void srpc_mem_account_node(const struct lyd_node *node)
+{
+    srpc_mem_account_frame_t *frame = mem_account_frame();
+
+    if (frame && node)
+    {
+        mem_account_measure(node, &frame->nodes, &frame->bytes);
+    }
+}
+
+/**
+ * Account a tree - the node, its following siblings and all their subtrees - for the current scope. No-op without an
+ * active scope.
+ *
+ * @param tree Tree to account, can be NULL.
+ *
+ */
+void srpc_mem_account_tree(const struct lyd_node *tree)
+{
+    srpc_mem_account_frame_t *frame = mem_account_frame();
+
+    if (!frame)
+    {
+        return;
+    }
+
+    for (const struct lyd_node *iter = tree; iter; iter = iter->next)
+    {
+        mem_account_measure(iter, &frame->nodes, &frame->bytes);
+    }
+}
+
+/**
+ * Set the scope size above which a warning is logged.
+ *
+ * @param bytes Threshold in bytes - 0 to disable the warning.
+ *
+ */
+void srpc_mem_account_set_threshold(uint64_t bytes)
+{
+    pthread_mutex_lock(&mem_account_lock);
+    mem_account_threshold = bytes;
+    pthread_mutex_unlock(&mem_account_lock);
+}
+
+/**
+ * Get the statistics of a named scope.
+ *
+ * @param name Name of the scope.
+ * @param stats Statistics output.
+ *
+ * @return Error code - 0 on success, -1 if no scope with the name finished yet.
+ */
+int srpc_mem_account_get_stats(const char *name, srpc_mem_account_stats_t *stats)
+{
+    srpc_mem_account_entry_t *entry = NULL;
+
+    pthread_mutex_lock(&mem_account_lock);
+
+    HASH_FIND_STR(mem_account_table, name, entry);
+    if (entry)
+    {
+        *stats = entry->stats;
+    }
+
+    pthread_mutex_unlock(&mem_account_lock);
+
+    return entry ? 0 : -1;
+}
+
+/**
+ * Call the callback for the statistics of each named scope. The statistics are locked during the iteration - do not
+ * begin or end scopes from the callback.
+ *
+ * @param cb Callback to call.
+ * @param priv Private data passed to the callback.
+ *
+ */
+void srpc_mem_account_foreach(srpc_mem_account_stats_cb cb, void *priv)
+{
+    srpc_mem_account_entry_t *entry = NULL, *tmp = NULL;
+
+    pthread_mutex_lock(&mem_account_lock);
+
+    HASH_ITER(hh, mem_account_table, entry, tmp)
+    {
+        cb(priv, entry->name, &entry->stats);
+    }
+
+    pthread_mutex_unlock(&mem_account_lock);
+}
+
+/**
+ * Remove the statistics of all scopes.
+ *
+ */
+void srpc_mem_account_reset(void)
+{
+    srpc_mem_account_entry_t *entry = NULL, *tmp = NULL;
+
+    pthread_mutex_lock(&mem_account_lock);
+
+    HASH_ITER(hh, mem_account_table, entry, tmp)
+    {
+        HASH_DEL(mem_account_table, entry);
+        free(entry->name);
+        free(entry);
+    }
+
+    pthread_mutex_unlock(&mem_account_lock);
+}
+
+/**
+ * Get the innermost tracked scope of the calling thread.
+ *
+ * @return Scope frame, NULL if no scope is active.
+ */
+static srpc_mem_account_frame_t *mem_account_frame(void)
+{
+    size_t depth = mem_account_depth < MEM_ACCOUNT_MAX_DEPTH ? mem_account_depth : MEM_ACCOUNT_MAX_DEPTH;
+
+    return depth ? &mem_account_frames[depth - 1] : NULL;
+}
+
+/**
+ * Add the size of a node and its subtree to the counters.
+ *
+ * @param node Node to measure.
+ * @param nodes Node counter.
+ * @param bytes Byte counter.
+ *
+ */
+static void mem_account_measure(const struct lyd_node *node, uint64_t *nodes, uint64_t *bytes)
+{
+    struct lyd_node *elem = NULL;
+
+    LYD_TREE_DFS_BEGIN(node, elem)
+    {
+        ++*nodes;
+        *bytes += mem_account_node_size(elem);
+
+        LYD_TREE_DFS_END(node, elem);
+    }
+}
+
+/**
+ * Get the approximate size of a single data node.
+ *
+ * @param node Data node.
+ *
+ * @return Size in bytes.
+ */
+static uint64_t mem_account_node_size(const struct lyd_node *node)
+{
+    const char *value = NULL;
+
+    if (!node->schema)
+    {
+        return sizeof(struct lyd_node_opaq);
+    }
+
+    if (node->schema->nodetype & LYD_NODE_INNER)
+    {
+        return sizeof(struct lyd_node_inner);
+    }
+
+    if (node->schema->nodetype & LYD_NODE_TERM)
+    {
+        value = lyd_get_value(node);
+        return sizeof(struct lyd_node_term) + (value ? strlen(value) + 1 : 0);
+    }
+
+    return sizeof(struct lyd_node_any);
+}
+
+/**
+ * Record the size of a finished scope.
+ *
+ * @param name Scope name.
+ * @param nodes Nodes of the scope.
+ * @param bytes Bytes of the scope.
+ *
+ */
+static void mem_account_record(const char *name, uint64_t nodes, uint64_t bytes)
+{
+    srpc_mem_account_entry_t *entry = NULL;
+    srpc_mem_account_stats_t *stats = NULL;
+    bool exceeded = false;
+
+    pthread_mutex_lock(&mem_account_lock);
+
+    HASH_FIND_STR(mem_account_table, name, entry);
+    if (!entry)
+    {
+        entry = calloc(1, sizeof(*entry));
+        if (!entry || !(entry->name = strdup(name)))
+        {
+            free(entry);
+            pthread_mutex_unlock(&mem_account_lock);
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to record memory accounting statistics of %s", name);
+            return;
+        }
+        HASH_ADD_KEYPTR(hh, mem_account_table, entry->name, strlen(entry->name), entry);
+    }
+
+    stats = &entry->stats;
+    stats->calls++;
+    stats->last_nodes = nodes;
+    stats->last_bytes = bytes;
+    stats->total_nodes += nodes;
+    stats->total_bytes += bytes;
+    if (nodes > stats->peak_nodes)
+    {
+        stats->peak_nodes = nodes;
+    }
+    if (bytes > stats->peak_bytes)
+    {
+        stats->peak_bytes = bytes;
+    }
+
+    exceeded = mem_account_threshold && bytes > mem_account_threshold;
+
+    pthread_mutex_unlock(&mem_account_lock);
+
+    if (exceeded)
+    {
+        SRPLG_LOG_WRN(SRPC_PLUGIN_NAME, "%s built %" PRIu64 " nodes (~%" PRIu64 " bytes), above the threshold", name,
+                      nodes, bytes);
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file mem_account.h
+ * @brief API for accounting the size of libyang trees built by callbacks.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_MEM_ACCOUNT_H
+#define SRPC_MEM_ACCOUNT_H
+
+#include "types.h"
+
+#include <stdint.h>
+
+/**
+ * Begin a named accounting scope on the calling thread. Until the matching srpc_mem_account_end(), nodes created by
+ * the srpc_ly_tree_create_* helpers and trees passed to srpc_mem_account_node() or srpc_mem_account_tree() are
+ * counted for the scope. Scopes can be nested - a finished scope is also counted for its parent.
+ * The collector and the operational cache open a scope around their build callbacks automatically.
+ *
+ * @param name Name of the scope, usually the callback path - has to stay valid until the scope ends.
+ *
+ */
+void srpc_mem_account_begin(const char *name);
+
+/**
+ * End the current accounting scope of the calling thread and record its statistics. If the scope size exceeds the
+ * threshold, a warning is logged.
+ *
+ * @param tree Tree built within the scope, can be NULL - if its size exceeds the nodes counted through the ly_tree
+ * helpers, the tree size is recorded instead, so trees built without the helpers are accounted as well.
+ *
+ */
+void srpc_mem_account_end(const struct lyd_node *tree);
+
+/**
+ * Account a node and its subtree for the current scope - no-op without an active scope.
+ *
+ * @param node Node to account, can be NULL.
+ *
+ */
+void srpc_mem_account_node(const struct lyd_node *node);
+
+/**
+ * Account a tree - the node, its following siblings and all their subtrees - for the current scope. No-op without an
+ * active scope.
+ *
+ * @param tree Tree to account, can be NULL.
+ *
+ */
+void srpc_mem_account_tree(const struct lyd_node *tree);
+
+/**
+ * Set the scope size above which a warning is logged.
+ *
+ * @param bytes Threshold in bytes - 0 to disable the warning.
+ *
+ */
+void srpc_mem_account_set_threshold(uint64_t bytes);
+
+/**
+ * Get the statistics of a named scope.
+ *
+ * @param name Name of the scope.
+ * @param stats Statistics output.
+ *
+ * @return Error code - 0 on success, -1 if no scope with the name finished yet.
+ */
+int srpc_mem_account_get_stats(const char *name, srpc_mem_account_stats_t *stats);
+
+/**
+ * Call the callback for the statistics of each named scope. The statistics are locked during the iteration - do not
+ * begin or end scopes from the callback.
+ *
+ * @param cb Callback to call.
+ * @param priv Private data passed to the callback.
+ *
+ */
+void srpc_mem_account_foreach(srpc_mem_account_stats_cb cb, void *priv);
+
+/**
+ * Remove the statistics of all scopes.
+ *
+ */
+void srpc_mem_account_reset(void);
+
+#endif // SRPC_MEM_ACCOUNT_H
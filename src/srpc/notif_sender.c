@@ -0,0 +1,638 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "notif_sender.h"
+#include "common.h"
+#include "ly_tree.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uthash.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+typedef struct srpc_notif_sender_event_s srpc_notif_sender_event_t;
+
+/**
+ * Pending event of a single key.
+ */
+struct srpc_notif_sender_event_s
+{
+    char *key;                       ///< Key - object the event describes.
+    char *path;                      ///< Path of the notification.
+    srpc_key_value_pair_t *leafs;    ///< Leaf paths relative to the notification node and their values, owned.
+    size_t leafs_count;              ///< Number of leafs.
+    uint64_t first_ms;               ///< Time of the first pending event of the key.
+    bool throttled;                  ///< Event was delayed by the rate limit.
+    srpc_notif_sender_event_t *next; ///< Next event taken for sending.
+    UT_hash_handle hh;               ///< UTHash reserved data.
+};
+
+/**
+ * Notification sender - pending events, the token bucket and the sender thread state.
+ */
+struct srpc_notif_sender_s
+{
+    sr_session_ctx_t *session;         ///< Session used for sending.
+    uint32_t window_ms;                ///< Coalescing window.
+    uint32_t rate;                     ///< Tokens refilled per second, 0 for no limit.
+    uint32_t burst;                    ///< Token bucket size.
+    double tokens;                     ///< Available tokens.
+    uint64_t refill_ms;                ///< Time of the last token refill.
+    srpc_notif_sender_event_t *events; ///< Pending events hashed by key, in the order of their first event.
+    srpc_notif_sender_stats_t stats;   ///< Counters.
+    bool stop;                         ///< Thread stop request.
+    pthread_t thread;                  ///< Sender thread.
+    pthread_mutex_t lock;              ///< Lock for the pending events, the token bucket and the counters.
+    pthread_mutex_t send_lock;         ///< Serializes sends of the sender thread and flushes.
+    pthread_cond_t cond;               ///< Signaled on new events and stop requests.
+};
+
+static void *notif_sender_thread(void *arg);
+static srpc_notif_sender_event_t *notif_sender_take(srpc_notif_sender_t *sender, uint64_t now, bool all);
+static int notif_sender_deliver(srpc_notif_sender_t *sender, srpc_notif_sender_event_t *events);
+static void notif_sender_refill(srpc_notif_sender_t *sender, uint64_t now);
+static void notif_sender_wait(srpc_notif_sender_t *sender, uint64_t until_ms);
+static uint64_t notif_sender_now_ms(void);
+static srpc_notif_sender_event_t *notif_sender_event_new(const char *key, const char *path,
+                                                         const srpc_key_value_pair_t leafs[], size_t leafs_count);
+static void notif_sender_event_free(srpc_notif_sender_event_t *event);
+
+/**
+ * Create a new notification sender and start its sender thread. Events are keyed by the object they describe (for
+ * example an interface name) - only the latest pending event of a key is sent. An event waits for the coalescing
+ * window after the first pending event of its key, then it is sent as soon as the token bucket allows it.
+ *
+ * @param session Session used for sending the notifications - has to stay valid until the sender is freed.
+ * @param window_ms Coalescing window - 0 to send events as soon as the rate allows it.
+ * @param rate Notifications per second refilled into the token bucket - 0 for no rate limit.
+ * @param burst Size of the token bucket - number of notifications which can be sent at once, at least 1.
+ *
+ * @return New notification sender, NULL on error.
+ */
+srpc_notif_sender_t *srpc_notif_sender_new(sr_session_ctx_t *session, uint32_t window_ms, uint32_t rate,
+                                           uint32_t burst)
+{
+    srpc_notif_sender_t *sender = NULL;
+    pthread_condattr_t cond_attr;
+    bool lock_init = false, send_lock_init = false, cond_init = false;
+
+    SRPC_SAFE_CALL_PTR(sender, calloc(1, sizeof(*sender)), error_out);
+
+    sender->session = session;
+    sender->window_ms = window_ms;
+    sender->rate = rate;
+    sender->burst = burst ? burst : 1;
+    sender->tokens = sender->burst;
+    sender->refill_ms = notif_sender_now_ms();
+
+    lock_init = pthread_mutex_init(&sender->lock, NULL) == 0;
+    send_lock_init = pthread_mutex_init(&sender->send_lock, NULL) == 0;
+
+    // use monotonic clock for the timers
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    cond_init = pthread_cond_init(&sender->cond, &cond_attr) == 0;
+    pthread_condattr_destroy(&cond_attr);
+
+    if (!lock_init || !send_lock_init || !cond_init)
+    {
+        goto error_out;
+    }
+
+    if (pthread_create(&sender->thread, NULL, notif_sender_thread, sender) != 0)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to start notification sender thread");
+        goto error_out;
+    }
+
+    return sender;
+
+error_out:
+    if (sender)
+    {
+        if (cond_init)
+        {
+            pthread_cond_destroy(&sender->cond);
+        }
+        if (send_lock_init)
+        {
+            pthread_mutex_destroy(&sender->send_lock);
+        }
+        if (lock_init)
+        {
+            pthread_mutex_destroy(&sender->lock);
+        }
+        free(sender);
+    }
+
+    return NULL;
+}
+
+/**
+ * Queue a notification event. The notification tree is built with the ly_tree helpers when the event is sent, so no
+ * libyang context is held while events are pending. Replaces a pending event of the same key.
+ *
+ * @param sender Notification sender.
+ * @param key Key of the event.
+ * @param path Path of the notification - for example "/ietf-interfaces:interface-state-change".
+ * @param leafs Leafs of the notification - paths relative to the notification node and their values, copied.
+ * @param leafs_count Number of leafs.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_notif_sender_send(srpc_notif_sender_t *sender, const char *key, const char *path,
+                           const srpc_key_value_pair_t leafs[], size_t leafs_count)
+{
+    srpc_notif_sender_event_t *event = NULL;
+    srpc_notif_sender_event_t *pending = NULL;
+    srpc_notif_sender_event_t *replaced = NULL;
+    srpc_notif_sender_event_t swap = {0};
+
+    event = notif_sender_event_new(key, path, leafs, leafs_count);
+    if (!event)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to queue notification event for \"%s\"", key);
+        return -1;
+    }
+
+    pthread_mutex_lock(&sender->lock);
+
+    sender->stats.queued++;
+
+    HASH_FIND_STR(sender->events, key, pending);
+    if (pending)
+    {
+        // swap the data into the pending event - it keeps its place in the order and its window isn't restarted
+        swap = *pending;
+        pending->path = event->path;
+        pending->leafs = event->leafs;
+        pending->leafs_count = event->leafs_count;
+        event->path = swap.path;
+        event->leafs = swap.leafs;
+        event->leafs_count = swap.leafs_count;
+        replaced = event;
+        sender->stats.coalesced++;
+    }
+    else
+    {
+        event->first_ms = notif_sender_now_ms();
+        HASH_ADD_KEYPTR(hh, sender->events, event->key, strlen(event->key), event);
+    }
+
+    pthread_cond_signal(&sender->cond);
+
+    pthread_mutex_unlock(&sender->lock);
+
+    if (replaced)
+    {
+        notif_sender_event_free(replaced);
+    }
+
+    return 0;
+}
+
+/**
+ * Send all pending events on the calling thread, regardless of the coalescing window and the rate limit.
+ *
+ * @param sender Notification sender.
+ *
+ * @return Error code - 0 on success, -1 if any notification failed to be built or sent.
+ */
+int srpc_notif_sender_flush(srpc_notif_sender_t *sender)
+{
+    srpc_notif_sender_event_t *taken = NULL;
+
+    pthread_mutex_lock(&sender->lock);
+    taken = notif_sender_take(sender, 0, true);
+    pthread_mutex_unlock(&sender->lock);
+
+    return notif_sender_deliver(sender, taken);
+}
+
+/**
+ * Get the number of pending events.
+ *
+ * @param sender Notification sender.
+ *
+ * @return Number of pending events.
+ */
+size_t srpc_notif_sender_pending_count(srpc_notif_sender_t *sender)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&sender->lock);
+    count = HASH_COUNT(sender->events);
+    pthread_mutex_unlock(&sender->lock);
+
+    return count;
+}
+
+/**
+ * Get the sender counters.
+ *
+ * @param sender Notification sender.
+ * @param stats Counters output.
+ *
+ */
+void srpc_notif_sender_get_stats(srpc_notif_sender_t *sender, srpc_notif_sender_stats_t *stats)
+{
+    pthread_mutex_lock(&sender->lock);
+    *stats = sender->stats;
+    pthread_mutex_unlock(&sender->lock);
+}
+
+/**
+ * Build a notification tree the way the sender does when sending an event - for sending a notification directly or
+ * checking the path and the leafs of an event.
+ *
+ * @param ly_ctx libyang context to use.
+ * @param path Path of the notification - the notification can be nested in a data node, for example a list entry.
+ * @param leafs Leafs of the notification - paths relative to the notification node and their values.
+ * @param leafs_count Number of leafs.
+ * @param notif Built tree output - the top-level node, free it using lyd_free_all().
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_notif_sender_build(const struct ly_ctx *ly_ctx, const char *path, const srpc_key_value_pair_t leafs[],
+                            size_t leafs_count, struct lyd_node **notif)
+{
+    int error = 0;
+    struct lyd_node *node = NULL;
+
+    *notif = NULL;
+
+    SRPC_SAFE_CALL_ERR(error, srpc_ly_tree_create_container(ly_ctx, NULL, notif, path), error_out);
+
+    // the first created node is the top-level one - the notification itself is found by its path, as the parents
+    // can be list entries with their keys as the first children
+    if (lyd_find_path(*notif, path, 0, &node) != LY_SUCCESS || !node->schema || node->schema->nodetype != LYS_NOTIF)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Path %s is not a notification", path);
+        goto error_out;
+    }
+
+    for (size_t i = 0; i < leafs_count; i++)
+    {
+        SRPC_SAFE_CALL_ERR(error, srpc_ly_tree_create_leaf(ly_ctx, node, NULL, leafs[i].key, leafs[i].value),
+                           error_out);
+    }
+
+    goto out;
+
+error_out:
+    lyd_free_all(*notif);
+    *notif = NULL;
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Stop the sender thread, send all pending events and free the sender.
+ *
+ * @param sender Notification sender.
+ *
+ */
+void srpc_notif_sender_free(srpc_notif_sender_t **sender)
+{
+    srpc_notif_sender_t *s = *sender;
+
+    if (!s)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+
+    pthread_join(s->thread, NULL);
+
+    // the events already happened - don't drop the last state of the keys
+    srpc_notif_sender_flush(s);
+
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->send_lock);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+
+    *sender = NULL;
+}
+
+/**
+ * Sender thread - sends events once their window has passed and the token bucket allows it.
+ *
+ * @param arg Notification sender.
+ *
+ * @return Always NULL.
+ */
+static void *notif_sender_thread(void *arg)
+{
+    srpc_notif_sender_t *sender = arg;
+    srpc_notif_sender_event_t *event = NULL, *tmp = NULL;
+    srpc_notif_sender_event_t *taken = NULL;
+    uint64_t due_ms = 0;
+    uint64_t now = 0;
+
+    pthread_mutex_lock(&sender->lock);
+
+    while (!sender->stop)
+    {
+        if (!sender->events)
+        {
+            pthread_cond_wait(&sender->cond, &sender->lock);
+            continue;
+        }
+
+        // events are kept in the order of their first event - the head is due first
+        due_ms = sender->events->first_ms + sender->window_ms;
+        now = notif_sender_now_ms();
+        if (now < due_ms)
+        {
+            notif_sender_wait(sender, due_ms);
+            continue;
+        }
+
+        notif_sender_refill(sender, now);
+        if (sender->rate && sender->tokens < 1)
+        {
+            HASH_ITER(hh, sender->events, event, tmp)
+            {
+                if (event->first_ms + sender->window_ms > now)
+                {
+                    break;
+                }
+                if (!event->throttled)
+                {
+                    event->throttled = true;
+                    sender->stats.throttled++;
+                }
+            }
+
+            // wait for the next token
+            notif_sender_wait(sender, now + (uint64_t)((1 - sender->tokens) * 1000 / sender->rate) + 1);
+            continue;
+        }
+
+        taken = notif_sender_take(sender, now, false);
+
+        pthread_mutex_unlock(&sender->lock);
+        notif_sender_deliver(sender, taken);
+        pthread_mutex_lock(&sender->lock);
+    }
+
+    pthread_mutex_unlock(&sender->lock);
+
+    return NULL;
+}
+
+/**
+ * Take pending events for sending - called with the lock held.
+ *
+ * @param sender Notification sender.
+ * @param now Current time.
+ * @param all Take all events regardless of their window and the available tokens.
+ *
+ * @return Taken events in the order of their first event.
+ */
+static srpc_notif_sender_event_t *notif_sender_take(srpc_notif_sender_t *sender, uint64_t now, bool all)
+{
+    srpc_notif_sender_event_t *event = NULL, *tmp = NULL;
+    srpc_notif_sender_event_t *taken = NULL;
+    srpc_notif_sender_event_t **tail = &taken;
+
+    HASH_ITER(hh, sender->events, event, tmp)
+    {
+        if (!all)
+        {
+            if (event->first_ms + sender->window_ms > now || (sender->rate && sender->tokens < 1))
+            {
+                break;
+            }
+            if (sender->rate)
+            {
+                sender->tokens -= 1;
+            }
+        }
+
+        HASH_DEL(sender->events, event);
+        event->next = NULL;
+        *tail = event;
+        tail = &event->next;
+    }
+
+    return taken;
+}
+
+/**
+ * Build and send taken events, then free them. Sends are serialized so a flush returns only after a batch running on
+ * the sender thread has finished.
+ *
+ * @param sender Notification sender.
+ * @param events Events to send.
+ *
+ * @return Error code - 0 on success, -1 if any notification failed to be built or sent.
+ */
+static int notif_sender_deliver(srpc_notif_sender_t *sender, srpc_notif_sender_event_t *events)
+{
+    int error = 0;
+    sr_conn_ctx_t *conn_ctx = NULL;
+    const struct ly_ctx *ly_ctx = NULL;
+    srpc_notif_sender_event_t *event = NULL;
+    struct lyd_node *notif = NULL;
+    uint64_t sent = 0, failed = 0;
+
+    if (!events)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&sender->send_lock);
+
+    // one context acquisition for the whole batch
+    conn_ctx = sr_session_get_connection(sender->session);
+    ly_ctx = conn_ctx ? sr_acquire_context(conn_ctx) : NULL;
+    if (!ly_ctx)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to acquire libyang context for sending notifications");
+    }
+
+    while (events)
+    {
+        event = events;
+        events = event->next;
+
+        notif = NULL;
+        if (!ly_ctx || srpc_notif_sender_build(ly_ctx, event->path, event->leafs, event->leafs_count, &notif) ||
+            sr_notif_send_tree(sender->session, notif, 0, 0) != SR_ERR_OK)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to send notification %s for \"%s\"", event->path, event->key);
+            failed++;
+        }
+        else
+        {
+            sent++;
+        }
+
+        lyd_free_all(notif);
+        notif_sender_event_free(event);
+    }
+
+    if (ly_ctx)
+    {
+        sr_release_context(conn_ctx);
+    }
+
+    pthread_mutex_unlock(&sender->send_lock);
+
+    pthread_mutex_lock(&sender->lock);
+    sender->stats.sent += sent;
+    sender->stats.failed += failed;
+    pthread_mutex_unlock(&sender->lock);
+
+    if (failed)
+    {
+        error = -1;
+    }
+
+    return error;
+}
+
+/**
+ * Refill the token bucket by the time passed since the last refill - called with the lock held.
+ *
+ * @param sender Notification sender.
+ * @param now Current time.
+ *
+ */
+static void notif_sender_refill(srpc_notif_sender_t *sender, uint64_t now)
+{
+    if (now > sender->refill_ms)
+    {
+        sender->tokens += (double)(now - sender->refill_ms) * sender->rate / 1000;
+        if (sender->tokens > sender->burst)
+        {
+            sender->tokens = sender->burst;
+        }
+        sender->refill_ms = now;
+    }
+}
+
+/**
+ * Wait on the condition until the given time, a new event or a stop request - called with the lock held.
+ *
+ * @param sender Notification sender.
+ * @param until_ms Time to wait for in milliseconds of the monotonic clock.
+ *
+ */
+static void notif_sender_wait(srpc_notif_sender_t *sender, uint64_t until_ms)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(until_ms / 1000),
+        .tv_nsec = (long)(until_ms % 1000) * 1000000L,
+    };
+
+    pthread_cond_timedwait(&sender->cond, &sender->lock, &ts);
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in milliseconds.
+ */
+static uint64_t notif_sender_now_ms(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Allocate an event and copy its data.
+ *
+ * @param key Key of the event.
+ * @param path Path of the notification.
+ * @param leafs Leafs of the notification.
+ * @param leafs_count Number of leafs.
+ *
+ * @return New event, NULL on error.
+ */
+static srpc_notif_sender_event_t *notif_sender_event_new(const char *key, const char *path,
+                                                         const srpc_key_value_pair_t leafs[], size_t leafs_count)
+{
+    srpc_notif_sender_event_t *event = NULL;
+
+    SRPC_SAFE_CALL_PTR(event, calloc(1, sizeof(*event)), error_out);
+    SRPC_SAFE_CALL_PTR(event->key, strdup(key), error_out);
+    SRPC_SAFE_CALL_PTR(event->path, strdup(path), error_out);
+
+    if (leafs_count)
+    {
+        SRPC_SAFE_CALL_PTR(event->leafs, calloc(leafs_count, sizeof(srpc_key_value_pair_t)), error_out);
+    }
+
+    for (size_t i = 0; i < leafs_count; i++)
+    {
+        // counted before the copies, so a partially copied event is freed completely
+        event->leafs_count++;
+        SRPC_SAFE_CALL_PTR(event->leafs[i].key, strdup(leafs[i].key), error_out);
+        if (leafs[i].value)
+        {
+            SRPC_SAFE_CALL_PTR(event->leafs[i].value, strdup(leafs[i].value), error_out);
+        }
+    }
+
+    return event;
+
+error_out:
+    notif_sender_event_free(event);
+    return NULL;
+}
+
+/**
+ * Free an event and its data.
+ *
+ * @param event Event to free, can be NULL.
+ *
+ */
+static void notif_sender_event_free(srpc_notif_sender_event_t *event)
+{
+    if (!event)
+    {
+        return;
+    }
+
+    // the copies are owned by the event
+    for (size_t i = 0; i < event->leafs_count; i++)
+    {
+        free((char *)event->leafs[i].key);
+        free((char *)event->leafs[i].value);
+    }
+
+    free(event->leafs);
+    free(event->path);
+    free(event->key);
+    free(event);
+}
@@ -0,0 +1,108 @@
+/**
+ * @file notif_sender.h
+ * @brief API for coalescing and rate limiting YANG notifications.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_NOTIF_SENDER_H
+#define SRPC_NOTIF_SENDER_H
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Create a new notification sender and start its sender thread. Events are keyed by the object they describe (for
+ * example an interface name) - only the latest pending event of a key is sent. An event waits for the coalescing
+ * window after the first pending event of its key, then it is sent as soon as the token bucket allows it.
+ *
+ * @param session Session used for sending the notifications - has to stay valid until the sender is freed.
+ * @param window_ms Coalescing window - 0 to send events as soon as the rate allows it.
+ * @param rate Notifications per second refilled into the token bucket - 0 for no rate limit.
+ * @param burst Size of the token bucket - number of notifications which can be sent at once, at least 1.
+ *
+ * @return New notification sender, NULL on error.
+ */
+srpc_notif_sender_t *srpc_notif_sender_new(sr_session_ctx_t *session, uint32_t window_ms, uint32_t rate,
+                                           uint32_t burst);
+
+/**
+ * Queue a notification event. The notification tree is built with the ly_tree helpers when the event is sent, so no
+ * libyang context is held while events are pending. Replaces a pending event of the same key.
+ *
+ * @param sender Notification sender.
+ * @param key Key of the event.
+ * @param path Path of the notification - for example "/ietf-interfaces:interface-state-change".
+ * @param leafs Leafs of the notification - paths relative to the notification node and their values, copied.
+ * @param leafs_count Number of leafs.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_notif_sender_send(srpc_notif_sender_t *sender, const char *key, const char *path,
+                           const srpc_key_value_pair_t leafs[], size_t leafs_count);
+
+/**
+ * Send all pending events on the calling thread, regardless of the coalescing window and the rate limit.
+ *
+ * @param sender Notification sender.
+ *
+ * @return Error code - 0 on success, -1 if any notification failed to be built or sent.
+ */
+int srpc_notif_sender_flush(srpc_notif_sender_t *sender);
+
+/**
+ * Get the number of pending events.
+ *
+ * @param sender Notification sender.
+ *
+ * @return Number of pending events.
+ */
+size_t srpc_notif_sender_pending_count(srpc_notif_sender_t *sender);
+
+/**
+ * Get the sender counters.
+ *
+ * @param sender Notification sender.
+ * @param stats Counters output.
+ *
+ */
+void srpc_notif_sender_get_stats(srpc_notif_sender_t *sender, srpc_notif_sender_stats_t *stats);
+
+/**
+ * Build a notification tree the way the sender does when sending an event - for sending a notification directly or
+ * checking the path and the leafs of an event.
+ *
+ * @param ly_ctx libyang context to use.
+ * @param path Path of the notification - the notification can be nested in a data node, for example a list entry.
+ * @param leafs Leafs of the notification - paths relative to the notification node and their values.
+ * @param leafs_count Number of leafs.
+ * @param notif Built tree output - the top-level node, free it using lyd_free_all().
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_notif_sender_build(const struct ly_ctx *ly_ctx, const char *path, const srpc_key_value_pair_t leafs[],
+                            size_t leafs_count, struct lyd_node **notif);
+
+/**
+ * Stop the sender thread, send all pending events and free the sender.
+ *
+ * @param sender Notification sender.
+ *
+ */
+void srpc_notif_sender_free(srpc_notif_sender_t **sender);
+
+#endif // SRPC_NOTIF_SENDER_H
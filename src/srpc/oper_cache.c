@@ -0,0 +1,736 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "oper_cache.h"
+#include "common.h"
+#include "mem_account.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uthash.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+// Maximum number of cached entries - request xpaths are client specific so the number of keys is unbounded.
+#define SRPC_OPER_CACHE_MAX_ENTRIES 256
+
+typedef struct srpc_oper_cache_entry_s srpc_oper_cache_entry_t;
+typedef struct srpc_oper_cache_refresh_s srpc_oper_cache_refresh_t;
+
+/**
+ * Cached subtree of one module/path/request xpath combination.
+ */
+struct srpc_oper_cache_entry_s
+{
+    char *key;               ///< Hash key - module, path and request xpath.
+    char *module_name;       ///< Module name.
+    char *path;              ///< Subscription path.
+    char *request_xpath;     ///< Request xpath, NULL if none.
+    char *parent_path;       ///< Path of the parent node the data was built in, NULL for top-level data.
+    struct lyd_node *tree;   ///< Cached data - top-level siblings including the parent nodes.
+    uint64_t built_ms;       ///< Time of building the data.
+    bool refreshing;         ///< Entry is queued for a background refresh.
+    sr_oper_get_items_cb cb; ///< Callback which built the data.
+    void *priv;              ///< Callback private data.
+    uint32_t sub_id;         ///< Subscription ID of the request which built the data.
+    UT_hash_handle hh;       ///< UTHash reserved data.
+};
+
+/**
+ * Queued background refresh.
+ */
+struct srpc_oper_cache_refresh_s
+{
+    char *key;                       ///< Key of the entry to refresh.
+    srpc_oper_cache_refresh_t *next; ///< Next queued refresh.
+};
+
+/**
+ * Operational cache.
+ */
+struct srpc_oper_cache_s
+{
+    uint32_t ttl_ms;                   ///< Time to live of the cached data.
+    uint32_t stale_ms;                 ///< Time after TTL during which stale data is served.
+    sr_session_ctx_t *refresh_session; ///< Session used for background refreshes.
+    srpc_oper_cache_entry_t *entries;  ///< Cached entries hash.
+    srpc_oper_cache_stats_t stats;     ///< Counters.
+    uint64_t invalidation_seq;         ///< Incremented on each invalidation - refreshes started before are discarded.
+    srpc_oper_cache_refresh_t *queue;  ///< Queued background refreshes.
+    bool stop;                         ///< Refresh thread stop request.
+    bool has_thread;                   ///< Refresh thread is running.
+    pthread_t thread;                  ///< Refresh thread.
+    pthread_mutex_t lock;              ///< Lock for the whole cache state.
+    pthread_cond_t cond;               ///< Signaled on queued refreshes and stop requests.
+};
+
+static void *oper_cache_refresh_thread(void *arg);
+static int oper_cache_refresh(srpc_oper_cache_t *cache, srpc_oper_cache_entry_t *args, struct lyd_node **copy);
+static int oper_cache_serve(const struct lyd_node *tree, struct lyd_node **parent);
+static int oper_cache_existing(const struct lyd_node *parent, struct ly_set **existing);
+static int oper_cache_capture(const struct lyd_node *data, const struct ly_set *existing, struct lyd_node **copy);
+static void oper_cache_update(srpc_oper_cache_t *cache, const char *key, srpc_oper_cache_entry_t *args,
+                              struct lyd_node *copy);
+static char *oper_cache_key(const char *module_name, const char *path, const char *request_xpath);
+static void oper_cache_entry_free(srpc_oper_cache_entry_t *entry);
+static uint64_t oper_cache_now_ms(void);
+
+/**
+ * Create a new operational cache.
+ * Cached subtrees belong to the sysrepo libyang context - invalidate the whole cache if the context changes.
+ *
+ * @param ttl_ms Time for which a built subtree is served without calling the callback again.
+ * @param stale_ms Time after the TTL during which the stale subtree is served while it is refreshed in the background.
+ * Use 0 to disable background refreshing.
+ * @param refresh_session Session passed to the callbacks on background refreshes - can be NULL if stale_ms is 0.
+ *
+ * @return New operational cache, NULL on error.
+ */
+srpc_oper_cache_t *srpc_oper_cache_new(uint32_t ttl_ms, uint32_t stale_ms, sr_session_ctx_t *refresh_session)
+{
+    srpc_oper_cache_t *cache = NULL;
+
+    SRPC_SAFE_CALL_PTR(cache, calloc(1, sizeof(*cache)), error_out);
+
+    cache->ttl_ms = ttl_ms;
+    cache->stale_ms = refresh_session ? stale_ms : 0;
+    cache->refresh_session = refresh_session;
+
+    pthread_mutex_init(&cache->lock, NULL);
+    pthread_cond_init(&cache->cond, NULL);
+
+    if (cache->stale_ms)
+    {
+        if (pthread_create(&cache->thread, NULL, oper_cache_refresh_thread, cache) != 0)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to start operational cache refresh thread");
+            pthread_cond_destroy(&cache->cond);
+            pthread_mutex_destroy(&cache->lock);
+            goto error_out;
+        }
+        cache->has_thread = true;
+    }
+
+    return cache;
+
+error_out:
+    free(cache);
+
+    return NULL;
+}
+
+/**
+ * Serve the operational data from the cache or call the callback and cache its result.
+ * Call from sr_oper_get_items_cb with the received arguments - entries are keyed by module, path and request xpath.
+ *
+ * @param cache Operational cache.
+ * @param session Sysrepo session of the request.
+ * @param sub_id Subscription ID.
+ * @param module_name Module name.
+ * @param path Subscription path.
+ * @param request_xpath Request XPath, can be NULL.
+ * @param request_id Request ID.
+ * @param parent Parent node for the data - same as for sr_oper_get_items_cb.
+ * @param cb Operational callback which builds the data.
+ * @param priv Private data passed to the callback.
+ *
+ * @return Error code - 0 on success, callback return value if the callback failed.
+ */
+int srpc_oper_cache_get_items(srpc_oper_cache_t *cache, sr_session_ctx_t *session, uint32_t sub_id,
+                              const char *module_name, const char *path, const char *request_xpath,
+                              uint32_t request_id, struct lyd_node **parent, sr_oper_get_items_cb cb, void *priv)
+{
+    int error = 0;
+    char *key = NULL;
+    srpc_oper_cache_entry_t *entry = NULL;
+    srpc_oper_cache_entry_t args = {0};
+    srpc_oper_cache_refresh_t *refresh = NULL;
+    struct lyd_node *copy = NULL;
+    struct ly_set *existing = NULL;
+    uint64_t age = 0;
+
+    SRPC_SAFE_CALL_PTR(key, oper_cache_key(module_name, path, request_xpath), error_out);
+
+    pthread_mutex_lock(&cache->lock);
+
+    HASH_FIND_STR(cache->entries, key, entry);
+    if (entry)
+    {
+        age = oper_cache_now_ms() - entry->built_ms;
+
+        if (age < cache->ttl_ms)
+        {
+            ++cache->stats.hits;
+            error = oper_cache_serve(entry->tree, parent);
+            pthread_mutex_unlock(&cache->lock);
+            goto out;
+        }
+
+        if (age < (uint64_t)cache->ttl_ms + cache->stale_ms)
+        {
+            ++cache->stats.stale_hits;
+
+            // queue only one refresh per entry - failing to queue just delays the refresh
+            if (!entry->refreshing && (refresh = calloc(1, sizeof(*refresh))) && (refresh->key = strdup(key)))
+            {
+                entry->refreshing = true;
+                refresh->next = cache->queue;
+                cache->queue = refresh;
+                pthread_cond_signal(&cache->cond);
+            }
+            else if (refresh)
+            {
+                free(refresh);
+            }
+
+            error = oper_cache_serve(entry->tree, parent);
+            pthread_mutex_unlock(&cache->lock);
+            goto out;
+        }
+    }
+
+    ++cache->stats.misses;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    // build the data and remember where it was built
+    if (*parent)
+    {
+        SRPC_SAFE_CALL_PTR(args.parent_path, lyd_path(*parent, LYD_PATH_STD, NULL, 0), error_out);
+        SRPC_SAFE_CALL_ERR(error, oper_cache_existing(*parent, &existing), error_out);
+    }
+
+    srpc_mem_account_begin(path);
+    error = cb(session, sub_id, module_name, path, request_xpath, request_id, parent, priv);
+    srpc_mem_account_end(error ? NULL : *parent);
+    if (error)
+    {
+        goto out;
+    }
+
+    // the request is answered either way - only the next one has to call the callback again
+    if (oper_cache_capture(*parent, existing, &copy))
+    {
+        SRPLG_LOG_WRN(SRPC_PLUGIN_NAME, "Unable to cache operational data for %s", path);
+        goto out;
+    }
+
+    args.module_name = (char *)module_name;
+    args.path = (char *)path;
+    args.request_xpath = (char *)request_xpath;
+    args.cb = cb;
+    args.priv = priv;
+    args.sub_id = sub_id;
+
+    pthread_mutex_lock(&cache->lock);
+    oper_cache_update(cache, key, &args, copy);
+    pthread_mutex_unlock(&cache->lock);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    ly_set_free(existing, NULL);
+    free(args.parent_path);
+    free(key);
+
+    return error;
+}
+
+/**
+ * Invalidate cache entries - use from change callbacks which change the cached data.
+ *
+ * @param cache Operational cache.
+ * @param module_name Module of the entries to invalidate, NULL for all entries.
+ * @param path Path of the entries to invalidate, NULL for all entries of the module.
+ *
+ */
+void srpc_oper_cache_invalidate(srpc_oper_cache_t *cache, const char *module_name, const char *path)
+{
+    srpc_oper_cache_entry_t *current = NULL, *tmp = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    HASH_ITER(hh, cache->entries, current, tmp)
+    {
+        if (module_name && strcmp(current->module_name, module_name))
+        {
+            continue;
+        }
+
+        if (module_name && path && strcmp(current->path, path))
+        {
+            continue;
+        }
+
+        HASH_DEL(cache->entries, current);
+        oper_cache_entry_free(current);
+        ++cache->stats.invalidations;
+    }
+
+    ++cache->invalidation_seq;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Get cache counters.
+ *
+ * @param cache Operational cache.
+ * @param stats Counters to set.
+ *
+ */
+void srpc_oper_cache_get_stats(srpc_oper_cache_t *cache, srpc_oper_cache_stats_t *stats)
+{
+    pthread_mutex_lock(&cache->lock);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Stop background refreshing and free all cache data.
+ *
+ * @param cache Operational cache.
+ *
+ */
+void srpc_oper_cache_free(srpc_oper_cache_t **cache)
+{
+    srpc_oper_cache_t *c = *cache;
+    srpc_oper_cache_entry_t *current = NULL, *tmp = NULL;
+    srpc_oper_cache_refresh_t *refresh = NULL;
+
+    if (!c)
+    {
+        return;
+    }
+
+    if (c->has_thread)
+    {
+        pthread_mutex_lock(&c->lock);
+        c->stop = true;
+        pthread_cond_signal(&c->cond);
+        pthread_mutex_unlock(&c->lock);
+
+        pthread_join(c->thread, NULL);
+    }
+
+    while (c->queue)
+    {
+        refresh = c->queue;
+        c->queue = refresh->next;
+        free(refresh->key);
+        free(refresh);
+    }
+
+    HASH_ITER(hh, c->entries, current, tmp)
+    {
+        HASH_DEL(c->entries, current);
+        oper_cache_entry_free(current);
+    }
+
+    pthread_cond_destroy(&c->cond);
+    pthread_mutex_destroy(&c->lock);
+    free(c);
+
+    *cache = NULL;
+}
+
+/**
+ * Background refresh thread - rebuilds stale entries using the refresh session.
+ *
+ * @param arg Operational cache.
+ *
+ * @return Always NULL.
+ */
+static void *oper_cache_refresh_thread(void *arg)
+{
+    srpc_oper_cache_t *cache = arg;
+    srpc_oper_cache_refresh_t *refresh = NULL;
+    srpc_oper_cache_entry_t *entry = NULL;
+    srpc_oper_cache_entry_t args = {0};
+    struct lyd_node *copy = NULL;
+    uint64_t seq = 0;
+    int error = 0;
+
+    pthread_mutex_lock(&cache->lock);
+
+    while (true)
+    {
+        while (!cache->queue && !cache->stop)
+        {
+            pthread_cond_wait(&cache->cond, &cache->lock);
+        }
+
+        if (cache->stop)
+        {
+            break;
+        }
+
+        refresh = cache->queue;
+        cache->queue = refresh->next;
+
+        HASH_FIND_STR(cache->entries, refresh->key, entry);
+        if (!entry)
+        {
+            // invalidated in the meantime
+            goto next;
+        }
+
+        // the entry can be freed while building - copy the callback arguments
+        memset(&args, 0, sizeof(args));
+        args.cb = entry->cb;
+        args.priv = entry->priv;
+        args.sub_id = entry->sub_id;
+        if (!(args.module_name = strdup(entry->module_name)) || !(args.path = strdup(entry->path)) ||
+            (entry->request_xpath && !(args.request_xpath = strdup(entry->request_xpath))) ||
+            (entry->parent_path && !(args.parent_path = strdup(entry->parent_path))))
+        {
+            entry->refreshing = false;
+            goto next;
+        }
+        seq = cache->invalidation_seq;
+
+        pthread_mutex_unlock(&cache->lock);
+        copy = NULL;
+        error = oper_cache_refresh(cache, &args, &copy);
+        pthread_mutex_lock(&cache->lock);
+
+        HASH_FIND_STR(cache->entries, refresh->key, entry);
+        if (!error && entry && seq == cache->invalidation_seq)
+        {
+            oper_cache_update(cache, refresh->key, &args, copy);
+            ++cache->stats.refreshes;
+        }
+        else
+        {
+            if (entry)
+            {
+                entry->refreshing = false;
+            }
+            lyd_free_all(copy);
+        }
+
+    next:
+        free(args.module_name);
+        free(args.path);
+        free(args.request_xpath);
+        free(args.parent_path);
+        memset(&args, 0, sizeof(args));
+        free(refresh->key);
+        free(refresh);
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return NULL;
+}
+
+/**
+ * Rebuild the data of an entry using the refresh session.
+ *
+ * @param cache Operational cache.
+ * @param args Entry arguments.
+ * @param copy Rebuilt data to cache.
+ *
+ * @return Error code - 0 on success.
+ */
+static int oper_cache_refresh(srpc_oper_cache_t *cache, srpc_oper_cache_entry_t *args, struct lyd_node **copy)
+{
+    int error = 0;
+    sr_conn_ctx_t *conn_ctx = NULL;
+    const struct ly_ctx *ly_ctx = NULL;
+    struct lyd_node *root = NULL;
+    struct lyd_node *parent = NULL;
+    struct ly_set *existing = NULL;
+
+    SRPC_SAFE_CALL_PTR(conn_ctx, sr_session_get_connection(cache->refresh_session), error_out);
+    SRPC_SAFE_CALL_PTR(ly_ctx, sr_acquire_context(conn_ctx), error_out);
+
+    // recreate the parent the data was originally built in
+    if (args->parent_path)
+    {
+        SRPC_SAFE_CALL_ERR(error, lyd_new_path(NULL, ly_ctx, args->parent_path, NULL, 0, &root), error_out);
+        SRPC_SAFE_CALL_ERR(error, lyd_find_path(root, args->parent_path, 0, &parent), error_out);
+        SRPC_SAFE_CALL_ERR(error, oper_cache_existing(parent, &existing), error_out);
+    }
+
+    srpc_mem_account_begin(args->path);
+    error = args->cb(cache->refresh_session, args->sub_id, args->module_name, args->path, args->request_xpath, 0,
+                     &parent, args->priv);
+    srpc_mem_account_end(error ? NULL : parent);
+    if (error)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Operational callback for %s failed (%d)", args->path, error);
+        goto error_out;
+    }
+
+    if (oper_cache_capture(parent, existing, copy))
+    {
+        SRPLG_LOG_WRN(SRPC_PLUGIN_NAME, "Unable to cache refreshed operational data for %s", args->path);
+        goto error_out;
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    ly_set_free(existing, NULL);
+    lyd_free_all(root ? root : parent);
+
+    if (ly_ctx)
+    {
+        sr_release_context(conn_ctx);
+    }
+
+    return error;
+}
+
+/**
+ * Add a copy of the cached data to the request parent.
+ *
+ * @param tree Cached data, can be NULL.
+ * @param parent Request parent node.
+ *
+ * @return Error code - 0 on success.
+ */
+static int oper_cache_serve(const struct lyd_node *tree, struct lyd_node **parent)
+{
+    struct lyd_node *root = NULL;
+
+    if (!tree)
+    {
+        return 0;
+    }
+
+    if (!*parent)
+    {
+        return lyd_dup_siblings(tree, NULL, LYD_DUP_RECURSIVE, parent) ? -1 : 0;
+    }
+
+    // cached data includes the parent nodes - merge it into the request tree
+    root = *parent;
+    while (lyd_parent(root))
+    {
+        root = lyd_parent(root);
+    }
+    root = lyd_first_sibling(root);
+
+    return lyd_merge_siblings(&root, tree, 0) ? -1 : 0;
+}
+
+/**
+ * Remember the children a request parent has before the callback is called - list keys or data of other
+ * subscriptions, which must not be cached with the data built by the callback.
+ *
+ * @param parent Parent node passed to the callback.
+ * @param existing Set to which the current children of the parent are stored.
+ *
+ * @return Error code - 0 on success.
+ */
+static int oper_cache_existing(const struct lyd_node *parent, struct ly_set **existing)
+{
+    struct lyd_node *iter = NULL;
+
+    if (ly_set_new(existing))
+    {
+        return -1;
+    }
+
+    LY_LIST_FOR(lyd_child(parent), iter)
+    {
+        if (ly_set_add(*existing, iter, 1, NULL))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Duplicate the data built by a callback.
+ *
+ * @param data Parent node passed to the callback - for top-level requests the first top-level node built.
+ * @param existing Children the parent had before the callback, NULL for top-level requests. Only the other children
+ * are duplicated, together with the parent nodes.
+ * @param copy Copy of the data.
+ *
+ * @return Error code - 0 on success.
+ */
+static int oper_cache_capture(const struct lyd_node *data, const struct ly_set *existing, struct lyd_node **copy)
+{
+    struct lyd_node *dup = NULL;
+    struct lyd_node *iter = NULL;
+
+    *copy = NULL;
+
+    if (!data)
+    {
+        return 0;
+    }
+
+    if (!existing)
+    {
+        return lyd_dup_siblings(data, NULL, LYD_DUP_RECURSIVE, copy) ? -1 : 0;
+    }
+
+    // list keys are always duplicated with the parent
+    if (lyd_dup_single(data, NULL, LYD_DUP_WITH_PARENTS, &dup))
+    {
+        return -1;
+    }
+
+    LY_LIST_FOR(lyd_child(data), iter)
+    {
+        if (!ly_set_contains(existing, iter, NULL) &&
+            lyd_dup_single(iter, (struct lyd_node_inner *)dup, LYD_DUP_RECURSIVE, NULL))
+        {
+            lyd_free_all(dup);
+            return -1;
+        }
+    }
+
+    while (lyd_parent(dup))
+    {
+        dup = lyd_parent(dup);
+    }
+    *copy = dup;
+
+    return 0;
+}
+
+/**
+ * Create or update an entry - called with the cache locked.
+ *
+ * @param cache Operational cache.
+ * @param key Entry key.
+ * @param args Entry arguments to copy for new entries.
+ * @param copy Data to cache - ownership is taken.
+ *
+ */
+static void oper_cache_update(srpc_oper_cache_t *cache, const char *key, srpc_oper_cache_entry_t *args,
+                              struct lyd_node *copy)
+{
+    srpc_oper_cache_entry_t *entry = NULL, *current = NULL, *tmp = NULL;
+    const uint64_t now = oper_cache_now_ms();
+
+    HASH_FIND_STR(cache->entries, key, entry);
+    if (entry)
+    {
+        lyd_free_all(entry->tree);
+        entry->tree = copy;
+        entry->built_ms = now;
+        entry->refreshing = false;
+        return;
+    }
+
+    if (HASH_COUNT(cache->entries) >= SRPC_OPER_CACHE_MAX_ENTRIES)
+    {
+        // drop expired entries first, then the oldest inserted ones
+        HASH_ITER(hh, cache->entries, current, tmp)
+        {
+            if (now - current->built_ms >= (uint64_t)cache->ttl_ms + cache->stale_ms ||
+                HASH_COUNT(cache->entries) >= SRPC_OPER_CACHE_MAX_ENTRIES)
+            {
+                HASH_DEL(cache->entries, current);
+                oper_cache_entry_free(current);
+            }
+        }
+    }
+
+    entry = calloc(1, sizeof(*entry));
+    if (!entry || !(entry->key = strdup(key)) || !(entry->module_name = strdup(args->module_name)) ||
+        !(entry->path = strdup(args->path)) ||
+        (args->request_xpath && !(entry->request_xpath = strdup(args->request_xpath))) ||
+        (args->parent_path && !(entry->parent_path = strdup(args->parent_path))))
+    {
+        // not caching is not an error
+        if (entry)
+        {
+            oper_cache_entry_free(entry);
+        }
+        lyd_free_all(copy);
+        return;
+    }
+
+    entry->tree = copy;
+    entry->built_ms = now;
+    entry->cb = args->cb;
+    entry->priv = args->priv;
+    entry->sub_id = args->sub_id;
+
+    HASH_ADD_KEYPTR(hh, cache->entries, entry->key, strlen(entry->key), entry);
+}
+
+/**
+ * Create a hash key for the module, path and request xpath combination.
+ *
+ * @param module_name Module name.
+ * @param path Subscription path.
+ * @param request_xpath Request xpath, can be NULL.
+ *
+ * @return Allocated key, NULL on error.
+ */
+static char *oper_cache_key(const char *module_name, const char *path, const char *request_xpath)
+{
+    char *key = NULL;
+
+    if (asprintf(&key, "%s\x1f%s\x1f%s", module_name, path, request_xpath ? request_xpath : "") == -1)
+    {
+        return NULL;
+    }
+
+    return key;
+}
+
+/**
+ * Free an entry.
+ *
+ * @param entry Entry to free.
+ *
+ */
+static void oper_cache_entry_free(srpc_oper_cache_entry_t *entry)
+{
+    lyd_free_all(entry->tree);
+    free(entry->key);
+    free(entry->module_name);
+    free(entry->path);
+    free(entry->request_xpath);
+    free(entry->parent_path);
+    free(entry);
+}
+
+/**
+ * Get monotonic time in milliseconds.
+ *
+ * @return Current time.
+ */
+static uint64_t oper_cache_now_ms(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file oper_cache.h
+ * @brief API for caching subtrees built by operational callbacks.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_OPER_CACHE_H
+#define SRPC_OPER_CACHE_H
+
+#include "types.h"
+
+#include <stdint.h>
+
+/**
+ * Create a new operational cache.
+ * Cached subtrees belong to the sysrepo libyang context - invalidate the whole cache if the context changes.
+ *
+ * @param ttl_ms Time for which a built subtree is served without calling the callback again.
+ * @param stale_ms Time after the TTL during which the stale subtree is served while it is refreshed in the background.
+ * Use 0 to disable background refreshing.
+ * @param refresh_session Session passed to the callbacks on background refreshes - can be NULL if stale_ms is 0.
+ *
+ * @return New operational cache, NULL on error.
+ */
+srpc_oper_cache_t *srpc_oper_cache_new(uint32_t ttl_ms, uint32_t stale_ms, sr_session_ctx_t *refresh_session);
+
+/**
+ * Serve the operational data from the cache or call the callback and cache its result.
+ * Call from sr_oper_get_items_cb with the received arguments - entries are keyed by module, path and request xpath.
+ *
+ * @param cache Operational cache.
+ * @param session Sysrepo session of the request.
+ * @param sub_id Subscription ID.
+ * @param module_name Module name.
+ * @param path Subscription path.
+ * @param request_xpath Request XPath, can be NULL.
+ * @param request_id Request ID.
+ * @param parent Parent node for the data - same as for sr_oper_get_items_cb.
+ * @param cb Operational callback which builds the data.
+ * @param priv Private data passed to the callback.
+ *
+ * @return Error code - 0 on success, callback return value if the callback failed.
+ */
+int srpc_oper_cache_get_items(srpc_oper_cache_t *cache, sr_session_ctx_t *session, uint32_t sub_id,
+                              const char *module_name, const char *path, const char *request_xpath,
+                              uint32_t request_id, struct lyd_node **parent, sr_oper_get_items_cb cb, void *priv);
+
+/**
+ * Invalidate cache entries - use from change callbacks which change the cached data.
+ *
+ * @param cache Operational cache.
+ * @param module_name Module of the entries to invalidate, NULL for all entries.
+ * @param path Path of the entries to invalidate, NULL for all entries of the module.
+ *
+ */
+void srpc_oper_cache_invalidate(srpc_oper_cache_t *cache, const char *module_name, const char *path);
+
+/**
+ * Get cache counters.
+ *
+ * @param cache Operational cache.
+ * @param stats Counters to set.
+ *
+ */
+void srpc_oper_cache_get_stats(srpc_oper_cache_t *cache, srpc_oper_cache_stats_t *stats);
+
+/**
+ * Stop background refreshing and free all cache data.
+ *
+ * @param cache Operational cache.
+ *
+ */
+void srpc_oper_cache_free(srpc_oper_cache_t **cache);
+
+#endif // SRPC_OPER_CACHE_H
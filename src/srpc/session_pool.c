@@ -0,0 +1,407 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "session_pool.h"
+#include "common.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <sysrepo.h>
+
+/**
+ * Session started by the pool.
+ */
+typedef struct
+{
+    sr_session_ctx_t *session; ///< Session, NULL for a free slot.
+    bool in_use;               ///< Session is checked out.
+} session_pool_slot_t;
+
+/**
+ * Session pool - started sessions and the counters.
+ */
+struct srpc_session_pool_s
+{
+    sr_conn_ctx_t *connection;       ///< Connection of the sessions.
+    sr_datastore_t datastore;        ///< Datastore of the sessions.
+    size_t max_sessions;             ///< Maximal number of sessions.
+    size_t sessions_count;           ///< Started sessions, including the ones being started.
+    session_pool_slot_t *slots;      ///< Started sessions - max_sessions slots.
+    size_t *idle;                    ///< Slots of idle sessions - a stack, so recently used sessions are reused first.
+    size_t idle_count;               ///< Number of idle sessions.
+    srpc_session_pool_stats_t stats; ///< Counters.
+    pthread_mutex_t lock;            ///< Lock for the sessions and the counters.
+    pthread_cond_t cond;             ///< Signaled on returned sessions.
+};
+
+static int session_pool_reset(srpc_session_pool_t *pool, sr_session_ctx_t *session);
+static session_pool_slot_t *session_pool_find(srpc_session_pool_t *pool, const sr_session_ctx_t *session);
+static uint64_t session_pool_now_us(void);
+
+/**
+ * Create a new session pool. A session must not be used by more threads at once - worker threads check a session out,
+ * use it exclusively (for example with srpc_check_empty_datastore() or srpc_feature_status_hash_load()) and return
+ * it. Sessions are started on demand up to the maximal size and reused afterwards. Changes can't be iterated on a
+ * pooled session - sr_get_changes_iter() only works on the session passed to the module change callback, so
+ * srpc_iterate_changes() has to be called with the callback session.
+ *
+ * @param connection Connection to start the sessions on - has to stay valid until the pool is freed.
+ * @param datastore Datastore of the sessions.
+ * @param max_sessions Maximal number of sessions - checkouts wait for a returned session once all are in use.
+ *
+ * @return New session pool, NULL on error.
+ */
+srpc_session_pool_t *srpc_session_pool_new(sr_conn_ctx_t *connection, sr_datastore_t datastore, size_t max_sessions)
+{
+    srpc_session_pool_t *pool = NULL;
+    pthread_condattr_t cond_attr;
+    bool lock_init = false, cond_init = false;
+
+    if (!max_sessions)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Session pool needs at least one session");
+        return NULL;
+    }
+
+    SRPC_SAFE_CALL_PTR(pool, calloc(1, sizeof(*pool)), error_out);
+    SRPC_SAFE_CALL_PTR(pool->slots, calloc(max_sessions, sizeof(session_pool_slot_t)), error_out);
+    SRPC_SAFE_CALL_PTR(pool->idle, calloc(max_sessions, sizeof(size_t)), error_out);
+
+    pool->connection = connection;
+    pool->datastore = datastore;
+    pool->max_sessions = max_sessions;
+
+    lock_init = pthread_mutex_init(&pool->lock, NULL) == 0;
+
+    // use monotonic clock for the checkout timeouts
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    cond_init = pthread_cond_init(&pool->cond, &cond_attr) == 0;
+    pthread_condattr_destroy(&cond_attr);
+
+    if (!lock_init || !cond_init)
+    {
+        goto error_out;
+    }
+
+    return pool;
+
+error_out:
+    if (pool)
+    {
+        if (cond_init)
+        {
+            pthread_cond_destroy(&pool->cond);
+        }
+        if (lock_init)
+        {
+            pthread_mutex_destroy(&pool->lock);
+        }
+        free(pool->slots);
+        free(pool->idle);
+        free(pool);
+    }
+
+    return NULL;
+}
+
+/**
+ * Check a session out of the pool.
+ *
+ * @param pool Session pool.
+ * @param timeout_ms Maximal time to wait for a returned session - 0 to wait without a limit.
+ * @param session Checked out session output.
+ *
+ * @return Error code - 0 on success, -1 if no session could be started or the timeout expired.
+ */
+int srpc_session_pool_checkout(srpc_session_pool_t *pool, uint32_t timeout_ms, sr_session_ctx_t **session)
+{
+    int error = 0;
+    sr_session_ctx_t *taken = NULL;
+    session_pool_slot_t *slot = NULL;
+    bool start = false;
+    bool contended = false;
+    uint64_t begin_us = 0, waited_us = 0;
+    uint64_t deadline_us = 0;
+    struct timespec ts = {0};
+
+    *session = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    for (;;)
+    {
+        if (pool->idle_count)
+        {
+            slot = &pool->slots[pool->idle[--pool->idle_count]];
+            slot->in_use = true;
+            taken = slot->session;
+            break;
+        }
+
+        if (pool->sessions_count < pool->max_sessions)
+        {
+            // reserve the session, it is started without holding the lock
+            pool->sessions_count++;
+            start = true;
+            break;
+        }
+
+        if (!contended)
+        {
+            contended = true;
+            begin_us = session_pool_now_us();
+            deadline_us = begin_us + (uint64_t)timeout_ms * 1000;
+            ts.tv_sec = (time_t)(deadline_us / 1000000);
+            ts.tv_nsec = (long)(deadline_us % 1000000) * 1000L;
+            pool->stats.contended++;
+        }
+
+        if (!timeout_ms)
+        {
+            pthread_cond_wait(&pool->cond, &pool->lock);
+        }
+        else if (pthread_cond_timedwait(&pool->cond, &pool->lock, &ts) == ETIMEDOUT && !pool->idle_count &&
+                 pool->sessions_count >= pool->max_sessions)
+        {
+            pool->stats.timeouts++;
+            pthread_mutex_unlock(&pool->lock);
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "No session returned to the pool within %" PRIu32 " ms", timeout_ms);
+            return -1;
+        }
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    if (start)
+    {
+        error = sr_session_start(pool->connection, pool->datastore, &taken);
+        if (error != SR_ERR_OK)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "sr_session_start() error (%d): %s", error, sr_strerror(error));
+
+            // give the reservation to a waiting checkout
+            pthread_mutex_lock(&pool->lock);
+            pool->sessions_count--;
+            pthread_cond_signal(&pool->cond);
+            pthread_mutex_unlock(&pool->lock);
+
+            return -1;
+        }
+    }
+
+    if (contended)
+    {
+        waited_us = session_pool_now_us() - begin_us;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (start)
+    {
+        // a free slot exists for every reserved session
+        slot = session_pool_find(pool, NULL);
+        slot->session = taken;
+        slot->in_use = true;
+        pool->stats.created++;
+    }
+    pool->stats.checkouts++;
+    pool->stats.wait_us += waited_us;
+    if (waited_us > pool->stats.max_wait_us)
+    {
+        pool->stats.max_wait_us = waited_us;
+    }
+    pool->stats.in_use++;
+    if (pool->stats.in_use > pool->stats.max_in_use)
+    {
+        pool->stats.max_in_use = pool->stats.in_use;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    *session = taken;
+
+    return 0;
+}
+
+/**
+ * Return a checked out session to the pool. Changes which weren't applied are discarded and the session is switched
+ * back to the datastore of the pool. Sessions which weren't checked out of the pool - unknown or already returned
+ * sessions - are rejected and left untouched.
+ *
+ * @param pool Session pool.
+ * @param session Session returned by srpc_session_pool_checkout().
+ *
+ */
+void srpc_session_pool_return(srpc_session_pool_t *pool, sr_session_ctx_t *session)
+{
+    session_pool_slot_t *slot = NULL;
+    bool reusable = false;
+
+    pthread_mutex_lock(&pool->lock);
+
+    slot = session ? session_pool_find(pool, session) : NULL;
+    if (!slot || !slot->in_use)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Session returned to the pool isn't checked out of it - ignoring the return");
+        return;
+    }
+
+    // the session is neither idle nor checked out until it is reset, so another return of it is rejected as well
+    slot->in_use = false;
+    pool->stats.in_use--;
+
+    pthread_mutex_unlock(&pool->lock);
+
+    reusable = session_pool_reset(pool, session) == 0;
+    if (!reusable)
+    {
+        // drop the session - a new one is started on demand
+        sr_session_stop(session);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (reusable)
+    {
+        pool->idle[pool->idle_count++] = (size_t)(slot - pool->slots);
+    }
+    else
+    {
+        slot->session = NULL;
+        pool->sessions_count--;
+    }
+
+    pthread_cond_signal(&pool->cond);
+
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Get the pool counters.
+ *
+ * @param pool Session pool.
+ * @param stats Counters output.
+ *
+ */
+void srpc_session_pool_get_stats(srpc_session_pool_t *pool, srpc_session_pool_stats_t *stats)
+{
+    pthread_mutex_lock(&pool->lock);
+    *stats = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Stop all sessions and free the pool - all sessions have to be returned beforehand.
+ *
+ * @param pool Session pool.
+ *
+ */
+void srpc_session_pool_free(srpc_session_pool_t **pool)
+{
+    srpc_session_pool_t *p = *pool;
+
+    if (!p)
+    {
+        return;
+    }
+
+    if (p->stats.in_use)
+    {
+        // checked out sessions are stopped by sr_disconnect()
+        SRPLG_LOG_WRN(SRPC_PLUGIN_NAME, "Freeing session pool with %zu sessions still checked out", p->stats.in_use);
+    }
+
+    for (size_t i = 0; i < p->idle_count; i++)
+    {
+        sr_session_stop(p->slots[p->idle[i]].session);
+    }
+
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    free(p->slots);
+    free(p->idle);
+    free(p);
+
+    *pool = NULL;
+}
+
+/**
+ * Bring a returned session back to the state of a new session of the pool.
+ *
+ * @param pool Session pool.
+ * @param session Returned session.
+ *
+ * @return Error code - 0 on success.
+ */
+static int session_pool_reset(srpc_session_pool_t *pool, sr_session_ctx_t *session)
+{
+    int error = 0;
+
+    SRPC_SAFE_CALL_ERR(error, sr_discard_changes(session), error_out);
+
+    if (sr_session_get_ds(session) != pool->datastore)
+    {
+        SRPC_SAFE_CALL_ERR(error, sr_session_switch_ds(session, pool->datastore), error_out);
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Find the slot of a session - called with the pool locked.
+ *
+ * @param pool Session pool.
+ * @param session Session to search for, NULL for a free slot.
+ *
+ * @return Slot of the session, NULL if not found.
+ */
+static session_pool_slot_t *session_pool_find(srpc_session_pool_t *pool, const sr_session_ctx_t *session)
+{
+    for (size_t i = 0; i < pool->max_sessions; i++)
+    {
+        if (pool->slots[i].session == session)
+        {
+            return &pool->slots[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in microseconds.
+ */
+static uint64_t session_pool_now_us(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file session_pool.h
+ * @brief API for lending sysrepo sessions to worker threads.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_SESSION_POOL_H
+#define SRPC_SESSION_POOL_H
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Create a new session pool. A session must not be used by more threads at once - worker threads check a session out,
+ * use it exclusively (for example with srpc_check_empty_datastore() or srpc_feature_status_hash_load()) and return
+ * it. Sessions are started on demand up to the maximal size and reused afterwards. Changes can't be iterated on a
+ * pooled session - sr_get_changes_iter() only works on the session passed to the module change callback, so
+ * srpc_iterate_changes() has to be called with the callback session.
+ *
+ * @param connection Connection to start the sessions on - has to stay valid until the pool is freed.
+ * @param datastore Datastore of the sessions.
+ * @param max_sessions Maximal number of sessions - checkouts wait for a returned session once all are in use.
+ *
+ * @return New session pool, NULL on error.
+ */
+srpc_session_pool_t *srpc_session_pool_new(sr_conn_ctx_t *connection, sr_datastore_t datastore, size_t max_sessions);
+
+/**
+ * Check a session out of the pool.
+ *
+ * @param pool Session pool.
+ * @param timeout_ms Maximal time to wait for a returned session - 0 to wait without a limit.
+ * @param session Checked out session output.
+ *
+ * @return Error code - 0 on success, -1 if no session could be started or the timeout expired.
+ */
+int srpc_session_pool_checkout(srpc_session_pool_t *pool, uint32_t timeout_ms, sr_session_ctx_t **session);
+
+/**
+ * Return a checked out session to the pool. Changes which weren't applied are discarded and the session is switched
+ * back to the datastore of the pool. Sessions which weren't checked out of the pool - unknown or already returned
+ * sessions - are rejected and left untouched.
+ *
+ * @param pool Session pool.
+ * @param session Session returned by srpc_session_pool_checkout().
+ *
+ */
+void srpc_session_pool_return(srpc_session_pool_t *pool, sr_session_ctx_t *session);
+
+/**
+ * Get the pool counters.
+ *
+ * @param pool Session pool.
+ * @param stats Counters output.
+ *
+ */
+void srpc_session_pool_get_stats(srpc_session_pool_t *pool, srpc_session_pool_stats_t *stats);
+
+/**
+ * Stop all sessions and free the pool - all sessions have to be returned beforehand.
+ *
+ * @param pool Session pool.
+ *
+ */
+void srpc_session_pool_free(srpc_session_pool_t **pool);
+
+#endif // SRPC_SESSION_POOL_H
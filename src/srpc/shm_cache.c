@@ -0,0 +1,827 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "shm_cache.h"
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sysrepo.h>
+
+// Marks an initialized segment - "SRPC".
+#define SHM_CACHE_MAGIC 0x53525043u
+
+// Layout version of the segment - incremented on incompatible changes of the structures below.
+#define SHM_CACHE_LAYOUT 2
+
+// Alignment of the header and the slots - a cache line, so slots don't share lines.
+#define SHM_CACHE_ALIGN 64
+
+// Number of attempts of a reader to get a consistent copy before reporting a miss.
+#define SHM_CACHE_READ_RETRIES 1000
+
+// Time to wait for another process to finish initializing a new segment.
+#define SHM_CACHE_ATTACH_WAIT_MS 1000
+
+// Time to wait for a running process to finish writing a slot.
+#define SHM_CACHE_WRITE_WAIT_MS 1000
+
+typedef struct shm_cache_header_s shm_cache_header_t;
+typedef struct shm_cache_slot_s shm_cache_slot_t;
+
+/**
+ * Segment header - at the start of the shared memory object.
+ */
+struct shm_cache_header_s
+{
+    _Atomic uint32_t magic; ///< SHM_CACHE_MAGIC once the segment is initialized.
+    uint32_t layout;        ///< Layout version.
+    uint64_t slots_count;   ///< Number of slots.
+    uint64_t slot_size;     ///< Maximal blob size.
+    pthread_mutex_t lock;   ///< Process shared, robust lock for registering and releasing keys.
+};
+
+/**
+ * Slot holding one blob - followed by the blob data.
+ */
+struct shm_cache_slot_s
+{
+    _Atomic uint64_t sequence;         ///< Seqlock sequence - odd while the slot is being written.
+    _Atomic int32_t owner;             ///< Process ID of the producer, 0 for a free slot.
+    _Atomic int32_t writer;            ///< Process ID of the process writing the slot, 0 if none.
+    uint32_t max_age_ms;               ///< Maximal age of the blob, 0 for no limit.
+    uint64_t version;                  ///< Incremented on each publish.
+    uint64_t published_ms;             ///< Monotonic time of the last publish.
+    uint64_t size;                     ///< Blob size.
+    bool valid;                        ///< Blob is published and not invalidated.
+    char key[SRPC_SHM_CACHE_KEY_SIZE]; ///< Key of the blob.
+    unsigned char data[];              ///< Blob data.
+};
+
+/**
+ * Shared memory cache handle - local to the process.
+ */
+struct srpc_shm_cache_s
+{
+    void *base;                 ///< Mapping of the segment.
+    size_t size;                ///< Size of the mapping.
+    shm_cache_header_t *header; ///< Segment header.
+    size_t slots_count;         ///< Number of slots.
+    size_t slot_size;           ///< Maximal blob size.
+    size_t slot_stride;         ///< Distance of two slots in the segment.
+    bool *owned;                ///< Slots registered using this handle.
+};
+
+static size_t shm_cache_align(size_t size);
+static size_t shm_cache_header_size(void);
+static shm_cache_slot_t *shm_cache_slot(srpc_shm_cache_t *cache, size_t index);
+static int shm_cache_init(srpc_shm_cache_t *cache, int fd);
+static int shm_cache_attach(srpc_shm_cache_t *cache, int fd);
+static int shm_cache_lock(srpc_shm_cache_t *cache);
+static void shm_cache_unlock(srpc_shm_cache_t *cache);
+static shm_cache_slot_t *shm_cache_find(srpc_shm_cache_t *cache, const char *key, size_t *index);
+static int shm_cache_write_begin(shm_cache_slot_t *slot);
+static void shm_cache_write_end(shm_cache_slot_t *slot);
+static int shm_cache_copy(srpc_shm_cache_t *cache, const char *key, void *buffer, size_t buffer_size, size_t *size,
+                          uint64_t *version);
+static bool shm_cache_process_alive(pid_t pid);
+static uint64_t shm_cache_now_ms(void);
+
+/**
+ * Create or attach to a shared memory cache. The segment holds a fixed number of slots, each holding one versioned
+ * blob - for example a parsed netlink dump or /proc file - published by a single producer process and read by any
+ * number of consumers. Readers use a seqlock - they never block the producer and retry if a blob changes while being
+ * copied. All processes using the same segment have to pass the same slot count and size.
+ *
+ * @param name Name of the POSIX shared memory object - for example "/srpc-system-state".
+ * @param slots_count Number of slots.
+ * @param slot_size Maximal size of a single blob.
+ *
+ * @return New cache handle, NULL on error.
+ */
+srpc_shm_cache_t *srpc_shm_cache_new(const char *name, size_t slots_count, size_t slot_size)
+{
+    srpc_shm_cache_t *cache = NULL;
+    bool created = false;
+    int fd = -1;
+    int error = 0;
+
+    SRPC_SAFE_CALL_PTR(cache, calloc(1, sizeof(*cache)), error_out);
+    SRPC_SAFE_CALL_PTR(cache->owned, calloc(slots_count ? slots_count : 1, sizeof(bool)), error_out);
+
+    cache->base = MAP_FAILED;
+    cache->slots_count = slots_count;
+    cache->slot_size = slot_size;
+    cache->slot_stride = shm_cache_align(sizeof(shm_cache_slot_t) + slot_size);
+    cache->size = shm_cache_header_size() + slots_count * cache->slot_stride;
+
+    // the process which creates the object initializes it, the others wait for the initialization
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd != -1)
+    {
+        created = true;
+    }
+    else if (errno == EEXIST)
+    {
+        fd = shm_open(name, O_RDWR, 0);
+    }
+
+    if (fd == -1)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "shm_open() failed for %s: %s", name, strerror(errno));
+        goto error_out;
+    }
+
+    if (created)
+    {
+        SRPC_SAFE_CALL_ERR(error, ftruncate(fd, (off_t)cache->size), error_out);
+        SRPC_SAFE_CALL_ERR(error, shm_cache_init(cache, fd), error_out);
+    }
+    else if (shm_cache_attach(cache, fd))
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to attach to shared memory cache %s", name);
+        goto error_out;
+    }
+
+    close(fd);
+
+    return cache;
+
+error_out:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+    if (created)
+    {
+        shm_unlink(name);
+    }
+    srpc_shm_cache_free(&cache);
+    return NULL;
+}
+
+/**
+ * Register the calling process as the producer of a key. Only the registered producer can publish the key - a key
+ * registered by another running process can't be taken over, a key of a process which exited can.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param max_age_ms Age after which published blobs are considered invalid by readers - 0 for no limit, so the blob
+ * is valid until the producer invalidates it.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_shm_cache_register(srpc_shm_cache_t *cache, const char *key, uint32_t max_age_ms)
+{
+    int error = 0;
+    shm_cache_slot_t *slot = NULL;
+    size_t index = 0;
+    pid_t owner = 0;
+    bool locked = false;
+
+    if (strlen(key) >= SRPC_SHM_CACHE_KEY_SIZE)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache key %s too long", key);
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, shm_cache_lock(cache), error_out);
+    locked = true;
+
+    slot = shm_cache_find(cache, key, &index);
+    if (slot)
+    {
+        owner = atomic_load(&slot->owner);
+        if (owner != getpid() && shm_cache_process_alive(owner))
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache key %s already registered by process %d", key, owner);
+            goto error_out;
+        }
+    }
+    else
+    {
+        for (index = 0; index < cache->slots_count; index++)
+        {
+            if (!atomic_load(&shm_cache_slot(cache, index)->owner))
+            {
+                slot = shm_cache_slot(cache, index);
+                break;
+            }
+        }
+
+        if (!slot)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "No free shared memory cache slot for key %s", key);
+            goto error_out;
+        }
+    }
+
+    SRPC_SAFE_CALL_ERR(error, shm_cache_write_begin(slot), error_out);
+    if (owner != getpid())
+    {
+        // new or taken over key - the blob of the previous producer is not valid anymore
+        strcpy(slot->key, key);
+        slot->valid = false;
+        slot->size = 0;
+    }
+    slot->max_age_ms = max_age_ms;
+    atomic_store(&slot->owner, getpid());
+    shm_cache_write_end(slot);
+
+    cache->owned[index] = true;
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    if (locked)
+    {
+        shm_cache_unlock(cache);
+    }
+
+    return error;
+}
+
+/**
+ * Publish a new version of a blob. The key has to be registered using the same handle.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param data Blob data - should not contain pointers, the readers are other processes.
+ * @param size Blob size, at most the slot size of the cache.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_shm_cache_publish(srpc_shm_cache_t *cache, const char *key, const void *data, size_t size)
+{
+    shm_cache_slot_t *slot = NULL;
+    size_t index = 0;
+
+    slot = shm_cache_find(cache, key, &index);
+    if (!slot || !cache->owned[index])
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache key %s not registered by this producer", key);
+        return -1;
+    }
+
+    if (size > cache->slot_size)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Blob of %zu bytes for key %s exceeds the slot size of %zu bytes", size, key,
+                      cache->slot_size);
+        return -1;
+    }
+
+    if (shm_cache_write_begin(slot))
+    {
+        return -1;
+    }
+    memcpy(slot->data, data, size);
+    slot->size = size;
+    slot->version++;
+    slot->published_ms = shm_cache_now_ms();
+    slot->valid = true;
+    shm_cache_write_end(slot);
+
+    return 0;
+}
+
+/**
+ * Invalidate the published blob of a key - readers miss until the producer publishes again. Can be called by any
+ * process using the cache, for example when it receives an event which changes the cached state.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ *
+ * @return Error code - 0 on success, also if the key isn't registered, -1 if another running process keeps writing
+ * the slot.
+ */
+int srpc_shm_cache_invalidate(srpc_shm_cache_t *cache, const char *key)
+{
+    shm_cache_slot_t *slot = shm_cache_find(cache, key, NULL);
+
+    if (slot)
+    {
+        if (shm_cache_write_begin(slot))
+        {
+            return -1;
+        }
+        // the slot could have been released and registered for another key meanwhile
+        if (!strncmp(slot->key, key, sizeof(slot->key)))
+        {
+            slot->valid = false;
+        }
+        shm_cache_write_end(slot);
+    }
+
+    return 0;
+}
+
+/**
+ * Copy the current blob of a key.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param buffer Buffer for the blob.
+ * @param buffer_size Size of the buffer.
+ * @param size Size of the blob output - also set if the buffer is too small.
+ * @param version Version of the blob output, incremented on each publish, can be NULL.
+ *
+ * @return 0 if the blob was copied, 1 if there is no valid blob for the key - not registered, not published,
+ * invalidated, older than its maximal age or being published for too long - and -1 if the buffer is too small.
+ */
+int srpc_shm_cache_read(srpc_shm_cache_t *cache, const char *key, void *buffer, size_t buffer_size, size_t *size,
+                        uint64_t *version)
+{
+    return shm_cache_copy(cache, key, buffer, buffer_size, size, version);
+}
+
+/**
+ * Get the version of the current blob of a key without copying it - consumers can skip re-parsing an unchanged blob.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param version Version of the blob output.
+ *
+ * @return 0 on success, 1 if there is no valid blob for the key.
+ */
+int srpc_shm_cache_get_version(srpc_shm_cache_t *cache, const char *key, uint64_t *version)
+{
+    size_t size = 0;
+
+    // a NULL buffer only validates the slot, so a non-zero size isn't an error here
+    return shm_cache_copy(cache, key, NULL, 0, &size, version) == 1 ? 1 : 0;
+}
+
+/**
+ * Free the cache handle. Keys registered using the handle are invalidated and released, the segment itself stays
+ * for the other processes.
+ *
+ * @param cache Cache handle.
+ *
+ */
+void srpc_shm_cache_free(srpc_shm_cache_t **cache)
+{
+    srpc_shm_cache_t *ptr = *cache;
+    shm_cache_slot_t *slot = NULL;
+    bool locked = false;
+
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (ptr->base != MAP_FAILED && ptr->header)
+    {
+        locked = !shm_cache_lock(ptr);
+
+        for (size_t i = 0; i < ptr->slots_count; i++)
+        {
+            slot = shm_cache_slot(ptr, i);
+            if (ptr->owned[i] && atomic_load(&slot->owner) == getpid() && !shm_cache_write_begin(slot))
+            {
+                slot->valid = false;
+                slot->key[0] = 0;
+                atomic_store(&slot->owner, 0);
+                shm_cache_write_end(slot);
+            }
+        }
+
+        if (locked)
+        {
+            shm_cache_unlock(ptr);
+        }
+    }
+
+    if (ptr->base != MAP_FAILED)
+    {
+        munmap(ptr->base, ptr->size);
+    }
+
+    free(ptr->owned);
+    free(ptr);
+
+    *cache = NULL;
+}
+
+/**
+ * Remove the shared memory segment - processes which are attached keep using it, new handles create a new segment.
+ *
+ * @param name Name of the POSIX shared memory object.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_shm_cache_unlink(const char *name)
+{
+    if (shm_unlink(name) && errno != ENOENT)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "shm_unlink() failed for %s: %s", name, strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Round a size up to the slot alignment.
+ *
+ * @param size Size to round.
+ *
+ * @return Aligned size.
+ */
+static size_t shm_cache_align(size_t size)
+{
+    return (size + SHM_CACHE_ALIGN - 1) & ~((size_t)SHM_CACHE_ALIGN - 1);
+}
+
+/**
+ * Get the size of the segment header including its padding.
+ *
+ * @return Header size.
+ */
+static size_t shm_cache_header_size(void)
+{
+    return shm_cache_align(sizeof(shm_cache_header_t));
+}
+
+/**
+ * Get a slot of the segment.
+ *
+ * @param cache Cache handle.
+ * @param index Slot index.
+ *
+ * @return Slot.
+ */
+static shm_cache_slot_t *shm_cache_slot(srpc_shm_cache_t *cache, size_t index)
+{
+    return (shm_cache_slot_t *)(void *)((unsigned char *)cache->base + shm_cache_header_size() +
+                                        index * cache->slot_stride);
+}
+
+/**
+ * Map and initialize a newly created segment.
+ *
+ * @param cache Cache handle.
+ * @param fd Descriptor of the shared memory object.
+ *
+ * @return Error code - 0 on success.
+ */
+static int shm_cache_init(srpc_shm_cache_t *cache, int fd)
+{
+    pthread_mutexattr_t attr;
+    int error = 0;
+
+    cache->base = mmap(NULL, cache->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cache->base == MAP_FAILED)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "mmap() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    // the object is zero filled - only the header needs to be set up
+    cache->header = cache->base;
+    cache->header->layout = SHM_CACHE_LAYOUT;
+    cache->header->slots_count = cache->slots_count;
+    cache->header->slot_size = cache->slot_size;
+
+    // robust, so a producer which exits while holding the lock doesn't block the others
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    error = pthread_mutex_init(&cache->header->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    if (error)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to initialize the shared memory cache lock: %s", strerror(error));
+        return -1;
+    }
+
+    atomic_store_explicit(&cache->header->magic, SHM_CACHE_MAGIC, memory_order_release);
+
+    return 0;
+}
+
+/**
+ * Map a segment created by another process, waiting for its initialization.
+ *
+ * @param cache Cache handle.
+ * @param fd Descriptor of the shared memory object.
+ *
+ * @return Error code - 0 on success.
+ */
+static int shm_cache_attach(srpc_shm_cache_t *cache, int fd)
+{
+    const struct timespec delay = {.tv_sec = 0, .tv_nsec = 1000000};
+    const uint64_t deadline = shm_cache_now_ms() + SHM_CACHE_ATTACH_WAIT_MS;
+    struct stat st = {0};
+
+    // the creator resizes the object right after creating it
+    while (!fstat(fd, &st) && !st.st_size && shm_cache_now_ms() < deadline)
+    {
+        nanosleep(&delay, NULL);
+    }
+
+    if ((size_t)st.st_size != cache->size)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache size %jd doesn't match the expected size %zu",
+                      (intmax_t)st.st_size, cache->size);
+        return -1;
+    }
+
+    cache->base = mmap(NULL, cache->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (cache->base == MAP_FAILED)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "mmap() failed: %s", strerror(errno));
+        return -1;
+    }
+
+    while (atomic_load_explicit(&((shm_cache_header_t *)cache->base)->magic, memory_order_acquire) != SHM_CACHE_MAGIC)
+    {
+        if (shm_cache_now_ms() >= deadline)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache not initialized by its creator");
+            return -1;
+        }
+        nanosleep(&delay, NULL);
+    }
+
+    cache->header = cache->base;
+
+    if (cache->header->layout != SHM_CACHE_LAYOUT || cache->header->slots_count != cache->slots_count ||
+        cache->header->slot_size != cache->slot_size)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache layout doesn't match");
+        cache->header = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Lock the segment for registering or releasing keys.
+ *
+ * @param cache Cache handle.
+ *
+ * @return Error code - 0 on success.
+ */
+static int shm_cache_lock(srpc_shm_cache_t *cache)
+{
+    int error = pthread_mutex_lock(&cache->header->lock);
+
+    if (error == EOWNERDEAD)
+    {
+        // the previous holder exited - the slots are consistent as the seqlock covers every slot change
+        error = pthread_mutex_consistent(&cache->header->lock);
+    }
+
+    if (error)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to lock the shared memory cache: %s", strerror(error));
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Unlock the segment.
+ *
+ * @param cache Cache handle.
+ *
+ */
+static void shm_cache_unlock(srpc_shm_cache_t *cache)
+{
+    pthread_mutex_unlock(&cache->header->lock);
+}
+
+/**
+ * Find the slot of a registered key.
+ *
+ * @param cache Cache handle.
+ * @param key Key to find.
+ * @param index Index of the found slot output, can be NULL.
+ *
+ * @return Slot, NULL if the key isn't registered.
+ */
+static shm_cache_slot_t *shm_cache_find(srpc_shm_cache_t *cache, const char *key, size_t *index)
+{
+    shm_cache_slot_t *slot = NULL;
+
+    for (size_t i = 0; i < cache->slots_count; i++)
+    {
+        slot = shm_cache_slot(cache, i);
+
+        // unlocked comparison - readers confirm the key within the seqlock read
+        if (atomic_load(&slot->owner) && !strncmp(slot->key, key, sizeof(slot->key)))
+        {
+            if (index)
+            {
+                *index = i;
+            }
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Begin writing a slot - takes the slot write lock and makes the sequence odd. Concurrent writers of the same slot
+ * wait for each other, readers never block the writer. The lock holds the process ID of the writer, so the lock of a
+ * process which exited while writing is taken over and its unfinished write completed by the next writer - the
+ * sequence is only changed by the lock holder, so it can't be left odd by a takeover race.
+ *
+ * @param slot Slot to write.
+ *
+ * @return Error code - 0 on success, -1 if another running process didn't finish its write in time.
+ */
+static int shm_cache_write_begin(shm_cache_slot_t *slot)
+{
+    const uint64_t deadline = shm_cache_now_ms() + SHM_CACHE_WRITE_WAIT_MS;
+    int32_t writer = 0;
+
+    for (;;)
+    {
+        writer = 0;
+        if (atomic_compare_exchange_weak_explicit(&slot->writer, &writer, getpid(), memory_order_acquire,
+                                                  memory_order_relaxed))
+        {
+            break;
+        }
+
+        if (writer && writer != getpid() && !shm_cache_process_alive(writer) &&
+            atomic_compare_exchange_strong_explicit(&slot->writer, &writer, getpid(), memory_order_acquire,
+                                                    memory_order_relaxed))
+        {
+            SRPLG_LOG_WRN(SRPC_PLUGIN_NAME, "Process %d exited while writing a shared memory cache slot", writer);
+            break;
+        }
+
+        if (shm_cache_now_ms() >= deadline)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Shared memory cache slot written by process %d for too long", writer);
+            return -1;
+        }
+
+        sched_yield();
+    }
+
+    // a taken over lock may come with the sequence already odd
+    if (!(atomic_load_explicit(&slot->sequence, memory_order_relaxed) & 1))
+    {
+        atomic_fetch_add_explicit(&slot->sequence, 1, memory_order_relaxed);
+    }
+
+    // the odd sequence has to be visible before any of the slot data changes
+    atomic_thread_fence(memory_order_release);
+
+    return 0;
+}
+
+/**
+ * Finish writing a slot - makes the sequence even again and releases the slot write lock.
+ *
+ * @param slot Slot written.
+ *
+ */
+static void shm_cache_write_end(shm_cache_slot_t *slot)
+{
+    atomic_fetch_add_explicit(&slot->sequence, 1, memory_order_release);
+    atomic_store_explicit(&slot->writer, 0, memory_order_release);
+}
+
+/**
+ * Get a consistent copy of a slot using the seqlock.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param buffer Buffer for the blob, NULL to only check the slot.
+ * @param buffer_size Size of the buffer.
+ * @param size Size of the blob output.
+ * @param version Version of the blob output, can be NULL.
+ *
+ * @return 0 if the blob was copied, 1 if there is no valid blob for the key and -1 if the buffer is too small.
+ */
+static int shm_cache_copy(srpc_shm_cache_t *cache, const char *key, void *buffer, size_t buffer_size, size_t *size,
+                          uint64_t *version)
+{
+    shm_cache_slot_t *slot = shm_cache_find(cache, key, NULL);
+    char slot_key[SRPC_SHM_CACHE_KEY_SIZE] = {0};
+    uint64_t begin = 0, end = 0;
+    uint64_t slot_version = 0, published_ms = 0, slot_size = 0;
+    uint32_t max_age_ms = 0;
+    bool valid = false;
+    bool consistent = false;
+
+    if (!slot)
+    {
+        return 1;
+    }
+
+    for (int i = 0; i < SHM_CACHE_READ_RETRIES && !consistent; i++)
+    {
+        begin = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (begin & 1)
+        {
+            sched_yield();
+            continue;
+        }
+
+        memcpy(slot_key, slot->key, sizeof(slot_key));
+        valid = slot->valid;
+        slot_size = slot->size;
+        slot_version = slot->version;
+        published_ms = slot->published_ms;
+        max_age_ms = slot->max_age_ms;
+
+        // a torn size is caught by the sequence check below, it only must not overflow the buffer
+        if (buffer && valid && slot_size <= buffer_size && slot_size <= cache->slot_size)
+        {
+            memcpy(buffer, slot->data, slot_size);
+        }
+
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+
+        consistent = begin == end;
+    }
+
+    if (!consistent || !valid || strncmp(slot_key, key, sizeof(slot_key)))
+    {
+        return 1;
+    }
+
+    if (max_age_ms && shm_cache_now_ms() - published_ms > max_age_ms)
+    {
+        return 1;
+    }
+
+    *size = slot_size;
+    if (version)
+    {
+        *version = slot_version;
+    }
+
+    if (buffer && slot_size > buffer_size)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Blob of key %s has %zu bytes, buffer only %zu bytes", key, (size_t)slot_size,
+                      buffer_size);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Check whether a process is still running.
+ *
+ * @param pid Process ID.
+ *
+ * @return True if the process exists.
+ */
+static bool shm_cache_process_alive(pid_t pid)
+{
+    return pid > 0 && (!kill(pid, 0) || errno == EPERM);
+}
+
+/**
+ * Get the monotonic time in milliseconds - the clock is shared by all processes.
+ *
+ * @return Current time.
+ */
+static uint64_t shm_cache_now_ms(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file shm_cache.h
+ * @brief API for sharing collected system state between plugin processes.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_SHM_CACHE_H
+#define SRPC_SHM_CACHE_H
+
+#include "types.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Maximal length of a shared memory cache key, including the terminating zero.
+ */
+#define SRPC_SHM_CACHE_KEY_SIZE 64
+
+/**
+ * Create or attach to a shared memory cache. The segment holds a fixed number of slots, each holding one versioned
+ * blob - for example a parsed netlink dump or /proc file - published by a single producer process and read by any
+ * number of consumers. Readers use a seqlock - they never block the producer and retry if a blob changes while being
+ * copied. All processes using the same segment have to pass the same slot count and size.
+ *
+ * @param name Name of the POSIX shared memory object - for example "/srpc-system-state".
+ * @param slots_count Number of slots.
+ * @param slot_size Maximal size of a single blob.
+ *
+ * @return New cache handle, NULL on error.
+ */
+srpc_shm_cache_t *srpc_shm_cache_new(const char *name, size_t slots_count, size_t slot_size);
+
+/**
+ * Register the calling process as the producer of a key. Only the registered producer can publish the key - a key
+ * registered by another running process can't be taken over, a key of a process which exited can.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param max_age_ms Age after which published blobs are considered invalid by readers - 0 for no limit, so the blob
+ * is valid until the producer invalidates it.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_shm_cache_register(srpc_shm_cache_t *cache, const char *key, uint32_t max_age_ms);
+
+/**
+ * Publish a new version of a blob. The key has to be registered using the same handle.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param data Blob data - should not contain pointers, the readers are other processes.
+ * @param size Blob size, at most the slot size of the cache.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_shm_cache_publish(srpc_shm_cache_t *cache, const char *key, const void *data, size_t size);
+
+/**
+ * Invalidate the published blob of a key - readers miss until the producer publishes again. Can be called by any
+ * process using the cache, for example when it receives an event which changes the cached state.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ *
+ * @return Error code - 0 on success, also if the key isn't registered, -1 if another running process keeps writing
+ * the slot.
+ */
+int srpc_shm_cache_invalidate(srpc_shm_cache_t *cache, const char *key);
+
+/**
+ * Copy the current blob of a key.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param buffer Buffer for the blob.
+ * @param buffer_size Size of the buffer.
+ * @param size Size of the blob output - also set if the buffer is too small.
+ * @param version Version of the blob output, incremented on each publish, can be NULL.
+ *
+ * @return 0 if the blob was copied, 1 if there is no valid blob for the key - not registered, not published,
+ * invalidated, older than its maximal age or being published for too long - and -1 if the buffer is too small.
+ */
+int srpc_shm_cache_read(srpc_shm_cache_t *cache, const char *key, void *buffer, size_t buffer_size, size_t *size,
+                        uint64_t *version);
+
+/**
+ * Get the version of the current blob of a key without copying it - consumers can skip re-parsing an unchanged blob.
+ *
+ * @param cache Cache handle.
+ * @param key Key of the blob.
+ * @param version Version of the blob output.
+ *
+ * @return 0 on success, 1 if there is no valid blob for the key.
+ */
+int srpc_shm_cache_get_version(srpc_shm_cache_t *cache, const char *key, uint64_t *version);
+
+/**
+ * Free the cache handle. Keys registered using the handle are invalidated and released, the segment itself stays
+ * for the other processes.
+ *
+ * @param cache Cache handle.
+ *
+ */
+void srpc_shm_cache_free(srpc_shm_cache_t **cache);
+
+/**
+ * Remove the shared memory segment - processes which are attached keep using it, new handles create a new segment.
+ *
+ * @param name Name of the POSIX shared memory object.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_shm_cache_unlink(const char *name);
+
+#endif // SRPC_SHM_CACHE_H
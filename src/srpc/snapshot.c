@@ -0,0 +1,749 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "snapshot.h"
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <libyang/libyang.h>
+
+// Snapshot file magic.
+#define SRPC_SNAPSHOT_MAGIC "SRPCLYB"
+
+// Snapshot file format version.
+#define SRPC_SNAPSHOT_VERSION 1
+
+// Fingerprint file magic.
+#define SRPC_SNAPSHOT_FINGERPRINT_MAGIC "SRPCFPR"
+
+// Fingerprint file format version.
+#define SRPC_SNAPSHOT_FINGERPRINT_VERSION 1
+
+// FNV-1a 64-bit offset basis and prime.
+#define SRPC_SNAPSHOT_FNV_OFFSET 0xcbf29ce484222325ULL
+#define SRPC_SNAPSHOT_FNV_PRIME 0x100000001b3ULL
+
+typedef struct srpc_snapshot_header_s srpc_snapshot_header_t;
+typedef struct srpc_snapshot_fingerprint_s srpc_snapshot_fingerprint_t;
+
+/**
+ * Header written in front of the LYB data.
+ */
+struct srpc_snapshot_header_s
+{
+    char magic[8];            ///< SRPC_SNAPSHOT_MAGIC.
+    uint32_t version;         ///< SRPC_SNAPSHOT_VERSION.
+    uint32_t reserved;        ///< Reserved - set to 0.
+    uint64_t ctx_fingerprint; ///< Fingerprint of the schema context used for printing the data.
+    uint64_t data_len;        ///< Length of the LYB data following the header.
+};
+
+/**
+ * Content of a fingerprint file.
+ */
+struct srpc_snapshot_fingerprint_s
+{
+    char magic[8];             ///< SRPC_SNAPSHOT_FINGERPRINT_MAGIC.
+    uint32_t version;          ///< SRPC_SNAPSHOT_FINGERPRINT_VERSION.
+    uint32_t reserved;         ///< Reserved - set to 0.
+    uint64_t ctx_fingerprint;  ///< Fingerprint of the schema context.
+    uint64_t tree_fingerprint; ///< Fingerprint of the data tree.
+};
+
+static int snapshot_write(const struct ly_ctx *ly_ctx, const struct lyd_node *tree, int siblings, const char *path);
+static int snapshot_replace(const char *path, const void *header, size_t header_len, const void *data, size_t len);
+static int snapshot_write_all(int fd, const void *data, size_t len);
+static int snapshot_merge_children(struct lyd_node *target, const struct lyd_node *source);
+static uint64_t snapshot_node_fingerprint(const struct lyd_node *node, uint64_t parent_hash, uint32_t position);
+static uint32_t snapshot_user_ordered_position(const struct lyd_node *node, uint32_t previous_position);
+static uint64_t snapshot_fnv(uint64_t hash, const void *data, size_t len);
+static uint64_t snapshot_mix(uint64_t hash);
+
+/**
+ * Compute a fingerprint of the schema context - names, revisions and enabled features of all modules.
+ * The fingerprint doesn't depend on the order in which the modules were loaded.
+ *
+ * @param ly_ctx libyang context.
+ *
+ * @return Context fingerprint.
+ */
+uint64_t srpc_snapshot_ctx_fingerprint(const struct ly_ctx *ly_ctx)
+{
+    uint64_t fingerprint = 0;
+    uint64_t hash = 0;
+    uint32_t module_idx = 0;
+    uint32_t feature_idx = 0;
+    const struct lys_module *module = NULL;
+    const struct lysp_feature *feature = NULL;
+
+    while ((module = ly_ctx_get_module_iter(ly_ctx, &module_idx)))
+    {
+        hash = SRPC_SNAPSHOT_FNV_OFFSET;
+        hash = snapshot_fnv(hash, module->name, strlen(module->name) + 1);
+        if (module->revision)
+        {
+            hash = snapshot_fnv(hash, module->revision, strlen(module->revision));
+        }
+        hash = snapshot_fnv(hash, &module->implemented, sizeof(module->implemented));
+
+        if (module->parsed)
+        {
+            feature_idx = 0;
+            feature = NULL;
+            while ((feature = lysp_feature_next(feature, module->parsed, &feature_idx)))
+            {
+                if (feature->flags & LYS_FENABLED)
+                {
+                    hash = snapshot_fnv(hash, feature->name, strlen(feature->name) + 1);
+                }
+            }
+        }
+
+        // mix before summing so the combination stays order independent but doesn't cancel out
+        fingerprint += snapshot_mix(hash);
+    }
+
+    return fingerprint;
+}
+
+/**
+ * Save a data tree with all its siblings to a snapshot file in the LYB format. The file is replaced atomically.
+ *
+ * @param ly_ctx libyang context of the data tree.
+ * @param tree Data tree to save, can be NULL.
+ * @param path Path of the snapshot file.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_snapshot_save(const struct ly_ctx *ly_ctx, const struct lyd_node *tree, const char *path)
+{
+    return snapshot_write(ly_ctx, tree, 1, path);
+}
+
+/**
+ * Load a data tree from a snapshot file. The file is mapped into memory and parsed without validation.
+ *
+ * @param ly_ctx libyang context to parse the data in.
+ * @param path Path of the snapshot file.
+ * @param tree Loaded data tree.
+ *
+ * @return Error code - 0 on success, 1 if the snapshot doesn't exist or doesn't match the schema context.
+ */
+int srpc_snapshot_load(const struct ly_ctx *ly_ctx, const char *path, struct lyd_node **tree)
+{
+    int error = 0;
+    int fd = -1;
+    struct stat st = {0};
+    void *map = MAP_FAILED;
+    size_t map_len = 0;
+    srpc_snapshot_header_t header = {0};
+    struct ly_in *in = NULL;
+
+    *tree = NULL;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        if (errno == ENOENT)
+        {
+            error = 1;
+            goto out;
+        }
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to open snapshot \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, fstat(fd, &st), error_out);
+
+    if ((size_t)st.st_size < sizeof(header))
+    {
+        goto invalid_out;
+    }
+
+    map_len = (size_t)st.st_size;
+    map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to map snapshot \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    memcpy(&header, map, sizeof(header));
+
+    if (memcmp(header.magic, SRPC_SNAPSHOT_MAGIC, sizeof(SRPC_SNAPSHOT_MAGIC)) ||
+        header.version != SRPC_SNAPSHOT_VERSION || header.data_len != map_len - sizeof(header))
+    {
+        goto invalid_out;
+    }
+
+    if (header.ctx_fingerprint != srpc_snapshot_ctx_fingerprint(ly_ctx))
+    {
+        SRPLG_LOG_INF(SRPC_PLUGIN_NAME, "Snapshot \"%s\" was created with a different schema context", path);
+        error = 1;
+        goto out;
+    }
+
+    SRPC_SAFE_CALL_ERR(error, ly_in_new_memory((const char *)map + sizeof(header), &in), error_out);
+    SRPC_SAFE_CALL_ERR(error, lyd_parse_data(ly_ctx, NULL, in, LYD_LYB, LYD_PARSE_ONLY | LYD_PARSE_STRICT, 0, tree),
+                       invalid_out);
+
+    goto out;
+
+invalid_out:
+    SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Snapshot \"%s\" is invalid", path);
+    lyd_free_all(*tree);
+    *tree = NULL;
+    error = 1;
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    ly_in_free(in, 0);
+
+    if (map != MAP_FAILED)
+    {
+        munmap(map, map_len);
+    }
+
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return error;
+}
+
+/**
+ * Save the subtree of the parent node to a snapshot file - use from a srpc_startup_store_cb callback.
+ *
+ * @param path Path of the snapshot file.
+ * @param parent_node Node whose subtree is saved.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_snapshot_store(const char *path, const struct lyd_node *parent_node)
+{
+    int error = 0;
+    struct lyd_node *dup = NULL;
+    struct lyd_node *top = NULL;
+
+    if (!parent_node->parent)
+    {
+        return snapshot_write(LYD_CTX(parent_node), parent_node, 0, path);
+    }
+
+    // LYB data has to start at the top level - keep the parents of a nested node
+    SRPC_SAFE_CALL_ERR(error, lyd_dup_single(parent_node, NULL, LYD_DUP_RECURSIVE | LYD_DUP_WITH_PARENTS, &dup),
+                       error_out);
+
+    for (top = dup; top->parent; top = lyd_parent(top))
+    {
+    }
+
+    SRPC_SAFE_CALL_ERR(error, snapshot_write(LYD_CTX(parent_node), top, 0, path), error_out);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    lyd_free_all(top ? top : dup);
+
+    return error;
+}
+
+/**
+ * Load a snapshot saved using srpc_snapshot_store() and merge it into the parent node - use from a
+ * srpc_startup_load_cb callback.
+ *
+ * @param ly_ctx libyang context.
+ * @param path Path of the snapshot file.
+ * @param parent_node Node to merge the loaded subtree into - a top-level or a nested node like a list entry.
+ *
+ * @return Error code - 0 on success, 1 if the snapshot doesn't exist or doesn't match the schema context.
+ */
+int srpc_snapshot_load_into(const struct ly_ctx *ly_ctx, const char *path, struct lyd_node *parent_node)
+{
+    int error = 0;
+    struct lyd_node *tree = NULL;
+    struct lyd_node *match = NULL;
+    char *parent_path = NULL;
+
+    error = srpc_snapshot_load(ly_ctx, path, &tree);
+    if (error)
+    {
+        goto out;
+    }
+
+    SRPC_SAFE_CALL_PTR(parent_path, lyd_path(parent_node, LYD_PATH_STD, NULL, 0), error_out);
+
+    if (lyd_find_path(tree, parent_path, 0, &match) != LY_SUCCESS)
+    {
+        SRPLG_LOG_INF(SRPC_PLUGIN_NAME, "Snapshot \"%s\" doesn't contain \"%s\"", path, parent_path);
+        error = 1;
+        goto out;
+    }
+
+    // libyang merges top-level trees only, the parent node can be nested
+    SRPC_SAFE_CALL_ERR(error, snapshot_merge_children(parent_node, match), error_out);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    free(parent_path);
+    lyd_free_all(tree);
+
+    return error;
+}
+
+/**
+ * Compute an order independent fingerprint of a data tree with all its siblings - values and the identity of every
+ * node. Trees collected from the system in a different order, for example interfaces listed in a different order by
+ * the kernel, get the same fingerprint. The order of ordered-by user list and leaf-list entries is part of the data
+ * though, so reordering them changes the fingerprint.
+ *
+ * @param tree Data tree, can be NULL.
+ *
+ * @return Tree fingerprint.
+ */
+uint64_t srpc_snapshot_tree_fingerprint(const struct lyd_node *tree)
+{
+    uint64_t fingerprint = 0;
+    uint32_t position = 0;
+
+    for (const struct lyd_node *iter = tree; iter; iter = iter->next)
+    {
+        position = snapshot_user_ordered_position(iter, position);
+        fingerprint += snapshot_node_fingerprint(iter, SRPC_SNAPSHOT_FNV_OFFSET, position);
+    }
+
+    return fingerprint;
+}
+
+/**
+ * Compare the fingerprint of a data tree collected from the system with the fingerprint stored on the previous
+ * plugin start. If both the tree and the schema context are unchanged, the startup import and the sync of the
+ * system can be skipped.
+ *
+ * @param ly_ctx libyang context of the data tree.
+ * @param tree Data tree collected from the system, can be NULL.
+ * @param path Path of the fingerprint file.
+ * @param fingerprint Fingerprint of the tree output - store it using srpc_snapshot_fingerprint_store() after a
+ * successful import, can be NULL.
+ *
+ * @return Error code - 0 if the fingerprint matches, 1 if it differs or no valid fingerprint is stored, -1 if the file
+ * can't be read.
+ */
+int srpc_snapshot_fingerprint_check(const struct ly_ctx *ly_ctx, const struct lyd_node *tree, const char *path,
+                                    uint64_t *fingerprint)
+{
+    int error = 0;
+    int fd = -1;
+    ssize_t rc = 0;
+    uint64_t tree_fingerprint = srpc_snapshot_tree_fingerprint(tree);
+    srpc_snapshot_fingerprint_t stored = {0};
+
+    if (fingerprint)
+    {
+        *fingerprint = tree_fingerprint;
+    }
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        if (errno == ENOENT)
+        {
+            error = 1;
+            goto out;
+        }
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to open fingerprint \"%s\" (%s)", path, strerror(errno));
+        goto error_out;
+    }
+
+    rc = read(fd, &stored, sizeof(stored));
+    if (rc != (ssize_t)sizeof(stored) ||
+        memcmp(stored.magic, SRPC_SNAPSHOT_FINGERPRINT_MAGIC, sizeof(SRPC_SNAPSHOT_FINGERPRINT_MAGIC)) ||
+        stored.version != SRPC_SNAPSHOT_FINGERPRINT_VERSION)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Fingerprint \"%s\" is invalid", path);
+        error = 1;
+        goto out;
+    }
+
+    if (stored.ctx_fingerprint != srpc_snapshot_ctx_fingerprint(ly_ctx))
+    {
+        SRPLG_LOG_INF(SRPC_PLUGIN_NAME, "Fingerprint \"%s\" was created with a different schema context", path);
+        error = 1;
+        goto out;
+    }
+
+    error = stored.tree_fingerprint == tree_fingerprint ? 0 : 1;
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    return error;
+}
+
+/**
+ * Store a data tree fingerprint together with the fingerprint of the schema context. The file is replaced
+ * atomically. Remove the file to force the next import.
+ *
+ * @param ly_ctx libyang context of the fingerprinted tree.
+ * @param path Path of the fingerprint file.
+ * @param fingerprint Tree fingerprint - as returned by srpc_snapshot_fingerprint_check().
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_snapshot_fingerprint_store(const struct ly_ctx *ly_ctx, const char *path, uint64_t fingerprint)
+{
+    srpc_snapshot_fingerprint_t stored = {0};
+
+    memcpy(stored.magic, SRPC_SNAPSHOT_FINGERPRINT_MAGIC, sizeof(SRPC_SNAPSHOT_FINGERPRINT_MAGIC));
+    stored.version = SRPC_SNAPSHOT_FINGERPRINT_VERSION;
+    stored.ctx_fingerprint = srpc_snapshot_ctx_fingerprint(ly_ctx);
+    stored.tree_fingerprint = fingerprint;
+
+    return snapshot_replace(path, &stored, sizeof(stored), NULL, 0);
+}
+
+/**
+ * Print the data in the LYB format and write it with the snapshot header to a temporary file which then replaces the
+ * snapshot file.
+ *
+ * @param ly_ctx libyang context of the data.
+ * @param tree Data to write, can be NULL.
+ * @param siblings Write all siblings of the tree - otherwise only the tree itself is written.
+ * @param path Path of the snapshot file.
+ *
+ * @return Error code - 0 on success.
+ */
+static int snapshot_write(const struct ly_ctx *ly_ctx, const struct lyd_node *tree, int siblings, const char *path)
+{
+    int error = 0;
+    char *data = NULL;
+    struct ly_out *out = NULL;
+    srpc_snapshot_header_t header = {0};
+
+    SRPC_SAFE_CALL_ERR(error, ly_out_new_memory(&data, 0, &out), error_out);
+
+    if (siblings || !tree)
+    {
+        SRPC_SAFE_CALL_ERR(error, lyd_print_all(out, tree, LYD_LYB, 0), error_out);
+    }
+    else
+    {
+        SRPC_SAFE_CALL_ERR(error, lyd_print_tree(out, tree, LYD_LYB, 0), error_out);
+    }
+
+    memcpy(header.magic, SRPC_SNAPSHOT_MAGIC, sizeof(SRPC_SNAPSHOT_MAGIC));
+    header.version = SRPC_SNAPSHOT_VERSION;
+    header.ctx_fingerprint = srpc_snapshot_ctx_fingerprint(ly_ctx);
+    header.data_len = ly_out_printed(out);
+
+    SRPC_SAFE_CALL_ERR(error, snapshot_replace(path, &header, sizeof(header), data, (size_t)header.data_len),
+                       error_out);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    ly_out_free(out, NULL, 0);
+    free(data);
+
+    return error;
+}
+
+/**
+ * Write the header and the data to a temporary file which then replaces the file at the path.
+ *
+ * @param path Path of the file.
+ * @param header Header to write.
+ * @param header_len Length of the header.
+ * @param data Data following the header, can be NULL.
+ * @param len Length of the data.
+ *
+ * @return Error code - 0 on success.
+ */
+static int snapshot_replace(const char *path, const void *header, size_t header_len, const void *data, size_t len)
+{
+    int error = 0;
+    int fd = -1;
+    char *tmp_path = NULL;
+    size_t tmp_path_size = 0;
+
+    tmp_path_size = strlen(path) + 5;
+    SRPC_SAFE_CALL_PTR(tmp_path, malloc(tmp_path_size), error_out);
+    snprintf(tmp_path, tmp_path_size, "%s.tmp", path);
+
+    SRPC_SAFE_CALL_ERR_COND(fd, fd == -1, open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600), error_out);
+    SRPC_SAFE_CALL_ERR(error, snapshot_write_all(fd, header, header_len), error_out);
+    if (len)
+    {
+        SRPC_SAFE_CALL_ERR(error, snapshot_write_all(fd, data, len), error_out);
+    }
+    SRPC_SAFE_CALL_ERR(error, fsync(fd), error_out);
+
+    close(fd);
+    fd = -1;
+
+    SRPC_SAFE_CALL_ERR(error, rename(tmp_path, path), error_out);
+
+    goto out;
+
+error_out:
+    if (fd != -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+    if (tmp_path)
+    {
+        unlink(tmp_path);
+    }
+    error = -1;
+
+out:
+    free(tmp_path);
+
+    return error;
+}
+
+/**
+ * Write the whole buffer to a file descriptor.
+ *
+ * @param fd File descriptor.
+ * @param data Data to write.
+ * @param len Length of the data.
+ *
+ * @return Error code - 0 on success.
+ */
+static int snapshot_write_all(int fd, const void *data, size_t len)
+{
+    const char *ptr = data;
+    ssize_t rc = 0;
+
+    while (len)
+    {
+        rc = write(fd, ptr, len);
+        if (rc == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+
+        ptr += rc;
+        len -= (size_t)rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Merge the children of the source node into the children of the target node - missing nodes are duplicated into the
+ * target, existing leafs take the source value and existing inner nodes are merged recursively.
+ *
+ * @param target Node to merge into.
+ * @param source Node whose children are merged.
+ *
+ * @return Error code - 0 on success.
+ */
+static int snapshot_merge_children(struct lyd_node *target, const struct lyd_node *source)
+{
+    int error = 0;
+    struct lyd_node *existing = NULL;
+    const char *value = NULL;
+
+    for (const struct lyd_node *iter = lyd_child(source); iter; iter = iter->next)
+    {
+        if (lyd_find_sibling_first(lyd_child(target), iter, &existing) != LY_SUCCESS)
+        {
+            SRPC_SAFE_CALL_ERR(error, lyd_dup_single(iter, (struct lyd_node_inner *)target, LYD_DUP_RECURSIVE, NULL),
+                               error_out);
+        }
+        else if (iter->schema->nodetype == LYS_LEAF)
+        {
+            // keys and equal values stay untouched
+            value = lyd_get_value(iter);
+            if (strcmp(lyd_get_value(existing), value))
+            {
+                SRPC_SAFE_CALL_ERR(error, lyd_change_term(existing, value), error_out);
+            }
+        }
+        else if (iter->schema->nodetype & (LYS_CONTAINER | LYS_LIST))
+        {
+            SRPC_SAFE_CALL_ERR(error, snapshot_merge_children(existing, iter), error_out);
+        }
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Compute the fingerprint of a node and its subtree. The identity of a node - its module, name and the identity of
+ * its parent, the key values for list entries and the value for leafs and leaf-lists - is hashed and the hashes of
+ * all nodes are summed, so the order of siblings doesn't matter. Only for ordered-by user entries the position among
+ * the entries is a part of the identity.
+ *
+ * @param node Data node.
+ * @param parent_hash Identity hash of the parent node.
+ * @param position Position of an ordered-by user entry among its instances, 0 for other nodes.
+ *
+ * @return Subtree fingerprint.
+ */
+static uint64_t snapshot_node_fingerprint(const struct lyd_node *node, uint64_t parent_hash, uint32_t position)
+{
+    uint64_t hash = parent_hash;
+    uint64_t fingerprint = 0;
+    const char *value = NULL;
+
+    if (node->schema)
+    {
+        hash = snapshot_fnv(hash, node->schema->module->name, strlen(node->schema->module->name) + 1);
+    }
+    hash = snapshot_fnv(hash, LYD_NAME(node), strlen(LYD_NAME(node)) + 1);
+
+    if (!node->schema || (node->schema->nodetype & LYD_NODE_TERM))
+    {
+        value = lyd_get_value(node);
+        if (value)
+        {
+            hash = snapshot_fnv(hash, value, strlen(value) + 1);
+        }
+    }
+    else if (node->schema->nodetype == LYS_LIST)
+    {
+        // keys are the first children - they tell the entries apart, so moved values change the fingerprint
+        for (const struct lyd_node *key = lyd_child(node); key && key->schema && (key->schema->flags & LYS_KEY);
+             key = key->next)
+        {
+            value = lyd_get_value(key);
+            hash = snapshot_fnv(hash, value, strlen(value) + 1);
+        }
+    }
+
+    if (position)
+    {
+        hash = snapshot_fnv(hash, &position, sizeof(position));
+    }
+
+    fingerprint = snapshot_mix(hash);
+
+    position = 0;
+    for (const struct lyd_node *child = lyd_child(node); child; child = child->next)
+    {
+        position = snapshot_user_ordered_position(child, position);
+        fingerprint += snapshot_node_fingerprint(child, hash, position);
+    }
+
+    return fingerprint;
+}
+
+/**
+ * Get the position of an ordered-by user list or leaf-list entry among the instances of its schema node. The instances
+ * are always adjacent siblings, so the position follows from the previous sibling.
+ *
+ * @param node Data node.
+ * @param previous_position Position returned for the previous sibling.
+ *
+ * @return Position starting from 1, 0 if the node isn't an ordered-by user entry.
+ */
+static uint32_t snapshot_user_ordered_position(const struct lyd_node *node, uint32_t previous_position)
+{
+    if (!node->schema || !(node->schema->flags & LYS_ORDBY_USER))
+    {
+        return 0;
+    }
+
+    // prev of the first sibling points to the last one
+    if (node->prev->next == node && node->prev->schema == node->schema)
+    {
+        return previous_position + 1;
+    }
+
+    return 1;
+}
+
+/**
+ * Update a FNV-1a hash with the given data.
+ *
+ * @param hash Current hash value.
+ * @param data Data to hash.
+ * @param len Length of the data.
+ *
+ * @return Updated hash value.
+ */
+static uint64_t snapshot_fnv(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *ptr = data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= ptr[i];
+        hash *= SRPC_SNAPSHOT_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/**
+ * Finalize a hash before summing it with others, so similar hashes don't cancel out.
+ *
+ * @param hash Hash value.
+ *
+ * @return Mixed hash value.
+ */
+static uint64_t snapshot_mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file snapshot.h
+ * @brief API for persisting data trees in the libyang binary format for fast plugin startup.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_SNAPSHOT_H
+#define SRPC_SNAPSHOT_H
+
+#include "types.h"
+
+#include <stdint.h>
+
+/**
+ * Compute a fingerprint of the schema context - names, revisions and enabled features of all modules.
+ * The fingerprint doesn't depend on the order in which the modules were loaded.
+ *
+ * @param ly_ctx libyang context.
+ *
+ * @return Context fingerprint.
+ */
+uint64_t srpc_snapshot_ctx_fingerprint(const struct ly_ctx *ly_ctx);
+
+/**
+ * Save a data tree with all its siblings to a snapshot file in the LYB format. The file is replaced atomically.
+ *
+ * @param ly_ctx libyang context of the data tree.
+ * @param tree Data tree to save, can be NULL.
+ * @param path Path of the snapshot file.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_snapshot_save(const struct ly_ctx *ly_ctx, const struct lyd_node *tree, const char *path);
+
+/**
+ * Load a data tree from a snapshot file. The file is mapped into memory and parsed without validation.
+ *
+ * @param ly_ctx libyang context to parse the data in.
+ * @param path Path of the snapshot file.
+ * @param tree Loaded data tree.
+ *
+ * @return Error code - 0 on success, 1 if the snapshot doesn't exist or doesn't match the schema context.
+ */
+int srpc_snapshot_load(const struct ly_ctx *ly_ctx, const char *path, struct lyd_node **tree);
+
+/**
+ * Save the subtree of the parent node to a snapshot file - use from a srpc_startup_store_cb callback.
+ *
+ * @param path Path of the snapshot file.
+ * @param parent_node Node whose subtree is saved.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_snapshot_store(const char *path, const struct lyd_node *parent_node);
+
+/**
+ * Load a snapshot saved using srpc_snapshot_store() and merge it into the parent node - use from a
+ * srpc_startup_load_cb callback.
+ *
+ * @param ly_ctx libyang context.
+ * @param path Path of the snapshot file.
+ * @param parent_node Node to merge the loaded subtree into - a top-level or a nested node like a list entry.
+ *
+ * @return Error code - 0 on success, 1 if the snapshot doesn't exist or doesn't match the schema context.
+ */
+int srpc_snapshot_load_into(const struct ly_ctx *ly_ctx, const char *path, struct lyd_node *parent_node);
+
+/**
+ * Compute an order independent fingerprint of a data tree with all its siblings - values and the identity of every
+ * node. Trees collected from the system in a different order, for example interfaces listed in a different order by
+ * the kernel, get the same fingerprint. The order of ordered-by user list and leaf-list entries is part of the data
+ * though, so reordering them changes the fingerprint.
+ *
+ * @param tree Data tree, can be NULL.
+ *
+ * @return Tree fingerprint.
+ */
+uint64_t srpc_snapshot_tree_fingerprint(const struct lyd_node *tree);
+
+/**
+ * Compare the fingerprint of a data tree collected from the system with the fingerprint stored on the previous
+ * plugin start. If both the tree and the schema context are unchanged, the startup import and the sync of the
+ * system can be skipped.
+ *
+ * @param ly_ctx libyang context of the data tree.
+ * @param tree Data tree collected from the system, can be NULL.
+ * @param path Path of the fingerprint file.
+ * @param fingerprint Fingerprint of the tree output - store it using srpc_snapshot_fingerprint_store() after a
+ * successful import, can be NULL.
+ *
+ * @return Error code - 0 if the fingerprint matches, 1 if it differs or no valid fingerprint is stored, -1 if the file
+ * can't be read.
+ */
+int srpc_snapshot_fingerprint_check(const struct ly_ctx *ly_ctx, const struct lyd_node *tree, const char *path,
+                                    uint64_t *fingerprint);
+
+/**
+ * Store a data tree fingerprint together with the fingerprint of the schema context. The file is replaced
+ * atomically. Remove the file to force the next import.
+ *
+ * @param ly_ctx libyang context of the fingerprinted tree.
+ * @param path Path of the fingerprint file.
+ * @param fingerprint Tree fingerprint - as returned by srpc_snapshot_fingerprint_check().
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_snapshot_fingerprint_store(const struct ly_ctx *ly_ctx, const char *path, uint64_t fingerprint);
+
+#endif // SRPC_SNAPSHOT_H
@@ -0,0 +1,505 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "startup_store.h"
+#include "common.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <sysrepo.h>
+#include <libyang/libyang.h>
+
+// Maximum number of coalescing windows to wait for before storing even if commits keep arriving.
+#define SRPC_STARTUP_STORE_MAX_WINDOWS 8
+
+/**
+ * Startup store engine - snapshot of the stored data and the write-behind thread state.
+ */
+struct srpc_startup_store_engine_s
+{
+    void *priv;                   ///< Private data passed to the store callbacks.
+    srpc_startup_store_t *stores; ///< Store callbacks.
+    size_t stores_count;          ///< Number of store callbacks.
+    uint32_t coalesce_ms;         ///< Coalescing window.
+    struct lyd_node *snapshot;    ///< Last successfully stored data - used only by the thread after startup.
+    struct lyd_node *pending;     ///< Submitted data waiting to be stored.
+    bool has_pending;             ///< Pending data is set - the pending tree itself can be NULL.
+    uint64_t submit_seq;          ///< Number of submitted trees.
+    uint64_t stored_seq;          ///< Submit sequence number of the last stored tree.
+    int last_error;               ///< Error of the stores since the last flush.
+    bool stop;                    ///< Thread stop request.
+    pthread_t thread;             ///< Write-behind thread.
+    pthread_mutex_t lock;         ///< Lock for the whole engine state.
+    pthread_cond_t work_cond;     ///< Signaled on new submits and stop requests.
+    pthread_cond_t done_cond;     ///< Signaled when a tree gets stored.
+};
+
+static void *startup_store_thread(void *arg);
+static int startup_store_apply(srpc_startup_store_engine_t *engine, struct lyd_node *tree);
+static int startup_store_call_changed(srpc_startup_store_engine_t *engine, const srpc_startup_store_t *store,
+                                      const struct lyd_node *tree, const struct lyd_node *diff_node);
+static int startup_store_call(srpc_startup_store_engine_t *engine, const srpc_startup_store_t *store,
+                              const struct lyd_node *node);
+static void startup_store_deadline(struct timespec *ts, uint32_t ms);
+
+/**
+ * Create a new startup store engine and start its background thread.
+ * The engine keeps the last stored data snapshot and calls the store callbacks only with the subtrees changed compared
+ * to the snapshot - a callback with a path is called once for each changed node selected by the path, with that node
+ * of the stored tree. If the node was removed, the callback gets its diff node instead, which has the yang:operation
+ * metadata set to delete. Callbacks without a path are called with the whole tree on every change. All submitted trees
+ * have to belong to a libyang context which outlives the engine.
+ *
+ * @param priv Private user data passed to the store callbacks - pass plugin context.
+ * @param stores Array of store callbacks - the array is copied.
+ * @param stores_count Number of store callbacks.
+ * @param coalesce_ms Time to wait for more submitted trees before storing - bursts of commits are stored only once.
+ *
+ * @return New engine, NULL on error.
+ */
+srpc_startup_store_engine_t *srpc_startup_store_engine_new(void *priv, const srpc_startup_store_t stores[],
+                                                           size_t stores_count, uint32_t coalesce_ms)
+{
+    srpc_startup_store_engine_t *engine = NULL;
+    pthread_condattr_t cond_attr;
+    bool lock_init = false, work_init = false, done_init = false;
+
+    SRPC_SAFE_CALL_PTR(engine, calloc(1, sizeof(*engine)), error_out);
+
+    if (stores_count)
+    {
+        SRPC_SAFE_CALL_PTR(engine->stores, malloc(stores_count * sizeof(*engine->stores)), error_out);
+        memcpy(engine->stores, stores, stores_count * sizeof(*engine->stores));
+    }
+
+    engine->priv = priv;
+    engine->stores_count = stores_count;
+    engine->coalesce_ms = coalesce_ms;
+
+    if (pthread_mutex_init(&engine->lock, NULL) != 0)
+    {
+        goto error_out;
+    }
+    lock_init = true;
+
+    // use monotonic clock for the coalescing window
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    work_init = pthread_cond_init(&engine->work_cond, &cond_attr) == 0;
+    done_init = pthread_cond_init(&engine->done_cond, NULL) == 0;
+    pthread_condattr_destroy(&cond_attr);
+    if (!work_init || !done_init)
+    {
+        goto error_out;
+    }
+
+    if (pthread_create(&engine->thread, NULL, startup_store_thread, engine) != 0)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Unable to start startup store thread");
+        goto error_out;
+    }
+
+    return engine;
+
+error_out:
+    if (engine)
+    {
+        if (done_init)
+        {
+            pthread_cond_destroy(&engine->done_cond);
+        }
+        if (work_init)
+        {
+            pthread_cond_destroy(&engine->work_cond);
+        }
+        if (lock_init)
+        {
+            pthread_mutex_destroy(&engine->lock);
+        }
+        free(engine->stores);
+        free(engine);
+    }
+
+    return NULL;
+}
+
+/**
+ * Set the snapshot of already stored data without calling any store callbacks - use with the data loaded from the
+ * system on plugin startup, before submitting any data.
+ *
+ * @param engine Startup store engine.
+ * @param tree Data tree to duplicate and use as the snapshot, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_startup_store_engine_set_snapshot(srpc_startup_store_engine_t *engine, const struct lyd_node *tree)
+{
+    int error = 0;
+    struct lyd_node *dup = NULL;
+
+    if (tree)
+    {
+        SRPC_SAFE_CALL_ERR(error, lyd_dup_siblings(tree, NULL, LYD_DUP_RECURSIVE, &dup), error_out);
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    lyd_free_all(engine->snapshot);
+    engine->snapshot = dup;
+    pthread_mutex_unlock(&engine->lock);
+
+    goto out;
+
+error_out:
+    lyd_free_all(dup);
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Submit new data for storing. The tree is duplicated and stored on the background thread - if a previously submitted
+ * tree hasn't been stored yet, it is replaced by the new one.
+ *
+ * @param engine Startup store engine.
+ * @param tree Complete data tree to store, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_startup_store_engine_submit(srpc_startup_store_engine_t *engine, const struct lyd_node *tree)
+{
+    int error = 0;
+    struct lyd_node *dup = NULL;
+    struct lyd_node *replaced = NULL;
+
+    // duplicate outside of the lock - the commit path only pays for the copy
+    if (tree)
+    {
+        SRPC_SAFE_CALL_ERR(error, lyd_dup_siblings(tree, NULL, LYD_DUP_RECURSIVE, &dup), error_out);
+    }
+
+    pthread_mutex_lock(&engine->lock);
+    replaced = engine->pending;
+    engine->pending = dup;
+    engine->has_pending = true;
+    ++engine->submit_seq;
+    pthread_cond_signal(&engine->work_cond);
+    pthread_mutex_unlock(&engine->lock);
+
+    // coalesced - the older tree will never be stored
+    lyd_free_all(replaced);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Wait until all submitted data has been stored.
+ *
+ * @param engine Startup store engine.
+ *
+ * @return Error code of the stores done since the last flush - 0 on success.
+ */
+int srpc_startup_store_engine_flush(srpc_startup_store_engine_t *engine)
+{
+    int error = 0;
+    uint64_t target = 0;
+
+    pthread_mutex_lock(&engine->lock);
+
+    target = engine->submit_seq;
+    while (engine->stored_seq < target)
+    {
+        pthread_cond_wait(&engine->done_cond, &engine->lock);
+    }
+
+    error = engine->last_error;
+    engine->last_error = 0;
+
+    pthread_mutex_unlock(&engine->lock);
+
+    return error;
+}
+
+/**
+ * Store all pending data, stop the background thread and free the engine.
+ *
+ * @param engine Startup store engine.
+ *
+ */
+void srpc_startup_store_engine_free(srpc_startup_store_engine_t **engine)
+{
+    srpc_startup_store_engine_t *e = *engine;
+
+    if (!e)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&e->lock);
+    e->stop = true;
+    pthread_cond_signal(&e->work_cond);
+    pthread_mutex_unlock(&e->lock);
+
+    // the thread stores pending data before exiting
+    pthread_join(e->thread, NULL);
+
+    pthread_cond_destroy(&e->done_cond);
+    pthread_cond_destroy(&e->work_cond);
+    pthread_mutex_destroy(&e->lock);
+
+    lyd_free_all(e->pending);
+    lyd_free_all(e->snapshot);
+    free(e->stores);
+    free(e);
+
+    *engine = NULL;
+}
+
+/**
+ * Write-behind thread - waits for submitted trees, coalesces bursts and stores the latest tree.
+ *
+ * @param arg Startup store engine.
+ *
+ * @return Always NULL.
+ */
+static void *startup_store_thread(void *arg)
+{
+    srpc_startup_store_engine_t *engine = arg;
+    struct lyd_node *tree = NULL;
+    struct timespec deadline = {0};
+    uint64_t seq = 0;
+    int error = 0;
+
+    pthread_mutex_lock(&engine->lock);
+
+    while (true)
+    {
+        while (!engine->has_pending && !engine->stop)
+        {
+            pthread_cond_wait(&engine->work_cond, &engine->lock);
+        }
+
+        if (!engine->has_pending)
+        {
+            // stop requested and nothing left to store
+            break;
+        }
+
+        // wait until no new tree is submitted for the whole window
+        for (int i = 0; i < SRPC_STARTUP_STORE_MAX_WINDOWS && engine->coalesce_ms && !engine->stop; i++)
+        {
+            seq = engine->submit_seq;
+            startup_store_deadline(&deadline, engine->coalesce_ms);
+            while (seq == engine->submit_seq && !engine->stop)
+            {
+                if (pthread_cond_timedwait(&engine->work_cond, &engine->lock, &deadline) != 0)
+                {
+                    break;
+                }
+            }
+            if (seq == engine->submit_seq)
+            {
+                break;
+            }
+        }
+
+        tree = engine->pending;
+        seq = engine->submit_seq;
+        engine->pending = NULL;
+        engine->has_pending = false;
+
+        pthread_mutex_unlock(&engine->lock);
+        error = startup_store_apply(engine, tree);
+        pthread_mutex_lock(&engine->lock);
+
+        if (error)
+        {
+            engine->last_error = error;
+        }
+        engine->stored_seq = seq;
+        pthread_cond_broadcast(&engine->done_cond);
+    }
+
+    pthread_mutex_unlock(&engine->lock);
+
+    return NULL;
+}
+
+/**
+ * Diff the tree against the last stored snapshot and call the store callbacks for the changed data.
+ * On success the tree becomes the new snapshot, otherwise the old snapshot is kept so that the changes are retried on
+ * the next submit.
+ *
+ * @param engine Startup store engine.
+ * @param tree Tree to store - ownership is taken.
+ *
+ * @return Error code - 0 on success.
+ */
+static int startup_store_apply(srpc_startup_store_engine_t *engine, struct lyd_node *tree)
+{
+    int error = 0;
+    struct lyd_node *diff = NULL;
+    struct ly_set *set = NULL;
+
+    SRPC_SAFE_CALL_ERR(error, lyd_diff_siblings(engine->snapshot, tree, 0, &diff), error_out);
+
+    if (!diff)
+    {
+        // nothing changed since the last store
+        lyd_free_all(tree);
+        goto out;
+    }
+
+    for (size_t i = 0; i < engine->stores_count; i++)
+    {
+        const srpc_startup_store_t *store = &engine->stores[i];
+
+        if (!store->path)
+        {
+            if (startup_store_call(engine, store, tree))
+            {
+                error = -1;
+            }
+            continue;
+        }
+
+        SRPC_SAFE_CALL_ERR(error, lyd_find_xpath(diff, store->path, &set), error_out);
+
+        for (uint32_t j = 0; j < set->count; j++)
+        {
+            if (startup_store_call_changed(engine, store, tree, set->dnodes[j]))
+            {
+                error = -1;
+            }
+        }
+
+        ly_set_free(set, NULL);
+        set = NULL;
+    }
+
+    if (error)
+    {
+        lyd_free_all(tree);
+        goto out;
+    }
+
+    lyd_free_all(engine->snapshot);
+    engine->snapshot = tree;
+
+    goto out;
+
+error_out:
+    lyd_free_all(tree);
+    error = -1;
+
+out:
+    ly_set_free(set, NULL);
+    lyd_free_all(diff);
+
+    return error;
+}
+
+/**
+ * Call the store callback for a changed subtree - with the subtree of the stored tree, or with the diff node if the
+ * subtree was removed.
+ *
+ * @param engine Startup store engine.
+ * @param store Store callback.
+ * @param tree Tree being stored.
+ * @param diff_node Diff node of the changed subtree.
+ *
+ * @return Error code - 0 on success.
+ */
+static int startup_store_call_changed(srpc_startup_store_engine_t *engine, const srpc_startup_store_t *store,
+                                      const struct lyd_node *tree, const struct lyd_node *diff_node)
+{
+    int error = 0;
+    char *path = NULL;
+    struct lyd_node *current = NULL;
+
+    SRPC_SAFE_CALL_PTR(path, lyd_path(diff_node, LYD_PATH_STD, NULL, 0), error_out);
+
+    if (!tree || lyd_find_path(tree, path, 0, &current) != LY_SUCCESS)
+    {
+        // removed - the diff node carries the removed subtree with the delete operation
+        current = NULL;
+    }
+
+    error = startup_store_call(engine, store, current ? current : diff_node);
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    free(path);
+
+    return error;
+}
+
+/**
+ * Call the store callback and log its failure.
+ *
+ * @param engine Startup store engine.
+ * @param store Store callback.
+ * @param node Node passed to the callback.
+ *
+ * @return Error code - 0 on success.
+ */
+static int startup_store_call(srpc_startup_store_engine_t *engine, const srpc_startup_store_t *store,
+                              const struct lyd_node *node)
+{
+    int error = store->cb(engine->priv, node);
+
+    if (error)
+    {
+        SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Startup store callback for %s failed (%d)", store->name, error);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Compute an absolute monotonic deadline.
+ *
+ * @param ts Timespec to set.
+ * @param ms Milliseconds from now.
+ *
+ */
+static void startup_store_deadline(struct timespec *ts, uint32_t ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec += 1;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
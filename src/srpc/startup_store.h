@@ -0,0 +1,84 @@
+/**
+ * @file startup_store.h
+ * @brief API for incremental, write-behind storing of startup data using srpc_startup_store_t callbacks.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_STARTUP_STORE_H
+#define SRPC_STARTUP_STORE_H
+
+#include "types.h"
+
+#include <stdint.h>
+
+/**
+ * Create a new startup store engine and start its background thread.
+ * The engine keeps the last stored data snapshot and calls the store callbacks only with the subtrees changed compared
+ * to the snapshot - a callback with a path is called once for each changed node selected by the path, with that node
+ * of the stored tree. If the node was removed, the callback gets its diff node instead, which has the yang:operation
+ * metadata set to delete. Callbacks without a path are called with the whole tree on every change. All submitted trees
+ * have to belong to a libyang context which outlives the engine.
+ *
+ * @param priv Private user data passed to the store callbacks - pass plugin context.
+ * @param stores Array of store callbacks - the array is copied.
+ * @param stores_count Number of store callbacks.
+ * @param coalesce_ms Time to wait for more submitted trees before storing - bursts of commits are stored only once.
+ *
+ * @return New engine, NULL on error.
+ */
+srpc_startup_store_engine_t *srpc_startup_store_engine_new(void *priv, const srpc_startup_store_t stores[],
+                                                           size_t stores_count, uint32_t coalesce_ms);
+
+/**
+ * Set the snapshot of already stored data without calling any store callbacks - use with the data loaded from the
+ * system on plugin startup, before submitting any data.
+ *
+ * @param engine Startup store engine.
+ * @param tree Data tree to duplicate and use as the snapshot, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_startup_store_engine_set_snapshot(srpc_startup_store_engine_t *engine, const struct lyd_node *tree);
+
+/**
+ * Submit new data for storing. The tree is duplicated and stored on the background thread - if a previously submitted
+ * tree hasn't been stored yet, it is replaced by the new one.
+ *
+ * @param engine Startup store engine.
+ * @param tree Complete data tree to store, can be NULL.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_startup_store_engine_submit(srpc_startup_store_engine_t *engine, const struct lyd_node *tree);
+
+/**
+ * Wait until all submitted data has been stored.
+ *
+ * @param engine Startup store engine.
+ *
+ * @return Error code of the stores done since the last flush - 0 on success.
+ */
+int srpc_startup_store_engine_flush(srpc_startup_store_engine_t *engine);
+
+/**
+ * Store all pending data, stop the background thread and free the engine.
+ *
+ * @param engine Startup store engine.
+ *
+ */
+void srpc_startup_store_engine_free(srpc_startup_store_engine_t **engine);
+
+#endif // SRPC_STARTUP_STORE_H
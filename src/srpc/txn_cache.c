@@ -0,0 +1,345 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "txn_cache.h"
+#include "common.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <uthash.h>
+
+typedef struct srpc_txn_cache_entry_s srpc_txn_cache_entry_t;
+
+/**
+ * Prepared data of a single transaction.
+ */
+struct srpc_txn_cache_entry_s
+{
+    char *key;                      ///< Key - module name, subscription ID and request ID.
+    void *data;                     ///< Prepared data.
+    srpc_txn_cache_free_cb free_cb; ///< Callback for freeing the data, can be NULL.
+    uint64_t created_ms;            ///< Time the data was stored.
+    srpc_txn_cache_entry_t *next;   ///< Next expired entry.
+    UT_hash_handle hh;              ///< UTHash reserved data.
+};
+
+/**
+ * Transaction cache.
+ */
+struct srpc_txn_cache_s
+{
+    uint32_t expire_ms;              ///< Expiry time of unclaimed entries, 0 for no expiry.
+    srpc_txn_cache_entry_t *entries; ///< Entries hashed by key.
+    pthread_mutex_t lock;            ///< Lock for the entries.
+};
+
+static char *txn_cache_key(const char *module_name, uint32_t sub_id, uint32_t request_id);
+static srpc_txn_cache_entry_t *txn_cache_expire(srpc_txn_cache_t *cache);
+static void txn_cache_entry_free(srpc_txn_cache_entry_t *entry);
+static uint64_t txn_cache_now_ms(void);
+
+/**
+ * Create a new transaction cache. Module change callbacks receive the same request ID for all events of a transaction
+ * - SR_EV_CHANGE puts the data prepared while iterating changes, SR_EV_DONE takes it and SR_EV_ABORT releases it.
+ * Entries are keyed by the subscription as well, so each srpc_module_change_t callback of a module has its own data.
+ * Entries of transactions which never got their done or abort event are freed after the expiry time.
+ *
+ * @param expire_ms Time after which unclaimed entries are freed - 0 to keep them until taken or released.
+ *
+ * @return New transaction cache, NULL on error.
+ */
+srpc_txn_cache_t *srpc_txn_cache_new(uint32_t expire_ms)
+{
+    srpc_txn_cache_t *cache = NULL;
+
+    SRPC_SAFE_CALL_PTR(cache, calloc(1, sizeof(*cache)), error_out);
+
+    cache->expire_ms = expire_ms;
+
+    if (pthread_mutex_init(&cache->lock, NULL) != 0)
+    {
+        goto error_out;
+    }
+
+    return cache;
+
+error_out:
+    free(cache);
+
+    return NULL;
+}
+
+/**
+ * Store prepared data for a transaction. Data already stored for the same transaction is freed and replaced.
+ * The cache takes ownership of the data, also on error.
+ *
+ * @param cache Transaction cache.
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ * @param data Prepared data.
+ * @param free_cb Callback for freeing the data - can be NULL if the data is not allocated.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_txn_cache_put(srpc_txn_cache_t *cache, const char *module_name, uint32_t sub_id, uint32_t request_id,
+                       void *data, srpc_txn_cache_free_cb free_cb)
+{
+    int error = 0;
+    srpc_txn_cache_entry_t *entry = NULL;
+    srpc_txn_cache_entry_t *replaced = NULL;
+    srpc_txn_cache_entry_t *expired = NULL;
+    char *key = NULL;
+
+    SRPC_SAFE_CALL_PTR(key, txn_cache_key(module_name, sub_id, request_id), error_out);
+    SRPC_SAFE_CALL_PTR(entry, calloc(1, sizeof(*entry)), error_out);
+
+    entry->key = key;
+    entry->data = data;
+    entry->free_cb = free_cb;
+    entry->created_ms = txn_cache_now_ms();
+    key = NULL;
+
+    pthread_mutex_lock(&cache->lock);
+
+    expired = txn_cache_expire(cache);
+
+    HASH_FIND_STR(cache->entries, entry->key, replaced);
+    if (replaced)
+    {
+        HASH_DEL(cache->entries, replaced);
+    }
+    HASH_ADD_KEYPTR(hh, cache->entries, entry->key, strlen(entry->key), entry);
+
+    pthread_mutex_unlock(&cache->lock);
+
+    // free outside of the lock - the data can be large
+    if (replaced)
+    {
+        txn_cache_entry_free(replaced);
+    }
+    while (expired)
+    {
+        entry = expired;
+        expired = expired->next;
+        txn_cache_entry_free(entry);
+    }
+
+    goto out;
+
+error_out:
+    free(key);
+    if (free_cb && data)
+    {
+        free_cb(data);
+    }
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Remove prepared data of a transaction from the cache and pass its ownership to the caller.
+ *
+ * @param cache Transaction cache.
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ *
+ * @return Prepared data, NULL if no data is stored for the transaction - recompute it from the changes.
+ */
+void *srpc_txn_cache_take(srpc_txn_cache_t *cache, const char *module_name, uint32_t sub_id, uint32_t request_id)
+{
+    srpc_txn_cache_entry_t *entry = NULL;
+    char *key = NULL;
+    void *data = NULL;
+
+    SRPC_SAFE_CALL_PTR(key, txn_cache_key(module_name, sub_id, request_id), out);
+
+    pthread_mutex_lock(&cache->lock);
+    HASH_FIND_STR(cache->entries, key, entry);
+    if (entry)
+    {
+        HASH_DEL(cache->entries, entry);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (entry)
+    {
+        data = entry->data;
+        entry->data = NULL;
+        txn_cache_entry_free(entry);
+    }
+
+out:
+    free(key);
+
+    return data;
+}
+
+/**
+ * Free prepared data of a transaction - use on SR_EV_ABORT.
+ *
+ * @param cache Transaction cache.
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ *
+ */
+void srpc_txn_cache_release(srpc_txn_cache_t *cache, const char *module_name, uint32_t sub_id, uint32_t request_id)
+{
+    srpc_txn_cache_entry_t *entry = NULL;
+    char *key = NULL;
+
+    SRPC_SAFE_CALL_PTR(key, txn_cache_key(module_name, sub_id, request_id), out);
+
+    pthread_mutex_lock(&cache->lock);
+    HASH_FIND_STR(cache->entries, key, entry);
+    if (entry)
+    {
+        HASH_DEL(cache->entries, entry);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    if (entry)
+    {
+        txn_cache_entry_free(entry);
+    }
+
+out:
+    free(key);
+}
+
+/**
+ * Free all stored data and the cache.
+ *
+ * @param cache Transaction cache.
+ *
+ */
+void srpc_txn_cache_free(srpc_txn_cache_t **cache)
+{
+    srpc_txn_cache_t *c = *cache;
+    srpc_txn_cache_entry_t *entry = NULL, *tmp = NULL;
+
+    if (!c)
+    {
+        return;
+    }
+
+    HASH_ITER(hh, c->entries, entry, tmp)
+    {
+        HASH_DEL(c->entries, entry);
+        txn_cache_entry_free(entry);
+    }
+
+    pthread_mutex_destroy(&c->lock);
+    free(c);
+
+    *cache = NULL;
+}
+
+/**
+ * Build the hash key of a transaction.
+ *
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ *
+ * @return Allocated key, NULL on error.
+ */
+static char *txn_cache_key(const char *module_name, uint32_t sub_id, uint32_t request_id)
+{
+    char *key = NULL;
+    size_t key_size = strlen(module_name) + 23;
+
+    key = malloc(key_size);
+    if (key)
+    {
+        snprintf(key, key_size, "%s#%u#%u", module_name, sub_id, request_id);
+    }
+
+    return key;
+}
+
+/**
+ * Remove entries which were not taken or released within the expiry time. Called with the cache lock held - the
+ * removed entries are freed by the caller after unlocking.
+ *
+ * @param cache Transaction cache.
+ *
+ * @return List of the removed entries linked by next, NULL if none expired.
+ */
+static srpc_txn_cache_entry_t *txn_cache_expire(srpc_txn_cache_t *cache)
+{
+    srpc_txn_cache_entry_t *entry = NULL, *tmp = NULL;
+    srpc_txn_cache_entry_t *expired = NULL;
+    uint64_t now = 0;
+
+    if (!cache->expire_ms)
+    {
+        return NULL;
+    }
+
+    now = txn_cache_now_ms();
+
+    HASH_ITER(hh, cache->entries, entry, tmp)
+    {
+        if (now - entry->created_ms >= cache->expire_ms)
+        {
+            SRPLG_LOG_ERR(SRPC_PLUGIN_NAME, "Prepared data of transaction \"%s\" expired", entry->key);
+            HASH_DEL(cache->entries, entry);
+            entry->next = expired;
+            expired = entry;
+        }
+    }
+
+    return expired;
+}
+
+/**
+ * Free an entry and its data.
+ *
+ * @param entry Entry to free.
+ *
+ */
+static void txn_cache_entry_free(srpc_txn_cache_entry_t *entry)
+{
+    if (entry->free_cb && entry->data)
+    {
+        entry->free_cb(entry->data);
+    }
+
+    free(entry->key);
+    free(entry);
+}
+
+/**
+ * Get the current time of the monotonic clock.
+ *
+ * @return Time in milliseconds.
+ */
+static uint64_t txn_cache_now_ms(void)
+{
+    struct timespec ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file txn_cache.h
+ * @brief API for keeping data prepared in the change event of a transaction until its done or abort event.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_TXN_CACHE_H
+#define SRPC_TXN_CACHE_H
+
+#include "types.h"
+
+#include <stdint.h>
+
+/**
+ * Create a new transaction cache. Module change callbacks receive the same request ID for all events of a transaction
+ * - SR_EV_CHANGE puts the data prepared while iterating changes, SR_EV_DONE takes it and SR_EV_ABORT releases it.
+ * Entries are keyed by the subscription as well, so each srpc_module_change_t callback of a module has its own data.
+ * Entries of transactions which never got their done or abort event are freed after the expiry time.
+ *
+ * @param expire_ms Time after which unclaimed entries are freed - 0 to keep them until taken or released.
+ *
+ * @return New transaction cache, NULL on error.
+ */
+srpc_txn_cache_t *srpc_txn_cache_new(uint32_t expire_ms);
+
+/**
+ * Store prepared data for a transaction. Data already stored for the same transaction is freed and replaced.
+ * The cache takes ownership of the data, also on error.
+ *
+ * @param cache Transaction cache.
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ * @param data Prepared data.
+ * @param free_cb Callback for freeing the data - can be NULL if the data is not allocated.
+ *
+ * @return Error code - 0 on success.
+ */
+int srpc_txn_cache_put(srpc_txn_cache_t *cache, const char *module_name, uint32_t sub_id, uint32_t request_id,
+                       void *data, srpc_txn_cache_free_cb free_cb);
+
+/**
+ * Remove prepared data of a transaction from the cache and pass its ownership to the caller.
+ *
+ * @param cache Transaction cache.
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ *
+ * @return Prepared data, NULL if no data is stored for the transaction - recompute it from the changes.
+ */
+void *srpc_txn_cache_take(srpc_txn_cache_t *cache, const char *module_name, uint32_t sub_id, uint32_t request_id);
+
+/**
+ * Free prepared data of a transaction - use on SR_EV_ABORT.
+ *
+ * @param cache Transaction cache.
+ * @param module_name Module name of the change subscription.
+ * @param sub_id Subscription ID passed to the change callback - all subscriptions of a module get the same request ID.
+ * @param request_id Request ID of the transaction.
+ *
+ */
+void srpc_txn_cache_release(srpc_txn_cache_t *cache, const char *module_name, uint32_t sub_id, uint32_t request_id);
+
+/**
+ * Free all stored data and the cache.
+ *
+ * @param cache Transaction cache.
+ *
+ */
+void srpc_txn_cache_free(srpc_txn_cache_t **cache);
+
+#endif // SRPC_TXN_CACHE_H
@@ -23,6 +23,8 @@
 #include <libyang/libyang.h>
 #include <sysrepo_types.h>
 
+#include <stdbool.h>
+
 typedef struct srpc_module_change_s srpc_module_change_t;
 typedef struct srpc_operational_s srpc_operational_t;
 typedef struct srpc_rpc_s srpc_rpc_t;
@@ -31,7 +33,35 @@ typedef struct srpc_startup_store_s srpc_startup_store_t;
 typedef struct srpc_node_s srpc_node_t;
 typedef struct srpc_change_ctx_s srpc_change_ctx_t;
 typedef struct srpc_key_value_pair_s srpc_key_value_pair_t;
+typedef struct srpc_ly_tree_gather_s srpc_ly_tree_gather_t;
 typedef struct srpc_feature_status_hash_s srpc_feature_status_hash_t;
+typedef struct srpc_startup_store_engine_s srpc_startup_store_engine_t;
+typedef struct srpc_check_result_s srpc_check_result_t;
+typedef struct srpc_oper_cache_s srpc_oper_cache_t;
+typedef struct srpc_oper_cache_stats_s srpc_oper_cache_stats_t;
+typedef struct srpc_collector_s srpc_collector_t;
+typedef struct srpc_collector_item_s srpc_collector_item_t;
+typedef struct srpc_xpath_filter_s srpc_xpath_filter_t;
+typedef struct srpc_file_reader_s srpc_file_reader_t;
+typedef struct srpc_exec_output_s srpc_exec_output_t;
+typedef struct srpc_exec_batch_s srpc_exec_batch_t;
+typedef struct srpc_debounce_s srpc_debounce_t;
+typedef struct srpc_txn_cache_s srpc_txn_cache_t;
+typedef struct srpc_change_set_s srpc_change_set_t;
+typedef struct srpc_change_view_s srpc_change_view_t;
+typedef struct srpc_edit_buffer_s srpc_edit_buffer_t;
+typedef struct srpc_edit_buffer_stats_s srpc_edit_buffer_stats_t;
+typedef struct srpc_mem_account_stats_s srpc_mem_account_stats_t;
+typedef struct srpc_file_writer_s srpc_file_writer_t;
+typedef struct srpc_file_writer_failure_s srpc_file_writer_failure_t;
+typedef struct srpc_shm_cache_s srpc_shm_cache_t;
+typedef struct srpc_notif_sender_s srpc_notif_sender_t;
+typedef struct srpc_notif_sender_stats_s srpc_notif_sender_stats_t;
+typedef struct srpc_session_pool_s srpc_session_pool_t;
+typedef struct srpc_session_pool_stats_s srpc_session_pool_stats_t;
+typedef struct srpc_backup_store_s srpc_backup_store_t;
+typedef struct srpc_change_journal_batch_s srpc_change_journal_batch_t;
+typedef struct srpc_change_journal_stats_s srpc_change_journal_stats_t;
 
 /**
  * Struct used to gather all module change callbacks based on a path.
@@ -70,6 +100,21 @@ typedef int (*srpc_startup_load_cb)(void *priv, sr_session_ctx_t *session, const
  * node. */
 typedef int (*srpc_startup_store_cb)(void *priv, const struct lyd_node *parent_node);
 
+/** Callback type for building a state subtree on the collector thread. The built tree is stored into tree. */
+typedef int (*srpc_collector_build_cb)(void *priv, const struct ly_ctx *ly_ctx, struct lyd_node **tree);
+
+/** Callback type for merging a newly enqueued intent into the pending intent of the same resource. */
+typedef int (*srpc_debounce_merge_cb)(void *priv, const char *resource, void *pending, const void *intent);
+
+/** Callback type for applying the merged intent of a resource to the system. */
+typedef int (*srpc_debounce_apply_cb)(void *priv, const char *resource, void *intent);
+
+/** Callback type for freeing an enqueued intent. */
+typedef void (*srpc_debounce_free_cb)(void *intent);
+
+/** Callback type for freeing prepared transaction data stored in the transaction cache. */
+typedef void (*srpc_txn_cache_free_cb)(void *data);
+
 /** Callback type for initializing changes callback data before iterating changes. */
 typedef int (*srpc_change_init_cb)(void *priv);
 
@@ -79,6 +124,9 @@ typedef void (*srpc_change_free_cb)(void *priv);
 /** Callback type for applying changes when using sr_get_change_tree_next() functionality. */
 typedef int (*srpc_change_cb)(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
 
+/** Callback type for iterating over the memory accounting statistics. */
+typedef void (*srpc_mem_account_stats_cb)(void *priv, const char *name, const srpc_mem_account_stats_t *stats);
+
 /** Callback used to allocate data for the new node. */
 typedef void *(*srpc_node_data_alloc_cb)(void);
 
@@ -98,6 +146,7 @@ struct srpc_startup_store_s
 {
     const char *name;         ///< Name of the value for which the callback is being called.
     srpc_startup_store_cb cb; ///< Store callback.
+    const char *path;         ///< Optional path of the stored subtrees - callback gets only the changed ones.
 };
 
 /**
@@ -109,6 +158,15 @@ struct srpc_startup_load_s
     srpc_startup_load_cb cb; ///< Load callback.
 };
 
+/**
+ * State subtree periodically rebuilt by the collector.
+ */
+struct srpc_collector_item_s
+{
+    const char *name;           ///< Name of the subtree - used for error messages.
+    srpc_collector_build_cb cb; ///< Build callback.
+};
+
 /**
  * Change context - operation, previous value etc.
  */
@@ -121,6 +179,15 @@ struct srpc_change_ctx_s
     sr_change_oper_t operation;  ///< Operation being applied on the node.
 };
 
+/**
+ * Filtered view of a change set - indices of the selected changes in their original order.
+ */
+struct srpc_change_view_s
+{
+    const size_t *indices; ///< Indices into the change set.
+    size_t count;          ///< Number of selected changes.
+};
+
 /**
  * List key/value pair - used for creating list elements.
  */
@@ -130,6 +197,16 @@ struct srpc_key_value_pair_s
     const char *value; ///< Value for the list key.
 };
 
+/**
+ * Child node lookup descriptor - used for gathering multiple child nodes at once.
+ */
+struct srpc_ly_tree_gather_s
+{
+    const char *name;   ///< Name of the child node.
+    uint16_t node_type; ///< Schema node type - LYS_CONTAINER, LYS_LIST etc.
+    size_t slot;        ///< Index of the output array entry to which the found node is stored.
+};
+
 /**
  * Used as return codes of the check API for particular YANG values (leafs, leaf-list or list).
  * The enum value is returned from a function which checks wether the value/values exist/exists on the system or not.
@@ -145,4 +222,121 @@ enum srpc_check_status_e
 
 typedef enum srpc_check_status_e srpc_check_status_t;
 
+/**
+ * Result of comparing datastore values with the values found on the system.
+ */
+struct srpc_check_result_s
+{
+    srpc_check_status_t status;                     ///< Overall comparison status.
+    const srpc_key_value_pair_t **missing;          ///< Datastore entries not found on the system.
+    size_t missing_count;                           ///< Number of missing entries.
+    const srpc_key_value_pair_t **differing;        ///< Datastore entries found on the system with a different value.
+    const srpc_key_value_pair_t **differing_system; ///< System entries matching the differing datastore entries.
+    size_t differing_count;                         ///< Number of differing entries.
+};
+
+/**
+ * Operational cache counters.
+ */
+struct srpc_oper_cache_stats_s
+{
+    uint64_t hits;          ///< Requests served from a fresh cache entry.
+    uint64_t stale_hits;    ///< Requests served from a stale cache entry while it was being refreshed.
+    uint64_t misses;        ///< Requests which called the operational callback.
+    uint64_t refreshes;     ///< Background refreshes of stale entries.
+    uint64_t invalidations; ///< Entries removed by explicit invalidation.
+};
+
+/**
+ * Output of an executed command - the buffer is reused between calls until freed.
+ */
+struct srpc_exec_output_s
+{
+    char *data;      ///< Captured stdout and stderr of the command, null terminated.
+    size_t len;      ///< Length of the captured output.
+    size_t size;     ///< Allocated size of the data buffer.
+    int exit_status; ///< Exit status of the command, -1 if it did not exit normally.
+    bool timed_out;  ///< The command was killed after reaching the timeout.
+};
+
+/**
+ * Edit buffer counters - a chunk is one tree submitted with a single sr_edit_batch() and sr_apply_changes().
+ */
+struct srpc_edit_buffer_stats_s
+{
+    uint64_t edits;         ///< Edits submitted to the datastore.
+    uint64_t chunks;        ///< Applied chunks.
+    uint64_t total_us;      ///< Time spent submitting and applying all chunks.
+    uint64_t last_chunk_us; ///< Time spent submitting and applying the last chunk.
+    uint64_t max_chunk_us;  ///< Longest time spent submitting and applying a chunk.
+};
+
+/**
+ * Memory accounting statistics of a named scope - usually a callback. Sizes are approximate, based on the libyang
+ * node structures and value strings.
+ */
+struct srpc_mem_account_stats_s
+{
+    uint64_t calls;       ///< Number of finished scopes.
+    uint64_t last_nodes;  ///< Nodes of the last scope.
+    uint64_t last_bytes;  ///< Bytes of the last scope.
+    uint64_t peak_nodes;  ///< Highest number of nodes of a single scope.
+    uint64_t peak_bytes;  ///< Highest number of bytes of a single scope.
+    uint64_t total_nodes; ///< Cumulative number of nodes of all scopes.
+    uint64_t total_bytes; ///< Cumulative number of bytes of all scopes.
+};
+
+/**
+ * Failed attribute write of a file writer flush.
+ */
+struct srpc_file_writer_failure_s
+{
+    const char *path;   ///< Path of the attribute.
+    const char *value;  ///< Value which was written.
+    const void *change; ///< Change which caused the write, as passed when queueing it.
+    int error;          ///< errno value of the failed operation.
+};
+
+/**
+ * Notification sender counters.
+ */
+struct srpc_notif_sender_stats_s
+{
+    uint64_t queued;    ///< Events queued.
+    uint64_t sent;      ///< Notifications sent.
+    uint64_t coalesced; ///< Events suppressed by a newer event of the same key.
+    uint64_t throttled; ///< Events delayed by the rate limit.
+    uint64_t failed;    ///< Notifications which failed to be built or sent.
+};
+
+/**
+ * Session pool counters - contention is a checkout which found no idle session and the pool at its maximal size.
+ */
+struct srpc_session_pool_stats_s
+{
+    uint64_t checkouts;   ///< Successful checkouts.
+    uint64_t created;     ///< Sessions started by the pool.
+    uint64_t contended;   ///< Checkouts which had to wait for a returned session.
+    uint64_t timeouts;    ///< Checkouts which gave up waiting.
+    uint64_t wait_us;     ///< Cumulative time spent waiting by contended checkouts.
+    uint64_t max_wait_us; ///< Longest time spent waiting by a single checkout.
+    size_t in_use;        ///< Sessions currently checked out.
+    size_t max_in_use;    ///< Highest number of sessions checked out at once.
+};
+
+/**
+ * Change journal replay counters - callback times are measured around the callbacks only, without rebuilding the
+ * changed nodes.
+ */
+struct srpc_change_journal_stats_s
+{
+    uint64_t batches;              ///< Replayed batches - one per recorded srpc_iterate_changes() call.
+    uint64_t changes;              ///< Changes passed to the callback.
+    uint64_t skipped;              ///< Changes whose node couldn't be rebuilt in the given context.
+    uint64_t failed;               ///< Batches aborted by a failed callback.
+    uint64_t callback_us;          ///< Cumulative time spent in the callback.
+    uint64_t max_callback_us;      ///< Longest single callback.
+    uint64_t recorded_callback_us; ///< Cumulative callback time of the replayed changes when they were recorded.
+};
+
 #endif // SRPC_TYPES_H
@@ -0,0 +1,527 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include "xpath_filter.h"
+#include "common.h"
+#include "ly_tree.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libyang/libyang.h>
+
+// Maximum depth of the checked data - deeper data is always reported as needed.
+#define SRPC_XPATH_FILTER_MAX_DEPTH 64
+
+typedef struct srpc_xpath_filter_pred_s srpc_xpath_filter_pred_t;
+typedef struct srpc_xpath_filter_step_s srpc_xpath_filter_step_t;
+
+/**
+ * Key predicate of a step - [key='value'].
+ */
+struct srpc_xpath_filter_pred_s
+{
+    char *key;   ///< Key name, "." for leaf-list values.
+    char *value; ///< Key value.
+};
+
+/**
+ * Single location step of the request xpath.
+ */
+struct srpc_xpath_filter_step_s
+{
+    char *module;                    ///< Module of the node - inherited from the previous steps, NULL if unknown.
+    char *name;                      ///< Node name, NULL for any node.
+    srpc_xpath_filter_pred_t *preds; ///< Key predicates.
+    size_t preds_count;              ///< Number of key predicates.
+};
+
+/**
+ * Request filter - parsed location steps.
+ */
+struct srpc_xpath_filter_s
+{
+    bool match_all;                  ///< Filter matches all data.
+    srpc_xpath_filter_step_t *steps; ///< Location steps.
+    size_t steps_count;              ///< Number of location steps.
+};
+
+static int xpath_filter_parse(srpc_xpath_filter_t *filter, const char *xpath);
+static int xpath_filter_parse_pred(srpc_xpath_filter_step_t *step, const char **ptr);
+static size_t xpath_filter_identifier(const char *str);
+static const char *xpath_filter_skip_pred(const char *str);
+static bool xpath_filter_step_match(const srpc_xpath_filter_step_t *step, const struct lysc_node *schema);
+
+/**
+ * Parse the request xpath received by sr_oper_get_items_cb into a filter.
+ * Only simple location paths with key predicates are used for filtering - unsupported predicates are ignored and
+ * unsupported expressions make the filter match everything, so the filter never drops requested data.
+ *
+ * @param request_xpath Request xpath, can be NULL.
+ *
+ * @return New filter, NULL on error.
+ */
+srpc_xpath_filter_t *srpc_xpath_filter_new(const char *request_xpath)
+{
+    srpc_xpath_filter_t *filter = NULL;
+
+    SRPC_SAFE_CALL_PTR(filter, calloc(1, sizeof(*filter)), error_out);
+
+    if (!request_xpath || xpath_filter_parse(filter, request_xpath) || !filter->steps_count)
+    {
+        filter->match_all = true;
+    }
+
+    return filter;
+
+error_out:
+    return NULL;
+}
+
+/**
+ * Check wether data of the schema node is needed for the request.
+ * Data is needed if the node is an ancestor of the requested data or if it is inside of the requested data.
+ *
+ * @param filter Request filter.
+ * @param schema Schema node of the data to collect.
+ * @param keys Key values of the list instance to collect - only used if the schema node is a list, can be NULL.
+ * @param keys_count Number of key values.
+ *
+ * @return Wether the data is needed.
+ */
+bool srpc_xpath_filter_check(const srpc_xpath_filter_t *filter, const struct lysc_node *schema,
+                             const srpc_key_value_pair_t keys[], size_t keys_count)
+{
+    const struct lysc_node *nodes[SRPC_XPATH_FILTER_MAX_DEPTH];
+    size_t depth = 0;
+
+    if (filter->match_all)
+    {
+        return true;
+    }
+
+    // collect data ancestors - choice and case nodes are not part of the data path
+    for (const struct lysc_node *iter = schema; iter; iter = iter->parent)
+    {
+        if (iter->nodetype & (LYS_CHOICE | LYS_CASE))
+        {
+            continue;
+        }
+        if (depth == SRPC_XPATH_FILTER_MAX_DEPTH)
+        {
+            return true;
+        }
+        nodes[depth++] = iter;
+    }
+
+    for (size_t i = 0; i < depth && i < filter->steps_count; i++)
+    {
+        const srpc_xpath_filter_step_t *step = &filter->steps[i];
+        const struct lysc_node *node = nodes[depth - 1 - i];
+
+        if (!xpath_filter_step_match(step, node))
+        {
+            return false;
+        }
+
+        // key values are known only for the checked node itself
+        if (i != depth - 1 || !(node->nodetype & (LYS_LIST | LYS_LEAFLIST)))
+        {
+            continue;
+        }
+
+        for (size_t j = 0; j < step->preds_count; j++)
+        {
+            for (size_t k = 0; k < keys_count; k++)
+            {
+                if (!strcmp(keys[k].key, step->preds[j].key) && keys[k].value &&
+                    strcmp(keys[k].value, step->preds[j].value))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Check wether the data node is needed for the request - key values of the node and all its parents are checked.
+ *
+ * @param filter Request filter.
+ * @param node Data node with its list keys already created.
+ *
+ * @return Wether the data is needed.
+ */
+bool srpc_xpath_filter_check_node(const srpc_xpath_filter_t *filter, const struct lyd_node *node)
+{
+    const struct lyd_node *nodes[SRPC_XPATH_FILTER_MAX_DEPTH];
+    const struct lyd_node *key = NULL;
+    const char *value = NULL;
+    size_t depth = 0;
+
+    if (filter->match_all)
+    {
+        return true;
+    }
+
+    for (const struct lyd_node *iter = node; iter; iter = lyd_parent(iter))
+    {
+        if (depth == SRPC_XPATH_FILTER_MAX_DEPTH || !iter->schema)
+        {
+            // too deep or opaque - unable to decide
+            return true;
+        }
+        nodes[depth++] = iter;
+    }
+
+    for (size_t i = 0; i < depth && i < filter->steps_count; i++)
+    {
+        const srpc_xpath_filter_step_t *step = &filter->steps[i];
+        const struct lyd_node *data = nodes[depth - 1 - i];
+
+        if (!xpath_filter_step_match(step, data->schema))
+        {
+            return false;
+        }
+
+        for (size_t j = 0; j < step->preds_count; j++)
+        {
+            value = NULL;
+            if (data->schema->nodetype == LYS_LEAFLIST && !strcmp(step->preds[j].key, "."))
+            {
+                value = lyd_get_value(data);
+            }
+            else if (data->schema->nodetype == LYS_LIST)
+            {
+                key = srpc_ly_tree_get_child_leaf(data, step->preds[j].key);
+                value = key ? lyd_get_value(key) : NULL;
+            }
+
+            if (value && strcmp(value, step->preds[j].value))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Free the filter.
+ *
+ * @param filter Request filter.
+ *
+ */
+void srpc_xpath_filter_free(srpc_xpath_filter_t **filter)
+{
+    srpc_xpath_filter_t *f = *filter;
+
+    if (!f)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < f->steps_count; i++)
+    {
+        for (size_t j = 0; j < f->steps[i].preds_count; j++)
+        {
+            free(f->steps[i].preds[j].key);
+            free(f->steps[i].preds[j].value);
+        }
+        free(f->steps[i].preds);
+        free(f->steps[i].module);
+        free(f->steps[i].name);
+    }
+
+    free(f->steps);
+    free(f);
+
+    *filter = NULL;
+}
+
+/**
+ * Parse the xpath location steps. Parsing stops on the first unsupported construct - the parsed steps are a prefix of
+ * the requested data so they still never filter out anything requested.
+ *
+ * @param filter Filter to fill.
+ * @param xpath Request xpath.
+ *
+ * @return Error code - 0 on success, unsupported xpaths are reported as an error.
+ */
+static int xpath_filter_parse(srpc_xpath_filter_t *filter, const char *xpath)
+{
+    int error = 0;
+    const char *ptr = xpath;
+    const char *module = NULL;
+    size_t module_len = 0;
+    size_t len = 0;
+    char quote = 0;
+    srpc_xpath_filter_step_t *steps = NULL;
+    srpc_xpath_filter_step_t *step = NULL;
+
+    // unions select unrelated data - no filtering
+    for (const char *iter = xpath; *iter; iter++)
+    {
+        if (quote)
+        {
+            quote = *iter == quote ? 0 : quote;
+        }
+        else if (*iter == '\'' || *iter == '"')
+        {
+            quote = *iter;
+        }
+        else if (*iter == '|')
+        {
+            goto error_out;
+        }
+    }
+
+    while (*ptr == '/' && ptr[1] != '/')
+    {
+        ++ptr;
+
+        if (*ptr == '*')
+        {
+            len = 1;
+        }
+        else if (!(len = xpath_filter_identifier(ptr)))
+        {
+            break;
+        }
+
+        if (ptr[len] == ':')
+        {
+            // module prefix - valid for this and all following steps
+            module = ptr;
+            module_len = len;
+            ptr += len + 1;
+            if (*ptr == '*')
+            {
+                len = 1;
+            }
+            else if (!(len = xpath_filter_identifier(ptr)))
+            {
+                break;
+            }
+        }
+
+        SRPC_SAFE_CALL_PTR(steps, realloc(filter->steps, (filter->steps_count + 1) * sizeof(*steps)), error_out);
+        filter->steps = steps;
+        step = &filter->steps[filter->steps_count++];
+        memset(step, 0, sizeof(*step));
+
+        if (module)
+        {
+            SRPC_SAFE_CALL_PTR(step->module, strndup(module, module_len), error_out);
+        }
+        if (*ptr != '*')
+        {
+            SRPC_SAFE_CALL_PTR(step->name, strndup(ptr, len), error_out);
+        }
+        ptr += len;
+
+        while (*ptr == '[')
+        {
+            SRPC_SAFE_CALL_ERR(error, xpath_filter_parse_pred(step, &ptr), error_out);
+        }
+    }
+
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Parse a single predicate - key predicates are added to the step, other predicates are skipped.
+ *
+ * @param step Step to add the predicate to.
+ * @param ptr Pointer to the opening bracket - moved behind the predicate.
+ *
+ * @return Error code - 0 on success.
+ */
+static int xpath_filter_parse_pred(srpc_xpath_filter_step_t *step, const char **ptr)
+{
+    int error = 0;
+    const char *iter = *ptr + 1;
+    const char *key = NULL;
+    const char *value = NULL;
+    size_t key_len = 0;
+    size_t value_len = 0;
+    const char *end = NULL;
+    srpc_xpath_filter_pred_t *preds = NULL;
+
+    while (isspace((unsigned char)*iter))
+    {
+        ++iter;
+    }
+
+    key = iter;
+    key_len = *iter == '.' ? 1 : xpath_filter_identifier(iter);
+    iter += key_len;
+
+    while (isspace((unsigned char)*iter))
+    {
+        ++iter;
+    }
+
+    if (!key_len || *iter != '=')
+    {
+        goto skip;
+    }
+    ++iter;
+
+    while (isspace((unsigned char)*iter))
+    {
+        ++iter;
+    }
+
+    if (*iter != '\'' && *iter != '"')
+    {
+        goto skip;
+    }
+
+    value = iter + 1;
+    end = strchr(value, *iter);
+    if (!end)
+    {
+        goto skip;
+    }
+    value_len = (size_t)(end - value);
+    iter = end + 1;
+
+    while (isspace((unsigned char)*iter))
+    {
+        ++iter;
+    }
+
+    if (*iter != ']')
+    {
+        // compound predicate - not a simple key match
+        goto skip;
+    }
+
+    SRPC_SAFE_CALL_PTR(preds, realloc(step->preds, (step->preds_count + 1) * sizeof(*preds)), error_out);
+    step->preds = preds;
+    preds[step->preds_count].key = NULL;
+    preds[step->preds_count].value = NULL;
+    ++step->preds_count;
+
+    SRPC_SAFE_CALL_PTR(preds[step->preds_count - 1].key, strndup(key, key_len), error_out);
+    SRPC_SAFE_CALL_PTR(preds[step->preds_count - 1].value, strndup(value, value_len), error_out);
+
+    *ptr = iter + 1;
+    goto out;
+
+skip:
+    *ptr = xpath_filter_skip_pred(*ptr);
+    goto out;
+
+error_out:
+    error = -1;
+
+out:
+    return error;
+}
+
+/**
+ * Get length of the YANG identifier at the start of the string.
+ *
+ * @param str String to check.
+ *
+ * @return Identifier length, 0 if there is no identifier.
+ */
+static size_t xpath_filter_identifier(const char *str)
+{
+    size_t len = 0;
+
+    if (!isalpha((unsigned char)*str) && *str != '_')
+    {
+        return 0;
+    }
+
+    while (isalnum((unsigned char)str[len]) || str[len] == '_' || str[len] == '-' || str[len] == '.')
+    {
+        ++len;
+    }
+
+    return len;
+}
+
+/**
+ * Skip a predicate including nested predicates and quoted strings.
+ *
+ * @param str Pointer to the opening bracket.
+ *
+ * @return Pointer behind the closing bracket or to the string end.
+ */
+static const char *xpath_filter_skip_pred(const char *str)
+{
+    size_t level = 0;
+    char quote = 0;
+
+    for (; *str; str++)
+    {
+        if (quote)
+        {
+            quote = *str == quote ? 0 : quote;
+        }
+        else if (*str == '\'' || *str == '"')
+        {
+            quote = *str;
+        }
+        else if (*str == '[')
+        {
+            ++level;
+        }
+        else if (*str == ']' && !--level)
+        {
+            return str + 1;
+        }
+    }
+
+    return str;
+}
+
+/**
+ * Check wether the step matches the schema node.
+ *
+ * @param step Location step.
+ * @param schema Schema node.
+ *
+ * @return Wether the step matches.
+ */
+static bool xpath_filter_step_match(const srpc_xpath_filter_step_t *step, const struct lysc_node *schema)
+{
+    if (step->name && strcmp(step->name, schema->name))
+    {
+        return false;
+    }
+
+    if (step->module && strcmp(step->module, schema->module->name))
+    {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file xpath_filter.h
+ * @brief API for pruning operational data collection based on the request xpath.
+ *
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#ifndef SRPC_XPATH_FILTER_H
+#define SRPC_XPATH_FILTER_H
+
+#include "types.h"
+
+#include <stdbool.h>
+
+/**
+ * Parse the request xpath received by sr_oper_get_items_cb into a filter.
+ * Only simple location paths with key predicates are used for filtering - unsupported predicates are ignored and
+ * unsupported expressions make the filter match everything, so the filter never drops requested data.
+ *
+ * @param request_xpath Request xpath, can be NULL.
+ *
+ * @return New filter, NULL on error.
+ */
+srpc_xpath_filter_t *srpc_xpath_filter_new(const char *request_xpath);
+
+/**
+ * Check wether data of the schema node is needed for the request.
+ * Data is needed if the node is an ancestor of the requested data or if it is inside of the requested data.
+ *
+ * @param filter Request filter.
+ * @param schema Schema node of the data to collect.
+ * @param keys Key values of the list instance to collect - only used if the schema node is a list, can be NULL.
+ * @param keys_count Number of key values.
+ *
+ * @return Wether the data is needed.
+ */
+bool srpc_xpath_filter_check(const srpc_xpath_filter_t *filter, const struct lysc_node *schema,
+                             const srpc_key_value_pair_t keys[], size_t keys_count);
+
+/**
+ * Check wether the data node is needed for the request - key values of the node and all its parents are checked.
+ *
+ * @param filter Request filter.
+ * @param node Data node with its list keys already created.
+ *
+ * @return Wether the data is needed.
+ */
+bool srpc_xpath_filter_check_node(const srpc_xpath_filter_t *filter, const struct lyd_node *node);
+
+/**
+ * Free the filter.
+ *
+ * @param filter Request filter.
+ *
+ */
+void srpc_xpath_filter_free(srpc_xpath_filter_t **filter);
+
+#endif // SRPC_XPATH_FILTER_H
@@ -47,4 +47,328 @@ target_link_libraries(
 	${CMAKE_PROJECT_NAME}
 )
 
-add_test(NAME test_feature_status COMMAND test_feature_status)
\ No newline at end of file
+add_test(NAME test_feature_status COMMAND test_feature_status)
+
+# check
+add_executable(
+	test_check
+
+	test/test_check.c
+)
+
+target_link_libraries(
+	test_check
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_check COMMAND test_check)
+
+# xpath_filter
+add_executable(
+	test_xpath_filter
+
+	test/test_xpath_filter.c
+)
+
+target_link_libraries(
+	test_xpath_filter
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_xpath_filter COMMAND test_xpath_filter)
+
+# test_file_reader
+add_executable(
+	test_file_reader
+
+	test/test_file_reader.c
+)
+
+target_link_libraries(
+	test_file_reader
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_file_reader COMMAND test_file_reader)
+
+# test_common
+add_executable(
+	test_common
+
+	test/test_common.c
+)
+
+target_link_libraries(
+	test_common
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_common COMMAND test_common)
+
+# test_debounce
+add_executable(
+	test_debounce
+
+	test/test_debounce.c
+)
+
+target_link_libraries(
+	test_debounce
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_debounce COMMAND test_debounce)
+
+# test_txn_cache
+add_executable(
+	test_txn_cache
+
+	test/test_txn_cache.c
+)
+
+target_link_libraries(
+	test_txn_cache
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_txn_cache COMMAND test_txn_cache)
+
+# test_snapshot
+add_executable(
+	test_snapshot
+
+	test/test_snapshot.c
+)
+
+target_link_libraries(
+	test_snapshot
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_snapshot COMMAND test_snapshot)
+
+# test_intern
+add_executable(
+	test_intern
+
+	test/test_intern.c
+)
+
+target_link_libraries(
+	test_intern
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_intern COMMAND test_intern)
+
+# test_mem_account
+add_executable(
+	test_mem_account
+
+	test/test_mem_account.c
+)
+
+target_link_libraries(
+	test_mem_account
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_mem_account COMMAND test_mem_account)
+
+# test_file_writer
+add_executable(
+	test_file_writer
+
+	test/test_file_writer.c
+)
+
+target_link_libraries(
+	test_file_writer
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_file_writer COMMAND test_file_writer)
+
+# test_shm_cache
+add_executable(
+	test_shm_cache
+
+	test/test_shm_cache.c
+)
+
+target_link_libraries(
+	test_shm_cache
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_shm_cache COMMAND test_shm_cache)
+
+# test_backup_store
+add_executable(
+	test_backup_store
+
+	test/test_backup_store.c
+)
+
+target_link_libraries(
+	test_backup_store
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_backup_store COMMAND test_backup_store)
+
+# test_change_journal
+add_executable(
+	test_change_journal
+
+	test/test_change_journal.c
+)
+
+target_link_libraries(
+	test_change_journal
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_change_journal COMMAND test_change_journal)
+
+# test_startup_store
+add_executable(
+	test_startup_store
+
+	test/test_startup_store.c
+)
+
+target_link_libraries(
+	test_startup_store
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_startup_store COMMAND test_startup_store)
+
+# test_notif_sender
+add_executable(
+	test_notif_sender
+
+	test/test_notif_sender.c
+)
+
+target_link_libraries(
+	test_notif_sender
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_notif_sender COMMAND test_notif_sender)
+
+# test_oper_cache
+add_executable(
+	test_oper_cache
+
+	test/test_oper_cache.c
+)
+
+target_link_libraries(
+	test_oper_cache
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_oper_cache COMMAND test_oper_cache)
+
+# test_collector
+add_executable(
+	test_collector
+
+	test/test_collector.c
+)
+
+target_link_libraries(
+	test_collector
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_collector COMMAND test_collector)
+
+# test_session_pool
+add_executable(
+	test_session_pool
+
+	test/test_session_pool.c
+)
+
+target_link_libraries(
+	test_session_pool
+
+	${CMOCKA_LIBRARIES}
+	${SYSREPO_LIBRARIES}
+	${LIBYANG_LIBRARIES}
+	${CMAKE_PROJECT_NAME}
+)
+
+add_test(NAME test_session_pool COMMAND test_session_pool)
\ No newline at end of file
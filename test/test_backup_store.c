@@ -0,0 +1,414 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static void test_backup_store_dedup(void **state);
+static void test_backup_store_restore(void **state);
+static void test_backup_store_retention(void **state);
+static void test_backup_store_gc(void **state);
+static void test_backup_store_processes(void **state);
+static int backup_changes(const char *root, const char *path, int count);
+static void write_file(const char *path, const char *content);
+static void read_file(const char *path, char *buffer, size_t size);
+static size_t count_blobs(const char *root);
+static void remove_store(const char *root);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_backup_store_dedup),
+        cmocka_unit_test(test_backup_store_restore),
+        cmocka_unit_test(test_backup_store_retention),
+        cmocka_unit_test(test_backup_store_gc),
+        cmocka_unit_test(test_backup_store_processes),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_backup_store_dedup(void **state)
+{
+    (void)state;
+
+    char root[] = "/tmp/srpc_backup_store_XXXXXX";
+    char path1[] = "/tmp/srpc_backup_file_XXXXXX";
+    char path2[] = "/tmp/srpc_backup_file_XXXXXX";
+    srpc_backup_store_t *store = NULL;
+    uint64_t generation = 0;
+    uint64_t *generations = NULL;
+    size_t generations_count = 0;
+
+    assert_non_null(mkdtemp(root));
+    close(mkstemp(path1));
+    close(mkstemp(path2));
+
+    store = srpc_backup_store_new(root, 0);
+    assert_non_null(store);
+
+    // never backed up
+    assert_int_equal(srpc_backup_store_generations(store, path1, &generations, &generations_count), 0);
+    assert_null(generations);
+    assert_int_equal(generations_count, 0);
+
+    write_file(path1, "nameserver 192.168.1.1\n");
+    assert_int_equal(srpc_backup_store_backup(store, path1, &generation), 0);
+    assert_int_equal(generation, 1);
+
+    // unchanged content keeps the generation
+    assert_int_equal(srpc_backup_store_backup(store, path1, &generation), 0);
+    assert_int_equal(generation, 1);
+
+    write_file(path1, "nameserver 10.0.0.1\n");
+    assert_int_equal(srpc_backup_store_backup(store, path1, &generation), 0);
+    assert_int_equal(generation, 2);
+    assert_int_equal(count_blobs(root), 2);
+
+    // the same content of another path is stored once
+    write_file(path2, "nameserver 10.0.0.1\n");
+    assert_int_equal(srpc_backup_store_backup(store, path2, &generation), 0);
+    assert_int_equal(generation, 1);
+    assert_int_equal(count_blobs(root), 2);
+
+    // back to older content
+    write_file(path1, "nameserver 192.168.1.1\n");
+    assert_int_equal(srpc_backup_store_backup(store, path1, &generation), 0);
+    assert_int_equal(generation, 3);
+    assert_int_equal(count_blobs(root), 2);
+
+    assert_int_equal(srpc_backup_store_generations(store, path1, &generations, &generations_count), 0);
+    assert_int_equal(generations_count, 3);
+    assert_int_equal(generations[0], 1);
+    assert_int_equal(generations[1], 2);
+    assert_int_equal(generations[2], 3);
+    free(generations);
+
+    srpc_backup_store_free(&store);
+    assert_null(store);
+
+    // generations are kept by the store directory
+    store = srpc_backup_store_new(root, 0);
+    assert_non_null(store);
+    assert_int_equal(srpc_backup_store_backup(store, path1, &generation), 0);
+    assert_int_equal(generation, 3);
+    srpc_backup_store_free(&store);
+
+    unlink(path1);
+    unlink(path2);
+    remove_store(root);
+}
+
+static void test_backup_store_restore(void **state)
+{
+    (void)state;
+
+    char root[] = "/tmp/srpc_backup_store_XXXXXX";
+    char path[] = "/tmp/srpc_backup_file_XXXXXX";
+    srpc_backup_store_t *store = NULL;
+    struct stat st = {0};
+    char buffer[64] = {0};
+
+    assert_non_null(mkdtemp(root));
+    close(mkstemp(path));
+
+    store = srpc_backup_store_new(root, 0);
+    assert_non_null(store);
+
+    // nothing to restore yet
+    assert_int_equal(srpc_backup_store_restore(store, path, 0), 1);
+
+    write_file(path, "first");
+    chmod(path, 0640);
+    assert_int_equal(srpc_backup_store_backup(store, path, NULL), 0);
+
+    write_file(path, "second");
+    chmod(path, 0600);
+    assert_int_equal(srpc_backup_store_backup(store, path, NULL), 0);
+
+    write_file(path, "broken");
+    chmod(path, 0666);
+
+    assert_int_equal(srpc_backup_store_restore(store, path, 0), 0);
+    read_file(path, buffer, sizeof(buffer));
+    assert_string_equal(buffer, "second");
+    assert_int_equal(stat(path, &st), 0);
+    assert_int_equal(st.st_mode & 07777, 0600);
+
+    assert_int_equal(srpc_backup_store_restore(store, path, 1), 0);
+    read_file(path, buffer, sizeof(buffer));
+    assert_string_equal(buffer, "first");
+    assert_int_equal(stat(path, &st), 0);
+    assert_int_equal(st.st_mode & 07777, 0640);
+
+    // restoring doesn't touch the stored content
+    write_file(path, "changed");
+    assert_int_equal(srpc_backup_store_restore(store, path, 1), 0);
+    read_file(path, buffer, sizeof(buffer));
+    assert_string_equal(buffer, "first");
+
+    assert_int_equal(srpc_backup_store_restore(store, path, 5), 1);
+
+    srpc_backup_store_free(&store);
+
+    unlink(path);
+    remove_store(root);
+}
+
+static void test_backup_store_retention(void **state)
+{
+    (void)state;
+
+    char root[] = "/tmp/srpc_backup_store_XXXXXX";
+    char path[] = "/tmp/srpc_backup_file_XXXXXX";
+    srpc_backup_store_t *store = NULL;
+    uint64_t generation = 0;
+    uint64_t *generations = NULL;
+    size_t generations_count = 0;
+    char content[16] = {0};
+
+    assert_non_null(mkdtemp(root));
+    close(mkstemp(path));
+
+    store = srpc_backup_store_new(root, 2);
+    assert_non_null(store);
+
+    for (int i = 0; i < 5; i++)
+    {
+        snprintf(content, sizeof(content), "mtu %d", 1500 + i);
+        write_file(path, content);
+        assert_int_equal(srpc_backup_store_backup(store, path, &generation), 0);
+        assert_int_equal(generation, i + 1);
+    }
+
+    // only the last generations and their blobs are kept
+    assert_int_equal(srpc_backup_store_generations(store, path, &generations, &generations_count), 0);
+    assert_int_equal(generations_count, 2);
+    assert_int_equal(generations[0], 4);
+    assert_int_equal(generations[1], 5);
+    free(generations);
+
+    assert_int_equal(count_blobs(root), 2);
+    assert_int_equal(srpc_backup_store_restore(store, path, 1), 1);
+
+    srpc_backup_store_free(&store);
+
+    unlink(path);
+    remove_store(root);
+}
+
+static void test_backup_store_gc(void **state)
+{
+    (void)state;
+
+    char root[] = "/tmp/srpc_backup_store_XXXXXX";
+    char path[] = "/tmp/srpc_backup_file_XXXXXX";
+    char blob_path[256] = {0};
+    srpc_backup_store_t *store = NULL;
+    struct timespec old[2] = {0};
+
+    assert_non_null(mkdtemp(root));
+    close(mkstemp(path));
+    write_file(path, "mtu 1500");
+
+    store = srpc_backup_store_new(root, 0);
+    assert_non_null(store);
+    assert_int_equal(srpc_backup_store_backup(store, path, NULL), 0);
+
+    // unreferenced blob, temporary copy in progress and one left over by an interrupted backup
+    snprintf(blob_path, sizeof(blob_path), "%s/blobs/0123456789abcdef-0644", root);
+    write_file(blob_path, "mtu 9000");
+    snprintf(blob_path, sizeof(blob_path), "%s/blobs/tmp.1.1", root);
+    write_file(blob_path, "mtu 1280");
+    snprintf(blob_path, sizeof(blob_path), "%s/blobs/tmp.1.2", root);
+    write_file(blob_path, "mtu 1280");
+    old[0].tv_sec = old[1].tv_sec = time(NULL) - 2 * 3600;
+    assert_int_equal(utimensat(AT_FDCWD, blob_path, old, 0), 0);
+    assert_int_equal(count_blobs(root), 4);
+
+    // the referenced blob and the copy in progress are kept
+    assert_int_equal(srpc_backup_store_gc(store), 0);
+    assert_int_equal(count_blobs(root), 2);
+    snprintf(blob_path, sizeof(blob_path), "%s/blobs/tmp.1.1", root);
+    assert_int_equal(access(blob_path, F_OK), 0);
+
+    srpc_backup_store_free(&store);
+
+    unlink(path);
+    remove_store(root);
+}
+
+static void test_backup_store_processes(void **state)
+{
+    (void)state;
+
+    char root[] = "/tmp/srpc_backup_store_XXXXXX";
+    char path1[] = "/tmp/srpc_backup_file_XXXXXX";
+    char path2[] = "/tmp/srpc_backup_file_XXXXXX";
+    pid_t pid = 0;
+    int status = 0;
+
+    assert_non_null(mkdtemp(root));
+    close(mkstemp(path1));
+    close(mkstemp(path2));
+
+    // stores of two processes on the same directory - each garbage collection runs while the other one backs up
+    pid = fork();
+    if (!pid)
+    {
+        _exit(backup_changes(root, path1, 200));
+    }
+    assert_true(pid > 0);
+
+    assert_int_equal(backup_changes(root, path2, 200), 0);
+
+    assert_int_equal(waitpid(pid, &status, 0), pid);
+    assert_true(WIFEXITED(status));
+    assert_int_equal(WEXITSTATUS(status), 0);
+
+    // a single generation of each path is kept
+    assert_int_equal(count_blobs(root), 2);
+
+    unlink(path1);
+    unlink(path2);
+    remove_store(root);
+}
+
+static int backup_changes(const char *root, const char *path, int count)
+{
+    srpc_backup_store_t *store = srpc_backup_store_new(root, 1);
+    char content[32] = {0};
+    int error = store ? 0 : 1;
+
+    for (int i = 0; i < count && !error; i++)
+    {
+        snprintf(content, sizeof(content), "%s %d", path, i);
+        write_file(path, content);
+        error = srpc_backup_store_backup(store, path, NULL) ? 1 : 0;
+    }
+
+    srpc_backup_store_free(&store);
+
+    return error;
+}
+
+static void write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+
+    assert_non_null(file);
+    fputs(content, file);
+    fclose(file);
+}
+
+static void read_file(const char *path, char *buffer, size_t size)
+{
+    FILE *file = fopen(path, "r");
+    size_t len = 0;
+
+    assert_non_null(file);
+    len = fread(buffer, 1, size - 1, file);
+    buffer[len] = 0;
+    fclose(file);
+}
+
+static size_t count_blobs(const char *root)
+{
+    char path[256] = {0};
+    DIR *dir = NULL;
+    struct dirent *entry = NULL;
+    size_t count = 0;
+
+    snprintf(path, sizeof(path), "%s/blobs", root);
+    dir = opendir(path);
+    assert_non_null(dir);
+
+    while ((entry = readdir(dir)))
+    {
+        if (entry->d_name[0] != '.')
+        {
+            count++;
+        }
+    }
+
+    closedir(dir);
+
+    return count;
+}
+
+static void remove_store(const char *root)
+{
+    char path[512] = {0};
+    const char *subdirs[] = {"blobs", "generations"};
+    DIR *dir = NULL;
+    DIR *generation_dir = NULL;
+    struct dirent *entry = NULL;
+    struct dirent *generation_entry = NULL;
+    char generation_path[768] = {0};
+
+    for (size_t i = 0; i < sizeof(subdirs) / sizeof(subdirs[0]); i++)
+    {
+        snprintf(path, sizeof(path), "%s/%s", root, subdirs[i]);
+        dir = opendir(path);
+        assert_non_null(dir);
+
+        while ((entry = readdir(dir)))
+        {
+            if (entry->d_name[0] == '.')
+            {
+                continue;
+            }
+
+            snprintf(generation_path, sizeof(generation_path), "%s/%s", path, entry->d_name);
+
+            // generations are directories per path
+            generation_dir = opendir(generation_path);
+            if (generation_dir)
+            {
+                while ((generation_entry = readdir(generation_dir)))
+                {
+                    if (generation_entry->d_name[0] != '.')
+                    {
+                        unlinkat(dirfd(generation_dir), generation_entry->d_name, 0);
+                    }
+                }
+                closedir(generation_dir);
+                rmdir(generation_path);
+            }
+            else
+            {
+                unlink(generation_path);
+            }
+        }
+
+        closedir(dir);
+        rmdir(path);
+    }
+
+    rmdir(root);
+}
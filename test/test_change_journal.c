@@ -0,0 +1,312 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+// Maximal number of changes seen by the test callback.
+#define TEST_CHANGES_MAX 8
+
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  container system {"
+                                 "    leaf hostname { type string; }"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+static const char *journal_path = "/tmp/srpc_test_change_journal";
+
+/**
+ * Changes seen by the test callback.
+ */
+typedef struct
+{
+    size_t count;
+    size_t fail_at;
+    sr_change_oper_t operations[TEST_CHANGES_MAX];
+    char *paths[TEST_CHANGES_MAX];
+    char *values[TEST_CHANGES_MAX];
+    char *previous_values[TEST_CHANGES_MAX];
+    int previous_defaults[TEST_CHANGES_MAX];
+} test_changes_t;
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_change_journal_record_replay(void **state);
+static void test_change_journal_failed_callback(void **state);
+static void test_change_journal_paced(void **state);
+static void test_change_journal_corrupted(void **state);
+static void record_changes(const struct ly_ctx *ly_ctx);
+static int change_cb(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx);
+static void changes_free(test_changes_t *changes);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_change_journal_record_replay),
+        cmocka_unit_test(test_change_journal_failed_callback),
+        cmocka_unit_test(test_change_journal_paced),
+        cmocka_unit_test(test_change_journal_corrupted),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+    unlink(journal_path);
+
+    return 0;
+}
+
+static void test_change_journal_record_replay(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    test_changes_t changes = {0};
+    srpc_change_journal_stats_t stats = {0};
+
+    record_changes(ly_ctx);
+
+    // nothing is recorded after the journal stopped
+    assert_null(srpc_change_journal_batch_begin("/test:system"));
+
+    assert_int_equal(srpc_change_journal_replay(ly_ctx, journal_path, NULL, false, &changes, NULL, change_cb, NULL,
+                                                NULL, &stats),
+                     0);
+
+    assert_int_equal(stats.batches, 2);
+    assert_int_equal(stats.changes, 4);
+    assert_int_equal(stats.skipped, 0);
+    assert_int_equal(stats.failed, 0);
+    assert_int_equal(changes.count, 4);
+
+    assert_int_equal(changes.operations[0], SR_OP_MODIFIED);
+    assert_string_equal(changes.paths[0], "/test:system/hostname");
+    assert_string_equal(changes.values[0], "router");
+    assert_string_equal(changes.previous_values[0], "switch");
+    assert_int_equal(changes.previous_defaults[0], 1);
+
+    assert_int_equal(changes.operations[1], SR_OP_CREATED);
+    assert_string_equal(changes.paths[1], "/test:system/server[address='10.0.0.1']");
+    assert_null(changes.values[1]);
+
+    assert_int_equal(changes.operations[2], SR_OP_CREATED);
+    assert_string_equal(changes.paths[2], "/test:system/server[address='10.0.0.1']/address");
+    assert_string_equal(changes.values[2], "10.0.0.1");
+
+    assert_int_equal(changes.operations[3], SR_OP_DELETED);
+    assert_string_equal(changes.paths[3], "/test:system/server[address='10.0.0.1']/port");
+    assert_string_equal(changes.values[3], "53");
+    assert_null(changes.previous_values[3]);
+
+    changes_free(&changes);
+
+    // only the batches of the given xpath
+    assert_int_equal(srpc_change_journal_replay(ly_ctx, journal_path, "/test:system/server", false, &changes, NULL,
+                                                change_cb, NULL, NULL, &stats),
+                     0);
+    assert_int_equal(stats.batches, 1);
+    assert_int_equal(changes.count, 3);
+    assert_int_equal(changes.operations[0], SR_OP_CREATED);
+
+    changes_free(&changes);
+}
+
+static void test_change_journal_failed_callback(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    test_changes_t changes = {.fail_at = 2};
+    srpc_change_journal_stats_t stats = {0};
+
+    record_changes(ly_ctx);
+
+    // the failed callback aborts its batch only
+    assert_int_equal(srpc_change_journal_replay(ly_ctx, journal_path, NULL, false, &changes, NULL, change_cb, NULL,
+                                                NULL, &stats),
+                     0);
+    assert_int_equal(stats.batches, 2);
+    assert_int_equal(stats.changes, 2);
+    assert_int_equal(stats.failed, 1);
+
+    changes_free(&changes);
+}
+
+static void test_change_journal_paced(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    test_changes_t changes = {0};
+    srpc_change_journal_stats_t stats = {0};
+    struct timespec begin = {0}, end = {0};
+    long elapsed_ms = 0;
+
+    // the batches are recorded 50 ms apart
+    record_changes(ly_ctx);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    assert_int_equal(srpc_change_journal_replay(ly_ctx, journal_path, NULL, true, &changes, NULL, change_cb, NULL,
+                                                NULL, &stats),
+                     0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    elapsed_ms = (end.tv_sec - begin.tv_sec) * 1000 + (end.tv_nsec - begin.tv_nsec) / 1000000;
+    assert_true(elapsed_ms >= 45);
+    assert_int_equal(stats.changes, 4);
+
+    changes_free(&changes);
+}
+
+static void test_change_journal_corrupted(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    test_changes_t changes = {0};
+    FILE *file = NULL;
+    long size = 0;
+
+    record_changes(ly_ctx);
+
+    // cut the last batch
+    file = fopen(journal_path, "r+");
+    assert_non_null(file);
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fclose(file);
+    assert_int_equal(truncate(journal_path, size - 3), 0);
+
+    assert_int_equal(srpc_change_journal_replay(ly_ctx, journal_path, NULL, false, &changes, NULL, change_cb, NULL,
+                                                NULL, NULL),
+                     -1);
+    changes_free(&changes);
+
+    assert_int_equal(srpc_change_journal_replay(ly_ctx, "/tmp/srpc_test_change_journal_missing", NULL, false,
+                                                &changes, NULL, change_cb, NULL, NULL, NULL),
+                     -1);
+}
+
+static void record_changes(const struct ly_ctx *ly_ctx)
+{
+    struct lyd_node *system = NULL, *hostname = NULL, *server = NULL, *address = NULL, *port = NULL;
+    srpc_change_journal_batch_t *batch = NULL;
+    test_changes_t recorded = {0};
+    srpc_change_ctx_t change_ctx = {0};
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, &hostname, "hostname", "router"), 0);
+    assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", "10.0.0.1"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, &port, "port", "53"), 0);
+    assert_int_equal(lyd_find_path(server, "address", 0, &address), LY_SUCCESS);
+
+    assert_int_equal(srpc_change_journal_start(journal_path), 0);
+
+    // a second journal can't be started meanwhile
+    assert_int_equal(srpc_change_journal_start(journal_path), -1);
+
+    batch = srpc_change_journal_batch_begin("/test:system/hostname");
+    assert_non_null(batch);
+    change_ctx = (srpc_change_ctx_t){
+        .node = hostname,
+        .operation = SR_OP_MODIFIED,
+        .previous_value = "switch",
+        .previous_default = 1,
+    };
+    assert_int_equal(srpc_change_journal_batch_call(batch, &recorded, NULL, change_cb, &change_ctx), 0);
+    srpc_change_journal_batch_end(&batch);
+    assert_null(batch);
+
+    usleep(50000);
+
+    batch = srpc_change_journal_batch_begin("/test:system/server");
+    assert_non_null(batch);
+    change_ctx = (srpc_change_ctx_t){.node = server, .operation = SR_OP_CREATED};
+    assert_int_equal(srpc_change_journal_batch_call(batch, &recorded, NULL, change_cb, &change_ctx), 0);
+    change_ctx = (srpc_change_ctx_t){.node = address, .operation = SR_OP_CREATED};
+    assert_int_equal(srpc_change_journal_batch_call(batch, &recorded, NULL, change_cb, &change_ctx), 0);
+    change_ctx = (srpc_change_ctx_t){.node = port, .operation = SR_OP_DELETED};
+    assert_int_equal(srpc_change_journal_batch_call(batch, &recorded, NULL, change_cb, &change_ctx), 0);
+    srpc_change_journal_batch_end(&batch);
+
+    srpc_change_journal_stop();
+
+    assert_int_equal(recorded.count, 4);
+    changes_free(&recorded);
+
+    lyd_free_all(system);
+}
+
+static int change_cb(void *priv, sr_session_ctx_t *session, const srpc_change_ctx_t *change_ctx)
+{
+    (void)session;
+
+    test_changes_t *changes = priv;
+    const char *value = lyd_get_value(change_ctx->node);
+    size_t i = changes->count++;
+
+    assert_true(i < TEST_CHANGES_MAX);
+
+    changes->operations[i] = change_ctx->operation;
+    changes->paths[i] = lyd_path(change_ctx->node, LYD_PATH_STD, NULL, 0);
+    changes->values[i] = value ? strdup(value) : NULL;
+    changes->previous_values[i] = change_ctx->previous_value ? strdup(change_ctx->previous_value) : NULL;
+    changes->previous_defaults[i] = change_ctx->previous_default;
+
+    return changes->fail_at && changes->count == changes->fail_at ? -1 : 0;
+}
+
+static void changes_free(test_changes_t *changes)
+{
+    for (size_t i = 0; i < changes->count; i++)
+    {
+        free(changes->paths[i]);
+        free(changes->values[i]);
+        free(changes->previous_values[i]);
+    }
+
+    *changes = (test_changes_t){.fail_at = changes->fail_at};
+}
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+#define LARGE_COUNT 100000
+
+static void test_check_status(void **state);
+static void test_check_key_only(void **state);
+static void test_check_large(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_check_status),
+        cmocka_unit_test(test_check_key_only),
+        cmocka_unit_test(test_check_large),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_check_status(void **state)
+{
+    (void)state;
+
+    const srpc_key_value_pair_t datastore[] = {
+        {"1.1.1.1", "53"},
+        {"8.8.8.8", "53"},
+        {"9.9.9.9", NULL},
+    };
+    const srpc_key_value_pair_t system_equal[] = {
+        {"9.9.9.9", NULL},
+        {"8.8.8.8", "53"},
+        {"1.1.1.1", "53"},
+    };
+    const srpc_key_value_pair_t system_partial[] = {
+        {"8.8.8.8", "5353"},
+        {"1.1.1.1", "53"},
+    };
+    const srpc_key_value_pair_t system_other[] = {
+        {"4.4.4.4", "53"},
+    };
+    srpc_check_result_t result;
+
+    assert_int_equal(srpc_check_values(datastore, 0, system_equal, 3, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_none);
+    srpc_check_result_free(&result);
+
+    assert_int_equal(srpc_check_values(datastore, 3, system_equal, 3, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_equal);
+    assert_int_equal(result.missing_count, 0);
+    assert_int_equal(result.differing_count, 0);
+    srpc_check_result_free(&result);
+
+    assert_int_equal(srpc_check_values(datastore, 3, system_partial, 2, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_partial);
+    assert_int_equal(result.missing_count, 1);
+    assert_ptr_equal(result.missing[0], &datastore[2]);
+    assert_int_equal(result.differing_count, 1);
+    assert_ptr_equal(result.differing[0], &datastore[1]);
+    assert_ptr_equal(result.differing_system[0], &system_partial[0]);
+    srpc_check_result_free(&result);
+
+    assert_int_equal(srpc_check_values(datastore, 3, system_other, 1, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_non_existant);
+    assert_int_equal(result.missing_count, 3);
+    srpc_check_result_free(&result);
+
+    assert_int_equal(srpc_check_values(datastore, 3, NULL, 0, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_non_existant);
+    srpc_check_result_free(&result);
+}
+
+static void test_check_key_only(void **state)
+{
+    (void)state;
+
+    const srpc_key_value_pair_t datastore[] = {
+        {"example.com", NULL},
+        {"eth0", "up"},
+    };
+    const srpc_key_value_pair_t system[] = {
+        {"example.com", "1"},
+        {"eth0", NULL},
+    };
+    srpc_check_result_t result;
+
+    // a NULL datastore value matches any system value, a NULL system value doesn't match a datastore value
+    assert_int_equal(srpc_check_values(datastore, 1, system, 2, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_equal);
+    srpc_check_result_free(&result);
+
+    assert_int_equal(srpc_check_values(datastore, 2, system, 2, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_partial);
+    assert_int_equal(result.missing_count, 0);
+    assert_int_equal(result.differing_count, 1);
+    assert_ptr_equal(result.differing[0], &datastore[1]);
+    assert_ptr_equal(result.differing_system[0], &system[1]);
+    srpc_check_result_free(&result);
+}
+
+static void test_check_large(void **state)
+{
+    (void)state;
+
+    static char keys[LARGE_COUNT][16];
+    static srpc_key_value_pair_t datastore[LARGE_COUNT];
+    static srpc_key_value_pair_t system[LARGE_COUNT];
+    srpc_check_result_t result;
+
+    for (size_t i = 0; i < LARGE_COUNT; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "eth%zu", i);
+        datastore[i] = (srpc_key_value_pair_t){keys[i], "up"};
+
+        // system entries in reverse order, last one differs
+        system[LARGE_COUNT - 1 - i] = (srpc_key_value_pair_t){keys[i], i == LARGE_COUNT - 1 ? "down" : "up"};
+    }
+
+    assert_int_equal(srpc_check_values(datastore, LARGE_COUNT, system, LARGE_COUNT, &result), 0);
+    assert_int_equal(result.status, srpc_check_status_partial);
+    assert_int_equal(result.missing_count, 0);
+    assert_int_equal(result.differing_count, 1);
+    assert_ptr_equal(result.differing[0], &datastore[LARGE_COUNT - 1]);
+    srpc_check_result_free(&result);
+}
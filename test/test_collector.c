@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  container system {"
+                                 "    leaf hostname { type string; }"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+// only the operation annotation of ietf-netconf is needed - the full module is installed by sysrepo
+static const char *netconf_module = "module ietf-netconf {"
+                                    "  namespace \"urn:ietf:params:xml:ns:netconf:base:1.0\";"
+                                    "  prefix nc;"
+                                    "  import ietf-yang-metadata { prefix md; }"
+                                    "  md:annotation operation {"
+                                    "    type enumeration {"
+                                    "      enum merge; enum replace; enum create; enum delete; enum remove;"
+                                    "    }"
+                                    "  }"
+                                    "}";
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_collector_diff_to_edit(void **state);
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx, const char *servers[][2], size_t servers_count);
+static const char *node_operation(const struct lyd_node *node);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_collector_diff_to_edit),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS ||
+        lys_parse_mem(ly_ctx, netconf_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static void test_collector_diff_to_edit(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const char *old_servers[][2] = {{"10.0.0.1", "53"}, {"10.0.0.2", "53"}};
+    const char *new_servers[][2] = {{"10.0.0.1", "5353"}, {"10.0.0.3", "53"}};
+    struct lyd_node *old = NULL, *new = NULL, *diff = NULL, *node = NULL, *elem = NULL;
+
+    old = create_system(ly_ctx, old_servers, 2);
+    new = create_system(ly_ctx, new_servers, 2);
+    assert_int_equal(lyd_diff_siblings(old, new, 0, &diff), LY_SUCCESS);
+    assert_non_null(diff);
+
+    assert_int_equal(srpc_collector_diff_to_edit(ly_ctx, diff), 0);
+
+    // no diff metadata is left - only removed nodes carry an operation
+    LYD_TREE_DFS_BEGIN(diff, elem)
+    {
+        assert_null(lyd_find_meta(elem->meta, NULL, "yang:operation"));
+        assert_null(lyd_find_meta(elem->meta, NULL, "yang:orig-value"));
+        LYD_TREE_DFS_END(diff, elem);
+    }
+
+    // deleted entry is removed, identified by its key only
+    assert_int_equal(lyd_find_path(diff, "/test:system/server[address='10.0.0.2']", 0, &node), LY_SUCCESS);
+    assert_string_equal(node_operation(node), "remove");
+    assert_int_equal(lyd_find_path(node, "port", 0, &elem), LY_ENOTFOUND);
+
+    // changed and created nodes are merged
+    assert_int_equal(lyd_find_path(diff, "/test:system/server[address='10.0.0.1']", 0, &node), LY_SUCCESS);
+    assert_null(node_operation(node));
+    assert_int_equal(lyd_find_path(node, "port", 0, &node), LY_SUCCESS);
+    assert_null(node_operation(node));
+    assert_string_equal(lyd_get_value(node), "5353");
+
+    assert_int_equal(lyd_find_path(diff, "/test:system/server[address='10.0.0.3']", 0, &node), LY_SUCCESS);
+    assert_null(node_operation(node));
+    assert_int_equal(lyd_find_path(node, "port", 0, &node), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(node), "53");
+
+    // unchanged data is not part of the edit
+    assert_int_equal(lyd_find_path(diff, "/test:system/hostname", 0, &node), LY_ENOTFOUND);
+
+    lyd_free_all(diff);
+    lyd_free_all(new);
+    lyd_free_all(old);
+}
+
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx, const char *servers[][2], size_t servers_count)
+{
+    struct lyd_node *system = NULL, *server = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", "router"), 0);
+
+    for (size_t i = 0; i < servers_count; i++)
+    {
+        assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", servers[i][0]), 0);
+        assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, NULL, "port", servers[i][1]), 0);
+    }
+
+    return system;
+}
+
+static const char *node_operation(const struct lyd_node *node)
+{
+    struct lyd_meta *operation = lyd_find_meta(node->meta, NULL, "ietf-netconf:operation");
+
+    return operation ? lyd_get_meta_value(operation) : NULL;
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static void test_exec(void **state);
+static void test_exec_timeout(void **state);
+static void test_exec_batch(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_exec),
+        cmocka_unit_test(test_exec_timeout),
+        cmocka_unit_test(test_exec_batch),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_exec(void **state)
+{
+    (void)state;
+
+    const char *echo_argv[] = {"echo", "hello", NULL};
+    const char *cat_argv[] = {"cat", NULL};
+    const char *fail_argv[] = {"sh", "-c", "echo error >&2; exit 3", NULL};
+    const char *missing_argv[] = {"/nonexistent/srpc/command", NULL};
+    srpc_exec_output_t output = {0};
+
+    assert_int_equal(srpc_exec(echo_argv, NULL, 0, 1000, &output), 0);
+    assert_string_equal(output.data, "hello\n");
+    assert_int_equal(output.exit_status, 0);
+
+    assert_int_equal(srpc_exec(cat_argv, "input data", 10, 1000, &output), 0);
+    assert_string_equal(output.data, "input data");
+    assert_int_equal(output.len, 10);
+
+    assert_int_not_equal(srpc_exec(fail_argv, NULL, 0, 1000, &output), 0);
+    assert_string_equal(output.data, "error\n");
+    assert_int_equal(output.exit_status, 3);
+    assert_false(output.timed_out);
+
+    assert_int_not_equal(srpc_exec(missing_argv, NULL, 0, 1000, &output), 0);
+
+    srpc_exec_output_free(&output);
+    assert_null(output.data);
+}
+
+static void test_exec_timeout(void **state)
+{
+    (void)state;
+
+    const char *sleep_argv[] = {"sleep", "10", NULL};
+    srpc_exec_output_t output = {0};
+
+    assert_int_not_equal(srpc_exec(sleep_argv, NULL, 0, 100, &output), 0);
+    assert_true(output.timed_out);
+
+    srpc_exec_output_free(&output);
+}
+
+static void test_exec_batch(void **state)
+{
+    (void)state;
+
+    const char *wc_argv[] = {"wc", "-l", NULL};
+    srpc_exec_batch_t *batch = NULL;
+    srpc_exec_output_t output = {0};
+
+    batch = srpc_exec_batch_new(wc_argv);
+    assert_non_null(batch);
+
+    // empty batch is not executed
+    assert_int_equal(srpc_exec_batch_run(batch, 1000, &output), 0);
+    assert_int_equal(output.len, 0);
+
+    for (int i = 0; i < 200; i++)
+    {
+        assert_int_equal(srpc_exec_batch_add(batch, "link set dev eth%d up", i), 0);
+    }
+    assert_int_equal(srpc_exec_batch_count(batch), 200);
+
+    assert_int_equal(srpc_exec_batch_run(batch, 1000, &output), 0);
+    assert_int_equal(atoi(output.data), 200);
+    assert_int_equal(srpc_exec_batch_count(batch), 0);
+
+    srpc_exec_batch_free(&batch);
+    assert_null(batch);
+    srpc_exec_output_free(&output);
+}
@@ -0,0 +1,244 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+typedef struct test_apply_s
+{
+    int applies;              ///< Number of apply callback calls.
+    int sum;                  ///< Sum of all applied intents.
+    int failures;             ///< Number of applies which fail before the applies succeed.
+    srpc_debounce_t *requeue; ///< Debouncer to which an intent of 5 is enqueued by failing applies, can be NULL.
+} test_apply_t;
+
+static void test_debounce_coalesce(void **state);
+static void test_debounce_flush(void **state);
+static void test_debounce_latest_wins(void **state);
+static void test_debounce_retry(void **state);
+static void test_debounce_retry_merge(void **state);
+static void test_debounce_retry_limit(void **state);
+static int merge_sum(void *priv, const char *resource, void *pending, const void *intent);
+static int apply_sum(void *priv, const char *resource, void *intent);
+static int *new_intent(int value);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_debounce_coalesce),
+        cmocka_unit_test(test_debounce_flush),
+        cmocka_unit_test(test_debounce_latest_wins),
+        cmocka_unit_test(test_debounce_retry),
+        cmocka_unit_test(test_debounce_retry_merge),
+        cmocka_unit_test(test_debounce_retry_limit),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_debounce_coalesce(void **state)
+{
+    (void)state;
+
+    test_apply_t result = {0};
+    srpc_debounce_t *debounce = srpc_debounce_new(&result, 50, 1000, merge_sum, apply_sum, free);
+
+    assert_non_null(debounce);
+
+    for (int i = 1; i <= 10; i++)
+    {
+        assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(i)), 0);
+    }
+
+    // wait for the quiet period to pass
+    for (int i = 0; i < 100 && srpc_debounce_pending_count(debounce); i++)
+    {
+        usleep(10 * 1000);
+    }
+    assert_int_equal(srpc_debounce_pending_count(debounce), 0);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), 0);
+
+    assert_int_equal(result.applies, 1);
+    assert_int_equal(result.sum, 55);
+
+    srpc_debounce_free(&debounce);
+    assert_null(debounce);
+}
+
+static void test_debounce_flush(void **state)
+{
+    (void)state;
+
+    test_apply_t result = {0};
+    srpc_debounce_t *debounce = srpc_debounce_new(&result, 10000, 10000, merge_sum, apply_sum, free);
+
+    assert_non_null(debounce);
+
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(1)), 0);
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth1", new_intent(2)), 0);
+    assert_int_equal(srpc_debounce_pending_count(debounce), 2);
+
+    assert_int_equal(srpc_debounce_flush(debounce, "eth1"), 0);
+    assert_int_equal(result.applies, 1);
+    assert_int_equal(result.sum, 2);
+    assert_int_equal(srpc_debounce_pending_count(debounce), 1);
+
+    // pending intents are applied on free
+    srpc_debounce_free(&debounce);
+    assert_int_equal(result.applies, 2);
+    assert_int_equal(result.sum, 3);
+}
+
+static void test_debounce_latest_wins(void **state)
+{
+    (void)state;
+
+    test_apply_t result = {0};
+    srpc_debounce_t *debounce = srpc_debounce_new(&result, 10000, 10000, NULL, apply_sum, free);
+
+    assert_non_null(debounce);
+
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(1)), 0);
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(7)), 0);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), 0);
+
+    assert_int_equal(result.applies, 1);
+    assert_int_equal(result.sum, 7);
+
+    srpc_debounce_free(&debounce);
+}
+
+static void test_debounce_retry(void **state)
+{
+    (void)state;
+
+    test_apply_t result = {.failures = 1};
+    srpc_debounce_t *debounce = srpc_debounce_new(&result, 10, 1000, merge_sum, apply_sum, free);
+
+    assert_non_null(debounce);
+
+    // the failed intent stays pending and is retried by the timer thread
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(1)), 0);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), -1);
+    assert_int_equal(srpc_debounce_pending_count(debounce), 1);
+
+    for (int i = 0; i < 100 && srpc_debounce_pending_count(debounce); i++)
+    {
+        usleep(10 * 1000);
+    }
+    assert_int_equal(srpc_debounce_pending_count(debounce), 0);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), 0);
+
+    assert_int_equal(result.applies, 2);
+    assert_int_equal(result.sum, 1);
+
+    srpc_debounce_free(&debounce);
+}
+
+static void test_debounce_retry_merge(void **state)
+{
+    (void)state;
+
+    test_apply_t result = {.failures = 1};
+    srpc_debounce_t *debounce = srpc_debounce_new(&result, 10000, 10000, merge_sum, apply_sum, free);
+
+    assert_non_null(debounce);
+    result.requeue = debounce;
+
+    // an intent enqueued while the apply fails is merged into the failed one
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(1)), 0);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), -1);
+    assert_int_equal(srpc_debounce_pending_count(debounce), 1);
+
+    // as is an intent enqueued after the failure
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(2)), 0);
+    assert_int_equal(srpc_debounce_flush(debounce, "eth0"), 0);
+
+    assert_int_equal(result.applies, 2);
+    assert_int_equal(result.sum, 8);
+    assert_int_equal(srpc_debounce_pending_count(debounce), 0);
+
+    srpc_debounce_free(&debounce);
+}
+
+static void test_debounce_retry_limit(void **state)
+{
+    (void)state;
+
+    test_apply_t result = {.failures = 100};
+    srpc_debounce_t *debounce = srpc_debounce_new(&result, 1, 1000, merge_sum, apply_sum, free);
+
+    assert_non_null(debounce);
+
+    assert_int_equal(srpc_debounce_enqueue(debounce, "eth0", new_intent(1)), 0);
+
+    for (int i = 0; i < 100 && srpc_debounce_pending_count(debounce); i++)
+    {
+        usleep(10 * 1000);
+    }
+
+    // dropped after the first apply and 5 retries
+    assert_int_equal(srpc_debounce_pending_count(debounce), 0);
+    assert_int_equal(result.applies, 6);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), -1);
+    assert_int_equal(srpc_debounce_flush(debounce, NULL), 0);
+
+    srpc_debounce_free(&debounce);
+}
+
+static int merge_sum(void *priv, const char *resource, void *pending, const void *intent)
+{
+    *(int *)pending += *(const int *)intent;
+
+    return 0;
+}
+
+static int apply_sum(void *priv, const char *resource, void *intent)
+{
+    test_apply_t *result = priv;
+
+    result->applies++;
+
+    if (result->failures)
+    {
+        result->failures--;
+        if (result->requeue)
+        {
+            assert_int_equal(srpc_debounce_enqueue(result->requeue, resource, new_intent(5)), 0);
+        }
+        return -1;
+    }
+
+    result->sum += *(int *)intent;
+
+    return 0;
+}
+
+static int *new_intent(int value)
+{
+    int *intent = malloc(sizeof(*intent));
+
+    assert_non_null(intent);
+    *intent = value;
+
+    return intent;
+}
@@ -0,0 +1,165 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static void test_file_reader_read(void **state);
+static void test_file_reader_batch(void **state);
+static void write_file(const char *path, const char *content);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_file_reader_read),
+        cmocka_unit_test(test_file_reader_batch),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_file_reader_read(void **state)
+{
+    (void)state;
+
+    char path[] = "/tmp/srpc_file_reader_XXXXXX";
+    srpc_file_reader_t *reader = NULL;
+    size_t id = 0, same_id = 0;
+    const char *data = NULL;
+    size_t len = 0;
+    uint64_t value = 0;
+    int64_t signed_value = 0;
+    char *large = NULL;
+
+    close(mkstemp(path));
+    write_file(path, "1234\n");
+
+    reader = srpc_file_reader_new();
+    assert_non_null(reader);
+
+    assert_int_equal(srpc_file_reader_add(reader, path, &id), 0);
+    assert_int_equal(srpc_file_reader_add(reader, path, &same_id), 0);
+    assert_int_equal(id, same_id);
+
+    assert_int_equal(srpc_file_reader_read(reader, id, &data, &len), 0);
+    assert_string_equal(data, "1234\n");
+    assert_int_equal(len, 5);
+
+    assert_int_equal(srpc_file_reader_read_uint64(reader, id, &value), 0);
+    assert_int_equal(value, 1234);
+
+    // decimal even with leading zeros, hexadecimal only on request
+    write_file(path, "010\n");
+    assert_int_equal(srpc_file_reader_read_uint64(reader, id, &value), 0);
+    assert_int_equal(value, 10);
+    assert_int_equal(srpc_file_reader_read_int64(reader, id, &signed_value), 0);
+    assert_int_equal(signed_value, 10);
+    assert_int_equal(srpc_file_reader_read_hex64(reader, id, &value), 0);
+    assert_int_equal(value, 16);
+    write_file(path, "0x1003\n");
+    assert_int_not_equal(srpc_file_reader_read_uint64(reader, id, &value), 0);
+    assert_int_not_equal(srpc_file_reader_read_int64(reader, id, &signed_value), 0);
+    assert_int_equal(srpc_file_reader_read_hex64(reader, id, &value), 0);
+    assert_int_equal(value, 0x1003);
+
+    // content changes are visible through the kept descriptor
+    write_file(path, "-42\n");
+    assert_int_equal(srpc_file_reader_read_int64(reader, id, &signed_value), 0);
+    assert_int_equal(signed_value, -42);
+    assert_int_not_equal(srpc_file_reader_read_uint64(reader, id, &value), 0);
+
+    // larger than the initial buffer
+    large = malloc(10000);
+    assert_non_null(large);
+    memset(large, 'a', 9999);
+    large[9999] = 0;
+    write_file(path, large);
+    assert_int_equal(srpc_file_reader_read(reader, id, &data, &len), 0);
+    assert_int_equal(len, 9999);
+    assert_string_equal(data, large);
+
+    // exactly fills the initial buffer
+    large[4095] = 0;
+    write_file(path, large);
+    assert_int_equal(srpc_file_reader_read(reader, id, &data, &len), 0);
+    assert_int_equal(len, 4095);
+    assert_string_equal(data, large);
+    free(large);
+
+    srpc_file_reader_remove(reader, id);
+    assert_int_not_equal(srpc_file_reader_read(reader, id, &data, &len), 0);
+
+    assert_int_not_equal(srpc_file_reader_add(reader, "/nonexistent/srpc/file", &id), 0);
+
+    srpc_file_reader_free(&reader);
+    assert_null(reader);
+
+    unlink(path);
+}
+
+static void test_file_reader_batch(void **state)
+{
+    (void)state;
+
+    char paths[3][32] = {"/tmp/srpc_file_reader_XXXXXX", "/tmp/srpc_file_reader_XXXXXX",
+                         "/tmp/srpc_file_reader_XXXXXX"};
+    const char *contents[3] = {"10\n", "020\n", "0x20\n"};
+    srpc_file_reader_t *reader = NULL;
+    size_t ids[3] = {0};
+    uint64_t values[3] = {0};
+    int errors[3] = {0};
+
+    reader = srpc_file_reader_new();
+    assert_non_null(reader);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        close(mkstemp(paths[i]));
+        write_file(paths[i], contents[i]);
+        assert_int_equal(srpc_file_reader_add(reader, paths[i], &ids[i]), 0);
+    }
+
+    assert_int_equal(srpc_file_reader_read_batch(reader, ids, values, errors, 3), 1);
+    assert_int_equal(values[0], 10);
+    assert_int_equal(values[1], 20);
+    assert_int_equal(values[2], 0);
+    assert_int_equal(errors[0], 0);
+    assert_int_equal(errors[1], 0);
+    assert_int_not_equal(errors[2], 0);
+
+    srpc_file_reader_free(&reader);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        unlink(paths[i]);
+    }
+}
+
+static void write_file(const char *path, const char *content)
+{
+    FILE *file = fopen(path, "w");
+
+    assert_non_null(file);
+    assert_int_equal(fputs(content, file) >= 0, 1);
+    fclose(file);
+}
@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static void test_file_writer_flush(void **state);
+static void test_file_writer_many(void **state);
+static void test_file_writer_order(void **state);
+static void read_file(const char *path, char *buffer, size_t size);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_file_writer_flush),
+        cmocka_unit_test(test_file_writer_many),
+        cmocka_unit_test(test_file_writer_order),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_file_writer_flush(void **state)
+{
+    (void)state;
+
+    char path1[] = "/tmp/srpc_file_writer_XXXXXX";
+    char path2[] = "/tmp/srpc_file_writer_XXXXXX";
+    const char *missing = "/tmp/srpc_file_writer_missing/mtu";
+    int change1 = 0, change2 = 0, change3 = 0;
+    srpc_file_writer_t *writer = NULL;
+    const srpc_file_writer_failure_t *failures = NULL;
+    size_t failures_count = 0;
+    char buffer[64] = {0};
+
+    close(mkstemp(path1));
+    close(mkstemp(path2));
+
+    writer = srpc_file_writer_new();
+    assert_non_null(writer);
+
+    assert_int_equal(srpc_file_writer_add(writer, path1, "1500", &change1), 0);
+    assert_int_equal(srpc_file_writer_add(writer, missing, "1", &change2), 0);
+    assert_int_equal(srpc_file_writer_addf(writer, path2, &change3, "%d", 64), 0);
+    assert_int_equal(srpc_file_writer_count(writer), 3);
+
+    // the failed write is mapped to its change, the others are done
+    assert_int_equal(srpc_file_writer_flush(writer, &failures, &failures_count), -1);
+    assert_int_equal(failures_count, 1);
+    assert_ptr_equal(failures[0].change, &change2);
+    assert_string_equal(failures[0].path, missing);
+    assert_string_equal(failures[0].value, "1");
+    assert_int_equal(failures[0].error, ENOENT);
+    assert_int_equal(srpc_file_writer_count(writer), 0);
+
+    read_file(path1, buffer, sizeof(buffer));
+    assert_string_equal(buffer, "1500");
+    read_file(path2, buffer, sizeof(buffer));
+    assert_string_equal(buffer, "64");
+
+    // the writer is reusable after a flush
+    assert_int_equal(srpc_file_writer_add(writer, path1, "9000", &change1), 0);
+    assert_int_equal(srpc_file_writer_flush(writer, &failures, &failures_count), 0);
+    assert_int_equal(failures_count, 0);
+    read_file(path1, buffer, sizeof(buffer));
+    assert_string_equal(buffer, "9000");
+
+    // nothing queued
+    assert_int_equal(srpc_file_writer_flush(writer, NULL, NULL), 0);
+
+    srpc_file_writer_free(&writer);
+    assert_null(writer);
+
+    unlink(path1);
+    unlink(path2);
+}
+
+static void test_file_writer_many(void **state)
+{
+    (void)state;
+
+    // more writes than fit into a single submission
+    char paths[100][32];
+    srpc_file_writer_t *writer = NULL;
+    char buffer[64] = {0};
+    char expected[16] = {0};
+
+    writer = srpc_file_writer_new();
+    assert_non_null(writer);
+
+    for (int i = 0; i < 100; i++)
+    {
+        strcpy(paths[i], "/tmp/srpc_file_writer_XXXXXX");
+        close(mkstemp(paths[i]));
+        assert_int_equal(srpc_file_writer_addf(writer, paths[i], NULL, "%d", i), 0);
+    }
+
+    assert_int_equal(srpc_file_writer_flush(writer, NULL, NULL), 0);
+
+    for (int i = 0; i < 100; i++)
+    {
+        snprintf(expected, sizeof(expected), "%d", i);
+        read_file(paths[i], buffer, sizeof(buffer));
+        assert_string_equal(buffer, expected);
+        unlink(paths[i]);
+    }
+
+    srpc_file_writer_free(&writer);
+}
+
+static void test_file_writer_order(void **state)
+{
+    (void)state;
+
+    char path[] = "/tmp/srpc_file_writer_XXXXXX";
+    srpc_file_writer_t *writer = NULL;
+    char buffer[64] = {0};
+
+    close(mkstemp(path));
+
+    writer = srpc_file_writer_new();
+    assert_non_null(writer);
+
+    // repeated writes of the same attribute are applied in the queue order, the last one wins
+    for (int round = 0; round < 20; round++)
+    {
+        assert_int_equal(srpc_file_writer_add(writer, path, "1280", NULL), 0);
+        assert_int_equal(srpc_file_writer_add(writer, path, "1500", NULL), 0);
+        assert_int_equal(srpc_file_writer_add(writer, path, "9000", NULL), 0);
+        assert_int_equal(srpc_file_writer_flush(writer, NULL, NULL), 0);
+
+        read_file(path, buffer, sizeof(buffer));
+        assert_string_equal(buffer, "9000");
+    }
+
+    srpc_file_writer_free(&writer);
+
+    unlink(path);
+}
+
+static void read_file(const char *path, char *buffer, size_t size)
+{
+    FILE *file = fopen(path, "r");
+    size_t len = 0;
+
+    assert_non_null(file);
+    len = fread(buffer, 1, size - 1, file);
+    buffer[len] = 0;
+    fclose(file);
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static void test_intern_equal(void **state);
+static void test_intern_refcount(void **state);
+static void test_intern_many(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_intern_equal),
+        cmocka_unit_test(test_intern_refcount),
+        cmocka_unit_test(test_intern_many),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_intern_equal(void **state)
+{
+    (void)state;
+
+    char buffer[] = "eth0";
+    const char *s1 = srpc_intern("eth0");
+    const char *s2 = srpc_intern(buffer);
+    const char *s3 = srpc_intern_len("eth0.100", 4);
+    const char *other = srpc_intern("eth1");
+
+    assert_non_null(s1);
+    assert_string_equal(s1, "eth0");
+    assert_ptr_equal(s1, s2);
+    assert_ptr_equal(s1, s3);
+    assert_ptr_not_equal(s1, other);
+    assert_ptr_not_equal(s1, buffer);
+    assert_int_equal(srpc_intern_count(), 2);
+
+    srpc_intern_release(s1);
+    srpc_intern_release(s2);
+    srpc_intern_release(s3);
+    srpc_intern_release(other);
+    assert_int_equal(srpc_intern_count(), 0);
+}
+
+static void test_intern_refcount(void **state)
+{
+    (void)state;
+
+    const char *s1 = srpc_intern("192.168.1.1");
+    const char *s2 = srpc_intern_ref(s1);
+
+    assert_ptr_equal(s1, s2);
+
+    srpc_intern_release(s1);
+    assert_int_equal(srpc_intern_count(), 1);
+    assert_string_equal(s2, "192.168.1.1");
+
+    srpc_intern_release(s2);
+    assert_int_equal(srpc_intern_count(), 0);
+
+    srpc_intern_release(NULL);
+}
+
+static void test_intern_many(void **state)
+{
+    (void)state;
+
+    const char *strings[1000] = {0};
+    char buffer[32] = {0};
+
+    for (int i = 0; i < 1000; i++)
+    {
+        snprintf(buffer, sizeof(buffer), "eth%d", i % 100);
+        strings[i] = srpc_intern(buffer);
+        assert_non_null(strings[i]);
+    }
+    assert_int_equal(srpc_intern_count(), 100);
+    assert_ptr_equal(strings[5], strings[105]);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        srpc_intern_release(strings[i]);
+    }
+    assert_int_equal(srpc_intern_count(), 0);
+}
@@ -17,21 +17,424 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
+#include <stdint.h>
+#include <arpa/inet.h>
 #include <cmocka.h>
 
 #include <srpc.h>
+#include <srpc/ly_tree_inline.h>
 
-static void test_ly_tree(void **state);
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  import ietf-inet-types { prefix inet; }"
+                                 "  import ietf-yang-types { prefix yang; }"
+                                 "  typedef port-number { type uint16 { range 1..65535; } }"
+                                 "  container system {"
+                                 "    leaf hostname { type string; }"
+                                 "    leaf-list search { type string; }"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "    }"
+                                 "    container clock {"
+                                 "      leaf timezone { type string; }"
+                                 "    }"
+                                 "    choice transport {"
+                                 "      leaf udp { type empty; }"
+                                 "      leaf tcp { type empty; }"
+                                 "    }"
+                                 "  }"
+                                 "  container values {"
+                                 "    leaf u8 { type uint8; }"
+                                 "    leaf u16 { type uint16; }"
+                                 "    leaf u32 { type uint32; }"
+                                 "    leaf u64 { type uint64; }"
+                                 "    leaf i8 { type int8; }"
+                                 "    leaf i16 { type int16; }"
+                                 "    leaf i32 { type int32; }"
+                                 "    leaf i64 { type int64; }"
+                                 "    leaf port { type port-number; }"
+                                 "    leaf limit {"
+                                 "      type union {"
+                                 "        type uint32;"
+                                 "        type enumeration { enum unlimited { value 7; } }"
+                                 "      }"
+                                 "    }"
+                                 "    leaf u32-ref { type leafref { path ../u32; } }"
+                                 "    leaf state {"
+                                 "      type enumeration {"
+                                 "        enum up { value 1; }"
+                                 "        enum down { value 2; }"
+                                 "      }"
+                                 "    }"
+                                 "    leaf ratio { type decimal64 { fraction-digits 2; } }"
+                                 "    leaf enabled { type boolean; }"
+                                 "    leaf name { type string; }"
+                                 "    leaf ipv4 { type inet:ipv4-address; }"
+                                 "    leaf ipv6 { type inet:ipv6-address; }"
+                                 "    leaf ipv4-prefix { type inet:ipv4-prefix; }"
+                                 "    leaf ipv6-prefix { type inet:ipv6-prefix; }"
+                                 "    leaf mac { type yang:mac-address; }"
+                                 "  }"
+                                 "}";
+
+/**
+ * Slots of the gathered system children.
+ */
+enum
+{
+    SYSTEM_CLOCK,
+    SYSTEM_SERVER,
+    SYSTEM_HOSTNAME,
+    SYSTEM_SEARCH,
+    SYSTEM_UDP,
+    SYSTEM_PORT,
+    SYSTEM_COUNT,
+};
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_ly_tree_gather(void **state);
+static void test_ly_tree_gather_invalid(void **state);
+static void test_ly_tree_inline_opaque(void **state);
+static void test_ly_tree_leaf_get_integer(void **state);
+static void test_ly_tree_leaf_get_enum_dec64_bool(void **state);
+static void test_ly_tree_leaf_get_address(void **state);
+static void test_ly_tree_leaf_get_mismatch(void **state);
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx);
+static struct lyd_node *create_value(struct lyd_node *values, const char *name, const char *value);
 
 int main(void)
 {
     const struct CMUnitTest tests[] = {
-        cmocka_unit_test(test_ly_tree),
+        cmocka_unit_test(test_ly_tree_gather),
+        cmocka_unit_test(test_ly_tree_gather_invalid),
+        cmocka_unit_test(test_ly_tree_inline_opaque),
+        cmocka_unit_test(test_ly_tree_leaf_get_integer),
+        cmocka_unit_test(test_ly_tree_leaf_get_enum_dec64_bool),
+        cmocka_unit_test(test_ly_tree_leaf_get_address),
+        cmocka_unit_test(test_ly_tree_leaf_get_mismatch),
     };
-    return cmocka_run_group_tests(tests, NULL, NULL);
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static void test_ly_tree_gather(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const srpc_ly_tree_gather_t items[] = {
+        {"clock", LYS_CONTAINER, SYSTEM_CLOCK},   {"server", LYS_LIST, SYSTEM_SERVER},
+        {"hostname", LYS_LEAF, SYSTEM_HOSTNAME}, {"search", LYS_LEAFLIST, SYSTEM_SEARCH},
+        {"udp", LYS_LEAF, SYSTEM_UDP},           {"port", LYS_LEAF, SYSTEM_PORT},
+    };
+    const srpc_ly_tree_gather_t mismatched[] = {{"hostname", LYS_CONTAINER, 0}};
+    struct lyd_node *system = create_system(ly_ctx);
+    struct lyd_node *nodes[SYSTEM_COUNT] = {0};
+    size_t missing_count = 0;
+
+    assert_int_equal(srpc_ly_tree_gather(system, items, SYSTEM_COUNT, nodes, &missing_count), 0);
+
+    // same nodes as found by the single child lookups
+    assert_null(nodes[SYSTEM_CLOCK]);
+    assert_ptr_equal(nodes[SYSTEM_SERVER], srpc_ly_tree_get_child_list(system, "server"));
+    assert_ptr_equal(nodes[SYSTEM_HOSTNAME], srpc_ly_tree_get_child_leaf(system, "hostname"));
+    assert_ptr_equal(nodes[SYSTEM_SEARCH], srpc_ly_tree_get_child_leaf_list(system, "search"));
+    assert_non_null(nodes[SYSTEM_SERVER]);
+    assert_non_null(nodes[SYSTEM_SEARCH]);
+    assert_string_equal(lyd_get_value(nodes[SYSTEM_HOSTNAME]), "router");
+
+    // a leaf in a case is a child of the container, the port is a grandchild
+    assert_ptr_equal(nodes[SYSTEM_UDP], srpc_ly_tree_get_child_leaf(system, "udp"));
+    assert_non_null(nodes[SYSTEM_UDP]);
+    assert_null(nodes[SYSTEM_PORT]);
+    assert_int_equal(missing_count, 2);
+
+    // the node type has to match too
+    assert_int_equal(srpc_ly_tree_gather(system, mismatched, 1, nodes, &missing_count), 0);
+    assert_null(nodes[0]);
+    assert_int_equal(missing_count, 1);
+
+    // nothing found in a node without children
+    assert_int_equal(srpc_ly_tree_gather(nodes[SYSTEM_HOSTNAME], items, SYSTEM_COUNT, nodes, &missing_count), 0);
+    assert_int_equal(missing_count, SYSTEM_COUNT);
+
+    lyd_free_all(system);
+}
+
+static void test_ly_tree_gather_invalid(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const srpc_ly_tree_gather_t out_of_range[] = {{"hostname", LYS_LEAF, 0}, {"search", LYS_LEAFLIST, 2}};
+    const srpc_ly_tree_gather_t duplicate[] = {{"hostname", LYS_LEAF, 1}, {"search", LYS_LEAFLIST, 1}};
+    struct lyd_node *system = create_system(ly_ctx);
+    struct lyd_node *nodes[2] = {0};
+
+    assert_int_equal(srpc_ly_tree_gather(system, out_of_range, 2, nodes, NULL), -1);
+    assert_int_equal(srpc_ly_tree_gather(system, duplicate, 2, nodes, NULL), -1);
+
+    lyd_free_all(system);
+}
+
+static void test_ly_tree_inline_opaque(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *system = create_system(ly_ctx);
+    struct lyd_node *opaque = NULL, *server = NULL;
+
+    // opaque nodes have no schema node - same name as the list entries to reach the node type check
+    assert_int_equal(lyd_new_opaq(system, ly_ctx, "server", NULL, NULL, "test", &opaque), LY_SUCCESS);
+    assert_null(opaque->schema);
+
+    assert_null(srpc_ly_tree_inline_get_child_container(system, "server"));
+    assert_null(srpc_ly_tree_inline_get_child_leaf(system, "missing"));
+
+    server = srpc_ly_tree_inline_get_child_list(system, "server");
+    assert_non_null(server);
+    assert_non_null(server = srpc_ly_tree_inline_get_list_next(server));
+    assert_non_null(server = srpc_ly_tree_inline_get_list_next(server));
+    assert_null(srpc_ly_tree_inline_get_list_next(server));
+
+    lyd_free_all(system);
+}
+
+static void test_ly_tree_leaf_get_integer(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *values = NULL;
+    uint64_t uint_value = 0;
+    int64_t int_value = 0;
+    const char *name = NULL;
+    int32_t enum_value = 0;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &values, "/test:values"), 0);
+
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "u8", "255"), &uint_value), 0);
+    assert_true(uint_value == UINT8_MAX);
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "u16", "65535"), &uint_value), 0);
+    assert_true(uint_value == UINT16_MAX);
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "u32", "4294967295"), &uint_value), 0);
+    assert_true(uint_value == UINT32_MAX);
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "u64", "18446744073709551615"), &uint_value), 0);
+    assert_true(uint_value == UINT64_MAX);
+
+    assert_int_equal(srpc_ly_tree_leaf_get_int(create_value(values, "i8", "-128"), &int_value), 0);
+    assert_true(int_value == INT8_MIN);
+    assert_int_equal(srpc_ly_tree_leaf_get_int(create_value(values, "i16", "-32768"), &int_value), 0);
+    assert_true(int_value == INT16_MIN);
+    assert_int_equal(srpc_ly_tree_leaf_get_int(create_value(values, "i32", "-2147483648"), &int_value), 0);
+    assert_true(int_value == INT32_MIN);
+    assert_int_equal(srpc_ly_tree_leaf_get_int(create_value(values, "i64", "-9223372036854775808"), &int_value), 0);
+    assert_true(int_value == INT64_MIN);
+
+    // typedef derived type
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "port", "8080"), &uint_value), 0);
+    assert_true(uint_value == 8080);
+
+    // union - the value of the matching member type
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "limit", "100"), &uint_value), 0);
+    assert_true(uint_value == 100);
+    lyd_free_tree(srpc_ly_tree_get_child_leaf(values, "limit"));
+    assert_int_equal(srpc_ly_tree_leaf_get_enum(create_value(values, "limit", "unlimited"), &name, &enum_value), 0);
+    assert_string_equal(name, "unlimited");
+    assert_int_equal(enum_value, 7);
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(srpc_ly_tree_get_child_leaf(values, "limit"), &uint_value), -1);
+
+    // leafref - the value of the target type
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(create_value(values, "u32-ref", "4294967295"), &uint_value), 0);
+    assert_true(uint_value == UINT32_MAX);
+
+    lyd_free_all(values);
+}
+
+static void test_ly_tree_leaf_get_enum_dec64_bool(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *values = NULL;
+    const char *name = NULL;
+    int32_t enum_value = 0;
+    int64_t dec64_value = 0;
+    uint8_t fraction_digits = 0;
+    bool bool_value = false;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &values, "/test:values"), 0);
+
+    assert_int_equal(srpc_ly_tree_leaf_get_enum(create_value(values, "state", "down"), &name, &enum_value), 0);
+    assert_string_equal(name, "down");
+    assert_int_equal(enum_value, 2);
+    assert_int_equal(srpc_ly_tree_leaf_get_enum(srpc_ly_tree_get_child_leaf(values, "state"), NULL, NULL), 0);
+
+    // real value is 12.34
+    assert_int_equal(srpc_ly_tree_leaf_get_dec64(create_value(values, "ratio", "12.34"), &dec64_value,
+                                                 &fraction_digits),
+                     0);
+    assert_true(dec64_value == 1234);
+    assert_int_equal(fraction_digits, 2);
+    lyd_free_tree(srpc_ly_tree_get_child_leaf(values, "ratio"));
+    assert_int_equal(srpc_ly_tree_leaf_get_dec64(create_value(values, "ratio", "-0.5"), &dec64_value, NULL), 0);
+    assert_true(dec64_value == -50);
+
+    assert_int_equal(srpc_ly_tree_leaf_get_bool(create_value(values, "enabled", "true"), &bool_value), 0);
+    assert_true(bool_value);
+    lyd_free_tree(srpc_ly_tree_get_child_leaf(values, "enabled"));
+    assert_int_equal(srpc_ly_tree_leaf_get_bool(create_value(values, "enabled", "false"), &bool_value), 0);
+    assert_false(bool_value);
+
+    lyd_free_all(values);
+}
+
+static void test_ly_tree_leaf_get_address(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *values = NULL;
+    struct lyd_node *node = NULL;
+    struct in_addr ipv4 = {0}, expected_ipv4 = {0};
+    struct in6_addr ipv6 = {0}, expected_ipv6 = {0};
+    uint8_t prefix_length = 0;
+    uint8_t mac[6] = {0};
+    const uint8_t expected_mac[6] = {0x00, 0x1b, 0x21, 0xaa, 0xbb, 0xcc};
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &values, "/test:values"), 0);
+
+    // zone suffixes are ignored
+    inet_pton(AF_INET, "192.0.2.1", &expected_ipv4);
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv4_address(create_value(values, "ipv4", "192.0.2.1%eth0"), &ipv4), 0);
+    assert_memory_equal(&ipv4, &expected_ipv4, sizeof(ipv4));
+
+    inet_pton(AF_INET6, "fe80::1", &expected_ipv6);
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv6_address(create_value(values, "ipv6", "fe80::1%eth0"), &ipv6), 0);
+    assert_memory_equal(&ipv6, &expected_ipv6, sizeof(ipv6));
+
+    // prefix lengths at their bounds
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv4_prefix(create_value(values, "ipv4-prefix", "0.0.0.0/0"), &ipv4,
+                                                       &prefix_length),
+                     0);
+    assert_int_equal(prefix_length, 0);
+    lyd_free_tree(srpc_ly_tree_get_child_leaf(values, "ipv4-prefix"));
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv4_prefix(create_value(values, "ipv4-prefix", "192.0.2.1/32"), &ipv4,
+                                                       &prefix_length),
+                     0);
+    assert_int_equal(prefix_length, 32);
+    assert_memory_equal(&ipv4, &expected_ipv4, sizeof(ipv4));
+
+    inet_pton(AF_INET6, "2001:db8::", &expected_ipv6);
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv6_prefix(create_value(values, "ipv6-prefix", "2001:db8::/32"), &ipv6,
+                                                       &prefix_length),
+                     0);
+    assert_int_equal(prefix_length, 32);
+    assert_memory_equal(&ipv6, &expected_ipv6, sizeof(ipv6));
+    lyd_free_tree(srpc_ly_tree_get_child_leaf(values, "ipv6-prefix"));
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv6_prefix(create_value(values, "ipv6-prefix", "2001:db8::1/128"), &ipv6,
+                                                       &prefix_length),
+                     0);
+    assert_int_equal(prefix_length, 128);
+
+    // lengths over the bounds of the family are rejected for string leafs
+    node = create_value(values, "name", "192.0.2.0/33");
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv4_prefix(node, &ipv4, &prefix_length), -1);
+    lyd_free_tree(node);
+    node = create_value(values, "name", "2001:db8::/129");
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv6_prefix(node, &ipv6, &prefix_length), -1);
+    lyd_free_tree(node);
+    node = create_value(values, "name", "192.0.2.0/");
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv4_prefix(node, &ipv4, &prefix_length), -1);
+    lyd_free_tree(node);
+
+    assert_int_equal(srpc_ly_tree_leaf_get_mac_address(create_value(values, "mac", "00:1B:21:AA:BB:CC"), mac), 0);
+    assert_memory_equal(mac, expected_mac, sizeof(mac));
+
+    lyd_free_all(values);
+}
+
+static void test_ly_tree_leaf_get_mismatch(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *values = NULL;
+    struct lyd_node *u8 = NULL, *i8 = NULL, *name = NULL, *ipv4 = NULL;
+    uint64_t uint_value = 0;
+    int64_t int_value = 0;
+    bool bool_value = false;
+    int64_t dec64_value = 0;
+    struct in_addr ipv4_addr = {0};
+    struct in6_addr ipv6_addr = {0};
+    uint8_t mac[6] = {0};
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &values, "/test:values"), 0);
+    u8 = create_value(values, "u8", "1");
+    i8 = create_value(values, "i8", "1");
+    name = create_value(values, "name", "router");
+    ipv4 = create_value(values, "ipv4", "192.0.2.1");
+
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(i8, &uint_value), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_int(u8, &int_value), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(name, &uint_value), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_bool(u8, &bool_value), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_enum(name, NULL, NULL), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_dec64(i8, &dec64_value, NULL), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv4_address(u8, &ipv4_addr), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_ipv6_address(ipv4, &ipv6_addr), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_mac_address(name, mac), -1);
+
+    // not a leaf and a missing leaf
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(values, &uint_value), -1);
+    assert_int_equal(srpc_ly_tree_leaf_get_uint(NULL, &uint_value), -1);
+
+    lyd_free_all(values);
 }
 
-static void test_ly_tree(void **state)
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx)
 {
-    (void)state;
-}
\ No newline at end of file
+    struct lyd_node *system = NULL, *server = NULL;
+    const char *addresses[] = {"10.0.0.1", "10.0.0.2", "10.0.0.3"};
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+
+    for (size_t i = 0; i < sizeof(addresses) / sizeof(addresses[0]); i++)
+    {
+        assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", addresses[i]), 0);
+        assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, NULL, "port", "53"), 0);
+    }
+
+    assert_int_equal(srpc_ly_tree_append_leaf_list(ly_ctx, system, NULL, "search", "example.com"), 0);
+    assert_int_equal(srpc_ly_tree_append_leaf_list(ly_ctx, system, NULL, "search", "example.net"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", "router"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "udp", NULL), 0);
+
+    return system;
+}
+
+static struct lyd_node *create_value(struct lyd_node *values, const char *name, const char *value)
+{
+    struct lyd_node *node = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_leaf(LYD_CTX(values), values, &node, name, value), 0);
+
+    return node;
+}
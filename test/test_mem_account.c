@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static int setup_ctx(void **state);
+static int teardown_ctx(void **state);
+static int teardown_stats(void **state);
+static void test_mem_account_helpers(void **state);
+static void test_mem_account_tree(void **state);
+static void test_mem_account_nested(void **state);
+static void test_mem_account_no_scope(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_teardown(test_mem_account_helpers, teardown_stats),
+        cmocka_unit_test_teardown(test_mem_account_tree, teardown_stats),
+        cmocka_unit_test_teardown(test_mem_account_nested, teardown_stats),
+        cmocka_unit_test_teardown(test_mem_account_no_scope, teardown_stats),
+    };
+    return cmocka_run_group_tests(tests, setup_ctx, teardown_ctx);
+}
+
+static int setup_ctx(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    // the yang library module is implemented in every context
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown_ctx(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static int teardown_stats(void **state)
+{
+    (void)state;
+
+    srpc_mem_account_set_threshold(0);
+    srpc_mem_account_reset();
+
+    return 0;
+}
+
+static void test_mem_account_helpers(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *tree = NULL;
+    srpc_mem_account_stats_t stats = {0};
+
+    for (int i = 0; i < 2; i++)
+    {
+        srpc_mem_account_begin("build");
+        assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &tree, "/ietf-yang-library:yang-library"), 0);
+        if (i == 1)
+        {
+            assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, tree, NULL, "content-id", "1"), 0);
+        }
+        srpc_mem_account_end(NULL);
+
+        lyd_free_all(tree);
+        tree = NULL;
+    }
+
+    assert_int_equal(srpc_mem_account_get_stats("build", &stats), 0);
+    assert_int_equal(stats.calls, 2);
+    assert_int_equal(stats.last_nodes, 2);
+    assert_int_equal(stats.peak_nodes, 2);
+    assert_int_equal(stats.total_nodes, 3);
+    assert_true(stats.peak_bytes > 0);
+    assert_int_equal(stats.peak_bytes, stats.last_bytes);
+    assert_true(stats.total_bytes > stats.peak_bytes);
+}
+
+static void test_mem_account_tree(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *tree = NULL;
+    srpc_mem_account_stats_t stats = {0};
+
+    // built without the helpers - accounted from the tree passed to the end of the scope
+    assert_int_equal(lyd_new_path(NULL, ly_ctx, "/ietf-yang-library:yang-library/content-id", "1", 0, &tree), 0);
+
+    srpc_mem_account_set_threshold(1);
+    srpc_mem_account_begin("oper");
+    srpc_mem_account_end(tree);
+
+    assert_int_equal(srpc_mem_account_get_stats("oper", &stats), 0);
+    assert_int_equal(stats.calls, 1);
+    assert_int_equal(stats.last_nodes, 2);
+
+    lyd_free_all(tree);
+}
+
+static void test_mem_account_nested(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *tree = NULL;
+    srpc_mem_account_stats_t outer = {0}, inner = {0};
+
+    srpc_mem_account_begin("outer");
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &tree, "/ietf-yang-library:yang-library"), 0);
+
+    srpc_mem_account_begin("inner");
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, tree, NULL, "content-id", "1"), 0);
+    srpc_mem_account_end(NULL);
+
+    srpc_mem_account_end(NULL);
+
+    assert_int_equal(srpc_mem_account_get_stats("inner", &inner), 0);
+    assert_int_equal(srpc_mem_account_get_stats("outer", &outer), 0);
+    assert_int_equal(inner.last_nodes, 1);
+    assert_int_equal(outer.last_nodes, 2);
+
+    lyd_free_all(tree);
+}
+
+static void test_mem_account_no_scope(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *tree = NULL;
+    srpc_mem_account_stats_t stats = {0};
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &tree, "/ietf-yang-library:yang-library"), 0);
+    srpc_mem_account_tree(tree);
+
+    assert_int_equal(srpc_mem_account_get_stats("build", &stats), -1);
+
+    lyd_free_all(tree);
+}
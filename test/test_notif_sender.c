@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static const char *test_module = "module test {"
+                                 "  yang-version 1.1;"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  notification restarted {"
+                                 "    leaf reason { type string; }"
+                                 "  }"
+                                 "  container system {"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "      notification unreachable {"
+                                 "        leaf since { type uint32; }"
+                                 "      }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_notif_sender_build(void **state);
+static void test_notif_sender_build_nested(void **state);
+static void test_notif_sender_build_invalid(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_notif_sender_build),
+        cmocka_unit_test(test_notif_sender_build_nested),
+        cmocka_unit_test(test_notif_sender_build_invalid),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static void test_notif_sender_build(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const srpc_key_value_pair_t leafs[] = {{"reason", "upgrade"}};
+    struct lyd_node *notif = NULL, *node = NULL;
+
+    assert_int_equal(srpc_notif_sender_build(ly_ctx, "/test:restarted", leafs, 1, &notif), 0);
+    assert_non_null(notif);
+    assert_int_equal(notif->schema->nodetype, LYS_NOTIF);
+
+    assert_int_equal(lyd_find_path(notif, "/test:restarted/reason", 0, &node), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(node), "upgrade");
+
+    lyd_free_all(notif);
+}
+
+static void test_notif_sender_build_nested(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const char *path = "/test:system/server[address='10.0.0.1']/unreachable";
+    const srpc_key_value_pair_t leafs[] = {{"since", "10"}};
+    struct lyd_node *notif = NULL, *node = NULL;
+
+    // the first child of the list entry is its key, not the notification
+    assert_int_equal(srpc_notif_sender_build(ly_ctx, path, leafs, 1, &notif), 0);
+    assert_non_null(notif);
+    assert_string_equal(LYD_NAME(notif), "system");
+
+    assert_int_equal(lyd_find_path(notif, path, 0, &node), LY_SUCCESS);
+    assert_int_equal(node->schema->nodetype, LYS_NOTIF);
+
+    assert_int_equal(lyd_find_path(node, "since", 0, &node), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(node), "10");
+
+    lyd_free_all(notif);
+}
+
+static void test_notif_sender_build_invalid(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const srpc_key_value_pair_t leafs[] = {{"missing", "1"}};
+    struct lyd_node *notif = NULL;
+
+    // not a notification
+    assert_int_equal(srpc_notif_sender_build(ly_ctx, "/test:system", NULL, 0, &notif), -1);
+    assert_null(notif);
+
+    // unknown leaf
+    assert_int_equal(srpc_notif_sender_build(ly_ctx, "/test:restarted", leafs, 1, &notif), -1);
+    assert_null(notif);
+}
@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  container system {"
+                                 "    leaf hostname { type string; }"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+/**
+ * Private data of the operational callback.
+ */
+typedef struct
+{
+    const struct ly_ctx *ly_ctx;
+    size_t calls;
+} test_oper_t;
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_oper_cache_top_level(void **state);
+static void test_oper_cache_nested(void **state);
+static int oper_servers(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path,
+                        const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *priv);
+static int get_items(srpc_oper_cache_t *cache, test_oper_t *oper, struct lyd_node **parent);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_oper_cache_top_level),
+        cmocka_unit_test(test_oper_cache_nested),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static void test_oper_cache_top_level(void **state)
+{
+    test_oper_t oper = {.ly_ctx = *state};
+    srpc_oper_cache_t *cache = NULL;
+    srpc_oper_cache_stats_t stats = {0};
+    struct lyd_node *data = NULL, *node = NULL;
+
+    cache = srpc_oper_cache_new(60000, 0, NULL);
+    assert_non_null(cache);
+
+    assert_int_equal(get_items(cache, &oper, &data), 0);
+    assert_int_equal(oper.calls, 1);
+    lyd_free_all(data);
+    data = NULL;
+
+    // served from the cache
+    assert_int_equal(get_items(cache, &oper, &data), 0);
+    assert_int_equal(oper.calls, 1);
+    assert_non_null(data);
+    assert_int_equal(lyd_find_path(data, "/test:system/server[address='10.0.0.1']/port", 0, &node), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(node), "53");
+    lyd_free_all(data);
+
+    srpc_oper_cache_get_stats(cache, &stats);
+    assert_int_equal(stats.hits, 1);
+    assert_int_equal(stats.misses, 1);
+
+    srpc_oper_cache_free(&cache);
+    assert_null(cache);
+}
+
+static void test_oper_cache_nested(void **state)
+{
+    test_oper_t oper = {.ly_ctx = *state};
+    srpc_oper_cache_t *cache = NULL;
+    struct lyd_node *system = NULL, *node = NULL;
+
+    cache = srpc_oper_cache_new(60000, 0, NULL);
+    assert_non_null(cache);
+
+    // the parent already holds data of another subscription
+    assert_int_equal(srpc_ly_tree_create_container(oper.ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(oper.ly_ctx, system, NULL, "hostname", "router"), 0);
+    assert_int_equal(get_items(cache, &oper, &system), 0);
+    assert_int_equal(oper.calls, 1);
+    lyd_free_all(system);
+
+    // only the servers are cached - the hostname of the new parent is kept
+    assert_int_equal(srpc_ly_tree_create_container(oper.ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(oper.ly_ctx, system, NULL, "hostname", "switch"), 0);
+    assert_int_equal(get_items(cache, &oper, &system), 0);
+    assert_int_equal(oper.calls, 1);
+
+    assert_int_equal(lyd_find_path(system, "hostname", 0, &node), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(node), "switch");
+    assert_int_equal(lyd_find_path(system, "server[address='10.0.0.1']/port", 0, &node), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(node), "53");
+    lyd_free_all(system);
+
+    srpc_oper_cache_free(&cache);
+}
+
+static int oper_servers(sr_session_ctx_t *session, uint32_t sub_id, const char *module_name, const char *path,
+                        const char *request_xpath, uint32_t request_id, struct lyd_node **parent, void *priv)
+{
+    test_oper_t *oper = priv;
+    struct lyd_node *server = NULL;
+
+    (void)session;
+    (void)sub_id;
+    (void)module_name;
+    (void)path;
+    (void)request_xpath;
+    (void)request_id;
+
+    ++oper->calls;
+
+    if (!*parent && srpc_ly_tree_create_container(oper->ly_ctx, NULL, parent, "/test:system"))
+    {
+        return -1;
+    }
+
+    if (srpc_ly_tree_create_list(oper->ly_ctx, *parent, &server, "server", "address", "10.0.0.1") ||
+        srpc_ly_tree_create_leaf(oper->ly_ctx, server, NULL, "port", "53"))
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int get_items(srpc_oper_cache_t *cache, test_oper_t *oper, struct lyd_node **parent)
+{
+    return srpc_oper_cache_get_items(cache, NULL, 1, "test", "/test:system/server", NULL, 0, parent, oper_servers,
+                                     oper);
+}
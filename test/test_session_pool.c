@@ -0,0 +1,125 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+#include <sysrepo.h>
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_session_pool_reuse(void **state);
+static void test_session_pool_double_return(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_session_pool_reuse),
+        cmocka_unit_test(test_session_pool_double_return),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    sr_conn_ctx_t *connection = NULL;
+
+    if (sr_connect(0, &connection) != SR_ERR_OK)
+    {
+        return -1;
+    }
+
+    *state = connection;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    sr_disconnect(*state);
+
+    return 0;
+}
+
+static void test_session_pool_reuse(void **state)
+{
+    srpc_session_pool_t *pool = NULL;
+    sr_session_ctx_t *first = NULL, *second = NULL;
+    srpc_session_pool_stats_t stats = {0};
+
+    pool = srpc_session_pool_new(*state, SR_DS_RUNNING, 1);
+    assert_non_null(pool);
+
+    assert_int_equal(srpc_session_pool_checkout(pool, 0, &first), 0);
+    assert_int_equal(sr_session_switch_ds(first, SR_DS_STARTUP), SR_ERR_OK);
+    assert_int_equal(srpc_session_pool_checkout(pool, 10, &second), -1);
+    srpc_session_pool_return(pool, first);
+
+    // the returned session is reused and switched back to the pool datastore
+    assert_int_equal(srpc_session_pool_checkout(pool, 10, &second), 0);
+    assert_ptr_equal(second, first);
+    assert_int_equal(sr_session_get_ds(second), SR_DS_RUNNING);
+    srpc_session_pool_return(pool, second);
+
+    srpc_session_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.checkouts, 2);
+    assert_int_equal(stats.created, 1);
+    assert_int_equal(stats.timeouts, 1);
+    assert_int_equal(stats.in_use, 0);
+
+    srpc_session_pool_free(&pool);
+    assert_null(pool);
+}
+
+static void test_session_pool_double_return(void **state)
+{
+    srpc_session_pool_t *pool = NULL;
+    sr_session_ctx_t *session = NULL, *first = NULL, *second = NULL, *foreign = NULL;
+    srpc_session_pool_stats_t stats = {0};
+
+    pool = srpc_session_pool_new(*state, SR_DS_RUNNING, 4);
+    assert_non_null(pool);
+
+    assert_int_equal(srpc_session_pool_checkout(pool, 0, &session), 0);
+    srpc_session_pool_return(pool, session);
+
+    // the second return and a session of another owner are ignored
+    srpc_session_pool_return(pool, session);
+    assert_int_equal(sr_session_start(*state, SR_DS_RUNNING, &foreign), SR_ERR_OK);
+    srpc_session_pool_return(pool, foreign);
+    assert_int_equal(sr_session_stop(foreign), SR_ERR_OK);
+
+    srpc_session_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.in_use, 0);
+
+    // the session is handed out only once
+    assert_int_equal(srpc_session_pool_checkout(pool, 0, &first), 0);
+    assert_int_equal(srpc_session_pool_checkout(pool, 0, &second), 0);
+    assert_ptr_not_equal(first, second);
+    assert_ptr_equal(first, session);
+
+    srpc_session_pool_return(pool, first);
+    srpc_session_pool_return(pool, second);
+
+    srpc_session_pool_get_stats(pool, &stats);
+    assert_int_equal(stats.created, 2);
+    assert_int_equal(stats.in_use, 0);
+
+    srpc_session_pool_free(&pool);
+}
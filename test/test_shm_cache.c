@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+#define TEST_SLOTS_COUNT 4
+#define TEST_SLOT_SIZE 256
+
+static char test_name[64];
+
+static int setup_cache(void **state);
+static int teardown_cache(void **state);
+static void test_shm_cache_publish(void **state);
+static void test_shm_cache_invalidate(void **state);
+static void test_shm_cache_processes(void **state);
+static void test_shm_cache_killed_producer(void **state);
+static int run_child(const char *key, const char *value);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_shm_cache_publish, setup_cache, teardown_cache),
+        cmocka_unit_test_setup_teardown(test_shm_cache_invalidate, setup_cache, teardown_cache),
+        cmocka_unit_test_setup_teardown(test_shm_cache_processes, setup_cache, teardown_cache),
+        cmocka_unit_test_setup_teardown(test_shm_cache_killed_producer, setup_cache, teardown_cache),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static int setup_cache(void **state)
+{
+    snprintf(test_name, sizeof(test_name), "/srpc-test-shm-cache-%d", (int)getpid());
+    srpc_shm_cache_unlink(test_name);
+
+    *state = srpc_shm_cache_new(test_name, TEST_SLOTS_COUNT, TEST_SLOT_SIZE);
+
+    return *state ? 0 : -1;
+}
+
+static int teardown_cache(void **state)
+{
+    srpc_shm_cache_t *cache = *state;
+
+    srpc_shm_cache_free(&cache);
+
+    return srpc_shm_cache_unlink(test_name);
+}
+
+static void test_shm_cache_publish(void **state)
+{
+    srpc_shm_cache_t *cache = *state;
+    char buffer[TEST_SLOT_SIZE] = {0};
+    char large[TEST_SLOT_SIZE + 1] = {0};
+    size_t size = 0;
+    uint64_t version = 0;
+
+    assert_int_equal(srpc_shm_cache_read(cache, "links", buffer, sizeof(buffer), &size, &version), 1);
+    assert_int_equal(srpc_shm_cache_publish(cache, "links", "eth0", 5), -1);
+
+    assert_int_equal(srpc_shm_cache_register(cache, "links", 0), 0);
+
+    // registered but not published yet
+    assert_int_equal(srpc_shm_cache_read(cache, "links", buffer, sizeof(buffer), &size, &version), 1);
+
+    assert_int_equal(srpc_shm_cache_publish(cache, "links", "eth0", 5), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "links", buffer, sizeof(buffer), &size, &version), 0);
+    assert_string_equal(buffer, "eth0");
+    assert_int_equal(size, 5);
+    assert_int_equal(version, 1);
+
+    assert_int_equal(srpc_shm_cache_publish(cache, "links", "eth0 eth1", 10), 0);
+    assert_int_equal(srpc_shm_cache_get_version(cache, "links", &version), 0);
+    assert_int_equal(version, 2);
+
+    // too small buffer reports the needed size
+    assert_int_equal(srpc_shm_cache_read(cache, "links", buffer, 4, &size, NULL), -1);
+    assert_int_equal(size, 10);
+
+    assert_int_equal(srpc_shm_cache_publish(cache, "links", large, sizeof(large)), -1);
+}
+
+static void test_shm_cache_invalidate(void **state)
+{
+    srpc_shm_cache_t *cache = *state;
+    const struct timespec delay = {.tv_sec = 0, .tv_nsec = 100 * 1000000};
+    char buffer[TEST_SLOT_SIZE] = {0};
+    size_t size = 0;
+    uint64_t version = 0;
+
+    assert_int_equal(srpc_shm_cache_register(cache, "routes", 50), 0);
+    assert_int_equal(srpc_shm_cache_publish(cache, "routes", "default", 8), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "routes", buffer, sizeof(buffer), &size, NULL), 0);
+
+    assert_int_equal(srpc_shm_cache_invalidate(cache, "routes"), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "routes", buffer, sizeof(buffer), &size, NULL), 1);
+    assert_int_equal(srpc_shm_cache_get_version(cache, "routes", &version), 1);
+
+    // published again, then older than the maximal age
+    assert_int_equal(srpc_shm_cache_publish(cache, "routes", "default", 8), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "routes", buffer, sizeof(buffer), &size, NULL), 0);
+    nanosleep(&delay, NULL);
+    assert_int_equal(srpc_shm_cache_read(cache, "routes", buffer, sizeof(buffer), &size, NULL), 1);
+
+    assert_int_equal(srpc_shm_cache_invalidate(cache, "missing"), 0);
+}
+
+static void test_shm_cache_processes(void **state)
+{
+    srpc_shm_cache_t *cache = *state;
+    char buffer[TEST_SLOT_SIZE] = {0};
+    size_t size = 0;
+
+    // blob published by another process - stays readable after the producer exited without freeing its handle
+    assert_int_equal(run_child("addresses", "10.0.0.1"), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "addresses", buffer, sizeof(buffer), &size, NULL), 0);
+    assert_string_equal(buffer, "10.0.0.1");
+
+    // the key of an exited producer can be taken over, its blob is dropped
+    assert_int_equal(srpc_shm_cache_register(cache, "addresses", 0), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "addresses", buffer, sizeof(buffer), &size, NULL), 1);
+
+    // the key of a running producer can't
+    assert_int_equal(run_child("addresses", "10.0.0.2"), 1);
+}
+
+static void test_shm_cache_killed_producer(void **state)
+{
+    srpc_shm_cache_t *cache = *state;
+    const struct timespec delay = {.tv_sec = 0, .tv_nsec = 20 * 1000000};
+    char buffer[TEST_SLOT_SIZE] = {0};
+    size_t size = 0;
+    pid_t pid = 0;
+
+    // producer killed while publishing in a loop - likely in the middle of a write
+    pid = fork();
+    if (!pid)
+    {
+        srpc_shm_cache_t *child_cache = srpc_shm_cache_new(test_name, TEST_SLOTS_COUNT, TEST_SLOT_SIZE);
+
+        if (!child_cache || srpc_shm_cache_register(child_cache, "neighbors", 0))
+        {
+            _exit(1);
+        }
+        for (;;)
+        {
+            srpc_shm_cache_publish(child_cache, "neighbors", buffer, sizeof(buffer));
+        }
+    }
+
+    assert_true(pid > 0);
+    nanosleep(&delay, NULL);
+    assert_int_equal(kill(pid, SIGKILL), 0);
+    assert_int_equal(waitpid(pid, NULL, 0), pid);
+
+    // the unfinished write doesn't block other writers
+    assert_int_equal(srpc_shm_cache_invalidate(cache, "neighbors"), 0);
+    assert_int_equal(srpc_shm_cache_register(cache, "neighbors", 0), 0);
+    assert_int_equal(srpc_shm_cache_publish(cache, "neighbors", "fe80::1", 8), 0);
+    assert_int_equal(srpc_shm_cache_read(cache, "neighbors", buffer, sizeof(buffer), &size, NULL), 0);
+    assert_string_equal(buffer, "fe80::1");
+}
+
+static int run_child(const char *key, const char *value)
+{
+    srpc_shm_cache_t *cache = NULL;
+    pid_t pid = 0;
+    int status = 0;
+
+    pid = fork();
+    if (!pid)
+    {
+        cache = srpc_shm_cache_new(test_name, TEST_SLOTS_COUNT, TEST_SLOT_SIZE);
+        if (!cache)
+        {
+            _exit(2);
+        }
+        if (srpc_shm_cache_register(cache, key, 0))
+        {
+            _exit(1);
+        }
+        _exit(srpc_shm_cache_publish(cache, key, value, strlen(value) + 1) ? 3 : 0);
+    }
+
+    assert_true(pid > 0);
+    assert_int_equal(waitpid(pid, &status, 0), pid);
+    assert_true(WIFEXITED(status));
+
+    return WEXITSTATUS(status);
+}
@@ -0,0 +1,305 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  container system {"
+                                 "    leaf hostname { type string; }"
+                                 "    leaf-list search { type string; ordered-by user; }"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+static const char *other_module = "module other {"
+                                  "  namespace urn:other;"
+                                  "  prefix o;"
+                                  "  leaf value { type string; }"
+                                  "}";
+
+static const char *snapshot_path = "/tmp/srpc_test_snapshot.lyb";
+static const char *fingerprint_path = "/tmp/srpc_test_fingerprint";
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_snapshot_save_load(void **state);
+static void test_snapshot_store_load_into(void **state);
+static void test_snapshot_store_load_into_nested(void **state);
+static void test_snapshot_incompatible(void **state);
+static void test_snapshot_tree_fingerprint(void **state);
+static void test_snapshot_tree_fingerprint_user_ordered(void **state);
+static void test_snapshot_fingerprint_check(void **state);
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx, const char *servers[][2], size_t servers_count);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_snapshot_save_load),
+        cmocka_unit_test(test_snapshot_store_load_into),
+        cmocka_unit_test(test_snapshot_store_load_into_nested),
+        cmocka_unit_test(test_snapshot_incompatible),
+        cmocka_unit_test(test_snapshot_tree_fingerprint),
+        cmocka_unit_test(test_snapshot_tree_fingerprint_user_ordered),
+        cmocka_unit_test(test_snapshot_fingerprint_check),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+    unlink(snapshot_path);
+    unlink(fingerprint_path);
+
+    return 0;
+}
+
+static void test_snapshot_save_load(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *system = NULL, *server = NULL;
+    struct lyd_node *loaded = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", "router"), 0);
+    assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", "10.0.0.1"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, NULL, "port", "53"), 0);
+
+    unlink(snapshot_path);
+    assert_int_equal(srpc_snapshot_load(ly_ctx, snapshot_path, &loaded), 1);
+
+    assert_int_equal(srpc_snapshot_save(ly_ctx, system, snapshot_path), 0);
+    assert_int_equal(srpc_snapshot_load(ly_ctx, snapshot_path, &loaded), 0);
+    assert_non_null(loaded);
+    assert_int_equal(lyd_compare_siblings(system, loaded, LYD_COMPARE_FULL_RECURSION), LY_SUCCESS);
+
+    lyd_free_all(loaded);
+    lyd_free_all(system);
+}
+
+static void test_snapshot_store_load_into(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *system = NULL, *restored = NULL;
+    struct lyd_node *hostname = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", "switch"), 0);
+    assert_int_equal(srpc_snapshot_store(snapshot_path, system), 0);
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &restored, "/test:system"), 0);
+    assert_int_equal(srpc_snapshot_load_into(ly_ctx, snapshot_path, restored), 0);
+
+    assert_int_equal(lyd_find_path(restored, "hostname", 0, &hostname), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(hostname), "switch");
+
+    lyd_free_all(restored);
+    lyd_free_all(system);
+}
+
+static void test_snapshot_store_load_into_nested(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *system = NULL, *server = NULL;
+    struct lyd_node *restored = NULL, *restored_server = NULL;
+    struct lyd_node *port = NULL;
+
+    // list entry as the parent
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", "router"), 0);
+    assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", "10.0.0.1"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, NULL, "port", "53"), 0);
+    assert_int_equal(srpc_snapshot_store(snapshot_path, server), 0);
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &restored, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_list(ly_ctx, restored, &restored_server, "server", "address", "10.0.0.1"), 0);
+    assert_int_equal(srpc_snapshot_load_into(ly_ctx, snapshot_path, restored_server), 0);
+
+    assert_int_equal(lyd_find_path(restored_server, "port", 0, &port), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(port), "53");
+
+    // an existing value is replaced
+    assert_int_equal(lyd_change_term(port, "5353"), LY_SUCCESS);
+    assert_int_equal(srpc_snapshot_load_into(ly_ctx, snapshot_path, restored_server), 0);
+    assert_int_equal(lyd_find_path(restored_server, "port", 0, &port), LY_SUCCESS);
+    assert_string_equal(lyd_get_value(port), "53");
+
+    lyd_free_all(restored);
+    lyd_free_all(system);
+}
+
+static void test_snapshot_incompatible(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct ly_ctx *other_ctx = NULL;
+    struct lyd_node *system = NULL;
+    struct lyd_node *loaded = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_snapshot_save(ly_ctx, system, snapshot_path), 0);
+
+    // same modules give the same fingerprint, an additional module changes it
+    assert_int_equal(ly_ctx_new(NULL, 0, &other_ctx), LY_SUCCESS);
+    assert_int_equal(lys_parse_mem(other_ctx, test_module, LYS_IN_YANG, NULL), LY_SUCCESS);
+    assert_true(srpc_snapshot_ctx_fingerprint(ly_ctx) == srpc_snapshot_ctx_fingerprint(other_ctx));
+
+    assert_int_equal(lys_parse_mem(other_ctx, other_module, LYS_IN_YANG, NULL), LY_SUCCESS);
+    assert_true(srpc_snapshot_ctx_fingerprint(ly_ctx) != srpc_snapshot_ctx_fingerprint(other_ctx));
+    assert_int_equal(srpc_snapshot_load(other_ctx, snapshot_path, &loaded), 1);
+    assert_null(loaded);
+
+    ly_ctx_destroy(other_ctx);
+    lyd_free_all(system);
+}
+
+static void test_snapshot_tree_fingerprint(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const char *servers[][2] = {{"10.0.0.1", "53"}, {"10.0.0.2", "853"}};
+    const char *reordered[][2] = {{"10.0.0.2", "853"}, {"10.0.0.1", "53"}};
+    const char *swapped[][2] = {{"10.0.0.1", "853"}, {"10.0.0.2", "53"}};
+    struct lyd_node *tree = create_system(ly_ctx, servers, 2);
+    struct lyd_node *other = NULL;
+
+    assert_true(srpc_snapshot_tree_fingerprint(NULL) == 0);
+    assert_true(srpc_snapshot_tree_fingerprint(tree) != 0);
+
+    // the order of the entries doesn't matter
+    other = create_system(ly_ctx, reordered, 2);
+    assert_true(srpc_snapshot_tree_fingerprint(tree) == srpc_snapshot_tree_fingerprint(other));
+    lyd_free_all(other);
+
+    // values moved between the entries do
+    other = create_system(ly_ctx, swapped, 2);
+    assert_true(srpc_snapshot_tree_fingerprint(tree) != srpc_snapshot_tree_fingerprint(other));
+    lyd_free_all(other);
+
+    other = create_system(ly_ctx, servers, 1);
+    assert_true(srpc_snapshot_tree_fingerprint(tree) != srpc_snapshot_tree_fingerprint(other));
+    lyd_free_all(other);
+
+    lyd_free_all(tree);
+}
+
+static void test_snapshot_tree_fingerprint_user_ordered(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const char *searches[] = {"example.com", "example.net", "example.org"};
+    const char *reordered[] = {"example.net", "example.com", "example.org"};
+    struct lyd_node *tree = create_system(ly_ctx, NULL, 0);
+    struct lyd_node *other = create_system(ly_ctx, NULL, 0);
+
+    for (size_t i = 0; i < 3; i++)
+    {
+        assert_int_equal(srpc_ly_tree_append_leaf_list(ly_ctx, tree, NULL, "search", searches[i]), 0);
+        assert_int_equal(srpc_ly_tree_append_leaf_list(ly_ctx, other, NULL, "search", reordered[i]), 0);
+    }
+
+    // the order of ordered-by user entries is part of the data
+    assert_true(srpc_snapshot_tree_fingerprint(tree) != srpc_snapshot_tree_fingerprint(other));
+
+    lyd_free_all(other);
+    other = create_system(ly_ctx, NULL, 0);
+    for (size_t i = 0; i < 3; i++)
+    {
+        assert_int_equal(srpc_ly_tree_append_leaf_list(ly_ctx, other, NULL, "search", searches[i]), 0);
+    }
+    assert_true(srpc_snapshot_tree_fingerprint(tree) == srpc_snapshot_tree_fingerprint(other));
+
+    lyd_free_all(other);
+    lyd_free_all(tree);
+}
+
+static void test_snapshot_fingerprint_check(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const char *servers[][2] = {{"10.0.0.1", "53"}};
+    const char *changed[][2] = {{"10.0.0.1", "5353"}};
+    struct lyd_node *tree = create_system(ly_ctx, servers, 1);
+    struct lyd_node *other = create_system(ly_ctx, changed, 1);
+    struct ly_ctx *other_ctx = NULL;
+    uint64_t fingerprint = 0;
+
+    // first start - nothing stored, import and store the fingerprint afterwards
+    unlink(fingerprint_path);
+    assert_int_equal(srpc_snapshot_fingerprint_check(ly_ctx, tree, fingerprint_path, &fingerprint), 1);
+    assert_true(fingerprint == srpc_snapshot_tree_fingerprint(tree));
+    assert_int_equal(srpc_snapshot_fingerprint_store(ly_ctx, fingerprint_path, fingerprint), 0);
+
+    // unchanged system
+    assert_int_equal(srpc_snapshot_fingerprint_check(ly_ctx, tree, fingerprint_path, NULL), 0);
+
+    // changed system
+    assert_int_equal(srpc_snapshot_fingerprint_check(ly_ctx, other, fingerprint_path, NULL), 1);
+
+    // changed schema context
+    assert_int_equal(ly_ctx_new(NULL, 0, &other_ctx), LY_SUCCESS);
+    assert_int_equal(lys_parse_mem(other_ctx, other_module, LYS_IN_YANG, NULL), LY_SUCCESS);
+    assert_int_equal(srpc_snapshot_fingerprint_check(other_ctx, NULL, fingerprint_path, NULL), 1);
+    ly_ctx_destroy(other_ctx);
+
+    lyd_free_all(other);
+    lyd_free_all(tree);
+}
+
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx, const char *servers[][2], size_t servers_count)
+{
+    struct lyd_node *system = NULL, *server = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", "router"), 0);
+
+    for (size_t i = 0; i < servers_count; i++)
+    {
+        assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", servers[i][0]), 0);
+        assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, NULL, "port", servers[i][1]), 0);
+    }
+
+    return system;
+}
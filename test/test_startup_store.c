@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+// Maximal number of calls recorded per store callback.
+#define TEST_CALLS_MAX 8
+
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  container system {"
+                                 "    leaf hostname { type string; }"
+                                 "    list server {"
+                                 "      key address;"
+                                 "      leaf address { type string; }"
+                                 "      leaf port { type uint16; }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+/**
+ * Calls of a store callback.
+ */
+typedef struct
+{
+    size_t count;
+    char *paths[TEST_CALLS_MAX];
+    char *ports[TEST_CALLS_MAX];
+    int deleted[TEST_CALLS_MAX];
+} test_calls_t;
+
+/**
+ * Calls of all store callbacks.
+ */
+typedef struct
+{
+    test_calls_t servers;
+    test_calls_t hostname;
+    test_calls_t all;
+} test_stores_t;
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_startup_store_changed_subtrees(void **state);
+static int store_servers(void *priv, const struct lyd_node *parent_node);
+static int store_hostname(void *priv, const struct lyd_node *parent_node);
+static int store_all(void *priv, const struct lyd_node *parent_node);
+static void record_call(test_calls_t *calls, const struct lyd_node *node);
+static void calls_free(test_stores_t *stores);
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx, const char *hostname, const char *servers[][2],
+                                      size_t servers_count);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_startup_store_changed_subtrees),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static void test_startup_store_changed_subtrees(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    test_stores_t stores = {0};
+    const srpc_startup_store_t store_callbacks[] = {
+        {.name = "servers", .cb = store_servers, .path = "/test:system/server"},
+        {.name = "hostname", .cb = store_hostname, .path = "/test:system/hostname"},
+        {.name = "all", .cb = store_all},
+    };
+    const char *initial[][2] = {{"10.0.0.1", "53"}, {"10.0.0.2", "53"}};
+    const char *modified[][2] = {{"10.0.0.1", "53"}, {"10.0.0.2", "5353"}, {"10.0.0.3", "53"}};
+    srpc_startup_store_engine_t *engine = NULL;
+    struct lyd_node *system = NULL;
+
+    engine = srpc_startup_store_engine_new(&stores, store_callbacks, 3, 0);
+    assert_non_null(engine);
+
+    system = create_system(ly_ctx, "router", initial, 2);
+    assert_int_equal(srpc_startup_store_engine_set_snapshot(engine, system), 0);
+    lyd_free_all(system);
+
+    // one modified and one added server - only those entries are passed
+    system = create_system(ly_ctx, "router", modified, 3);
+    assert_int_equal(srpc_startup_store_engine_submit(engine, system), 0);
+    lyd_free_all(system);
+    assert_int_equal(srpc_startup_store_engine_flush(engine), 0);
+
+    assert_int_equal(stores.servers.count, 2);
+    assert_string_equal(stores.servers.paths[0], "/test:system/server[address='10.0.0.2']");
+    assert_string_equal(stores.servers.ports[0], "5353");
+    assert_false(stores.servers.deleted[0]);
+    assert_string_equal(stores.servers.paths[1], "/test:system/server[address='10.0.0.3']");
+    assert_string_equal(stores.servers.ports[1], "53");
+    assert_false(stores.servers.deleted[1]);
+    assert_int_equal(stores.hostname.count, 0);
+    assert_int_equal(stores.all.count, 1);
+    assert_string_equal(stores.all.paths[0], "/test:system");
+    calls_free(&stores);
+
+    // removed server and changed hostname
+    system = create_system(ly_ctx, "switch", modified, 2);
+    assert_int_equal(srpc_startup_store_engine_submit(engine, system), 0);
+    lyd_free_all(system);
+    assert_int_equal(srpc_startup_store_engine_flush(engine), 0);
+
+    assert_int_equal(stores.servers.count, 1);
+    assert_string_equal(stores.servers.paths[0], "/test:system/server[address='10.0.0.3']");
+    assert_true(stores.servers.deleted[0]);
+    assert_int_equal(stores.hostname.count, 1);
+    assert_string_equal(stores.hostname.paths[0], "/test:system/hostname");
+    assert_false(stores.hostname.deleted[0]);
+    assert_int_equal(stores.all.count, 1);
+    calls_free(&stores);
+
+    // unchanged data calls nothing
+    system = create_system(ly_ctx, "switch", modified, 2);
+    assert_int_equal(srpc_startup_store_engine_submit(engine, system), 0);
+    lyd_free_all(system);
+    assert_int_equal(srpc_startup_store_engine_flush(engine), 0);
+
+    assert_int_equal(stores.servers.count, 0);
+    assert_int_equal(stores.hostname.count, 0);
+    assert_int_equal(stores.all.count, 0);
+
+    srpc_startup_store_engine_free(&engine);
+    assert_null(engine);
+}
+
+static int store_servers(void *priv, const struct lyd_node *parent_node)
+{
+    record_call(&((test_stores_t *)priv)->servers, parent_node);
+
+    return 0;
+}
+
+static int store_hostname(void *priv, const struct lyd_node *parent_node)
+{
+    record_call(&((test_stores_t *)priv)->hostname, parent_node);
+
+    return 0;
+}
+
+static int store_all(void *priv, const struct lyd_node *parent_node)
+{
+    record_call(&((test_stores_t *)priv)->all, parent_node);
+
+    return 0;
+}
+
+static void record_call(test_calls_t *calls, const struct lyd_node *node)
+{
+    struct lyd_node *port = NULL;
+    struct lyd_meta *operation = NULL;
+    size_t i = calls->count++;
+
+    assert_true(i < TEST_CALLS_MAX);
+
+    calls->paths[i] = lyd_path(node, LYD_PATH_STD, NULL, 0);
+
+    if (lyd_find_path(node, "port", 0, &port) == LY_SUCCESS)
+    {
+        calls->ports[i] = strdup(lyd_get_value(port));
+    }
+
+    operation = lyd_find_meta(node->meta, NULL, "yang:operation");
+    calls->deleted[i] = operation && !strcmp(lyd_get_meta_value(operation), "delete");
+}
+
+static void calls_free(test_stores_t *stores)
+{
+    test_calls_t *all_calls[] = {&stores->servers, &stores->hostname, &stores->all};
+
+    for (size_t i = 0; i < sizeof(all_calls) / sizeof(all_calls[0]); i++)
+    {
+        for (size_t j = 0; j < all_calls[i]->count; j++)
+        {
+            free(all_calls[i]->paths[j]);
+            free(all_calls[i]->ports[j]);
+        }
+        *all_calls[i] = (test_calls_t){0};
+    }
+}
+
+static struct lyd_node *create_system(const struct ly_ctx *ly_ctx, const char *hostname, const char *servers[][2],
+                                      size_t servers_count)
+{
+    struct lyd_node *system = NULL, *server = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &system, "/test:system"), 0);
+    assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, system, NULL, "hostname", hostname), 0);
+
+    for (size_t i = 0; i < servers_count; i++)
+    {
+        assert_int_equal(srpc_ly_tree_create_list(ly_ctx, system, &server, "server", "address", servers[i][0]), 0);
+        assert_int_equal(srpc_ly_tree_create_leaf(ly_ctx, server, NULL, "port", servers[i][1]), 0);
+    }
+
+    return system;
+}
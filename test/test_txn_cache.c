@@ -0,0 +1,138 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static int freed = 0;
+
+static void test_txn_cache_take(void **state);
+static void test_txn_cache_subscriptions(void **state);
+static void test_txn_cache_release(void **state);
+static void test_txn_cache_expire(void **state);
+static void count_free(void *data);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_txn_cache_take),
+        cmocka_unit_test(test_txn_cache_subscriptions),
+        cmocka_unit_test(test_txn_cache_release),
+        cmocka_unit_test(test_txn_cache_expire),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
+
+static void test_txn_cache_take(void **state)
+{
+    (void)state;
+
+    srpc_txn_cache_t *cache = srpc_txn_cache_new(0);
+    int data1 = 1, data2 = 2;
+
+    assert_non_null(cache);
+
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-interfaces", 1, 5, &data1, NULL), 0);
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-system", 1, 5, &data2, NULL), 0);
+
+    assert_ptr_equal(srpc_txn_cache_take(cache, "ietf-interfaces", 1, 5), &data1);
+    assert_null(srpc_txn_cache_take(cache, "ietf-interfaces", 1, 5));
+    assert_null(srpc_txn_cache_take(cache, "ietf-system", 1, 6));
+    assert_ptr_equal(srpc_txn_cache_take(cache, "ietf-system", 1, 5), &data2);
+
+    srpc_txn_cache_free(&cache);
+    assert_null(cache);
+}
+
+static void test_txn_cache_subscriptions(void **state)
+{
+    (void)state;
+
+    srpc_txn_cache_t *cache = srpc_txn_cache_new(0);
+    int data1 = 1, data2 = 2;
+
+    assert_non_null(cache);
+    freed = 0;
+
+    // subscriptions of the same module get the same request ID
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-system", 1, 7, &data1, count_free), 0);
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-system", 2, 7, &data2, count_free), 0);
+    assert_int_equal(freed, 0);
+
+    assert_ptr_equal(srpc_txn_cache_take(cache, "ietf-system", 2, 7), &data2);
+    assert_ptr_equal(srpc_txn_cache_take(cache, "ietf-system", 1, 7), &data1);
+
+    srpc_txn_cache_free(&cache);
+    assert_int_equal(freed, 0);
+}
+
+static void test_txn_cache_release(void **state)
+{
+    (void)state;
+
+    srpc_txn_cache_t *cache = srpc_txn_cache_new(0);
+    int data = 1;
+
+    assert_non_null(cache);
+    freed = 0;
+
+    // replacing frees the previous data
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-interfaces", 1, 1, &data, count_free), 0);
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-interfaces", 1, 1, &data, count_free), 0);
+    assert_int_equal(freed, 1);
+
+    srpc_txn_cache_release(cache, "ietf-interfaces", 1, 1);
+    assert_int_equal(freed, 2);
+    assert_null(srpc_txn_cache_take(cache, "ietf-interfaces", 1, 1));
+
+    // remaining data is freed with the cache
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-interfaces", 1, 2, &data, count_free), 0);
+    srpc_txn_cache_free(&cache);
+    assert_int_equal(freed, 3);
+}
+
+static void test_txn_cache_expire(void **state)
+{
+    (void)state;
+
+    srpc_txn_cache_t *cache = srpc_txn_cache_new(10);
+    int data = 1;
+
+    assert_non_null(cache);
+    freed = 0;
+
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-interfaces", 1, 1, &data, count_free), 0);
+    usleep(20 * 1000);
+    assert_int_equal(srpc_txn_cache_put(cache, "ietf-interfaces", 1, 2, &data, count_free), 0);
+
+    assert_int_equal(freed, 1);
+    assert_null(srpc_txn_cache_take(cache, "ietf-interfaces", 1, 1));
+    assert_ptr_equal(srpc_txn_cache_take(cache, "ietf-interfaces", 1, 2), &data);
+
+    srpc_txn_cache_free(&cache);
+}
+
+static void count_free(void *data)
+{
+    (void)data;
+    ++freed;
+}
@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2022 Deutsche Telekom AG.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ *
+ * SPDX-FileCopyrightText: 2022 Deutsche Telekom AG
+ * SPDX-FileContributor: Sartura Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <srpc.h>
+
+static const char *test_module = "module test {"
+                                 "  namespace urn:test;"
+                                 "  prefix t;"
+                                 "  container interfaces {"
+                                 "    config false;"
+                                 "    list interface {"
+                                 "      key name;"
+                                 "      leaf name { type string; }"
+                                 "      container statistics {"
+                                 "        leaf in-octets { type uint64; }"
+                                 "      }"
+                                 "      container ipv4 {"
+                                 "        leaf mtu { type uint16; }"
+                                 "      }"
+                                 "    }"
+                                 "  }"
+                                 "}";
+
+static int setup(void **state);
+static int teardown(void **state);
+static void test_xpath_filter_schema(void **state);
+static void test_xpath_filter_node(void **state);
+static void test_xpath_filter_unsupported(void **state);
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_xpath_filter_schema),
+        cmocka_unit_test(test_xpath_filter_node),
+        cmocka_unit_test(test_xpath_filter_unsupported),
+    };
+    return cmocka_run_group_tests(tests, setup, teardown);
+}
+
+static int setup(void **state)
+{
+    struct ly_ctx *ly_ctx = NULL;
+
+    if (ly_ctx_new(NULL, 0, &ly_ctx) != LY_SUCCESS)
+    {
+        return -1;
+    }
+
+    if (lys_parse_mem(ly_ctx, test_module, LYS_IN_YANG, NULL) != LY_SUCCESS)
+    {
+        ly_ctx_destroy(ly_ctx);
+        return -1;
+    }
+
+    *state = ly_ctx;
+
+    return 0;
+}
+
+static int teardown(void **state)
+{
+    ly_ctx_destroy(*state);
+
+    return 0;
+}
+
+static void test_xpath_filter_schema(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const srpc_key_value_pair_t eth0[] = {{"name", "eth0"}};
+    const srpc_key_value_pair_t eth1[] = {{"name", "eth1"}};
+    srpc_xpath_filter_t *filter = NULL;
+
+    filter = srpc_xpath_filter_new("/test:interfaces/interface[name='eth0']/statistics/in-octets");
+    assert_non_null(filter);
+
+    assert_true(srpc_xpath_filter_check(filter, lys_find_path(ly_ctx, NULL, "/test:interfaces", 0), NULL, 0));
+    assert_true(
+        srpc_xpath_filter_check(filter, lys_find_path(ly_ctx, NULL, "/test:interfaces/interface", 0), eth0, 1));
+    assert_false(
+        srpc_xpath_filter_check(filter, lys_find_path(ly_ctx, NULL, "/test:interfaces/interface", 0), eth1, 1));
+    assert_true(srpc_xpath_filter_check(
+        filter, lys_find_path(ly_ctx, NULL, "/test:interfaces/interface/statistics/in-octets", 0), NULL, 0));
+    assert_false(
+        srpc_xpath_filter_check(filter, lys_find_path(ly_ctx, NULL, "/test:interfaces/interface/ipv4", 0), NULL, 0));
+
+    srpc_xpath_filter_free(&filter);
+    assert_null(filter);
+}
+
+static void test_xpath_filter_node(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    struct lyd_node *interfaces = NULL;
+    struct lyd_node *eth0 = NULL, *eth1 = NULL;
+    struct lyd_node *statistics = NULL;
+    srpc_xpath_filter_t *filter = NULL;
+
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, NULL, &interfaces, "/test:interfaces"), 0);
+    assert_int_equal(srpc_ly_tree_create_list(ly_ctx, interfaces, &eth0, "interface", "name", "eth0"), 0);
+    assert_int_equal(srpc_ly_tree_create_list(ly_ctx, interfaces, &eth1, "interface", "name", "eth1"), 0);
+    assert_int_equal(srpc_ly_tree_create_container(ly_ctx, eth1, &statistics, "statistics"), 0);
+
+    filter = srpc_xpath_filter_new("/test:interfaces/interface[name=\"eth0\"]");
+    assert_non_null(filter);
+
+    assert_true(srpc_xpath_filter_check_node(filter, interfaces));
+    assert_true(srpc_xpath_filter_check_node(filter, eth0));
+    assert_false(srpc_xpath_filter_check_node(filter, eth1));
+    assert_false(srpc_xpath_filter_check_node(filter, statistics));
+
+    srpc_xpath_filter_free(&filter);
+    lyd_free_all(interfaces);
+}
+
+static void test_xpath_filter_unsupported(void **state)
+{
+    const struct ly_ctx *ly_ctx = *state;
+    const srpc_key_value_pair_t eth1[] = {{"name", "eth1"}};
+    const struct lysc_node *interface = lys_find_path(ly_ctx, NULL, "/test:interfaces/interface", 0);
+    srpc_xpath_filter_t *filter = NULL;
+
+    // union
+    filter = srpc_xpath_filter_new("/test:interfaces/interface[name='eth0'] | /test:interfaces");
+    assert_true(srpc_xpath_filter_check(filter, interface, eth1, 1));
+    srpc_xpath_filter_free(&filter);
+
+    // non-key predicate
+    filter = srpc_xpath_filter_new("/test:interfaces/interface[statistics/in-octets>10]");
+    assert_true(srpc_xpath_filter_check(filter, interface, eth1, 1));
+    srpc_xpath_filter_free(&filter);
+
+    // descendant axis
+    filter = srpc_xpath_filter_new("/test:interfaces//in-octets");
+    assert_true(srpc_xpath_filter_check(filter, interface, eth1, 1));
+    srpc_xpath_filter_free(&filter);
+
+    // no request xpath
+    filter = srpc_xpath_filter_new(NULL);
+    assert_true(srpc_xpath_filter_check(filter, interface, eth1, 1));
+    srpc_xpath_filter_free(&filter);
+}